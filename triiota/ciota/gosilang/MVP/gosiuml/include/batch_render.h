@@ -0,0 +1,66 @@
+#ifndef BATCH_RENDER_H
+#define BATCH_RENDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "layout_engine.h"
+
+// Many-file rendering
+// Jobs come from a manifest ("input [output]" per line, # comments) or a
+// glob. Workers on the thread pool claim jobs in order and run parse ->
+// layout -> render for each, so at most one document per worker is in
+// flight. Every worker places each document, its tokens and relations in
+// its own arena, reset between files, so those cost no allocator traffic
+// once the arena has grown; chunk parse results, the symbol table and the
+// layout arrays are still heap-allocated per file. Outputs ending in
+// .xml or .json are exported; anything else is rendered as SVG.
+typedef struct {
+    const char* input;
+    const char* output;
+} BatchJob;
+
+typedef struct {
+    BatchJob* jobs;
+    size_t count;
+    size_t capacity;
+    struct PhenoArena* strings;    // Paths
+} BatchList;
+
+typedef struct {
+    int threads;                   // Workers: 0 = one per CPU, 1 = serial on the caller
+    LayoutMode layout;
+    size_t arena_block;            // Per-worker arena block (0 = 8 MB)
+    bool quiet;                    // No per-file failure messages
+} BatchOptions;
+
+typedef struct {
+    uint64_t files;
+    uint64_t failed;
+    uint64_t tokens;
+    uint64_t relations;
+    uint64_t input_bytes;
+    uint64_t output_bytes;
+    double parse_seconds;          // Summed over workers
+    double layout_seconds;
+    double render_seconds;
+    double seconds;                // Wall clock
+    size_t arena_peak;             // Largest per-worker arena reservation
+    int workers;
+} BatchStats;
+
+// Outputs of glob or manifest lines without one go to out_dir (NULL = next
+// to the input) as <stem>.svg. spec is a glob if it contains *, ? or [.
+bool batch_list_load(const char* spec, const char* out_dir, BatchList* list);
+bool batch_list_add(BatchList* list, const char* input, const char* output, const char* out_dir);
+void batch_list_free(BatchList* list);
+
+// <out_dir or the input's directory>/<input stem>.svg; false if it does not fit
+bool batch_output_path(const char* input, const char* out_dir, char* out, size_t size);
+
+void batch_defaults(BatchOptions* options);
+
+// False if any job failed; stats cover every job
+bool batch_run(const BatchList* list, const BatchOptions* options, BatchStats* stats);
+
+#endif // BATCH_RENDER_H
@@ -0,0 +1,114 @@
+#ifndef GOSIB_H
+#define GOSIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Compiled token container (.gosib)
+// A fixed header followed by 8-byte aligned sections in the byte order of
+// the host that compiled it (byte_order reads GOSIB_BYTE_ORDER there):
+//   string table   uint32 offsets[string_count + 1], then NUL-terminated bytes
+//   tokens         GosibToken[token_count] in source order
+//   relation index uint32[token_count + 1] row starts into edges (CSR)
+//   edges          GosibEdge[edge_count], grouped by source token, source order
+//   dangling       GosibRelation[dangling_count], endpoints not among tokens
+// Edges and dangling relations each carry their ordinal among all the
+// relations of the source, so readers can restore file order.
+// The loader maps the file and points straight into it; nothing is parsed.
+// It validates every offset, the index, the edge endpoints and the
+// ordinals once at open, and rejects files written with the other byte
+// order.
+#define GOSIB_MAGIC       "GSIB"
+#define GOSIB_VERSION     4
+#define GOSIB_BYTE_ORDER  0x01020304u
+#define GOSIB_EXTENSION   ".gosib"
+#define GOSIB_NO_STRING   UINT32_MAX
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t flags;
+    uint32_t token_count;
+    uint32_t edge_count;
+    uint32_t dangling_count;
+    uint32_t string_count;
+    uint32_t byte_order;           // GOSIB_BYTE_ORDER in the writer's order
+    uint64_t source_size;          // Source file size at compile time
+    int64_t source_mtime_ns;       // Source modification time at compile time
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t tokens_offset;
+    uint64_t index_offset;
+    uint64_t edges_offset;
+    uint64_t dangling_offset;
+    uint64_t file_size;
+    uint64_t content_hash;         // XXH64 of the source bytes (seed 0)
+    uint64_t malformed;            // Source lines that failed to parse
+    uint64_t reserved[2];
+} GosibHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t type;                 // String index
+    uint32_t zone;                 // Leading decimal digits of the zone name
+    uint32_t zone_name;            // String index
+} GosibToken;
+
+typedef struct {
+    uint32_t dst;                  // Destination token index
+    uint32_t type;                 // String index
+    uint32_t ordinal;              // Position among the source's relations
+} GosibEdge;
+
+typedef struct {
+    uint32_t src_id;
+    uint32_t dst_id;
+    uint32_t type;                 // String index
+    uint32_t ordinal;              // Position among the source's relations
+} GosibRelation;
+
+// Mapped container; every pointer aliases the mapping
+typedef struct {
+    const GosibHeader* header;
+    const uint32_t* string_offsets;
+    const char* string_data;
+    const GosibToken* tokens;
+    const uint32_t* index;
+    const GosibEdge* edges;
+    const GosibRelation* dangling;
+    void* map;
+    size_t size;
+} GosibFile;
+
+typedef struct {
+    uint32_t tokens;
+    uint32_t edges;
+    uint32_t dangling;
+    uint32_t strings;
+    uint64_t malformed;
+} GosibCompileStats;
+
+// Compile a token text file. out_path NULL writes <src_path>.gosib.
+// The file is written to a temporary name and renamed into place.
+bool gosib_compile(const char* src_path, const char* out_path, GosibCompileStats* stats);
+
+bool gosib_open(GosibFile* file, const char* path);
+void gosib_close(GosibFile* file);
+
+// True if source_path still has the size and mtime recorded at compile time
+bool gosib_is_current(const GosibFile* file, const char* source_path);
+
+const char* gosib_string(const GosibFile* file, uint32_t index);
+
+// Outgoing edges of token i: edges[index[i] .. index[i + 1])
+static inline uint32_t gosib_edge_begin(const GosibFile* file, uint32_t token) {
+    return file->index[token];
+}
+
+static inline uint32_t gosib_edge_end(const GosibFile* file, uint32_t token) {
+    return file->index[token + 1];
+}
+
+#endif // GOSIB_H
@@ -23,14 +23,87 @@ typedef enum {
     GOSIUML_OPT_VERBOSE = 1,
     GOSIUML_OPT_SHOW_BITFIELDS = 2,
     GOSIUML_OPT_STATE_MACHINE = 3,
-    GOSIUML_OPT_MEMORY_TRACKING = 4
+    GOSIUML_OPT_MEMORY_TRACKING = 4,
+    GOSIUML_OPT_POOL_KB = 5             // Context pool size; only before the first allocation
 } GosiUMLOption;
 
-// Forward declaration of context structure
+#define GOSIUML_OPT_COUNT 6
+
+// Context: a self-contained instance owning its token pool, document
+// arena, symbol table, options and statistics. Nothing in it is shared
+// with other contexts or guarded by a lock, so independent contexts run
+// in parallel threads without contending; one context is used by one
+// thread at a time.
 typedef struct GosiUMLContext GosiUMLContext;
 
 // Include platform definitions (contains PhenoToken, PhenoState, etc)
 #include "phenomemory_platform.h"
+#include "pheno_symbols.h"
+
+// Relation parsed from "RELATION: 0x<src> -> 0x<dst> : <type>"
+// type is truncated to 31 characters; type_symbol keeps the full name
+typedef struct {
+    uint32_t src_id;
+    uint32_t dst_id;
+    char type[32];
+    uint32_t type_symbol;
+} GosiUMLRelation;
+
+typedef struct PhenoArena PhenoArena;
+typedef struct PhenoThreadPool PhenoThreadPool;
+
+// Parse options for gosiuml_parse_file_ex()
+typedef struct {
+    int threads;                    // 0 = one per CPU, 1 = serial on the caller
+    size_t chunk_size;              // Target bytes per chunk (0 = default)
+    GosiUMLRelation** relations;    // Optional: receives the relation array
+    int* relation_count;
+    PhenoArena* arena;              // Optional (documents): allocate here instead of a new arena
+    PhenoSymbolTable* symbols;      // Optional: intern names here instead of a new table
+    PhenoThreadPool* pool;          // Optional: run chunks here; threads then follows its size
+} GosiUMLParseOptions;
+
+// Parsed file: the document, its tokens and relations live in one arena
+// and are released together by gosiuml_free_document(). Token and
+// relation type/zone names are interned in symbols; filter and group by
+// comparing the symbol ids. A document parsed into a caller's arena has
+// arena == NULL; gosiuml_free_document() then releases only the symbols
+// and the caller resets the arena. A document parsed with the caller's
+// symbol table has shared_symbols set and leaves the table alone.
+
+typedef struct {
+    PhenoToken* tokens;
+    size_t token_count;
+    GosiUMLRelation* relations;
+    size_t relation_count;
+    uint64_t malformed;             // TOKEN:/RELATION: lines that failed to parse
+    uint64_t source_size;
+    PhenoSymbolTable* symbols;
+    PhenoArena* arena;
+    bool shared_symbols;            // symbols came from GosiUMLParseOptions
+} GosiUMLDocument;
+
+// Document kept current with an append-only token file. Each refresh
+// parses only the bytes appended since the previous one; a truncated or
+// replaced file is parsed again from its start. The token and relation
+// arrays grow by reallocation, so pointers into the document do not
+// survive a refresh.
+typedef struct GosiUMLDocumentFollower GosiUMLDocumentFollower;
+
+typedef struct {
+    uint64_t tokens_allocated;
+    uint64_t tokens_freed;
+    uint64_t tokens_processed;
+    uint64_t tokens_rejected;       // Failed validation in gosiuml_process_token()
+    uint64_t machines;              // State machines created
+    uint64_t documents;             // Parsed since the last reset
+    uint64_t bytes_in_use;          // Token payload bytes (GOSIUML_OPT_MEMORY_TRACKING)
+    uint64_t bytes_peak;
+    size_t pool_size;
+    size_t pool_used;
+    size_t arena_reserved;
+    size_t symbols;
+} GosiUMLContextStats;
 
 // Function prototypes
 int gosiuml_init(void);
@@ -38,26 +111,65 @@ void gosiuml_cleanup(void);
 const char* gosiuml_version(void);
 GosiUMLContext* gosiuml_create_context(void);
 void gosiuml_free_context(GosiUMLContext* ctx);
+// 0 on success, -1 for an unknown option or a value that cannot apply now
 int gosiuml_set_option(GosiUMLContext* ctx, GosiUMLOption option, int value);
+int gosiuml_get_option(const GosiUMLContext* ctx, GosiUMLOption option);
+PhenoToken* gosiuml_context_alloc_token(GosiUMLContext* ctx, uint32_t size);
+void gosiuml_context_free_token(GosiUMLContext* ctx, PhenoToken* token);
+// State machine drawing its tokens from the context pool; destroy_state_machine() releases it.
+// The machine must be destroyed before the context is freed.
+StateMachine* gosiuml_context_create_machine(GosiUMLContext* ctx);
+PhenoSymbol gosiuml_context_intern(GosiUMLContext* ctx, const char* name);
+const PhenoSymbolTable* gosiuml_context_symbols(const GosiUMLContext* ctx);
+// Serial parse into the context arena; valid until gosiuml_context_reset(), not freed separately.
+// Names are interned in the context symbol table, so ids compare with gosiuml_context_intern().
+GosiUMLDocument* gosiuml_context_parse(GosiUMLContext* ctx, const char* filename);
+void gosiuml_context_reset(GosiUMLContext* ctx);
+void gosiuml_context_stats(const GosiUMLContext* ctx, GosiUMLContextStats* stats);
+const char* gosiuml_context_error(const GosiUMLContext* ctx);
+// Record an error on ctx (may be NULL) and as this thread's gosiuml_get_error()
+void gosiuml_context_set_error(GosiUMLContext* ctx, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
 PhenoToken* gosiuml_parse_file(const char* filename, int* count);
+PhenoToken* gosiuml_parse_file_ex(const char* filename, const GosiUMLParseOptions* options,
+                                  int* count);
+void gosiuml_free_relations(GosiUMLRelation* relations);
+GosiUMLDocument* gosiuml_parse_document(const char* filename, const GosiUMLParseOptions* options);
+void gosiuml_free_document(GosiUMLDocument* doc);
+PhenoSymbol gosiuml_document_symbol(const GosiUMLDocument* doc, const char* name);
+GosiUMLDocumentFollower* gosiuml_follow_document(const char* filename);
+// Tokens plus relations added (0 if unchanged), -1 if unreadable; *reset on a restart
+long gosiuml_follow_refresh(GosiUMLDocumentFollower* follower, bool* reset);
+const GosiUMLDocument* gosiuml_follow_get(const GosiUMLDocumentFollower* follower);
+uint64_t gosiuml_follow_offset(const GosiUMLDocumentFollower* follower);
+void gosiuml_follow_free(GosiUMLDocumentFollower* follower);
 PhenoToken* gosiuml_create_token(uint8_t type, const char* name);
 void gosiuml_free_token(PhenoToken* token);
 void gosiuml_free_tokens(PhenoToken* tokens, int count);
 int gosiuml_process_token(GosiUMLContext* ctx, PhenoToken* token);
 int gosiuml_generate_svg(GosiUMLContext* ctx, PhenoToken* tokens, int count, const char* output_file);
+int gosiuml_generate_document_svg(GosiUMLContext* ctx, const GosiUMLDocument* doc,
+                                  const char* output_file);
 int gosiuml_generate_xml(GosiUMLContext* ctx, PhenoToken* tokens, int count, const char* output_file);
 int gosiuml_generate_json(GosiUMLContext* ctx, PhenoToken* tokens, int count, const char* output_file);
+// FORMAT_XML for *.xml, FORMAT_JSON for *.json, else FORMAT_SVG
+GosiUMLFormat gosiuml_format_from_path(const char* path);
+// Tokens with their type/zone names plus relations; FORMAT_SVG lays out and renders
+int gosiuml_export_document(GosiUMLContext* ctx, const GosiUMLDocument* doc,
+                            GosiUMLFormat format, const char* output_file);
 int gosiuml_get_state(PhenoToken* token);
 int gosiuml_transition(PhenoToken* token, int new_state);
 int gosiuml_test_state_machine(GosiUMLContext* ctx);
 int gosiuml_test_bitfields(void);
 int gosiuml_run_tests(void);
+// Last error recorded on the calling thread, "" if none
 const char* gosiuml_get_error(void);
 void gosiuml_set_debug(bool enable);
 
 // Export parse_token_file function
 int parse_token_file(const char* filename);
 int generate_svg(const char* output_file);
+void generate_svg_from_tokens(PhenoToken* tokens, int count, const char* output_file);
 
 #endif // GOSIUML_H
 
@@ -0,0 +1,107 @@
+#ifndef GOSIUML_DAEMON_H
+#define GOSIUML_DAEMON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "layout_engine.h"
+#include "parse_cache.h"
+
+// Resident server
+// A daemon owns the memory pool, the thread pool and a table of parsed
+// documents for its whole life and answers requests on a Unix stream
+// socket, so a client pays for a connect and one round trip instead of
+// process start, pool setup and a parse. Documents are keyed by path and
+// revalidated with a stat on every request; each keeps its layout, an id
+// index and an SVG fragment cache, so repeated renders reformat only
+// what changed.
+//
+// Every message is a DaemonFrame followed by length payload bytes, in
+// host byte order (the socket never leaves the machine). Request payloads
+// are NUL-separated arguments; reply payloads are one JSON object.
+//
+//   PING                         {"pong":true}
+//   PARSE  path                  document summary
+//   RENDER path output [layout]  .xml/.json export, else SVG
+//   QUERY  path [token id]       summary, or one token
+//   STATS                        server counters, request latency, pool memory
+//   SHUTDOWN                     stop after replying
+#define DAEMON_MAGIC        0x31555347u  // "GSU1"
+#define DAEMON_MAX_PAYLOAD  (1u << 20)
+#define DAEMON_MAX_ARGS     4
+
+typedef enum {
+    DAEMON_PING = 1,
+    DAEMON_PARSE,
+    DAEMON_RENDER,
+    DAEMON_QUERY,
+    DAEMON_STATS,
+    DAEMON_SHUTDOWN
+} DaemonOp;
+
+typedef enum {
+    DAEMON_OK = 0,
+    DAEMON_BAD_REQUEST,            // Unknown op, bad arguments or oversized frame
+    DAEMON_NOT_FOUND,              // Input cannot be parsed, or no such token
+    DAEMON_FAILED                  // Layout or output failed
+} DaemonStatus;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t op;                   // DaemonOp
+    uint16_t status;               // DaemonStatus in replies, 0 in requests
+    uint32_t length;               // Payload bytes that follow
+} DaemonFrame;
+
+typedef struct {
+    char socket_path[108];         // sun_path
+    int max_documents;             // Resident documents, least recently used evicted (0 = 64)
+    int threads;                   // Parse/layout threads, one pool for the daemon (0 = default pool)
+    LayoutMode layout;             // Default for RENDER without a layout argument
+    const ParseCacheConfig* parse_cache;  // Optional on-disk cache behind the table
+    bool quiet;
+} DaemonOptions;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t errors;
+    uint64_t parses;               // Documents (re)built
+    uint64_t hits;                 // Requests served from a resident document
+    uint64_t renders;
+    uint64_t connections;
+    uint64_t documents;            // Currently resident
+    uint64_t p50_ns;               // Request latency, read to reply sent
+    uint64_t p99_ns;
+} DaemonStats;
+
+typedef struct GosiUMLDaemon GosiUMLDaemon;
+
+void daemon_defaults(DaemonOptions* options);
+
+// Bind, listen and serve on a background thread; NULL if the socket
+// cannot be bound. A stale socket file left by a dead daemon is replaced.
+GosiUMLDaemon* daemon_start(const DaemonOptions* options);
+
+// Block until a SHUTDOWN request or daemon_shutdown()
+void daemon_wait(GosiUMLDaemon* daemon);
+
+// Stop accepting and wake daemon_wait(); requests in progress finish
+void daemon_shutdown(GosiUMLDaemon* daemon);
+
+// Close every connection, release resident documents and remove the socket
+void daemon_stop(GosiUMLDaemon* daemon);
+
+void daemon_get_stats(GosiUMLDaemon* daemon, DaemonStats* stats);
+
+// Client side. daemon_request() sends one frame of argc NUL-separated
+// arguments and reads the reply into reply (NUL-terminated, truncated to
+// reply_size); returns the reply status, or -1 on a transport error.
+int daemon_connect(const char* socket_path);
+int daemon_request(int fd, DaemonOp op, int argc, const char* const* argv,
+                   char* reply, size_t reply_size);
+void daemon_disconnect(int fd);
+
+// "ping", "parse", ... -> op; 0 if unknown
+DaemonOp daemon_parse_op(const char* name);
+
+#endif // GOSIUML_DAEMON_H
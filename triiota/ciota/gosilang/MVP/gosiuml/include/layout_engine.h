@@ -0,0 +1,76 @@
+#ifndef LAYOUT_ENGINE_H
+#define LAYOUT_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "gosiuml.h"
+
+// Diagram layout
+// GRID is the original fixed-spacing grid and ignores relations.
+// LAYERED is Sugiyama-style for acyclic relation graphs: longest-path
+// layering, barycenter crossing-reduction sweeps, and layers wrapped into
+// rows once wider than the canvas allows. FORCE is Fruchterman-Reingold
+// with Barnes-Hut repulsion over a quadtree, O(n log n) per iteration,
+// with the per-node forces split across the thread pool.
+// AUTO picks LAYERED when the relations form a DAG no deeper than a few
+// times sqrt(n) layers and FORCE otherwise; LAYERED on a cyclic graph
+// falls back to FORCE.
+
+// Node box and grid spacing shared with the SVG renderer
+#define LAYOUT_NODE_WIDTH  180
+#define LAYOUT_NODE_HEIGHT 120
+#define LAYOUT_H_SPACING   220
+#define LAYOUT_V_SPACING   (LAYOUT_NODE_HEIGHT + 60)
+#define LAYOUT_MARGIN      100
+#define LAYOUT_MIN_WIDTH   1200
+#define LAYOUT_MIN_HEIGHT  800
+
+typedef enum {
+    LAYOUT_AUTO = 0,
+    LAYOUT_GRID,
+    LAYOUT_LAYERED,
+    LAYOUT_FORCE
+} LayoutMode;
+
+typedef struct {
+    LayoutMode mode;
+    int threads;                   // 0 = default pool, 1 = serial on the caller
+    int iterations;                // FORCE iterations (0 = 50)
+    double theta;                  // Barnes-Hut opening angle (0 = 1.2)
+    int sweeps;                    // LAYERED barycenter sweeps (0 = 4)
+    PhenoThreadPool* pool;         // Optional: used instead of a pool per threads
+} LayoutOptions;
+
+typedef struct {
+    float x, y;                    // Node centre
+} LayoutPoint;
+
+typedef struct {
+    LayoutMode mode;               // Mode actually used
+    LayoutPoint* nodes;            // One per token, in token order
+    size_t node_count;
+    uint32_t* edges;               // (src, dst) token index pairs of drawable relations
+    size_t edge_count;
+    uint32_t layers;               // LAYERED only
+    float width, height;           // Canvas size including margins
+    double seconds;
+} Layout;
+
+void layout_defaults(LayoutOptions* options);
+
+// Grid of count nodes, no edges
+bool layout_grid(size_t count, Layout* layout);
+
+// Relations whose endpoints are not both tokens of doc, and self loops,
+// are left out of the layout and of layout->edges
+bool layout_document(const GosiUMLDocument* doc, const LayoutOptions* options, Layout* layout);
+
+void layout_free(Layout* layout);
+
+const char* layout_mode_name(LayoutMode mode);
+
+// Parses "auto", "grid", "layered" or "force"
+bool layout_parse_mode(const char* name, LayoutMode* mode);
+
+#endif // LAYOUT_ENGINE_H
@@ -0,0 +1,47 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "phenomemory_platform.h"
+#include "pheno_journal.h"
+
+// Multi-threaded contention load generator for the pheno state machine.
+// Machines are split into a shared set that every worker steps and
+// per-worker private slices; shared_ratio picks both the split and the
+// fraction of steps that target the shared set.
+typedef struct {
+    int threads;                              // Worker threads
+    int machines;                             // Total machines
+    double shared_ratio;                      // 0.0 = all private, 1.0 = all shared
+    double duration_sec;                      // Wall-clock budget (0 = steps only)
+    uint64_t max_steps;                       // Step budget across workers (0 = duration only)
+    uint32_t event_weights[PHENO_EVENT_COUNT];// Relative event mix
+    uint64_t seed;
+    char json_path[256];                      // "-" for stdout, empty for none
+    PhenoJournalWriter* journal;              // Optional event recording
+} LoadGenConfig;
+
+typedef struct {
+    uint64_t steps;
+    uint64_t transitions;       // Steps that changed state
+    uint64_t recycled;          // FREED machines returned to NIL
+    uint64_t shared_steps;
+    double elapsed_sec;
+    double steps_per_sec;
+    PhenoHistogramSnapshot latency;   // Per-step latency in nanoseconds
+    uint32_t final_states[PHENO_STATE_COUNT];   // Machines per state at the end
+} LoadGenResult;
+
+// Configuration helpers
+void load_generator_defaults(LoadGenConfig* config);
+bool load_generator_parse_mix(const char* spec, uint32_t weights[PHENO_EVENT_COUNT]);
+bool load_generator_parse_spec(const char* spec, LoadGenConfig* config);
+
+// Run and report
+bool load_generator_run(const LoadGenConfig* config, LoadGenResult* result);
+void load_generator_print(FILE* out, const LoadGenConfig* config, const LoadGenResult* result);
+bool load_generator_write_json(FILE* out, const LoadGenConfig* config, const LoadGenResult* result);
+
+#endif // LOAD_GENERATOR_H
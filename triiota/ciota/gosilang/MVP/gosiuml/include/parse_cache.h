@@ -0,0 +1,52 @@
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "gosib.h"
+#include "gosiuml.h"
+
+// On-disk parse cache
+// One compiled .gosib entry per source path, named by the XXH64 of the
+// resolved path. A hit needs only a stat when size and mtime still match
+// the entry header; if only the mtime moved, the source is hashed and
+// compared with the recorded XXH64 before the entry is trusted. Entry
+// mtimes double as LRU stamps and the directory is trimmed to max_bytes
+// after every store.
+typedef struct {
+    char dir[1024];                // Empty = $GOSIUML_CACHE_DIR or ~/.cache/gosiuml
+    uint64_t max_bytes;            // Total entry size bound (0 = unbounded)
+} ParseCacheConfig;
+
+typedef enum {
+    PARSE_CACHE_MISS,              // Compiled and stored
+    PARSE_CACHE_HIT,               // Size and mtime matched
+    PARSE_CACHE_HIT_REHASHED,      // mtime changed, content hash matched
+    PARSE_CACHE_BYPASS             // Cache unusable, compiled to a temporary entry
+} ParseCacheOutcome;
+
+typedef struct {
+    ParseCacheOutcome outcome;
+    uint64_t evicted_entries;
+    uint64_t evicted_bytes;
+    char entry_path[1200];
+} ParseCacheResult;
+
+void parse_cache_defaults(ParseCacheConfig* config);
+
+// Map the compiled form of source, compiling and storing it on a miss
+bool parse_cache_open(const ParseCacheConfig* config, const char* source,
+                      GosibFile* file, ParseCacheResult* result);
+
+// Trim the cache directory to max_bytes, oldest entries first
+void parse_cache_evict(const ParseCacheConfig* config, ParseCacheResult* result);
+
+// Document built from the cached entry (relations grouped by source token,
+// then relations with undefined endpoints)
+GosiUMLDocument* parse_cache_load_document(const ParseCacheConfig* config, const char* source,
+                                           ParseCacheResult* result);
+
+const char* parse_cache_outcome_name(ParseCacheOutcome outcome);
+
+#endif // PARSE_CACHE_H
@@ -0,0 +1,27 @@
+#ifndef PHENO_ARENA_H
+#define PHENO_ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump allocator over a chain of blocks
+// Allocations are never freed individually; pheno_arena_reset() keeps
+// the first block for reuse and pheno_arena_destroy() releases all.
+typedef struct PhenoArena PhenoArena;
+
+PhenoArena* pheno_arena_create(size_t block_size);
+void pheno_arena_destroy(PhenoArena* arena);
+void pheno_arena_reset(PhenoArena* arena);
+
+void* pheno_arena_alloc(PhenoArena* arena, size_t size, size_t align);
+void* pheno_arena_calloc(PhenoArena* arena, size_t count, size_t size);
+char* pheno_arena_strndup(PhenoArena* arena, const char* str, size_t len);
+
+size_t pheno_arena_used(const PhenoArena* arena);       // Bytes handed out
+size_t pheno_arena_reserved(const PhenoArena* arena);   // Bytes held in blocks
+
+#define PHENO_ARENA_NEW(arena, type, count) \
+    ((type*)pheno_arena_alloc((arena), sizeof(type) * (count), _Alignof(type)))
+
+#endif // PHENO_ARENA_H
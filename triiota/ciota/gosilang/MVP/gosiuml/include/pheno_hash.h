@@ -0,0 +1,10 @@
+#ifndef PHENO_HASH_H
+#define PHENO_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// XXH64 (xxHash 64-bit), bit-compatible with the reference implementation
+uint64_t pheno_xxh64(const void* data, size_t len, uint64_t seed);
+
+#endif // PHENO_HASH_H
@@ -0,0 +1,73 @@
+#ifndef PHENO_HISTOGRAM_H
+#define PHENO_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Log-linear (HDR-style) histogram layout:
+// values below 2^SUB_BITS get one bucket each, every power of two above
+// that is split into 2^SUB_BITS linear sub-buckets (~6% relative error).
+#define PHENO_HIST_SUB_BITS   4
+#define PHENO_HIST_SUB_COUNT  (1 << PHENO_HIST_SUB_BITS)
+#define PHENO_HIST_MAX_MSB    39    // ~550s when recording nanoseconds
+#define PHENO_HIST_BUCKETS    ((PHENO_HIST_MAX_MSB - PHENO_HIST_SUB_BITS + 2) * PHENO_HIST_SUB_COUNT)
+
+// Recording side - lock-free, safe to share between threads
+typedef struct {
+    _Atomic uint64_t counts[PHENO_HIST_BUCKETS];
+    _Atomic uint64_t total_sum;
+} PhenoHistogram;
+
+// Plain copy used for reporting and thread-local recording
+typedef struct {
+    uint64_t counts[PHENO_HIST_BUCKETS];
+    uint64_t total_count;
+    uint64_t total_sum;
+} PhenoHistogramSnapshot;
+
+// Monotonic clock in nanoseconds
+static inline uint64_t pheno_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Map a value to its bucket index
+static inline uint32_t pheno_hist_bucket(uint64_t value) {
+    if (value < PHENO_HIST_SUB_COUNT) return (uint32_t)value;
+
+    uint32_t msb = 63 - (uint32_t)__builtin_clzll(value);
+    if (msb > PHENO_HIST_MAX_MSB) return PHENO_HIST_BUCKETS - 1;
+
+    uint32_t shift = msb - PHENO_HIST_SUB_BITS;
+    return (shift + 1) * PHENO_HIST_SUB_COUNT +
+           (uint32_t)((value >> shift) - PHENO_HIST_SUB_COUNT);
+}
+
+// Record one value (two relaxed atomic adds)
+static inline void pheno_hist_record(PhenoHistogram* hist, uint64_t value) {
+    atomic_fetch_add_explicit(&hist->counts[pheno_hist_bucket(value)], 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->total_sum, value, memory_order_relaxed);
+}
+
+// Record into a private snapshot (no atomics, single owner)
+static inline void pheno_hist_snapshot_record(PhenoHistogramSnapshot* snap,
+                                              uint64_t value) {
+    snap->counts[pheno_hist_bucket(value)]++;
+    snap->total_count++;
+    snap->total_sum += value;
+}
+
+// Histogram operations
+void pheno_hist_reset(PhenoHistogram* hist);
+void pheno_hist_snapshot(PhenoHistogram* hist, PhenoHistogramSnapshot* out, bool reset);
+void pheno_hist_snapshot_merge(PhenoHistogramSnapshot* dst, const PhenoHistogramSnapshot* src);
+uint64_t pheno_hist_bucket_lower(uint32_t index);
+uint64_t pheno_hist_bucket_upper(uint32_t index);
+uint64_t pheno_hist_percentile(const PhenoHistogramSnapshot* snap, double percentile);
+uint64_t pheno_hist_mean(const PhenoHistogramSnapshot* snap);
+
+#endif // PHENO_HISTOGRAM_H
@@ -0,0 +1,60 @@
+#ifndef PHENO_JOURNAL_H
+#define PHENO_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "phenomemory_platform.h"
+
+// Binary event journal
+// File layout: 16-byte header followed by variable-length records.
+// Each record is one tag byte (event) plus two zigzag varints holding the
+// machine id delta and the timestamp delta to the previous record, so a
+// typical record costs 3-4 bytes. Tag PHENO_JOURNAL_RESET records a
+// reset_state_machine() call (version 2); replay applies it in place.
+#define PHENO_JOURNAL_MAGIC   "PJNL"
+#define PHENO_JOURNAL_VERSION 2
+#define PHENO_JOURNAL_RESET   PHENO_EVENT_COUNT
+
+typedef struct {
+    char     magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint64_t base_timestamp_ns;
+} PhenoJournalHeader;
+
+// Decoded journal entry
+typedef struct {
+    uint64_t timestamp_ns;
+    uint32_t machine_id;
+    uint8_t  event;                             // PhenoEvent or PHENO_JOURNAL_RESET
+} PhenoJournalEntry;
+
+// Replay results
+typedef struct {
+    size_t   events;
+    size_t   machines;
+    int      threads;
+    double   elapsed_sec;
+    double   events_per_sec;
+    uint64_t state_digest;                      // Stable across runs and builds
+    uint32_t final_states[PHENO_STATE_COUNT];   // Machines per final state
+} PhenoReplayStats;
+
+typedef struct PhenoJournalWriter PhenoJournalWriter;
+
+// Recording (writers are thread-safe)
+PhenoJournalWriter* pheno_journal_open(const char* path);
+bool pheno_journal_record(PhenoJournalWriter* writer, uint32_t machine_id, PhenoEvent event);
+bool pheno_journal_record_at(PhenoJournalWriter* writer, uint32_t machine_id,
+                             PhenoEvent event, uint64_t timestamp_ns);
+bool pheno_journal_record_reset(PhenoJournalWriter* writer, uint32_t machine_id);
+uint64_t pheno_journal_count(PhenoJournalWriter* writer);
+bool pheno_journal_close(PhenoJournalWriter* writer);
+
+// Reading and replay
+PhenoJournalEntry* pheno_journal_load(const char* path, size_t* count);
+bool pheno_journal_replay(const char* path, int threads, PhenoReplayStats* stats);
+void pheno_journal_print_replay(FILE* out, const PhenoReplayStats* stats);
+
+#endif // PHENO_JOURNAL_H
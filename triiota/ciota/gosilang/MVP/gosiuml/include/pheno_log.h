@@ -0,0 +1,161 @@
+#ifndef PHENO_LOG_H
+#define PHENO_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Asynchronous diagnostics
+// A log call stores a binary record (format pointer, sequence number and
+// up to PHENO_LOG_MAX_ARGS tagged arguments) in a ring owned by the
+// calling thread and returns; nothing is formatted on the hot path. A
+// background drain thread merges the rings in call order, formats each record
+// with its format string and writes it to the output stream; it blocks on
+// a condition variable while every ring is empty. A full ring drops the
+// record and counts it instead of blocking.
+//
+// The default output is stderr. stdout is flushed before each batch, so
+// in a shared terminal or a 2>&1 file everything the program printed
+// before a log call comes out ahead of that message.
+//
+// Formats must be string literals (the pointer is kept until the drain).
+// String arguments are copied into the record, PHENO_LOG_TEXT bytes
+// shared by all of them, and truncated beyond that. Conversions: d i u x
+// X o c with any length modifier, f e g a, s and p.
+//
+// Calls above PHENO_LOG_COMPILE_LEVEL compile to nothing; the rest are
+// filtered at runtime by pheno_log_set_level() with one relaxed load.
+typedef enum {
+    PHENO_LOG_ERROR = 0,
+    PHENO_LOG_WARN,
+    PHENO_LOG_INFO,
+    PHENO_LOG_DEBUG,
+    PHENO_LOG_TRACE
+} PhenoLogLevel;
+
+#ifndef PHENO_LOG_COMPILE_LEVEL
+#define PHENO_LOG_COMPILE_LEVEL PHENO_LOG_DEBUG
+#endif
+
+#define PHENO_LOG_MAX_ARGS     6
+#define PHENO_LOG_TEXT         56
+#define PHENO_LOG_RING_RECORDS 1024        // Per thread, power of two
+
+typedef enum {
+    PHENO_ARG_INT,
+    PHENO_ARG_UINT,
+    PHENO_ARG_DOUBLE,
+    PHENO_ARG_STRING,
+    PHENO_ARG_POINTER
+} PhenoLogArgKind;
+
+typedef struct {
+    PhenoLogArgKind kind;
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        const char* s;
+        const void* p;
+    } v;
+} PhenoLogArg;
+
+typedef struct {
+    uint64_t written;              // Records formatted and written
+    uint64_t dropped;              // Records lost to a full ring
+    uint64_t rings;                // Threads that have logged
+} PhenoLogStats;
+
+extern _Atomic int pheno_log_level;
+
+void pheno_log_set_level(PhenoLogLevel level);
+PhenoLogLevel pheno_log_get_level(void);
+
+// "error", "warn", "info", "debug" or "trace"; -1 if unknown
+int pheno_log_parse_level(const char* name);
+
+// Destination for formatted records (NULL = stderr); flushes first
+void pheno_log_set_output(FILE* out);
+
+// Drain every record logged before the call and flush the output
+void pheno_log_flush(void);
+
+// Stop the drain thread after a final flush (also run at exit)
+void pheno_log_shutdown(void);
+
+void pheno_log_get_stats(PhenoLogStats* stats);
+
+// Record one message; use PHENO_LOG() rather than calling this directly
+void pheno_log_write(PhenoLogLevel level, const char* format, int argc, const PhenoLogArg* args);
+
+static inline PhenoLogArg pheno_log_arg_int(long long v) {
+    PhenoLogArg arg = { PHENO_ARG_INT, { .i = v } };
+    return arg;
+}
+
+static inline PhenoLogArg pheno_log_arg_uint(unsigned long long v) {
+    PhenoLogArg arg = { PHENO_ARG_UINT, { .u = v } };
+    return arg;
+}
+
+static inline PhenoLogArg pheno_log_arg_double(double v) {
+    PhenoLogArg arg = { PHENO_ARG_DOUBLE, { .d = v } };
+    return arg;
+}
+
+static inline PhenoLogArg pheno_log_arg_string(const char* v) {
+    PhenoLogArg arg = { PHENO_ARG_STRING, { .s = v } };
+    return arg;
+}
+
+static inline PhenoLogArg pheno_log_arg_pointer(const void* v) {
+    PhenoLogArg arg = { PHENO_ARG_POINTER, { .p = v } };
+    return arg;
+}
+
+#define PHENO_LOG_ARG(x) _Generic((x), \
+    _Bool: pheno_log_arg_uint, \
+    char: pheno_log_arg_int, \
+    signed char: pheno_log_arg_int, \
+    short: pheno_log_arg_int, \
+    int: pheno_log_arg_int, \
+    long: pheno_log_arg_int, \
+    long long: pheno_log_arg_int, \
+    unsigned char: pheno_log_arg_uint, \
+    unsigned short: pheno_log_arg_uint, \
+    unsigned int: pheno_log_arg_uint, \
+    unsigned long: pheno_log_arg_uint, \
+    unsigned long long: pheno_log_arg_uint, \
+    float: pheno_log_arg_double, \
+    double: pheno_log_arg_double, \
+    char*: pheno_log_arg_string, \
+    const char*: pheno_log_arg_string, \
+    default: pheno_log_arg_pointer)(x)
+
+// Argument list of a format and up to PHENO_LOG_MAX_ARGS values
+#define PHENO_LOG_COUNT_(_f, _1, _2, _3, _4, _5, _6, n, ...) n
+#define PHENO_LOG_COUNT(...) PHENO_LOG_COUNT_(__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0, _)
+#define PHENO_LOG_CAT_(a, b) a##b
+#define PHENO_LOG_CAT(a, b) PHENO_LOG_CAT_(a, b)
+#define PHENO_LOG_ARGS_0(f) { PHENO_ARG_INT, { 0 } }
+#define PHENO_LOG_ARGS_1(f, a) PHENO_LOG_ARG(a)
+#define PHENO_LOG_ARGS_2(f, a, b) PHENO_LOG_ARG(a), PHENO_LOG_ARG(b)
+#define PHENO_LOG_ARGS_3(f, a, b, c) PHENO_LOG_ARGS_2(f, a, b), PHENO_LOG_ARG(c)
+#define PHENO_LOG_ARGS_4(f, a, b, c, d) PHENO_LOG_ARGS_3(f, a, b, c), PHENO_LOG_ARG(d)
+#define PHENO_LOG_ARGS_5(f, a, b, c, d, e) PHENO_LOG_ARGS_4(f, a, b, c, d), PHENO_LOG_ARG(e)
+#define PHENO_LOG_ARGS_6(f, a, b, c, d, e, g) PHENO_LOG_ARGS_5(f, a, b, c, d, e), PHENO_LOG_ARG(g)
+#define PHENO_LOG_FORMAT_(f, ...) f
+
+#define PHENO_LOG(level, ...) \
+    do { \
+        if ((level) <= PHENO_LOG_COMPILE_LEVEL && \
+            (level) <= atomic_load_explicit(&pheno_log_level, memory_order_relaxed)) { \
+            const PhenoLogArg pheno_log_args_[] = { \
+                PHENO_LOG_CAT(PHENO_LOG_ARGS_, PHENO_LOG_COUNT(__VA_ARGS__))(__VA_ARGS__) }; \
+            pheno_log_write((level), PHENO_LOG_FORMAT_(__VA_ARGS__, _), \
+                            PHENO_LOG_COUNT(__VA_ARGS__), pheno_log_args_); \
+        } \
+    } while (0)
+
+#endif // PHENO_LOG_H
@@ -0,0 +1,64 @@
+#ifndef PHENO_PIPELINE_H
+#define PHENO_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "phenomemory_platform.h"
+
+// Substate pipelines
+// Each ACTIVE substate (READING, WRITING, TRANSFORMING) owns a chain of
+// stages. A stage receives a batch of spans that alias the tokens'
+// data_ptr directly - payloads are never copied - and the chain runs
+// stage-major over the batch so every stage streams through memory once.
+#define PHENO_PIPELINE_MAX_STAGES 8
+#define PHENO_PIPELINE_BATCH      64
+
+typedef struct PhenoPipeline PhenoPipeline;
+
+// In-place view of one token payload
+typedef struct {
+    PhenoToken* token;
+    uint8_t* data;
+    size_t size;
+} PhenoSpan;
+
+// Stage callback: operate on spans[0..count) in place
+typedef void (*PhenoStageFunc)(PhenoSpan* spans, size_t count, void* ctx);
+
+typedef struct {
+    uint64_t batches;
+    uint64_t tokens[PHENO_SUBSTATE_COUNT];
+    uint64_t bytes[PHENO_SUBSTATE_COUNT];
+    uint64_t skipped;           // Busy or not ACTIVE during a batch run
+} PhenoPipelineStats;
+
+// Lifecycle
+PhenoPipeline* pheno_pipeline_create(void);
+void pheno_pipeline_destroy(PhenoPipeline* pipeline);
+
+// Stages run in registration order; name must outlive the pipeline
+bool pheno_pipeline_add_stage(PhenoPipeline* pipeline, PhenoSubstate substate,
+                              const char* name, PhenoStageFunc func, void* ctx);
+size_t pheno_pipeline_stage_count(const PhenoPipeline* pipeline, PhenoSubstate substate);
+
+// Run one machine (caller serialises access, as with step_state_machine)
+bool pheno_pipeline_process(PhenoPipeline* pipeline, StateMachine* sm);
+
+// Run many machines in batches. Each machine is try-locked; busy machines
+// and machines outside ACTIVE are skipped. Returns tokens processed.
+size_t pheno_pipeline_run(PhenoPipeline* pipeline, StateMachine** machines, size_t count);
+
+void pheno_pipeline_get_stats(PhenoPipeline* pipeline, PhenoPipelineStats* stats);
+
+// Pipeline used by process_token_operations() (empty unless replaced)
+PhenoPipeline* pheno_pipeline_default(void);
+void pheno_pipeline_set_default(PhenoPipeline* pipeline);
+
+// Built-in stages
+uint64_t pheno_pipeline_checksum(const void* data, size_t size);
+void pheno_stage_checksum(PhenoSpan* spans, size_t count, void* ctx);  // ctx: _Atomic uint64_t*
+void pheno_stage_fill(PhenoSpan* spans, size_t count, void* ctx);      // ctx: const uint8_t*
+void pheno_stage_xor(PhenoSpan* spans, size_t count, void* ctx);       // ctx: const uint8_t*
+
+#endif // PHENO_PIPELINE_H
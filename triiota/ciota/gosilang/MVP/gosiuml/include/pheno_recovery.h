@@ -0,0 +1,58 @@
+#ifndef PHENO_RECOVERY_H
+#define PHENO_RECOVERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "phenomemory_platform.h"
+
+// Degradation recovery scheduler
+// A hierarchical timer wheel (4 levels x 64 slots) holds one entry per
+// attached machine. Machines that enter DEGRADED are scheduled with
+// exponential backoff; due machines are stepped with EVENT_RECOVER in
+// batches by a single background thread. After max_attempts failed
+// recoveries the scheduler sends EVENT_FREE so the machine retires once
+// its retry budget is spent instead of lingering in DEGRADED.
+#define PHENO_WHEEL_LEVELS     4
+#define PHENO_WHEEL_SLOT_BITS  6
+#define PHENO_WHEEL_SLOTS      (1 << PHENO_WHEEL_SLOT_BITS)
+
+typedef struct PhenoRecoveryScheduler PhenoRecoveryScheduler;
+
+typedef struct {
+    uint32_t tick_ms;         // Wheel resolution
+    uint32_t base_delay_ms;   // Delay before the first attempt
+    uint32_t max_delay_ms;    // Backoff cap
+    uint32_t max_attempts;    // Failed attempts before retiring the machine
+    uint32_t batch_size;      // Machines stepped per lock acquisition
+} PhenoRecoveryConfig;
+
+typedef struct {
+    uint64_t scheduled;       // Entries placed on the wheel
+    uint64_t attempts;        // EVENT_RECOVER steps issued
+    uint64_t recovered;       // Machines that left DEGRADED for ACTIVE
+    uint64_t retired;         // Machines that reached FREED
+    uint64_t batches;
+    uint64_t pending;         // Entries currently on the wheel
+    uint64_t attached;
+} PhenoRecoveryStats;
+
+void pheno_recovery_config_defaults(PhenoRecoveryConfig* config);
+
+// Lifecycle
+PhenoRecoveryScheduler* pheno_recovery_create(const PhenoRecoveryConfig* config);
+bool pheno_recovery_start(PhenoRecoveryScheduler* sched);
+void pheno_recovery_stop(PhenoRecoveryScheduler* sched);
+void pheno_recovery_destroy(PhenoRecoveryScheduler* sched);
+
+// Machines attach once; entering DEGRADED then schedules them automatically.
+// destroy_state_machine() detaches, waiting out an in-flight attempt.
+bool pheno_recovery_attach(PhenoRecoveryScheduler* sched, StateMachine* sm);
+void pheno_recovery_detach(StateMachine* sm);
+void pheno_recovery_notify_degraded(StateMachine* sm);
+
+// Process due entries on the calling thread (for callers without start())
+size_t pheno_recovery_poll(PhenoRecoveryScheduler* sched);
+void pheno_recovery_get_stats(PhenoRecoveryScheduler* sched, PhenoRecoveryStats* stats);
+
+#endif // PHENO_RECOVERY_H
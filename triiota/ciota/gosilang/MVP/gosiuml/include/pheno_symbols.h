@@ -0,0 +1,32 @@
+#ifndef PHENO_SYMBOLS_H
+#define PHENO_SYMBOLS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Interned names with dense ids
+// Ids start at 1 in first-intern order, so they can index side tables
+// directly; 0 is reserved for "no symbol". Names are stored once,
+// NUL-terminated and unbounded in length. A table is not thread-safe:
+// parallel producers intern into their own table and remap on merge.
+typedef uint32_t PhenoSymbol;
+#define PHENO_SYMBOL_NONE 0
+
+typedef struct PhenoSymbolTable PhenoSymbolTable;
+
+PhenoSymbolTable* pheno_symbols_create(void);
+void pheno_symbols_destroy(PhenoSymbolTable* table);
+
+PhenoSymbol pheno_symbols_intern(PhenoSymbolTable* table, const char* name, size_t len);
+PhenoSymbol pheno_symbols_find(const PhenoSymbolTable* table, const char* name, size_t len);
+
+const char* pheno_symbols_name(const PhenoSymbolTable* table, PhenoSymbol symbol);
+size_t pheno_symbols_length(const PhenoSymbolTable* table, PhenoSymbol symbol);
+size_t pheno_symbols_count(const PhenoSymbolTable* table);
+
+// Intern every symbol of src into dst; remap[i] receives the dst id of src
+// symbol i (remap must hold pheno_symbols_count(src) + 1 entries)
+bool pheno_symbols_merge(PhenoSymbolTable* dst, const PhenoSymbolTable* src, PhenoSymbol* remap);
+
+#endif // PHENO_SYMBOLS_H
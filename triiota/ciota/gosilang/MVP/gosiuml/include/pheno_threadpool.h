@@ -0,0 +1,40 @@
+#ifndef PHENO_THREADPOOL_H
+#define PHENO_THREADPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Fixed-size worker pool with task groups
+// Tasks are submitted against a group and the submitter waits on that
+// group only, so several callers can share one pool. A waiting thread
+// runs queued tasks itself instead of blocking, which keeps nested use
+// from a worker thread deadlock-free.
+typedef struct PhenoThreadPool PhenoThreadPool;
+typedef void (*PhenoTaskFunc)(void* arg);
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t done;
+    size_t pending;
+} PhenoTaskGroup;
+
+int pheno_cpu_count(void);
+
+// threads <= 0 uses one worker per online CPU
+PhenoThreadPool* pheno_threadpool_create(int threads);
+void pheno_threadpool_destroy(PhenoThreadPool* pool);
+int pheno_threadpool_size(const PhenoThreadPool* pool);
+
+// Process-wide pool, created on first use
+PhenoThreadPool* pheno_threadpool_default(void);
+
+void pheno_taskgroup_init(PhenoTaskGroup* group);
+void pheno_taskgroup_destroy(PhenoTaskGroup* group);
+
+// Runs func inline if the task cannot be queued
+void pheno_threadpool_submit(PhenoThreadPool* pool, PhenoTaskGroup* group,
+                             PhenoTaskFunc func, void* arg);
+void pheno_taskgroup_wait(PhenoThreadPool* pool, PhenoTaskGroup* group);
+
+#endif // PHENO_THREADPOOL_H
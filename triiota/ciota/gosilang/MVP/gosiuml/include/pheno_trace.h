@@ -0,0 +1,81 @@
+#ifndef PHENO_TRACE_H
+#define PHENO_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Static tracepoints
+// With systemtap's <sys/sdt.h> available each PHENO_TRACE site becomes a
+// single nop plus an ELF note naming provider "gosiuml", so bpftrace or
+// perf can attach to a running binary:
+//   bpftrace -e 'usdt:./bin/gosiuml:gosiuml:token_alloc { @[arg1] = count(); }'
+//   perf probe -x ./bin/gosiuml sdt_gosiuml:transition
+// Without the header (or with -DPHENO_NO_SDT) the sites compile to nothing.
+//
+//   token_alloc   (token, size, zone)      token_free   (token, id)
+//   token_lock    (token, owner)           token_unlock (token)
+//   transition    (machine, from, to, event)
+//   phase_begin   (phase)                  phase_end    (phase, ns)
+#if defined(__has_include) && !defined(PHENO_NO_SDT)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PHENO_TRACE_SDT 1
+#endif
+#endif
+
+#ifdef PHENO_TRACE_SDT
+#define PHENO_TRACE1(name, a)          STAP_PROBE1(gosiuml, name, a)
+#define PHENO_TRACE2(name, a, b)       STAP_PROBE2(gosiuml, name, a, b)
+#define PHENO_TRACE3(name, a, b, c)    STAP_PROBE3(gosiuml, name, a, b, c)
+#define PHENO_TRACE4(name, a, b, c, d) STAP_PROBE4(gosiuml, name, a, b, c, d)
+#else
+#define PHENO_TRACE1(name, a)          ((void)sizeof(a))
+#define PHENO_TRACE2(name, a, b)       ((void)sizeof(a), (void)sizeof(b))
+#define PHENO_TRACE3(name, a, b, c)    ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c))
+#define PHENO_TRACE4(name, a, b, c, d) \
+    ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c), (void)sizeof(d))
+#endif
+
+// Phases: coarse units of work bracketed by pheno_phase_begin/end. Each
+// boundary fires a tracepoint; while transition stats are enabled the
+// phase is also timed, and in perf mode the calling thread's cycle and
+// cache-miss counters (perf_event_open, user space only) are read at both
+// ends. Phases run on the thread that calls the public entry point.
+typedef enum {
+    PHENO_PHASE_PARSE,             // gosiuml_parse_document()
+    PHENO_PHASE_LAYOUT,            // layout_document()
+    PHENO_PHASE_RENDER,            // SVG output of a layout
+    PHENO_PHASE_EXPORT,            // XML/JSON output of a document
+    PHENO_PHASE_COUNT
+} PhenoPhase;
+
+typedef struct {
+    uint64_t count;
+    uint64_t ns;                   // Wall time across all runs
+    uint64_t counted;              // Runs that had perf counters
+    uint64_t cycles;
+    uint64_t cache_misses;
+} PhenoPhaseStats;
+
+typedef struct {
+    PhenoPhase phase;
+    uint64_t start_ns;             // 0 when the phase is not measured
+    uint64_t cycles;
+    uint64_t cache_misses;
+    bool counted;
+} PhenoPhaseScope;
+
+void pheno_phase_begin(PhenoPhaseScope* scope, PhenoPhase phase);
+void pheno_phase_end(PhenoPhaseScope* scope);
+const char* pheno_phase_name(PhenoPhase phase);
+
+void pheno_phase_stats_snapshot(PhenoPhaseStats stats[PHENO_PHASE_COUNT], bool reset);
+
+// Open the hardware counters for the calling thread and count phases on
+// every thread that can open them. Returns false (and stays off) when
+// perf_event_open is unavailable, e.g. under perf_event_paranoid or in a
+// VM without a PMU. Phases are still timed.
+bool pheno_perf_enable(bool enable);
+bool pheno_perf_enabled(void);
+
+#endif // PHENO_TRACE_H
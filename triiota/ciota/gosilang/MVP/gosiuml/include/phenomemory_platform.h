@@ -5,6 +5,10 @@
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <stdio.h>
+#include "pheno_histogram.h"
+#include "pheno_log.h"
+#include "pheno_trace.h"
 
 // Define atomic types for C11 compatibility
 typedef _Atomic uint32_t atomic_uint32_t;
@@ -14,6 +18,8 @@ typedef _Atomic unsigned int atomic_uint;
 // Forward declarations
 typedef struct PhenoToken PhenoToken;
 typedef struct StateMachine StateMachine;
+typedef struct PhenoPool PhenoPool;
+struct PhenoRecoveryEntry;
 
 // State enumeration - single definition
 typedef enum {
@@ -38,6 +44,9 @@ typedef enum {
     EVENT_FREE
 } PhenoEvent;
 
+#define PHENO_STATE_COUNT (STATE_FREED + 1)
+#define PHENO_EVENT_COUNT (EVENT_FREE + 1)
+
 // Substates for ACTIVE state
 typedef enum {
     SUBSTATE_NONE,
@@ -46,10 +55,22 @@ typedef enum {
     SUBSTATE_TRANSFORMING
 } PhenoSubstate;
 
+#define PHENO_SUBSTATE_COUNT (SUBSTATE_TRANSFORMING + 1)
+
 // Memory zones
 #define MAX_MEMORY_ZONES 16
 #define ZONE_MASK 0x0F
 
+// Pool size classes: power-of-two blocks from 64B to 64KB are recycled
+// through per-class free lists, larger blocks are bump-allocated only
+#define POOL_MIN_CLASS_SHIFT 6
+#define POOL_MAX_CLASS_SHIFT 16
+#define POOL_SIZE_CLASSES    (POOL_MAX_CLASS_SHIFT - POOL_MIN_CLASS_SHIFT + 1)
+
+// Hot-path diagnostics: queued to the asynchronous log at debug level,
+// toggled by gosiuml_set_debug() (on by default)
+#define PHENO_DEBUG(...) PHENO_LOG(PHENO_LOG_DEBUG, __VA_ARGS__)
+
 // Bitfield positions for atomic flags
 #define FLAG_NIL_BIT        0
 #define FLAG_ALLOCATED_BIT  1
@@ -157,11 +178,17 @@ struct PhenoToken {
     pthread_t thread_owner;
     void* data_ptr;
     size_t data_size;
+    uint32_t type_symbol;   // Interned type name (document symbol table)
+    uint32_t zone_symbol;   // Interned zone name
 };
 
+// Every initialized machine holds one token of this size, so n machines
+// need pheno_pool_size_for(n, PHENO_MACHINE_TOKEN_SIZE) pool bytes
+#define PHENO_MACHINE_TOKEN_SIZE 4096
+
 // State Machine structure
 struct StateMachine {
-    PhenoState current_state;
+    _Atomic PhenoState current_state;  // Written under mutex, readable anywhere
     PhenoSubstate current_substate;
     PhenoToken* token;
     pthread_mutex_t mutex;
@@ -169,6 +196,9 @@ struct StateMachine {
     uint32_t retry_count;
     float confidence_score;
     bool is_initialized;
+    uint64_t state_entered_ns;  // Monotonic entry time (0 = not tracked)
+    struct PhenoRecoveryEntry* recovery;  // Set by pheno_recovery_attach()
+    PhenoPool* pool;            // Token pool (NULL = process pool)
 };
 
 // Transition function type
@@ -187,9 +217,10 @@ static inline bool test_flag(MemFlags* flags, int bit) {
     return (atomic_load(&flags->flags) & (1U << bit)) != 0;
 }
 
+// Returns the previous value of the bit: true if it was already set
 static inline bool test_and_set_flag(MemFlags* flags, int bit) {
     uint32_t old_val = atomic_fetch_or(&flags->flags, (1U << bit));
-    return (old_val & (1U << bit)) == 0;
+    return (old_val & (1U << bit)) != 0;
 }
 
 // Reference count operations
@@ -209,13 +240,93 @@ static inline uint32_t get_ref_count(MemFlags* flags) {
 StateMachine* create_state_machine(void);
 void destroy_state_machine(StateMachine* sm);
 bool initialize_state_machine(StateMachine* sm);
+bool reset_state_machine(StateMachine* sm);
 void step_state_machine(StateMachine* sm, PhenoEvent event);
+
+// Same, for callers that already hold sm->mutex so other work (journaling)
+// is ordered with the step
+bool reset_state_machine_locked(StateMachine* sm);
+void step_state_machine_locked(StateMachine* sm, PhenoEvent event);
 const char* get_state_name(PhenoState state);
 const char* get_event_name(PhenoEvent event);
 
-// Token operations
+// Transition instrumentation (compile out with -DPHENO_NO_TRANSITION_STATS).
+// Histograms are in nanoseconds; the struct is large, allocate it on the heap.
+// phases holds the parse/layout/render/export totals (see pheno_trace.h).
+typedef struct {
+    PhenoHistogramSnapshot transition_latency[PHENO_STATE_COUNT][PHENO_EVENT_COUNT];
+    PhenoHistogramSnapshot time_in_state[PHENO_STATE_COUNT];
+    PhenoPhaseStats phases[PHENO_PHASE_COUNT];
+} PhenoTransitionStats;
+
+void pheno_transition_stats_enable(bool enable);
+bool pheno_transition_stats_enabled(void);
+void pheno_transition_stats_snapshot(PhenoTransitionStats* out, bool reset);
+void pheno_transition_stats_reset(void);
+void pheno_transition_stats_print(FILE* out, const PhenoTransitionStats* stats);
+
+// Token operations (process pool)
 PhenoToken* pheno_token_alloc(uint32_t size);
 void pheno_token_free(PhenoToken* token);
+
+// Token pools. The process pool is shared and locked; a private pool
+// (shared = false) takes no lock and is used by one thread at a time.
+// Tokens go back to the pool they came from.
+#define PHENO_POOL_DEFAULT_SIZE (1u << 20)
+
+typedef struct {
+    size_t total_size;
+    size_t used_size;                // High-water mark of carved blocks
+    uint32_t active_tokens;
+} PhenoPoolUsage;
+
+PhenoPool* pheno_pool_default(void);
+PhenoPool* pheno_pool_create(size_t size, bool shared);   // size 0 = PHENO_POOL_DEFAULT_SIZE
+void pheno_pool_destroy(PhenoPool* pool);                 // Ignores the process pool
+PhenoToken* pheno_pool_token_alloc(PhenoPool* pool, uint32_t size);
+void pheno_pool_token_free(PhenoPool* pool, PhenoToken* token);
+void pheno_pool_usage(PhenoPool* pool, PhenoPoolUsage* usage);
+// Pool size that holds count live tokens of size bytes at once
+size_t pheno_pool_size_for(size_t count, uint32_t size);
+
+// Pool statistics. Allocators count into per-thread shards with relaxed
+// atomics; a snapshot sums the shards without taking the pool lock, so a
+// metrics thread never stalls allocation. Counters are read one at a time
+// and may be a few operations apart from each other.
+#define PHENO_POOL_STAT_SHARDS 16
+#define PHENO_POOL_LARGE_CLASS POOL_SIZE_CLASSES   // Blocks above 64KB, never recycled
+
+typedef struct {
+    uint64_t block_size;             // 0 for the large class
+    uint64_t carved;                 // Blocks cut from the pool
+    uint64_t live;                   // Blocks holding a token
+} PhenoSizeClassStats;
+
+typedef struct {
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t failures;               // Pool exhausted
+    uint64_t tokens_live;
+    uint64_t bytes_live;             // Requested payload bytes of live tokens
+    uint64_t pool_size;
+    uint64_t high_water;             // Carved bytes; blocks are recycled, never returned
+    uint64_t free_list_bytes;        // Carved blocks waiting for reuse
+    uint64_t internal_waste;         // Block bytes beyond the requested sizes
+    double fragmentation;            // Share of carved bytes not holding payload
+    uint64_t lock_acquisitions;      // Shared pools only
+    uint64_t lock_contended;
+    uint64_t lock_wait_ns;
+    PhenoSizeClassStats classes[POOL_SIZE_CLASSES + 1];
+} PhenoMemoryStats;
+
+void pheno_pool_stats_snapshot(PhenoPool* pool, PhenoMemoryStats* stats);
+void pheno_memory_stats_snapshot(PhenoMemoryStats* stats);   // Process pool
+
+// One JSON object; snprintf semantics (returns the full length)
+size_t pheno_memory_stats_json(const PhenoMemoryStats* stats, char* buffer, size_t size);
+
+void pheno_memory_stats(void);       // Process pool summary on stdout
+void pheno_memory_cleanup(void);
 bool pheno_token_lock(PhenoToken* token);
 void pheno_token_unlock(PhenoToken* token);
 bool pheno_token_validate(PhenoToken* token);
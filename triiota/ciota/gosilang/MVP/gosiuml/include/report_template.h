@@ -0,0 +1,66 @@
+#ifndef REPORT_TEMPLATE_H
+#define REPORT_TEMPLATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "svg_writer.h"
+
+// Precompiled report templates
+// A template is plain text with {{name:type}} placeholders (type defaults
+// to str). Compiling splits it once into literal segments and typed
+// slots; rendering queues the literals by reference and formats values
+// into the gaps, so a render is one writev per SvgWriter flush and never
+// rescans the text. Placeholders that share a name share a slot and must
+// agree on its type.
+//
+//   str   text, escaped for XML/HTML      json  text, escaped for JSON
+//   raw   text or an emit callback, verbatim
+//   int   int64_t     uint  uint64_t     hex   0x + 8 uppercase digits
+#define TEMPLATE_MAX_SLOTS 256        // Distinct placeholder names per template
+
+typedef enum {
+    TEMPLATE_STR,
+    TEMPLATE_JSON,
+    TEMPLATE_RAW,
+    TEMPLATE_INT,
+    TEMPLATE_UINT,
+    TEMPLATE_HEX
+} TemplateSlotType;
+
+typedef struct ReportTemplate ReportTemplate;
+
+// Value for one slot; a zeroed value renders as empty text or 0
+typedef struct {
+    const char* str;               // str/json/raw
+    size_t len;                    // 0 = strlen(str)
+    int64_t i;                     // int
+    uint64_t u;                    // uint/hex
+    void (*emit)(SvgWriter* w, void* user);  // raw: called instead of str when set
+    void* user;
+} TemplateValue;
+
+// NULL on a malformed template, with the reason in error
+ReportTemplate* template_compile(const char* text, size_t len, char* error, size_t error_size);
+void template_free(ReportTemplate* tpl);
+
+// Compile path on first use and return the shared compiled form after;
+// owned by the process until template_cache_clear(). Thread-safe.
+const ReportTemplate* template_load(const char* path, char* error, size_t error_size);
+void template_cache_clear(void);
+
+size_t template_slot_count(const ReportTemplate* tpl);
+
+// Slot index of name, or -1
+int template_slot(const ReportTemplate* tpl, const char* name);
+const char* template_slot_name(const ReportTemplate* tpl, size_t slot, size_t* len);
+TemplateSlotType template_slot_type(const ReportTemplate* tpl, size_t slot);
+
+// values holds template_slot_count() entries, indexed by slot. Literal
+// segments are queued by reference and must not be freed before w flushes.
+void template_render(const ReportTemplate* tpl, const TemplateValue* values, SvgWriter* w);
+
+// Returns 0 on success
+int template_render_file(const ReportTemplate* tpl, const TemplateValue* values, const char* path);
+
+#endif // REPORT_TEMPLATE_H
@@ -0,0 +1,81 @@
+#ifndef SVG_GENERATOR_H
+#define SVG_GENERATOR_H
+
+#include <stdint.h>
+#include <string.h>
+#include "phenomemory_platform.h"
+#include "pheno_symbols.h"
+#include "svg_writer.h"
+#include "layout_engine.h"
+
+// SVG building blocks shared by the full renderer and the tile writer.
+// Coordinates are canvas (world) pixels; a viewBox maps them to output.
+
+// XML declaration, <svg> over the world rectangle view_* drawn at
+// width x height pixels, stylesheet and background
+void svg_emit_prologue(SvgWriter* w, uint32_t view_x, uint32_t view_y,
+                       uint32_t view_w, uint32_t view_h, uint32_t width, uint32_t height);
+
+// Label of a token: its interned type name, or the sentinel when there is
+// no symbol table (tokens that never went through the parser)
+static inline const char* svg_token_name(const PhenoSymbolTable* symbols, const PhenoToken* token,
+                                         size_t* len) {
+    if (symbols && token->type_symbol) {
+        *len = pheno_symbols_length(symbols, token->type_symbol);
+        return pheno_symbols_name(symbols, token->type_symbol);
+    }
+    *len = strnlen(token->sentinel, sizeof(token->sentinel));
+    return token->sentinel;
+}
+
+// Token box with its top-left corner at (x, y); symbols may be NULL
+void svg_emit_token(SvgWriter* w, const PhenoSymbolTable* symbols, const PhenoToken* token,
+                    uint32_t x, uint32_t y);
+
+// Relations as centre-to-centre segments, batched into shared paths of
+// SVG_EDGES_PER_PATH, at most SVG_EDGE_BYTES each
+#define SVG_EDGES_PER_PATH 512
+#define SVG_EDGE_BYTES     48
+void svg_emit_edges(SvgWriter* w, const Layout* layout);
+
+void svg_emit_epilogue(SvgWriter* w);
+
+static inline uint32_t svg_pixel(float v) {
+    return v > 0 ? (uint32_t)(v + 0.5f) : 0;
+}
+
+// Tokens at their layout positions, relations drawn beneath the nodes.
+// symbols is the table the tokens' type_symbol ids refer to (a document's
+// symbols), or NULL. Returns 0 on success.
+int svg_render_layout(const PhenoToken* tokens, const PhenoSymbolTable* symbols,
+                      const Layout* layout, const char* output_file);
+
+// Incremental rendering
+// The cache keeps every token's rendered fragment with the XXH64 of what
+// it shows (id, type symbol and name, box position). A render reformats
+// only tokens whose hash changed and hands the rest to writev straight
+// from the fragment store, so formatting cost follows the change, not the
+// corpus.
+// Fragments of neighbouring tokens stay adjacent in the store and go out
+// as one segment; the relation layer is one block keyed by the edges and
+// positions. Output is byte-identical to svg_render_layout(). A cache is
+// not thread-safe.
+typedef struct SvgFragmentCache SvgFragmentCache;
+
+typedef struct {
+    size_t tokens;
+    size_t reformatted;            // Token fragments formatted this render
+    bool edges_reformatted;
+    uint64_t bytes;
+    double seconds;
+} SvgCacheStats;
+
+SvgFragmentCache* svg_cache_create(void);
+void svg_cache_destroy(SvgFragmentCache* cache);
+
+// Tokens are matched to fragments by layout index. Returns 0 on success.
+int svg_render_layout_cached(SvgFragmentCache* cache, const PhenoToken* tokens,
+                             const PhenoSymbolTable* symbols, const Layout* layout,
+                             const char* output_file, SvgCacheStats* stats);
+
+#endif // SVG_GENERATOR_H
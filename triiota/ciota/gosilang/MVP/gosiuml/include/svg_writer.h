@@ -0,0 +1,92 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/uio.h>
+
+// Buffered markup writer
+// Dynamic text is formatted straight into one large buffer; long constant
+// fragments (stylesheets, headers) are queued by reference instead of
+// copied. A flush hands every queued segment to a single writev().
+// Shared by the SVG, XML and JSON generators.
+#define SVG_WRITER_BUFFER     (1u << 20)
+#define SVG_WRITER_IOV        64
+#define SVG_WRITER_STATIC_MIN 256      // Shorter static fragments are copied
+
+typedef struct {
+    int fd;
+    char* buffer;
+    size_t used;
+    size_t capacity;
+    size_t segment;                // Start of buffered bytes not yet queued
+    struct iovec iov[SVG_WRITER_IOV];
+    int iov_count;
+    uint64_t bytes;                // Bytes handed to the kernel so far
+    uint64_t flushes;
+    bool failed;
+} SvgWriter;
+
+// Create/truncate path for writing
+bool svg_writer_open(SvgWriter* w, const char* path);
+
+// Writer over caller memory with no file behind it: a flush fails, so
+// buffer must hold the whole output. Bytes written are w->used.
+void svg_writer_init_memory(SvgWriter* w, char* buffer, size_t capacity);
+
+// Flush and close; false if any write failed
+bool svg_writer_close(SvgWriter* w);
+
+bool svg_writer_flush(SvgWriter* w);
+
+// Slow path of svg_reserve(): flush until n bytes fit
+char* svg_writer_make_room(SvgWriter* w, size_t n);
+
+// Bytes copied or queued by reference; s must outlive the next flush
+void svg_put_static(SvgWriter* w, const char* s, size_t len);
+
+void svg_put_u32(SvgWriter* w, uint32_t value);
+void svg_put_i32(SvgWriter* w, int32_t value);
+void svg_put_u64(SvgWriter* w, uint64_t value);
+
+// Eight uppercase hex digits
+void svg_put_hex32(SvgWriter* w, uint32_t value);
+
+// Text with &, <, >, " and ' replaced by entities; control characters
+// XML cannot carry are dropped
+void svg_put_escaped(SvgWriter* w, const char* s, size_t len);
+
+// JSON string body: quote, backslash and control characters escaped
+void svg_put_json_escaped(SvgWriter* w, const char* s, size_t len);
+
+// Room for n bytes at the returned pointer (NULL once the writer failed);
+// commit with w->used += written
+static inline char* svg_reserve(SvgWriter* w, size_t n) {
+    if (w->capacity - w->used >= n) return w->buffer + w->used;
+    return svg_writer_make_room(w, n);
+}
+
+static inline void svg_put(SvgWriter* w, const char* s, size_t len) {
+    if (len <= w->capacity - w->used) {
+        memcpy(w->buffer + w->used, s, len);
+        w->used += len;
+        return;
+    }
+    while (len > 0 && !w->failed) {
+        size_t room = w->capacity - w->used;
+        if (room == 0 && !svg_writer_flush(w)) return;
+        room = w->capacity - w->used;
+        size_t n = len < room ? len : room;
+        memcpy(w->buffer + w->used, s, n);
+        w->used += n;
+        s += n;
+        len -= n;
+    }
+}
+
+// String literals only
+#define svg_puts(w, lit) svg_put((w), (lit), sizeof(lit) - 1)
+
+#endif // SVG_WRITER_H
@@ -0,0 +1,56 @@
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "gosiuml.h"
+#include "layout_engine.h"
+
+// Tiled level-of-detail output
+// The layout canvas is treated as a square world; zoom z cuts it into
+// 2^z x 2^z tiles written as <dir>/<z>/<x>/<y>.svg, each rendered at
+// tile_size pixels. The finest zoom (detail_level) is the first one whose
+// busiest tile holds at most max_tile_nodes tokens and draws every token
+// and relation. Coarser zooms draw one aggregate per PhenoTokenType
+// cluster_id in each cell of a cells x cells grid per tile, joined by
+// aggregated relations weighted by count (the heaviest 4 x max_tile_nodes
+// per tile). Only non-empty tiles are
+// written; <dir>/index.json lists them per zoom so a viewer fetches just
+// the visible tiles. Tiles are rendered in parallel on the thread pool.
+#define TILE_MAX_LEVEL 10
+
+// Classification of a token; only cluster_id is used for aggregation
+typedef PhenoTokenType (*TileClassifier)(const PhenoToken* token, void* user);
+
+typedef struct {
+    char dir[1024];                // Output directory (created if missing)
+    uint32_t tile_size;            // Output pixels per tile side (0 = 512)
+    uint32_t max_tile_nodes;       // Detail level bound (0 = 1500)
+    uint32_t cells;                // Aggregation cells per tile side (0 = 8)
+    int levels;                    // Force the zoom count (0 = derive)
+    int threads;                   // 0 = default pool, 1 = serial on the caller
+    TileClassifier classify;       // NULL = tile_default_type()
+    void* user;
+    PhenoThreadPool* pool;         // Optional: used instead of a pool per threads
+} TileOptions;
+
+typedef struct {
+    uint32_t levels;
+    uint32_t detail_level;
+    uint64_t tiles;                // Files written, excluding index.json
+    uint64_t aggregates;           // Cluster nodes over all coarse zooms
+    uint64_t bytes;
+    double seconds;
+} TileStats;
+
+void tile_defaults(TileOptions* options);
+
+// cluster_id from the interned type name, so each token type aggregates
+// separately (types beyond 256 share clusters)
+PhenoTokenType tile_default_type(const PhenoToken* token, void* user);
+
+bool tile_pyramid_write(const GosiUMLDocument* doc, const Layout* layout,
+                        const TileOptions* options, TileStats* stats);
+
+#endif // TILE_PYRAMID_H
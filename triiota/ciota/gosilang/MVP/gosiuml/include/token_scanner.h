@@ -0,0 +1,111 @@
+#ifndef TOKEN_SCANNER_H
+#define TOKEN_SCANNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Zero-copy token file scanner
+// The file is mmap'd and split into lines with memchr; ids and numbers
+// are parsed by hand and string fields are returned as views into the
+// mapping, so nothing is copied and line length is unbounded.
+//
+//   TOKEN: 0x<id> <type> <zone>
+//   RELATION: 0x<src> -> 0x<dst> : <type>
+//
+// Blank lines and lines starting with '#' are skipped.
+
+// Non-terminated view into the scanned buffer
+typedef struct {
+    const char* ptr;
+    size_t len;
+} TokenScanView;
+
+typedef struct {
+    uint32_t id;
+    TokenScanView type;
+    TokenScanView zone;
+    uint32_t zone_value;       // Leading decimal digits of zone (atoi semantics)
+    uint64_t line;             // 1-based line number within the buffer
+} TokenScanToken;
+
+typedef struct {
+    uint32_t src_id;
+    uint32_t dst_id;
+    TokenScanView type;
+    uint64_t line;
+} TokenScanRelation;
+
+// Callbacks return false to stop scanning
+typedef struct {
+    bool (*on_token)(const TokenScanToken* token, void* user);
+    bool (*on_relation)(const TokenScanRelation* relation, void* user);
+    void* user;
+} TokenScanCallbacks;
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t lines;
+    uint64_t tokens;
+    uint64_t relations;
+    uint64_t malformed;        // TOKEN:/RELATION: lines that failed to parse
+    bool stopped;              // A callback returned false
+} TokenScanStats;
+
+// Read-only file mapping
+typedef struct {
+    const char* data;
+    size_t size;
+    int fd;
+} TokenScanFile;
+
+bool token_scan_open(TokenScanFile* file, const char* path);
+void token_scan_close(TokenScanFile* file);
+
+// Scan complete lines of data[0..size). A trailing line without '\n' is
+// only scanned when final is true. first_line numbers the first line.
+// Returns the number of bytes consumed (end of the last scanned line).
+size_t token_scan_buffer(const char* data, size_t size, bool final, uint64_t first_line,
+                         const TokenScanCallbacks* callbacks, TokenScanStats* stats);
+
+// Map and scan a whole file. Returns tokens found, or -1 if it cannot be opened.
+long token_scan_file(const char* path, const TokenScanCallbacks* callbacks,
+                     TokenScanStats* stats);
+
+// Incremental follower for append-only files
+// Remembers the consumed offset and the bytes of an unterminated last
+// line, so each poll scans only what was appended since the previous
+// one. The read range is fingerprinted by the XXH64 of its first and
+// last TOKEN_FOLLOW_BLOCK bytes; a file that shrinks, is replaced (new
+// inode) or no longer matches the fingerprint (rewritten in place or
+// truncated and regrown between polls, even to a longer file) is
+// rescanned from the start and counted in resets.
+#define TOKEN_FOLLOW_BLOCK 4096
+
+typedef struct {
+    char* path;
+    uint64_t offset;           // End of the last complete line consumed
+    uint64_t next_line;
+    uint64_t inode;
+    char* buffer;              // Carried partial line + read window
+    size_t carry;
+    size_t capacity;
+    uint64_t resets;
+    uint64_t fingerprint;      // Of the range ending at fingerprint_pos
+    uint64_t fingerprint_pos;  // offset + carry when taken, 0 = none
+    bool stale;                // Fingerprint could not be taken: start over next poll
+    TokenScanStats stats;      // Totals across polls
+} TokenFollower;
+
+bool token_follow_open(TokenFollower* follower, const char* path);
+void token_follow_close(TokenFollower* follower);
+
+// Scan bytes appended since the last poll. Returns tokens delivered, 0
+// when nothing new is available, or -1 if the file cannot be read.
+long token_follow_poll(TokenFollower* follower, const TokenScanCallbacks* callbacks);
+
+// Hand-written field parsers; advance *p and return false on no digits
+bool token_scan_hex32(const char** p, const char* end, uint32_t* out);
+bool token_scan_dec32(const char** p, const char* end, uint32_t* out);
+
+#endif // TOKEN_SCANNER_H
@@ -0,0 +1,68 @@
+#ifndef TOKEN_WATCH_H
+#define TOKEN_WATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "layout_engine.h"
+
+// inotify-driven re-rendering
+// Watched files are followed, not reread: a change parses only the bytes
+// appended since the last render, and a truncated or replaced file starts
+// over. Events are coalesced: after the first one the watcher keeps
+// draining the queue until it has been quiet for coalesce_ms or max_delay_ms
+// has passed since the first, so a burst of appends becomes one render.
+// Changed files are then rendered in parallel on the thread pool, each
+// through its own layout and SVG fragment cache. Latency is measured from
+// the first event of a batch to the moment the file's render is written.
+#define WATCH_COALESCE_MS  5
+#define WATCH_MAX_DELAY_MS 50
+
+typedef struct {
+    int threads;                   // Render workers: 0 = default pool, 1 = serial
+    LayoutMode layout;
+    const char* out_dir;           // NULL = next to each input
+    const char* suffix;            // Files of a watched directory (NULL = ".tok")
+    int coalesce_ms;               // 0 = WATCH_COALESCE_MS
+    int max_delay_ms;              // 0 = WATCH_MAX_DELAY_MS
+    bool quiet;                    // No per-render lines on stdout
+} WatchOptions;
+
+typedef struct {
+    uint64_t events;               // inotify events read
+    uint64_t batches;              // Coalesced batches rendered
+    uint64_t renders;
+    uint64_t failed;
+    uint64_t resets;               // Files parsed again from the start
+    uint64_t parsed_bytes;         // Bytes parsed by refreshes
+    uint64_t files;                // Files currently followed
+    uint64_t p50_ns;               // Event to rendered output
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} WatchStats;
+
+typedef struct TokenWatch TokenWatch;
+
+void watch_defaults(WatchOptions* options);
+TokenWatch* watch_create(const WatchOptions* options);
+void watch_destroy(TokenWatch* watch);
+
+// Watch a token file, or every suffix file of a directory (files created
+// later included). Files that already exist are rendered by the next poll.
+bool watch_add(TokenWatch* watch, const char* path);
+
+// Wait up to timeout_ms (-1 = forever) for changes, coalesce, and render
+// what changed. Returns files rendered, 0 on timeout or watch_stop(), -1
+// on error.
+int watch_poll(TokenWatch* watch, int timeout_ms);
+
+// Poll until watch_stop()
+int watch_run(TokenWatch* watch);
+
+// Wake watch_poll()/watch_run() from any thread; async-signal-safe
+void watch_stop(TokenWatch* watch);
+
+// From the polling thread
+void watch_get_stats(TokenWatch* watch, WatchStats* stats);
+
+#endif // TOKEN_WATCH_H
@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include "gosiuml.h"
+#include "load_generator.h"
+
+// Holds workers until every thread exists so they start together
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool open;
+} StartGate;
+
+typedef struct {
+    const LoadGenConfig* config;
+    StateMachine** machines;        // Full machine array (journal ids are indices)
+    size_t shared_count;            // machines[0 .. shared_count) are shared
+    uint32_t* private_ids;          // Indices owned by this worker
+    size_t private_count;
+    uint32_t cdf[PHENO_EVENT_COUNT];
+    uint32_t total_weight;
+    uint64_t step_budget;
+    uint64_t shared_threshold;      // shared_ratio scaled to 2^32
+    StartGate* gate;
+    uint64_t rng;
+
+    // Results
+    uint64_t steps;
+    uint64_t transitions;
+    uint64_t recycled;
+    uint64_t shared_steps;
+    PhenoHistogramSnapshot latency;
+} LoadGenWorker;
+
+static const char* const k_event_keys[PHENO_EVENT_COUNT] = {
+    "alloc", "lock", "unlock", "validate", "degrade", "recover", "share", "free"
+};
+
+// xorshift64* - cheap per-thread generator
+static inline uint64_t worker_rand(LoadGenWorker* w) {
+    w->rng ^= w->rng >> 12;
+    w->rng ^= w->rng << 25;
+    w->rng ^= w->rng >> 27;
+    return w->rng * 0x2545F4914F6CDD1DULL;
+}
+
+void load_generator_defaults(LoadGenConfig* config) {
+    if (!config) return;
+
+    memset(config, 0, sizeof(*config));
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    config->threads = cpus > 0 ? (int)cpus : 1;
+    config->machines = 1024;
+    config->shared_ratio = 0.25;
+    config->duration_sec = 2.0;
+    config->seed = 0x5EED;
+
+    // Lifecycle-heavy default mix
+    static const uint32_t mix[PHENO_EVENT_COUNT] = { 15, 15, 10, 15, 5, 5, 10, 25 };
+    memcpy(config->event_weights, mix, sizeof(mix));
+}
+
+// "alloc:20/lock:20/free:10" (',' '/' separate, ':' or '=' assign).
+// Events not mentioned get weight 0.
+bool load_generator_parse_mix(const char* spec, uint32_t weights[PHENO_EVENT_COUNT]) {
+    if (!spec || !weights) return false;
+
+    uint32_t parsed[PHENO_EVENT_COUNT] = {0};
+    const char* p = spec;
+    while (*p) {
+        const char* end = p + strcspn(p, ",/");
+        const char* sep = memchr(p, ':', (size_t)(end - p));
+        if (!sep) sep = memchr(p, '=', (size_t)(end - p));
+        if (!sep) return false;
+
+        int event = -1;
+        for (int e = 0; e < PHENO_EVENT_COUNT; e++) {
+            size_t len = strlen(k_event_keys[e]);
+            if ((size_t)(sep - p) == len && strncasecmp(p, k_event_keys[e], len) == 0) {
+                event = e;
+                break;
+            }
+        }
+        if (event < 0) return false;
+        parsed[event] = (uint32_t)strtoul(sep + 1, NULL, 10);
+
+        p = *end ? end + 1 : end;
+    }
+
+    uint32_t total = 0;
+    for (int e = 0; e < PHENO_EVENT_COUNT; e++) total += parsed[e];
+    if (total == 0) return false;
+
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+// "threads=8,machines=4096,shared=0.1,duration=5,steps=0,mix=...,seed=1,json=out.json"
+bool load_generator_parse_spec(const char* spec, LoadGenConfig* config) {
+    if (!spec || !config) return false;
+
+    char* copy = strdup(spec);
+    if (!copy) return false;
+
+    bool ok = true;
+    char* save = NULL;
+    for (char* item = strtok_r(copy, ",", &save); item && ok;
+         item = strtok_r(NULL, ",", &save)) {
+        char* value = strchr(item, '=');
+        if (!value) {
+            ok = false;
+            break;
+        }
+        *value++ = '\0';
+
+        if (strcmp(item, "threads") == 0) {
+            config->threads = atoi(value);
+        } else if (strcmp(item, "machines") == 0) {
+            config->machines = atoi(value);
+        } else if (strcmp(item, "shared") == 0) {
+            config->shared_ratio = atof(value);
+        } else if (strcmp(item, "duration") == 0) {
+            config->duration_sec = atof(value);
+        } else if (strcmp(item, "steps") == 0) {
+            config->max_steps = strtoull(value, NULL, 10);
+        } else if (strcmp(item, "mix") == 0) {
+            ok = load_generator_parse_mix(value, config->event_weights);
+        } else if (strcmp(item, "seed") == 0) {
+            config->seed = strtoull(value, NULL, 0);
+        } else if (strcmp(item, "json") == 0) {
+            snprintf(config->json_path, sizeof(config->json_path), "%s", value);
+        } else {
+            ok = false;
+        }
+    }
+
+    free(copy);
+    if (!ok) fprintf(stderr, "Invalid load spec: %s\n", spec);
+    return ok;
+}
+
+static void* worker_run(void* arg) {
+    LoadGenWorker* w = arg;
+    const LoadGenConfig* config = w->config;
+
+    pthread_mutex_lock(&w->gate->mutex);
+    while (!w->gate->open) pthread_cond_wait(&w->gate->cond, &w->gate->mutex);
+    pthread_mutex_unlock(&w->gate->mutex);
+
+    uint64_t now = pheno_monotonic_ns();
+    uint64_t deadline = config->duration_sec > 0.0
+        ? now + (uint64_t)(config->duration_sec * 1e9)
+        : UINT64_MAX;
+
+    while (now < deadline && (w->step_budget == 0 || w->steps < w->step_budget)) {
+        uint64_t r = worker_rand(w);
+
+        // Pick a machine: shared with probability shared_ratio
+        uint32_t id;
+        bool shared = w->shared_count > 0 &&
+                      (w->private_count == 0 || (r & 0xFFFFFFFFu) < w->shared_threshold);
+        if (shared) {
+            id = (uint32_t)((r >> 32) % w->shared_count);
+            w->shared_steps++;
+        } else {
+            id = w->private_ids[(r >> 32) % w->private_count];
+        }
+        StateMachine* sm = w->machines[id];
+
+        // Pick an event from the mix
+        uint32_t pick = (uint32_t)(worker_rand(w) % w->total_weight);
+        int event = 0;
+        while (pick >= w->cdf[event]) event++;
+
+        // Journal records are written under the machine lock so the journal
+        // holds each machine's events, resets included, in the order they
+        // were applied. Latency covers the lock wait and the step.
+        uint64_t start = pheno_monotonic_ns();
+        pthread_mutex_lock(&sm->mutex);
+        PhenoState before = sm->current_state;
+        if (config->journal) {
+            pheno_journal_record(config->journal, id, (PhenoEvent)event);
+        }
+        step_state_machine_locked(sm, (PhenoEvent)event);
+        PhenoState after = sm->current_state;
+        now = pheno_monotonic_ns();
+        if (after == STATE_FREED) {
+            if (config->journal) pheno_journal_record_reset(config->journal, id);
+            if (reset_state_machine_locked(sm)) w->recycled++;
+        }
+        pthread_mutex_unlock(&sm->mutex);
+
+        pheno_hist_snapshot_record(&w->latency, now - start);
+        w->steps++;
+        if (after != before) w->transitions++;
+    }
+
+    return NULL;
+}
+
+bool load_generator_run(const LoadGenConfig* config, LoadGenResult* result) {
+    if (!config || !result || config->threads < 1 || config->machines < 1) return false;
+
+    uint32_t total_weight = 0;
+    for (int e = 0; e < PHENO_EVENT_COUNT; e++) total_weight += config->event_weights[e];
+    if (total_weight == 0) return false;
+
+    int threads = config->threads;
+    size_t machine_count = (size_t)config->machines;
+    double ratio = config->shared_ratio < 0.0 ? 0.0 :
+                   config->shared_ratio > 1.0 ? 1.0 : config->shared_ratio;
+    size_t shared_count = (size_t)(ratio * (double)machine_count + 0.5);
+
+    StateMachine** machines = calloc(machine_count, sizeof(StateMachine*));
+    LoadGenWorker* workers = calloc((size_t)threads, sizeof(LoadGenWorker));
+    uint32_t* private_ids = malloc((machine_count + 1) * sizeof(uint32_t));
+    pthread_t* tids = calloc((size_t)threads, sizeof(pthread_t));
+    if (!machines || !workers || !private_ids || !tids) {
+        free(machines);
+        free(workers);
+        free(private_ids);
+        free(tids);
+        return false;
+    }
+
+    // Tokens come from a pool sized for the machine set rather than the
+    // process pool, which only holds a few thousand machine tokens. Each
+    // machine holds one token at a time, so steps and recycles never
+    // exhaust it. Results from a partly initialized set would be
+    // meaningless, so any failure here aborts the run.
+    PhenoPool* pool = pheno_pool_create(pheno_pool_size_for(machine_count, PHENO_MACHINE_TOKEN_SIZE),
+                                        true);
+    size_t uninitialized = pool ? 0 : machine_count;
+    for (size_t m = 0; pool && m < machine_count; m++) {
+        machines[m] = create_state_machine();
+        if (machines[m]) machines[m]->pool = pool;
+        if (!machines[m] || !initialize_state_machine(machines[m])) uninitialized++;
+    }
+    if (uninitialized) {
+        fprintf(stderr, "[LOADGEN] %zu of %zu machines could not get a token\n",
+                uninitialized, machine_count);
+        for (size_t m = 0; m < machine_count; m++) destroy_state_machine(machines[m]);
+        pheno_pool_destroy(pool);
+        free(machines);
+        free(workers);
+        free(private_ids);
+        free(tids);
+        return false;
+    }
+
+    // Deal private machines round-robin so slices stay contiguous per worker
+    size_t cursor = 0;
+    for (int t = 0; t < threads; t++) {
+        LoadGenWorker* w = &workers[t];
+        w->private_ids = private_ids + cursor;
+        for (size_t m = shared_count + (size_t)t; m < machine_count; m += (size_t)threads) {
+            private_ids[cursor++] = (uint32_t)m;
+        }
+        w->private_count = (size_t)(private_ids + cursor - w->private_ids);
+
+        // Nothing private and nothing shared: fall back to the whole set
+        if (w->private_count == 0 && shared_count == 0) {
+            w->shared_count = machine_count;
+        } else {
+            w->shared_count = shared_count;
+        }
+    }
+    StartGate gate = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false };
+
+    for (int t = 0; t < threads; t++) {
+        LoadGenWorker* w = &workers[t];
+        w->config = config;
+        w->machines = machines;
+        w->gate = &gate;
+        w->total_weight = total_weight;
+        w->shared_threshold = (uint64_t)(ratio * 4294967296.0);
+        w->rng = (config->seed + 1) * 0x9E3779B97F4A7C15ULL + (uint64_t)t * 0xBF58476D1CE4E5B9ULL;
+        if (w->rng == 0) w->rng = 1;
+        uint32_t acc = 0;
+        for (int e = 0; e < PHENO_EVENT_COUNT; e++) {
+            acc += config->event_weights[e];
+            w->cdf[e] = acc;
+        }
+        if (config->max_steps) {
+            w->step_budget = config->max_steps / (uint64_t)threads +
+                             ((uint64_t)t < config->max_steps % (uint64_t)threads ? 1 : 0);
+            if (w->step_budget == 0) w->step_budget = 1;
+        }
+    }
+
+    // Hot-path diagnostics would dominate the measurement
+    PhenoLogLevel was_level = pheno_log_get_level();
+    gosiuml_set_debug(false);
+
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, worker_run, &workers[t]) != 0) break;
+        started++;
+    }
+
+    bool ok = started == threads;
+    if (!ok) {
+        fprintf(stderr, "[LOADGEN] Could only start %d of %d threads\n", started, threads);
+    }
+
+    pthread_mutex_lock(&gate.mutex);
+    gate.open = true;
+    uint64_t start = pheno_monotonic_ns();
+    pthread_cond_broadcast(&gate.cond);
+    pthread_mutex_unlock(&gate.mutex);
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    uint64_t elapsed = pheno_monotonic_ns() - start;
+
+    pheno_log_set_level(was_level);
+
+    memset(result, 0, sizeof(*result));
+    for (int t = 0; t < started; t++) {
+        result->steps += workers[t].steps;
+        result->transitions += workers[t].transitions;
+        result->recycled += workers[t].recycled;
+        result->shared_steps += workers[t].shared_steps;
+        pheno_hist_snapshot_merge(&result->latency, &workers[t].latency);
+    }
+    result->elapsed_sec = (double)elapsed / 1e9;
+    result->steps_per_sec = elapsed ? (double)result->steps * 1e9 / (double)elapsed : 0.0;
+
+    for (size_t m = 0; m < machine_count; m++) {
+        result->final_states[machines[m]->current_state]++;
+        destroy_state_machine(machines[m]);
+    }
+    pheno_pool_destroy(pool);
+    free(machines);
+    free(workers);
+    free(private_ids);
+    free(tids);
+    return ok;
+}
+
+void load_generator_print(FILE* out, const LoadGenConfig* config, const LoadGenResult* result) {
+    if (!out || !config || !result) return;
+
+    fprintf(out, "\nLoad Generator Results:\n");
+    fprintf(out, "  Threads:      %d\n", config->threads);
+    fprintf(out, "  Machines:     %d (%.0f%% shared)\n", config->machines,
+            config->shared_ratio * 100.0);
+    fprintf(out, "  Steps:        %llu (%llu shared)\n",
+            (unsigned long long)result->steps, (unsigned long long)result->shared_steps);
+    fprintf(out, "  Transitions:  %llu\n", (unsigned long long)result->transitions);
+    fprintf(out, "  Recycled:     %llu\n", (unsigned long long)result->recycled);
+    fprintf(out, "  Time:         %.3f seconds\n", result->elapsed_sec);
+    fprintf(out, "  Throughput:   %.1f steps/sec\n", result->steps_per_sec);
+    fprintf(out, "  Step latency: p50=%lluns p99=%lluns p999=%lluns max=%lluns\n",
+            (unsigned long long)pheno_hist_percentile(&result->latency, 50.0),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 99.0),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 99.9),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 100.0));
+}
+
+bool load_generator_write_json(FILE* out, const LoadGenConfig* config, const LoadGenResult* result) {
+    if (!out || !config || !result) return false;
+
+    fprintf(out, "{\"config\":{\"threads\":%d,\"machines\":%d,\"shared_ratio\":%.4f,"
+                 "\"duration_sec\":%.3f,\"max_steps\":%llu,\"seed\":%llu,\"mix\":{",
+            config->threads, config->machines, config->shared_ratio,
+            config->duration_sec, (unsigned long long)config->max_steps,
+            (unsigned long long)config->seed);
+    for (int e = 0; e < PHENO_EVENT_COUNT; e++) {
+        fprintf(out, "%s\"%s\":%u", e ? "," : "", k_event_keys[e], config->event_weights[e]);
+    }
+    fprintf(out, "}},\"results\":{\"steps\":%llu,\"shared_steps\":%llu,\"transitions\":%llu,"
+                 "\"recycled\":%llu,\"elapsed_sec\":%.6f,\"steps_per_sec\":%.1f,"
+                 "\"latency_ns\":{\"mean\":%llu,\"p50\":%llu,\"p99\":%llu,"
+                 "\"p999\":%llu,\"max\":%llu}}}\n",
+            (unsigned long long)result->steps,
+            (unsigned long long)result->shared_steps,
+            (unsigned long long)result->transitions,
+            (unsigned long long)result->recycled,
+            result->elapsed_sec, result->steps_per_sec,
+            (unsigned long long)pheno_hist_mean(&result->latency),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 50.0),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 99.0),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 99.9),
+            (unsigned long long)pheno_hist_percentile(&result->latency, 100.0));
+    return !ferror(out);
+}
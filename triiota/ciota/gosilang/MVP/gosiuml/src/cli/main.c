@@ -1,13 +1,47 @@
+#define _GNU_SOURCE  // nftw()
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <unistd.h>
-#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <signal.h>
+#include <pthread.h>
 #include "phenomemory_platform.h"
+#include "gosiuml.h"
+#include "pheno_journal.h"
+#include "load_generator.h"
+#include "pheno_recovery.h"
+#include "pheno_pipeline.h"
+#include "pheno_threadpool.h"
+#include "token_scanner.h"
+#include "gosib.h"
+#include "parse_cache.h"
+#include "svg_writer.h"
+#include "svg_generator.h"
+#include "tile_pyramid.h"
+#include "report_template.h"
+#include "batch_render.h"
+#include "gosiuml_daemon.h"
+#include "token_watch.h"
 
-// External functions
-void pheno_memory_stats(void);
-void pheno_memory_cleanup(void);
+// Journal recorded by the stress test (-J)
+static PhenoJournalWriter* g_journal = NULL;
+static int g_replay_threads = 1;
+static ParseCacheConfig* g_parse_cache = NULL;
+static const char* g_svg_output = NULL;
+static LayoutMode g_layout_mode = LAYOUT_AUTO;
+static GosiUMLDaemon* g_daemon = NULL;
+static const char* g_client_socket = NULL;
+static int g_client_repeat = 1;
+static const char* g_memory_json = NULL;
+static TokenWatch* g_watch = NULL;
+static const char* g_tile_dir = NULL;
+static const char* g_template = NULL;
 
 // Test scenarios
 void test_basic_transitions(void) {
@@ -66,6 +100,1960 @@ void test_degradation_recovery(void) {
     destroy_state_machine(sm);
 }
 
+void test_recovery_scheduler(void) {
+    printf("\n=== Testing Recovery Scheduler ===\n");
+    
+    PhenoRecoveryConfig config;
+    pheno_recovery_config_defaults(&config);
+    config.base_delay_ms = 2;
+    
+    PhenoRecoveryScheduler* sched = pheno_recovery_create(&config);
+    if (!sched) return;
+    pheno_recovery_start(sched);
+    
+    StateMachine* sm = create_state_machine();
+    initialize_state_machine(sm);
+    pheno_recovery_attach(sched, sm);
+    
+    step_state_machine(sm, EVENT_ALLOC);
+    step_state_machine(sm, EVENT_LOCK);
+    step_state_machine(sm, EVENT_VALIDATE);
+    sm->retry_count = 61;
+    step_state_machine(sm, EVENT_DEGRADE);
+    
+    // No EVENT_RECOVER is sent; the scheduler must bring it back
+    PhenoRecoveryStats stats = {0};
+    for (int i = 0; i < 200 && stats.recovered == 0; i++) {
+        usleep(1000);
+        pheno_recovery_get_stats(sched, &stats);
+    }
+    printf("Scheduled: %llu, attempts: %llu, recovered: %llu, state: %s (%s)\n",
+           (unsigned long long)stats.scheduled, (unsigned long long)stats.attempts,
+           (unsigned long long)stats.recovered, get_state_name(sm->current_state),
+           (stats.recovered == 1 && sm->current_state == STATE_ACTIVE) ? "expected" : "UNEXPECTED");
+    
+    destroy_state_machine(sm);
+    pheno_recovery_destroy(sched);
+}
+
+void test_substate_pipeline(void) {
+    printf("\n=== Testing Substate Pipelines ===\n");
+    
+    enum { MACHINES = 8 };
+    StateMachine* machines[MACHINES];
+    for (int i = 0; i < MACHINES; i++) {
+        machines[i] = create_state_machine();
+        initialize_state_machine(machines[i]);
+        step_state_machine(machines[i], EVENT_ALLOC);
+        step_state_machine(machines[i], EVENT_LOCK);
+        step_state_machine(machines[i], EVENT_VALIDATE);
+    }
+    
+    static const uint8_t fill = 0xAB;
+    static const uint8_t key = 0xFF;
+    _Atomic uint64_t checksum = 0;
+    
+    PhenoPipeline* pipeline = pheno_pipeline_create();
+    pheno_pipeline_add_stage(pipeline, SUBSTATE_WRITING, "fill", pheno_stage_fill, (void*)&fill);
+    pheno_pipeline_add_stage(pipeline, SUBSTATE_TRANSFORMING, "xor", pheno_stage_xor, (void*)&key);
+    pheno_pipeline_add_stage(pipeline, SUBSTATE_READING, "checksum", pheno_stage_checksum, &checksum);
+    
+    // WRITING -> TRANSFORMING -> READING over the whole batch
+    PhenoSubstate order[] = { SUBSTATE_WRITING, SUBSTATE_TRANSFORMING, SUBSTATE_READING };
+    size_t processed = 0;
+    for (int pass = 0; pass < 3; pass++) {
+        for (int i = 0; i < MACHINES; i++) {
+            machines[i]->current_substate = order[pass];
+        }
+        processed += pheno_pipeline_run(pipeline, machines, MACHINES);
+    }
+    
+    // Payload was transformed in place: 0xAB ^ 0xFF everywhere
+    size_t size = machines[0]->token->data_size;
+    uint8_t* expected = malloc(size);
+    memset(expected, 0xAB ^ 0xFF, size);
+    uint64_t want = pheno_pipeline_checksum(expected, size) * MACHINES;
+    free(expected);
+    
+    // process_token_operations() dispatches through the default pipeline
+    pheno_pipeline_set_default(pipeline);
+    process_token_operations(machines[0]);
+    pheno_pipeline_set_default(NULL);
+    want += pheno_pipeline_checksum(machines[0]->token->data_ptr, size);
+    
+    PhenoPipelineStats stats;
+    pheno_pipeline_get_stats(pipeline, &stats);
+    printf("Processed %zu tokens in %llu batches, checksum %s (%s)\n",
+           processed, (unsigned long long)stats.batches,
+           atomic_load(&checksum) == want ? "match" : "mismatch",
+           (processed == 3 * MACHINES && atomic_load(&checksum) == want) ? "expected" : "UNEXPECTED");
+    
+    pheno_pipeline_destroy(pipeline);
+    for (int i = 0; i < MACHINES; i++) {
+        destroy_state_machine(machines[i]);
+    }
+}
+
+static bool count_token(const TokenScanToken* tok, void* user) {
+    uint64_t* sum = user;
+    *sum += tok->id + tok->zone_value + tok->type.len;
+    return true;
+}
+
+static bool count_relation(const TokenScanRelation* rel, void* user) {
+    uint64_t* sum = user;
+    *sum += rel->src_id + rel->dst_id + rel->type.len;
+    return true;
+}
+
+void test_token_scanner(void) {
+    printf("\n=== Testing Token Scanner ===\n");
+    
+    // Long type name, CRLF, comment, malformed line and an unterminated tail
+    char long_type[600];
+    memset(long_type, 'T', sizeof(long_type) - 1);
+    long_type[sizeof(long_type) - 1] = '\0';
+    
+    char buf[1024];
+    int len = snprintf(buf, sizeof(buf),
+                       "# header\n"
+                       "\n"
+                       "TOKEN: 0x0000000A %s 3\r\n"
+                       "TOKEN: 0xZZ broken 1\n"
+                       "RELATION: 0x0A -> 0x1F : owns\n"
+                       "TOKEN: 0xFF tail 7",
+                       long_type);
+    
+    uint64_t sum = 0;
+    TokenScanCallbacks callbacks = { count_token, count_relation, &sum };
+    TokenScanStats partial = {0};
+    size_t consumed = token_scan_buffer(buf, (size_t)len, false, 1, &callbacks, &partial);
+    TokenScanStats rest = {0};
+    token_scan_buffer(buf + consumed, (size_t)len - consumed, true, partial.lines + 1,
+                      &callbacks, &rest);
+    
+    uint64_t want = (0x0A + 3 + 599) + (0x0A + 0x1F + 4) + (0xFF + 7 + 4);
+    bool ok = partial.tokens == 1 && partial.relations == 1 && partial.malformed == 1 &&
+              rest.tokens == 1 && rest.lines == 1 && sum == want;
+    printf("Tokens: %llu+%llu, relations: %llu, malformed: %llu (%s)\n",
+           (unsigned long long)partial.tokens, (unsigned long long)rest.tokens,
+           (unsigned long long)partial.relations, (unsigned long long)partial.malformed,
+           ok ? "expected" : "UNEXPECTED");
+}
+
+static void append_text(const char* path, const char* mode, const char* text) {
+    FILE* fp = fopen(path, mode);
+    if (!fp) return;
+    fputs(text, fp);
+    fclose(fp);
+}
+
+void test_token_follow(void) {
+    printf("\n=== Testing Incremental Follow ===\n");
+    
+    char path[] = "/tmp/gosiuml_follow_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    close(fd);
+    
+    uint64_t sum = 0;
+    TokenScanCallbacks callbacks = { count_token, count_relation, &sum };
+    TokenFollower follower;
+    token_follow_open(&follower, path);
+    
+    // Second token is split across two appends
+    append_text(path, "a", "TOKEN: 0x01 NODE 1\nTOKEN: 0x0");
+    long first = token_follow_poll(&follower, &callbacks);
+    append_text(path, "a", "2 NODE 2\nRELATION: 0x01 -> 0x02 : uses\n");
+    long second = token_follow_poll(&follower, &callbacks);
+    long idle = token_follow_poll(&follower, &callbacks);
+    uint64_t offset = follower.offset;
+    
+    // Truncation restarts from the beginning
+    append_text(path, "w", "TOKEN: 0x03 NODE 3\n");
+    long after_reset = token_follow_poll(&follower, &callbacks);
+    
+    // Truncate and regrow past the old offset on the same inode: the tail
+    // no longer matches, so this is a reset rather than an append
+    append_text(path, "w", "TOKEN: 0x04 NODE 4\nTOKEN: 0x05 NODE 5\n");
+    long after_regrow = token_follow_poll(&follower, &callbacks);
+    
+    bool ok = first == 1 && second == 1 && idle == 0 && after_reset == 1 &&
+              after_regrow == 2 && follower.resets == 2 &&
+              follower.stats.relations == 1 && offset == 68;
+    printf("Polls: %ld/%ld/%ld/%ld, resets: %llu, offset: %llu (%s)\n",
+           first, second, idle, after_regrow, (unsigned long long)follower.resets,
+           (unsigned long long)offset, ok ? "expected" : "UNEXPECTED");
+    
+    token_follow_close(&follower);
+    unlink(path);
+}
+
+static void* compile_worker(void* arg) {
+    return gosib_compile(arg, NULL, NULL) ? arg : NULL;
+}
+
+void test_gosib_roundtrip(void) {
+    printf("\n=== Testing Compiled Token Format ===\n");
+    
+    char path[] = "/tmp/gosiuml_gosib_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    FILE* fp = fdopen(fd, "w");
+    fprintf(fp, "TOKEN: 0x10 NODE_IDENTITY 1\n"
+                "TOKEN: 0x20 NODE_STATE 2\n"
+                "TOKEN: 0x30 NODE_IDENTITY 3\n"
+                "RELATION: 0x10 -> 0x30 : owns\n"
+                "RELATION: 0x20 -> 0x10 : uses\n"
+                "RELATION: 0x10 -> 0x20 : uses\n"
+                "RELATION: 0x10 -> 0x99 : orphan\n");
+    fclose(fp);
+    
+    char out[64];
+    snprintf(out, sizeof(out), "%s%s", path, GOSIB_EXTENSION);
+    GosibCompileStats stats;
+    GosibFile file;
+    bool ok = gosib_compile(path, NULL, &stats) && gosib_open(&file, out);
+    if (ok) {
+        const GosibToken* t = file.tokens;
+        // Token 0x10 has edges to 0x30 then 0x20, in source order
+        uint32_t b = gosib_edge_begin(&file, 0);
+        ok = file.header->token_count == 3 && file.header->edge_count == 3 &&
+             file.header->dangling_count == 1 && file.header->string_count == 8 &&
+             strcmp(gosib_string(&file, t[2].type), "NODE_IDENTITY") == 0 &&
+             t[0].type == t[2].type && t[1].zone == 2 &&
+             gosib_edge_end(&file, 0) - b == 2 &&
+             file.edges[b].dst == 2 && file.edges[b + 1].dst == 1 &&
+             strcmp(gosib_string(&file, file.edges[b].type), "owns") == 0 &&
+             file.dangling[0].dst_id == 0x99 &&
+             gosib_is_current(&file, path);
+        
+        // Damaged copies must be rejected at open, not read out of bounds
+        const GosibHeader* h = file.header;
+        size_t edge_dst = h->edges_offset;
+        size_t index_end = h->index_offset + h->token_count * sizeof(uint32_t);
+        size_t blob_end = h->strings_offset + h->strings_size - 1;
+        size_t order = offsetof(GosibHeader, byte_order);
+        size_t ordinal = h->edges_offset + offsetof(GosibEdge, ordinal);
+        size_t patches[] = { edge_dst, index_end, blob_end, order, ordinal };
+        char* copy = malloc(file.size);
+        char bad[80];
+        snprintf(bad, sizeof(bad), "%s.bad", out);
+        int rejected = 0;
+        for (size_t i = 0; copy && i < sizeof(patches) / sizeof(patches[0]); i++) {
+            memcpy(copy, file.map, file.size);
+            copy[patches[i]] ^= 0x5A;
+            FILE* bf = fopen(bad, "wb");
+            if (!bf) break;
+            fwrite(copy, 1, file.size, bf);
+            fclose(bf);
+            GosibFile damaged;
+            if (gosib_open(&damaged, bad)) {
+                gosib_close(&damaged);
+            } else {
+                rejected++;
+            }
+        }
+        printf("Damaged copies rejected: %d/5\n", rejected);
+        ok = ok && rejected == 5;
+        free(copy);
+        unlink(bad);
+        gosib_close(&file);
+        
+        // Concurrent compiles of one source each write their own temp file
+        pthread_t workers[4];
+        int started = 0, compiled = 0;
+        for (; started < 4; started++) {
+            if (pthread_create(&workers[started], NULL, compile_worker, path) != 0) break;
+        }
+        for (int i = 0; i < started; i++) {
+            void* rc = NULL;
+            pthread_join(workers[i], &rc);
+            if (rc) compiled++;
+        }
+        ok = ok && compiled == 4 && gosib_open(&file, out);
+        if (ok) gosib_close(&file);
+    }
+    printf("Tokens: %u, edges: %u, dangling: %u, strings: %u (%s)\n",
+           stats.tokens, stats.edges, stats.dangling, stats.strings,
+           ok ? "expected" : "UNEXPECTED");
+    unlink(out);
+    unlink(path);
+}
+
+void test_parse_cache(void) {
+    printf("\n=== Testing Parse Cache ===\n");
+    
+    char dir[] = "/tmp/gosiuml_cache_test_XXXXXX";
+    if (!mkdtemp(dir)) return;
+    char source[128];
+    snprintf(source, sizeof(source), "%s/tokens.txt", dir);
+    append_text(source, "w", "TOKEN: 0x01 NODE_IDENTITY 1\nTOKEN: 0x02 NODE_STATE 2\n"
+                             "RELATION: 0x01 -> 0x02 : owns\n");
+    
+    ParseCacheConfig config;
+    parse_cache_defaults(&config);
+    snprintf(config.dir, sizeof(config.dir), "%s/cache", dir);
+    
+    ParseCacheOutcome outcomes[4];
+    ParseCacheResult result;
+    GosibFile file;
+    
+    // Miss, then stat-only hit
+    for (int i = 0; i < 2; i++) {
+        if (parse_cache_open(&config, source, &file, &result)) gosib_close(&file);
+        outcomes[i] = result.outcome;
+    }
+    
+    // New mtime with identical bytes is validated by content hash
+    struct timespec times[2] = { { 1000, 0 }, { 1000, 0 } };
+    utimensat(AT_FDCWD, source, times, 0);
+    GosiUMLDocument* doc = parse_cache_load_document(&config, source, &result);
+    outcomes[2] = result.outcome;
+    bool doc_ok = doc && doc->token_count == 2 && doc->relation_count == 1 &&
+                  doc->relations[0].type_symbol == gosiuml_document_symbol(doc, "owns") &&
+                  strcmp(pheno_symbols_name(doc->symbols, doc->tokens[1].zone_symbol), "2") == 0;
+    gosiuml_free_document(doc);
+    
+    // Changed content is recompiled; a tiny bound evicts the entry
+    append_text(source, "a", "TOKEN: 0x03 NODE_STATE 3\n");
+    config.max_bytes = 1;
+    if (parse_cache_open(&config, source, &file, &result)) {
+        doc_ok = doc_ok && file.header->token_count == 3;
+        gosib_close(&file);
+    }
+    outcomes[3] = result.outcome;
+    
+    bool ok = outcomes[0] == PARSE_CACHE_MISS && outcomes[1] == PARSE_CACHE_HIT &&
+              outcomes[2] == PARSE_CACHE_HIT_REHASHED && outcomes[3] == PARSE_CACHE_MISS &&
+              result.evicted_entries == 1 && doc_ok;
+    printf("Outcomes: %s, %s, %s, %s; evicted %llu (%s)\n",
+           parse_cache_outcome_name(outcomes[0]), parse_cache_outcome_name(outcomes[1]),
+           parse_cache_outcome_name(outcomes[2]), parse_cache_outcome_name(outcomes[3]),
+           (unsigned long long)result.evicted_entries, ok ? "expected" : "UNEXPECTED");
+    
+    // A hit returns relations in file order, the same as a fresh parse,
+    // although the container groups them by source with dangling ones apart
+    config.max_bytes = 0;
+    append_text(source, "w", "TOKEN: 0x01 NODE_IDENTITY 1\nTOKEN: 0x02 NODE_STATE 2\n"
+                             "TOKEN: 0x03 NODE_STATE 3\nRELATION: 0x03 -> 0x01 : owns\n"
+                             "RELATION: 0x09 -> 0x01 : orphan\nRELATION: 0x01 -> 0x02 : uses\n");
+    GosiUMLParseOptions options = { 1, 0, NULL, NULL, NULL, NULL, NULL };
+    GosiUMLDocument* fresh = gosiuml_parse_document(source, &options);
+    GosiUMLDocument* cached = NULL;
+    for (int i = 0; i < 2; i++) {
+        gosiuml_free_document(cached);
+        cached = parse_cache_load_document(&config, source, &result);
+    }
+    bool order_ok = fresh && cached && result.outcome == PARSE_CACHE_HIT &&
+                    fresh->relation_count == 3 && cached->relation_count == 3;
+    for (size_t r = 0; order_ok && r < fresh->relation_count; r++) {
+        order_ok = fresh->relations[r].src_id == cached->relations[r].src_id &&
+                   fresh->relations[r].dst_id == cached->relations[r].dst_id &&
+                   strcmp(fresh->relations[r].type, cached->relations[r].type) == 0;
+    }
+    printf("Cache hit relation order matches a fresh parse: %s (%s)\n",
+           order_ok ? "yes" : "no", order_ok ? "expected" : "UNEXPECTED");
+    gosiuml_free_document(fresh);
+    gosiuml_free_document(cached);
+    
+    unlink(result.entry_path);
+    unlink(source);
+    rmdir(config.dir);
+    rmdir(dir);
+}
+
+static char* read_text(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* text = len >= 0 ? malloc((size_t)len + 1) : NULL;
+    if (text) {
+        *size = fread(text, 1, (size_t)len, fp);
+        text[*size] = '\0';
+    }
+    fclose(fp);
+    return text;
+}
+
+void test_svg_writer(void) {
+    printf("\n=== Testing SVG Writer ===\n");
+    
+    char path[] = "/tmp/gosiuml_svg_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    close(fd);
+    
+    // Hand-rolled formatting against printf
+    SvgWriter w;
+    bool format_ok = false;
+    if (svg_writer_open(&w, path)) {
+        static const uint32_t values[] = { 0, 7, 10, 99, 100, 65535, 1000000, 4294967295u };
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            svg_put_u32(&w, values[i]);
+            svg_puts(&w, " ");
+        }
+        svg_put_i32(&w, -2147483647 - 1);
+        svg_puts(&w, " ");
+        svg_put_hex32(&w, 0xDEADBEEF);
+        svg_puts(&w, " ");
+        svg_put_escaped(&w, "a<&>\"'b", 7);
+        svg_writer_close(&w);
+        
+        size_t size = 0;
+        char* text = read_text(path, &size);
+        format_ok = text && strcmp(text, "0 7 10 99 100 65535 1000000 4294967295 "
+                                         "-2147483648 DEADBEEF a&lt;&amp;&gt;&quot;&#39;b") == 0;
+        free(text);
+    }
+    
+    // Every token is emitted, well past the old 12-token cap
+    int count = 5000;
+    PhenoToken* tokens = calloc((size_t)count, sizeof(PhenoToken));
+    if (!tokens) return;
+    for (int i = 0; i < count; i++) {
+        tokens[i].token_id = (uint32_t)i;
+        snprintf(tokens[i].sentinel, sizeof(tokens[i].sentinel), "NODE_%d", i % 9);
+    }
+    snprintf(tokens[count - 1].sentinel, sizeof(tokens[count - 1].sentinel), "A&B");
+    
+    size_t nodes = 0, size = 0;
+    char* text = gosiuml_generate_svg(NULL, tokens, count, path) == 0 ? read_text(path, &size) : NULL;
+    for (const char* p = text; p && (p = strstr(p, "<rect class=\"n\"")); p++) nodes++;
+    bool ok = format_ok && text && nodes == (size_t)count &&
+              strstr(text, "ID: 0x00001387") && strstr(text, ">A&amp;B<") &&
+              size > 7 && strcmp(text + size - 7, "</svg>\n") == 0;
+    printf("Formatting %s, nodes: %zu/%d, bytes: %zu (%s)\n", format_ok ? "matches" : "differs",
+           nodes, count, size, ok ? "expected" : "UNEXPECTED");
+    
+    free(text);
+    free(tokens);
+    unlink(path);
+}
+
+static GosiUMLDocument* parse_text(const char* text) {
+    char path[] = "/tmp/gosiuml_layout_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    close(fd);
+    append_text(path, "w", text);
+    GosiUMLParseOptions options = { 1, 0, NULL, NULL, NULL, NULL, NULL };
+    GosiUMLDocument* doc = gosiuml_parse_document(path, &options);
+    unlink(path);
+    return doc;
+}
+
+static double point_distance(const LayoutPoint* a, const LayoutPoint* b) {
+    double dx = a->x - b->x, dy = a->y - b->y;
+    return sqrt(dx * dx + dy * dy);
+}
+
+void test_layout_engine(void) {
+    printf("\n=== Testing Layout Engine ===\n");
+    
+    // Binary tree (a DAG) and a ring (cyclic), 200 and 300 nodes
+    size_t cap = 64 * 1024, len = 0;
+    char* text = malloc(cap);
+    if (!text) return;
+    for (int i = 0; i < 200; i++) len += snprintf(text + len, cap - len, "TOKEN: 0x%X NODE_%d 0\n", i, i % 5);
+    for (int i = 1; i < 200; i++) len += snprintf(text + len, cap - len, "RELATION: 0x%X -> 0x%X : child\n", (i - 1) / 2, i);
+    GosiUMLDocument* tree = parse_text(text);
+    
+    len = 0;
+    for (int i = 0; i < 300; i++) len += snprintf(text + len, cap - len, "TOKEN: 0x%X NODE_%d 0\n", i, i % 5);
+    for (int i = 0; i < 300; i++) len += snprintf(text + len, cap - len, "RELATION: 0x%X -> 0x%X : next\n", i, (i + 1) % 300);
+    GosiUMLDocument* ring = parse_text(text);
+    free(text);
+    
+    // Both layouts share one caller-owned pool
+    LayoutOptions options;
+    layout_defaults(&options);
+    options.threads = 1;
+    options.pool = pheno_threadpool_create(2);
+    Layout a = {0}, b = {0};
+    bool ok = tree && ring && options.pool &&
+              layout_document(tree, &options, &a) && layout_document(ring, &options, &b);
+    pheno_threadpool_destroy(options.pool);
+    
+    // Every tree edge points to a lower layer
+    ok = ok && a.mode == LAYOUT_LAYERED && a.layers == 8 && a.edge_count == 199;
+    for (size_t e = 0; ok && e < a.edge_count; e++) {
+        ok = a.nodes[a.edges[e * 2 + 1]].y > a.nodes[a.edges[e * 2]].y;
+    }
+    
+    // Ring neighbours end up much closer than opposite nodes
+    double edge_sum = 0, far_sum = 0;
+    ok = ok && b.mode == LAYOUT_FORCE && b.edge_count == 300;
+    for (size_t i = 0; ok && i < b.node_count; i++) {
+        const LayoutPoint* p = &b.nodes[i];
+        ok = isfinite(p->x) && isfinite(p->y) && p->x > 0 && p->y > 0 &&
+             p->x < b.width && p->y < b.height;
+        edge_sum += point_distance(p, &b.nodes[(i + 1) % 300]);
+        far_sum += point_distance(p, &b.nodes[(i + 150) % 300]);
+    }
+    ok = ok && edge_sum * 2 < far_sum;
+    
+    char path[] = "/tmp/gosiuml_layout_svg_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        ok = ok && svg_render_layout(ring->tokens, NULL, &b, path) == 0;
+        unlink(path);
+    }
+    printf("Tree: %s, %u layers; ring: %s, edge/opposite distance %.2f (%s)\n",
+           layout_mode_name(a.mode), a.layers, layout_mode_name(b.mode),
+           far_sum > 0 ? edge_sum / far_sum : 0.0, ok ? "expected" : "UNEXPECTED");
+    
+    layout_free(&a);
+    layout_free(&b);
+    gosiuml_free_document(tree);
+    gosiuml_free_document(ring);
+}
+
+static size_t g_tile_rects = 0;
+
+static int count_tile_rects(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st;
+    (void)ftw;
+    size_t size = 0;
+    char* text = flag == FTW_F && strstr(path, ".svg") ? read_text(path, &size) : NULL;
+    for (const char* p = text; p && (p = strstr(p, "<rect class=\"n\"")); p++) g_tile_rects++;
+    free(text);
+    return 0;
+}
+
+static int remove_path(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+void test_tile_pyramid(void) {
+    printf("\n=== Testing Tile Pyramid ===\n");
+    
+    // Layered DAG of 3000 nodes in three types
+    size_t cap = 256 * 1024, len = 0;
+    char* text = malloc(cap);
+    if (!text) return;
+    for (int i = 0; i < 3000; i++) len += snprintf(text + len, cap - len, "TOKEN: 0x%X TYPE_%d 0\n", i, i % 3);
+    for (int i = 0; i + 50 < 3000; i++) len += snprintf(text + len, cap - len, "RELATION: 0x%X -> 0x%X : next\n", i, i + 50);
+    GosiUMLDocument* doc = parse_text(text);
+    free(text);
+    
+    TileOptions options;
+    TileStats stats = {0};
+    tile_defaults(&options);
+    options.max_tile_nodes = 200;
+    options.threads = 1;
+    options.pool = pheno_threadpool_create(2);
+    snprintf(options.dir, sizeof(options.dir), "/tmp/gosiuml_tiles_XXXXXX");
+    
+    Layout layout = {0};
+    bool ok = doc && options.pool && mkdtemp(options.dir) && layout_document(doc, NULL, &layout) &&
+              tile_pyramid_write(doc, &layout, &options, &stats) && stats.levels >= 2;
+    pheno_threadpool_destroy(options.pool);
+    
+    // The root tile shows clusters; the detail zoom shows every token at least once
+    char path[1200];
+    size_t size = 0;
+    snprintf(path, sizeof(path), "%s/0/0/0.svg", options.dir);
+    char* root = ok ? read_text(path, &size) : NULL;
+    ok = ok && root && strstr(root, "<circle class=\"c\"") && strstr(root, "TYPE_1 (") &&
+         !strstr(root, "<rect class=\"n\"");
+    free(root);
+    
+    g_tile_rects = 0;
+    snprintf(path, sizeof(path), "%s/%u", options.dir, stats.detail_level);
+    ok = ok && nftw(path, count_tile_rects, 16, FTW_PHYS) == 0 && g_tile_rects >= 3000;
+    snprintf(path, sizeof(path), "%s/index.json", options.dir);
+    ok = ok && access(path, R_OK) == 0;
+    printf("Levels: %u, tiles: %llu, aggregates: %llu, detail boxes: %zu (%s)\n",
+           stats.levels, (unsigned long long)stats.tiles, (unsigned long long)stats.aggregates,
+           g_tile_rects, ok ? "expected" : "UNEXPECTED");
+    
+    nftw(options.dir, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+    layout_free(&layout);
+    gosiuml_free_document(doc);
+}
+
+static bool same_file(const char* a, const char* b) {
+    size_t na = 0, nb = 0;
+    char* x = read_text(a, &na);
+    char* y = read_text(b, &nb);
+    bool same = x && y && na == nb && memcmp(x, y, na) == 0;
+    free(x);
+    free(y);
+    return same;
+}
+
+void test_svg_cache(void) {
+    printf("\n=== Testing Incremental SVG Render ===\n");
+    
+    // Ring of 5000 tokens so the relation layer is cached too
+    size_t cap = 512 * 1024, len = 0;
+    char* text = malloc(cap);
+    if (!text) return;
+    for (int i = 0; i < 5000; i++) len += snprintf(text + len, cap - len, "TOKEN: 0x%X NODE_%d 0\n", i, i % 7);
+    for (int i = 0; i < 5000; i++) len += snprintf(text + len, cap - len, "RELATION: 0x%X -> 0x%X : next\n", i, (i + 1) % 5000);
+    GosiUMLDocument* doc = parse_text(text);
+    free(text);
+    
+    char cached[] = "/tmp/gosiuml_cache_svg_XXXXXX";
+    char full[] = "/tmp/gosiuml_full_svg_XXXXXX";
+    int a = mkstemp(cached), b = mkstemp(full);
+    if (a >= 0) close(a);
+    if (b >= 0) close(b);
+    
+    LayoutOptions options;
+    layout_defaults(&options);
+    options.mode = LAYOUT_LAYERED;
+    Layout layout = {0};
+    SvgFragmentCache* cache = svg_cache_create();
+    SvgCacheStats first = {0}, again = {0}, changed = {0};
+    bool ok = doc && cache && layout_document(doc, &options, &layout) &&
+              svg_render_layout_cached(cache, doc->tokens, doc->symbols, &layout, cached, &first) == 0 &&
+              svg_render_layout(doc->tokens, doc->symbols, &layout, full) == 0 && same_file(cached, full) &&
+              svg_render_layout_cached(cache, doc->tokens, doc->symbols, &layout, cached, &again) == 0 &&
+              same_file(cached, full);
+    
+    // Three tokens change type, one past the sentinel's 16 bytes and one
+    // that needs escaping; only they are formatted again
+    static const char* long_type = "CLUSTER_CONSENSUS_COORDINATOR";
+    if (ok) {
+        doc->tokens[0].type_symbol = pheno_symbols_intern(doc->symbols, "PHENO_LOCKED", 12);
+        doc->tokens[2500].type_symbol = pheno_symbols_intern(doc->symbols, "A&B", 3);
+        doc->tokens[4999].type_symbol = pheno_symbols_intern(doc->symbols, long_type, strlen(long_type));
+    }
+    SvgCacheStats renamed = {0};
+    ok = ok && svg_render_layout_cached(cache, doc->tokens, doc->symbols, &layout, cached, &changed) == 0 &&
+         svg_render_layout(doc->tokens, doc->symbols, &layout, full) == 0 && same_file(cached, full);
+    size_t len_full = 0;
+    char* svg_text = ok ? read_text(full, &len_full) : NULL;
+    ok = ok && svg_text && strstr(svg_text, long_type) && strstr(svg_text, "A&amp;B");
+    free(svg_text);
+    
+    // A fresh table that maps the same ids to other names still invalidates
+    PhenoSymbolTable* other = pheno_symbols_create();
+    PhenoSymbolTable* previous = doc->symbols;
+    for (size_t i = 0; other && i < pheno_symbols_count(previous); i++) {
+        char name[32];
+        int n = snprintf(name, sizeof(name), "RENAMED_%zu", i);
+        pheno_symbols_intern(other, name, (size_t)n);
+    }
+    ok = ok && other &&
+         svg_render_layout_cached(cache, doc->tokens, other, &layout, cached, &renamed) == 0 &&
+         svg_render_layout(doc->tokens, other, &layout, full) == 0 && same_file(cached, full);
+    pheno_symbols_destroy(other);
+    
+    ok = ok && first.reformatted == 5000 && first.edges_reformatted &&
+         again.reformatted == 0 && !again.edges_reformatted &&
+         changed.reformatted == 3 && !changed.edges_reformatted &&
+         renamed.reformatted == 5000;
+    printf("Reformatted: %zu, %zu, %zu, %zu of %zu, output identical (%s)\n",
+           first.reformatted, again.reformatted, changed.reformatted, renamed.reformatted,
+           changed.tokens, ok ? "expected" : "UNEXPECTED");
+    
+    svg_cache_destroy(cache);
+    layout_free(&layout);
+    gosiuml_free_document(doc);
+    unlink(cached);
+    unlink(full);
+}
+
+static size_t count_text(const char* text, const char* needle) {
+    size_t n = 0;
+    for (const char* p = text; p && (p = strstr(p, needle)); p++) n++;
+    return n;
+}
+
+void test_exporters(void) {
+    printf("\n=== Testing XML/JSON Export ===\n");
+    
+    int count = 2000;
+    PhenoToken* tokens = calloc((size_t)count, sizeof(PhenoToken));
+    if (!tokens) return;
+    for (int i = 0; i < count; i++) {
+        tokens[i].token_id = (uint32_t)i;
+        tokens[i].memory_zone = (uint8_t)(i % 16);
+        snprintf(tokens[i].sentinel, sizeof(tokens[i].sentinel), "NODE_%d", i % 9);
+    }
+    snprintf(tokens[1].sentinel, sizeof(tokens[1].sentinel), "A&B\"<\x01");
+    
+    char xml_path[] = "/tmp/gosiuml_export_xml_XXXXXX";
+    char json_path[] = "/tmp/gosiuml_export_json_XXXXXX";
+    int xml_fd = mkstemp(xml_path), json_fd = mkstemp(json_path);
+    if (xml_fd >= 0) close(xml_fd);
+    if (json_fd >= 0) close(json_fd);
+    
+    size_t xml_size = 0, json_size = 0;
+    char* xml = gosiuml_generate_xml(NULL, tokens, count, xml_path) == 0 ? read_text(xml_path, &xml_size) : NULL;
+    char* json = gosiuml_generate_json(NULL, tokens, count, json_path) == 0 ? read_text(json_path, &json_size) : NULL;
+    bool ok = xml && json &&
+              strstr(xml, "xmlns=\"http://obinexus.org/gosiuml/v1\"") &&
+              count_text(xml, "<token ") == (size_t)count &&
+              strstr(xml, "id=\"0x00000001\" sentinel=\"A&amp;B&quot;&lt;\"") &&
+              strstr(xml, "</stateMachine>\n") &&
+              count_text(json, "{\"id\":") == (size_t)count &&
+              strstr(json, "\"sentinel\":\"A&B\\\"<\\u0001\"") &&
+              json_size > 3 && strcmp(json + json_size - 3, "]}\n") == 0;
+    free(xml);
+    free(json);
+    
+    // Documents add type/zone names and relations
+    GosiUMLDocument* doc = parse_text("TOKEN: 0x1 Widget<T> zone_a\nTOKEN: 0x2 Gadget zone_b\n"
+                                      "RELATION: 0x1 -> 0x2 : \"uses\"\n");
+    xml = doc && gosiuml_export_document(NULL, doc, FORMAT_XML, xml_path) == 0 ? read_text(xml_path, &xml_size) : NULL;
+    json = doc && gosiuml_export_document(NULL, doc, FORMAT_JSON, json_path) == 0 ? read_text(json_path, &json_size) : NULL;
+    ok = ok && xml && json &&
+         strstr(xml, "type=\"Widget&lt;T&gt;\" zone_name=\"zone_a\"") &&
+         strstr(xml, "<relation src=\"0x00000001\" dst=\"0x00000002\" type=\"&quot;uses&quot;\"/>") &&
+         strstr(json, "\"type\":\"Widget<T>\",\"zone_name\":\"zone_a\"") &&
+         strstr(json, "{\"src\":1,\"dst\":2,\"type\":\"\\\"uses\\\"\"}");
+    printf("Tokens: %d, XML bytes: %zu, JSON bytes: %zu (%s)\n", count, xml_size, json_size,
+           ok ? "expected" : "UNEXPECTED");
+    
+    free(xml);
+    free(json);
+    gosiuml_free_document(doc);
+    free(tokens);
+    unlink(xml_path);
+    unlink(json_path);
+}
+
+static void emit_greeting(SvgWriter* w, void* user) {
+    svg_put_escaped(w, user, strlen(user));
+}
+
+void test_report_template(void) {
+    printf("\n=== Testing Report Templates ===\n");
+    
+    // Malformed templates are rejected with a reason
+    char error[128] = "";
+    const char* bad[] = { "a {{name:float}} b", "unterminated {{name", "{{:str}}", "{{n:uint}} {{n:str}}" };
+    size_t rejected = 0;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        ReportTemplate* tpl = template_compile(bad[i], strlen(bad[i]), error, sizeof(error));
+        rejected += tpl == NULL && error[0];
+        template_free(tpl);
+    }
+    
+    const char text[] = "<r n=\"{{name}}\" j=\"{{name_json:json}}\">{{count:uint}} {{delta:int}} "
+                        "{{id:hex}} {{body:raw}}|{{name}}</r>\n";
+    ReportTemplate* tpl = template_compile(text, sizeof(text) - 1, error, sizeof(error));
+    bool ok = rejected == 4 && tpl && template_slot_count(tpl) == 6 &&
+              template_slot(tpl, "count") >= 0 && template_slot(tpl, "missing") < 0 &&
+              template_slot_type(tpl, template_slot(tpl, "id")) == TEMPLATE_HEX;
+    
+    char path[] = "/tmp/gosiuml_template_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    size_t size = 0;
+    char* out = NULL;
+    if (ok) {
+        TemplateValue values[6];
+        memset(values, 0, sizeof(values));
+        values[template_slot(tpl, "name")].str = "A&B <tenant>";
+        values[template_slot(tpl, "name_json")].str = "say \"hi\"";
+        values[template_slot(tpl, "count")].u = 18446744073709551615ull;
+        values[template_slot(tpl, "delta")].i = -42;
+        values[template_slot(tpl, "id")].u = 0xBEEF;
+        values[template_slot(tpl, "body")].emit = emit_greeting;
+        values[template_slot(tpl, "body")].user = "<ok>";
+        out = template_render_file(tpl, values, path) == 0 ? read_text(path, &size) : NULL;
+    }
+    ok = ok && out && strcmp(out, "<r n=\"A&amp;B &lt;tenant&gt;\" j=\"say \\\"hi\\\"\">"
+                                  "18446744073709551615 -42 0x0000BEEF &lt;ok&gt;|A&amp;B &lt;tenant&gt;</r>\n") == 0;
+    free(out);
+    
+    // Loading by path compiles once
+    append_text(path, "w", "<p>{{title}}</p>");
+    const ReportTemplate* first = template_load(path, error, sizeof(error));
+    append_text(path, "w", "changed");
+    ok = ok && first && template_load(path, error, sizeof(error)) == first &&
+         template_slot(first, "title") == 0;
+    
+    // Render throughput into memory, the per-report cost of a bulk run
+    static char buffer[4096];
+    TemplateValue values[6];
+    memset(values, 0, sizeof(values));
+    values[0].str = "tenant-0042";
+    uint64_t start = pheno_monotonic_ns();
+    int renders = 100000;
+    for (int i = 0; ok && i < renders; i++) {
+        SvgWriter w;
+        svg_writer_init_memory(&w, buffer, sizeof(buffer));
+        values[2].u = (uint64_t)i;
+        template_render(tpl, values, &w);
+        ok = !w.failed;
+    }
+    double secs = (pheno_monotonic_ns() - start) / 1e9;
+    printf("Rejected: %zu/4, slots: %zu, renders/s: %.0f (%s)\n", rejected, template_slot_count(tpl),
+           secs > 0 ? renders / secs : 0.0, ok ? "expected" : "UNEXPECTED");
+    
+    template_cache_clear();
+    template_free(tpl);
+    unlink(path);
+}
+
+void test_batch_render(void) {
+    printf("\n=== Testing Batch Render ===\n");
+    
+    char dir[] = "/tmp/gosiuml_batch_XXXXXX";
+    if (!mkdtemp(dir)) return;
+    char path[128], out_dir[64], spec[64], manifest[64], line[512];
+    snprintf(out_dir, sizeof(out_dir), "%s/out", dir);
+    mkdir(out_dir, 0700);
+    
+    // Six small chains of different sizes
+    for (int f = 0; f < 6; f++) {
+        snprintf(path, sizeof(path), "%s/doc%d.tok", dir, f);
+        append_text(path, "w", "");
+        for (int i = 0; i < 100 * (f + 1); i++) {
+            snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d 0\n", i, i % 4);
+            append_text(path, "a", line);
+            if (i > 0) {
+                snprintf(line, sizeof(line), "RELATION: 0x%X -> 0x%X : next\n", i - 1, i);
+                append_text(path, "a", line);
+            }
+        }
+    }
+    
+    // Glob pass on two workers, outputs next to each other in out_dir
+    BatchOptions options;
+    BatchStats stats;
+    BatchList list;
+    batch_defaults(&options);
+    options.threads = 2;
+    snprintf(spec, sizeof(spec), "%s/*.tok", dir);
+    bool ok = batch_list_load(spec, out_dir, &list) && list.count == 6 &&
+              batch_run(&list, &options, &stats) && stats.files == 6 && stats.failed == 0 &&
+              stats.tokens == 2100 && stats.relations == 2094 && stats.workers == 2;
+    batch_list_free(&list);
+    snprintf(path, sizeof(path), "%s/doc5.svg", out_dir);
+    ok = ok && access(path, R_OK) == 0;
+    
+    // Manifest with explicit formats and one missing input
+    snprintf(manifest, sizeof(manifest), "%s/jobs.txt", dir);
+    snprintf(line, sizeof(line), "# jobs\n%s/doc0.tok %s/doc0.json\n%s/doc1.tok %s/doc1.xml\n"
+             "%s/missing.tok\n\n%s/doc2.tok\n", dir, out_dir, dir, out_dir, dir, dir);
+    append_text(manifest, "w", line);
+    options.quiet = true;
+    options.threads = 1;
+    ok = ok && batch_list_load(manifest, NULL, &list) && list.count == 4 &&
+         !batch_run(&list, &options, &stats) && stats.files == 4 && stats.failed == 1 &&
+         stats.tokens == 600 && stats.arena_peak > 0;
+    batch_list_free(&list);
+    size_t size = 0;
+    snprintf(path, sizeof(path), "%s/doc0.json", out_dir);
+    char* json = ok ? read_text(path, &size) : NULL;
+    ok = ok && json && count_text(json, "\"sentinel\"") == 100;
+    free(json);
+    snprintf(path, sizeof(path), "%s/doc1.xml", out_dir);
+    ok = ok && access(path, R_OK) == 0;
+    snprintf(path, sizeof(path), "%s/doc2.svg", dir);
+    ok = ok && access(path, R_OK) == 0;
+    
+    printf("Files: %llu, failed: %llu, tokens: %llu, arena peak: %zu (%s)\n",
+           (unsigned long long)stats.files, (unsigned long long)stats.failed,
+           (unsigned long long)stats.tokens, stats.arena_peak, ok ? "expected" : "UNEXPECTED");
+    
+    nftw(dir, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void test_daemon(void) {
+    printf("\n=== Testing Resident Daemon ===\n");
+    
+    char dir[] = "/tmp/gosiuml_daemon_XXXXXX";
+    if (!mkdtemp(dir)) return;
+    char tokens[64], svg[64], line[128];
+    snprintf(tokens, sizeof(tokens), "%s/doc.tok", dir);
+    snprintf(svg, sizeof(svg), "%s/doc.svg", dir);
+    append_text(tokens, "w", "");
+    for (int i = 0; i < 500; i++) {
+        snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d zone_%d\n", i, i % 5, i % 2);
+        append_text(tokens, "a", line);
+    }
+    
+    // Two threads: every parse and layout runs on the daemon's one pool
+    DaemonOptions options;
+    daemon_defaults(&options);
+    options.threads = 2;
+    options.quiet = true;
+    snprintf(options.socket_path, sizeof(options.socket_path), "%s/sock", dir);
+    GosiUMLDaemon* daemon = daemon_start(&options);
+    int fd = daemon ? daemon_connect(options.socket_path) : -1;
+    
+    char reply[1024];
+    const char* parse[] = { tokens };
+    const char* query[] = { tokens, "0x1F" };
+    const char* missing[] = { tokens, "9999" };
+    const char* render[] = { tokens, svg, "grid" };
+    bool ok = fd >= 0 &&
+              daemon_request(fd, DAEMON_PING, 0, NULL, reply, sizeof(reply)) == DAEMON_OK &&
+              daemon_request(fd, DAEMON_PARSE, 1, parse, reply, sizeof(reply)) == DAEMON_OK &&
+              strstr(reply, "\"tokens\":500") && strstr(reply, "\"resident\":false") &&
+              daemon_request(fd, DAEMON_QUERY, 2, query, reply, sizeof(reply)) == DAEMON_OK &&
+              strstr(reply, "\"id\":31,") && strstr(reply, "\"type\":\"NODE_1\"") &&
+              daemon_request(fd, DAEMON_QUERY, 2, missing, reply, sizeof(reply)) == DAEMON_NOT_FOUND &&
+              daemon_request(fd, 99, 0, NULL, reply, sizeof(reply)) == DAEMON_BAD_REQUEST;
+    
+    // Second render of an unchanged document reformats nothing
+    ok = ok && daemon_request(fd, DAEMON_RENDER, 3, render, reply, sizeof(reply)) == DAEMON_OK &&
+         strstr(reply, "\"reformatted\":500") &&
+         daemon_request(fd, DAEMON_RENDER, 3, render, reply, sizeof(reply)) == DAEMON_OK &&
+         strstr(reply, "\"reformatted\":0,") && access(svg, R_OK) == 0;
+    
+    // Warm round trips
+    uint64_t start = pheno_monotonic_ns();
+    int rounds = 2000;
+    for (int i = 0; ok && i < rounds; i++) {
+        ok = daemon_request(fd, DAEMON_QUERY, 2, query, reply, sizeof(reply)) == DAEMON_OK;
+    }
+    double us = (pheno_monotonic_ns() - start) / 1e3 / rounds;
+    
+    // A change on disk is picked up by the next request
+    append_text(tokens, "a", "TOKEN: 0x1000 NODE_X zone_0\n");
+    ok = ok && daemon_request(fd, DAEMON_PARSE, 1, parse, reply, sizeof(reply)) == DAEMON_OK &&
+         strstr(reply, "\"tokens\":501") && strstr(reply, "\"resident\":false");
+    
+    DaemonStats stats;
+    daemon_get_stats(daemon, &stats);
+    ok = ok && stats.parses == 2 && stats.errors == 2 && stats.documents == 1 &&
+         daemon_request(fd, DAEMON_SHUTDOWN, 0, NULL, reply, sizeof(reply)) == DAEMON_OK;
+    daemon_wait(daemon);
+    daemon_disconnect(fd);
+    daemon_stop(daemon);
+    ok = ok && access(options.socket_path, F_OK) != 0;
+    
+    printf("Requests: %llu, parses: %llu, hits: %llu, round trip: %.1f us (%s)\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.parses,
+           (unsigned long long)stats.hits, us, ok ? "expected" : "UNEXPECTED");
+    
+    nftw(dir, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void test_token_watch(void) {
+    printf("\n=== Testing Watch Mode ===\n");
+    
+    char dir[] = "/tmp/gosiuml_watch_XXXXXX";
+    if (!mkdtemp(dir)) return;
+    char a[64], b[64], note[64], svg[64], line[128];
+    snprintf(a, sizeof(a), "%s/a.tok", dir);
+    snprintf(b, sizeof(b), "%s/b.tok", dir);
+    snprintf(note, sizeof(note), "%s/notes.txt", dir);
+    snprintf(svg, sizeof(svg), "%s/a.svg", dir);
+    append_text(a, "w", "");
+    for (int i = 0; i < 200; i++) {
+        snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d 0\n", i, i % 3);
+        append_text(a, "a", line);
+    }
+    
+    WatchOptions options;
+    WatchStats stats;
+    watch_defaults(&options);
+    options.threads = 2;
+    options.quiet = true;
+    TokenWatch* watch = watch_create(&options);
+    bool ok = watch && watch_add(watch, dir) && watch_poll(watch, 0) == 1;
+    
+    // A burst of appends, one split mid-line, becomes one render of the new bytes
+    size_t size = 0;
+    char* text = read_text(a, &size);
+    uint64_t parsed = 0;
+    if (ok) {
+        watch_get_stats(watch, &stats);
+        parsed = stats.parsed_bytes;
+    }
+    free(text);
+    size_t appended = 0;
+    for (int i = 200; i < 250; i++) {
+        snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d 0\nRELATION: 0x%X -> 0x%X : next\n",
+                 i, i % 3, i - 1, i);
+        appended += strlen(line);
+        append_text(a, "a", line);
+    }
+    append_text(a, "a", "TOKEN: 0x1F");
+    append_text(note, "w", "not a token file\n");
+    ok = ok && parsed == size && watch_poll(watch, 1000) == 1;
+    watch_get_stats(watch, &stats);
+    ok = ok && stats.parsed_bytes - parsed == appended && stats.batches == 2;
+    
+    // Completing the split line and creating a file render both together
+    append_text(a, "a", "F NODE_9 0\n");
+    append_text(b, "w", "TOKEN: 0x1 NODE_1 0\n");
+    ok = ok && watch_poll(watch, 1000) == 2;
+    
+    // Rewriting restarts the file
+    append_text(a, "w", "TOKEN: 0x1 NODE_1 0\n");
+    ok = ok && watch_poll(watch, 1000) == 1;
+    watch_get_stats(watch, &stats);
+    text = read_text(svg, &size);
+    ok = ok && text && count_text(text, "<rect class=\"n\"") == 1 && stats.resets == 1 &&
+         stats.files == 2 && stats.failed == 0 && watch_poll(watch, 0) == 0;
+    free(text);
+    
+    // Editing the first line in place and growing the file keeps every
+    // byte near the old end, yet the whole file is parsed again
+    for (int i = 2; i < 10; i++) {
+        snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d 0\n", i, i);
+        append_text(a, "a", line);
+    }
+    ok = ok && watch_poll(watch, 1000) == 1;
+    FILE* edit = fopen(a, "r+");
+    if (edit) {
+        fputs("TOKEN: 0x1 EDIT_1 0\n", edit);
+        fseek(edit, 0, SEEK_END);
+        fputs("TOKEN: 0xA NODE_A 0\nTOKEN: 0xB NODE_B 0\n", edit);
+        fclose(edit);
+    }
+    ok = ok && edit && watch_poll(watch, 1000) == 1;
+    watch_get_stats(watch, &stats);
+    text = read_text(svg, &size);
+    ok = ok && text && count_text(text, "<rect class=\"n\"") == 11 && strstr(text, "EDIT_1") &&
+         stats.resets == 2;
+    free(text);
+    
+    // Stop wakes a blocked poll
+    watch_stop(watch);
+    ok = ok && watch_run(watch) == 0;
+    
+    printf("Events: %llu, batches: %llu, renders: %llu, resets: %llu, p50: %.2f ms (%s)\n",
+           (unsigned long long)stats.events, (unsigned long long)stats.batches,
+           (unsigned long long)stats.renders, (unsigned long long)stats.resets,
+           stats.p50_ns / 1e6, ok ? "expected" : "UNEXPECTED");
+    
+    watch_destroy(watch);
+    nftw(dir, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+typedef struct {
+    const char* tokens;
+    int index;
+    GosiUMLContextStats stats;
+    bool ok;
+} ContextJob;
+
+static void* context_worker(void* arg) {
+    ContextJob* job = arg;
+    GosiUMLContext* ctx = gosiuml_create_context();
+    if (!ctx) return NULL;
+    bool ok = gosiuml_set_option(ctx, GOSIUML_OPT_MEMORY_TRACKING, 1) == 0 &&
+              gosiuml_set_option(ctx, GOSIUML_OPT_POOL_KB, 256) == 0;
+
+    PhenoToken* tokens[64];
+    for (int round = 0; ok && round < 50; round++) {
+        for (int i = 0; ok && i < 64; i++) {
+            tokens[i] = gosiuml_context_alloc_token(ctx, 128);
+            ok = tokens[i] && gosiuml_process_token(ctx, tokens[i]) == 0;
+        }
+        for (int i = 0; ok && i < 64; i++) gosiuml_context_free_token(ctx, tokens[i]);
+    }
+
+    StateMachine* sm = ok ? gosiuml_context_create_machine(ctx) : NULL;
+    if (sm) {
+        step_state_machine(sm, EVENT_ALLOC);
+        ok = sm->current_state == STATE_ALLOCATED && sm->pool;
+        step_state_machine(sm, EVENT_LOCK);
+        step_state_machine(sm, EVENT_VALIDATE);
+        ok = ok && sm->current_state == STATE_ACTIVE;
+        destroy_state_machine(sm);
+    }
+
+    char name[32];
+    for (int i = 0; i < 10 + job->index; i++) {
+        snprintf(name, sizeof(name), "ctx%d_sym%d", job->index, i);
+        gosiuml_context_intern(ctx, name);
+    }
+    // The document shares the context table: its ids match context interning
+    GosiUMLDocument* doc = gosiuml_context_parse(ctx, job->tokens);
+    ok = ok && sm && doc && doc->token_count == 100 &&
+         doc->symbols == gosiuml_context_symbols(ctx) &&
+         doc->tokens[1].type_symbol == gosiuml_context_intern(ctx, "NODE_1") &&
+         doc->tokens[1].zone_symbol == gosiuml_context_intern(ctx, "zone_1");
+    gosiuml_context_stats(ctx, &job->stats);
+    gosiuml_context_reset(ctx);
+    job->ok = ok;
+    gosiuml_free_context(ctx);
+    return NULL;
+}
+
+void test_contexts(void) {
+    printf("\n=== Testing Independent Contexts ===\n");
+
+    char dir[] = "/tmp/gosiuml_ctx_XXXXXX";
+    if (!mkdtemp(dir)) return;
+    char tokens[64], line[64];
+    snprintf(tokens, sizeof(tokens), "%s/ctx.tok", dir);
+    append_text(tokens, "w", "");
+    for (int i = 0; i < 100; i++) {
+        snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d zone_%d\n", i, i % 4, i % 2);
+        append_text(tokens, "a", line);
+    }
+
+    PhenoPoolUsage before, after;
+    pheno_pool_usage(pheno_pool_default(), &before);
+    PhenoLogLevel was_level = pheno_log_get_level();
+    gosiuml_set_debug(false);
+
+    ContextJob jobs[4];
+    pthread_t tids[4];
+    int started = 0;
+    for (int t = 0; t < 4; t++) {
+        jobs[t] = (ContextJob){ .tokens = tokens, .index = t };
+        if (pthread_create(&tids[t], NULL, context_worker, &jobs[t]) != 0) break;
+        started++;
+    }
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    pheno_log_set_level(was_level);
+    pheno_pool_usage(pheno_pool_default(), &after);
+
+    bool ok = started == 4 && after.active_tokens == before.active_tokens;
+    for (int t = 0; ok && t < 4; t++) {
+        const GosiUMLContextStats* s = &jobs[t].stats;
+        ok = jobs[t].ok && s->tokens_allocated == 3200 && s->tokens_freed == 3200 &&
+             s->tokens_processed == 3200 && s->tokens_rejected == 0 && s->machines == 1 &&
+             s->documents == 1 && s->bytes_in_use == 0 && s->bytes_peak == 64 * 128 &&
+             s->pool_size == 256 * 1024 && s->symbols == (size_t)(10 + t + 6);
+    }
+
+    // Options are validated, and rejections are reported per context and thread
+    GosiUMLContext* ctx = gosiuml_create_context();
+    PhenoToken* token = gosiuml_context_alloc_token(ctx, 64);
+    ok = ok && token && strcmp(gosiuml_version(), "1.0.0") == 0 &&
+         gosiuml_get_option(ctx, GOSIUML_OPT_STATE_MACHINE) == 1 &&
+         gosiuml_set_option(ctx, GOSIUML_OPT_POOL_KB, 64) == -1 &&
+         gosiuml_set_option(ctx, (GosiUMLOption)42, 1) == -1 &&
+         strstr(gosiuml_get_error(), "unknown option 42");
+    if (token) {
+        memcpy(token->sentinel, "BROKEN", 7);
+        ok = ok && gosiuml_process_token(ctx, token) == -1 &&
+             strstr(gosiuml_context_error(ctx), "failed validation") &&
+             gosiuml_set_option(ctx, GOSIUML_OPT_STATE_MACHINE, 0) == 0 &&
+             !gosiuml_context_create_machine(ctx);
+        memcpy(token->sentinel, "PHENO_ALLOCATED", 16);
+        gosiuml_context_free_token(ctx, token);
+    }
+    GosiUMLContextStats stats;
+    gosiuml_context_stats(ctx, &stats);
+    ok = ok && stats.tokens_rejected == 1 && stats.tokens_freed == 1;
+    gosiuml_free_context(ctx);
+
+    printf("Contexts: %d, tokens per context: %llu, process pool untouched: %s (%s)\n",
+           started, (unsigned long long)jobs[0].stats.tokens_allocated,
+           after.active_tokens == before.active_tokens ? "yes" : "no",
+           ok ? "expected" : "UNEXPECTED");
+
+    nftw(dir, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static void* log_worker(void* arg) {
+    int t = (int)(intptr_t)arg;
+    char name[16];
+    for (unsigned i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "worker-%d", t);
+        PHENO_LOG(PHENO_LOG_INFO, "[T%d] record %u %s %.1f %c\n", t, i, name, i * 0.5, 'a' + t);
+        name[0] = '\0';  // The record keeps its own copy
+    }
+    return NULL;
+}
+
+// Run this binary with args, stdout and stderr into one file as with 2>&1
+static char* run_self(char* const args[], size_t* size) {
+    char path[] = "/tmp/gosiuml_self_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        execv("/proc/self/exe", args);
+        _exit(127);
+    }
+    int status = 0;
+    bool ran = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+               WEXITSTATUS(status) == 0;
+    close(fd);
+    char* text = ran ? read_text(path, size) : NULL;
+    unlink(path);
+    return text;
+}
+
+void test_output_order(void) {
+    printf("\n=== Testing Output Order ===\n");
+    
+    // Diagnostics of -b stay under its header, ahead of the -d header
+    char* args[] = { "gosiuml", "-b", "-d", NULL };
+    size_t size = 0;
+    char* text = run_self(args, &size);
+    const char* basic = text ? strstr(text, "=== Testing Basic State Transitions ===") : NULL;
+    const char* shared = basic ? strstr(basic, "[STATE_MACHINE] ACTIVE + SHARE -> SHARED") : NULL;
+    const char* degraded = shared ? strstr(shared, "=== Testing Degradation and Recovery ===") : NULL;
+    const char* hitl = degraded ? strstr(degraded, "[HITL]") : NULL;
+    bool ok = basic && shared && degraded && hitl && !strstr(degraded, "-> SHARED") &&
+              count_text(text, "[ALLOC]") == count_text(basic, "[ALLOC]");
+    printf("Sections in order: %s (%s)\n", ok ? "yes" : "no", ok ? "expected" : "UNEXPECTED");
+    free(text);
+}
+
+void test_async_logging(void) {
+    printf("\n=== Testing Asynchronous Logging ===\n");
+
+    FILE* sink = tmpfile();
+    if (!sink) return;
+    PhenoLogLevel was_level = pheno_log_get_level();
+    PhenoLogStats before, after;
+    pheno_log_get_stats(&before);
+    pheno_log_set_output(sink);
+    pheno_log_set_level(PHENO_LOG_INFO);
+
+    pthread_t tids[3];
+    int started = 0;
+    for (int t = 0; t < 3; t++) {
+        if (pthread_create(&tids[t], NULL, log_worker, (void*)(intptr_t)t) != 0) break;
+        started++;
+    }
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+
+    // Filtered at runtime; long strings are truncated to the record
+    char wide[128];
+    memset(wide, 'w', sizeof(wide) - 1);
+    wide[sizeof(wide) - 1] = '\0';
+    pheno_log_set_level(PHENO_LOG_WARN);
+    PHENO_LOG(PHENO_LOG_INFO, "filtered %d\n", 1);
+    PHENO_LOG(PHENO_LOG_WARN, "kept %s|%s|%5.1f%%\n", wide, "tail", 99.5);
+    pheno_log_flush();
+
+    size_t size = 0;
+    char* text = NULL;
+    if (fseek(sink, 0, SEEK_END) == 0 && (size = (size_t)ftell(sink)) > 0 && (text = malloc(size + 1))) {
+        rewind(sink);
+        size = fread(text, 1, size, sink);
+        text[size] = '\0';
+    }
+    pheno_log_get_stats(&after);
+    bool ok = started == 3 && text && count_text(text, "\n") == 1501 &&
+              strstr(text, "[T1] record 42 worker-1 21.0 b\n") &&
+              strstr(text, "[T2] record 499 worker-2 249.5 c\n") &&
+              !strstr(text, "filtered") && strstr(text, "|| 99.5%\n") &&
+              after.written - before.written == 1501 && after.dropped == before.dropped;
+    free(text);
+    
+    // An idle drain thread is woken by the next record, no flush needed
+    PhenoLogStats idle;
+    pheno_log_get_stats(&idle);
+    PHENO_LOG(PHENO_LOG_WARN, "wake %d\n", 1);
+    bool woken = false;
+    for (int i = 0; !woken && i < 2000; i++) {
+        usleep(1000);
+        pheno_log_get_stats(&after);
+        woken = after.written == idle.written + 1;
+    }
+    ok = ok && woken;
+
+    // Hot-path cost against formatting the same line synchronously, for
+    // information; only delivery is checked
+    FILE* null_out = fopen("/dev/null", "w");
+    pheno_log_set_output(null_out);
+    pheno_log_set_level(PHENO_LOG_DEBUG);
+    pheno_log_get_stats(&before);
+    uint64_t async_ns = 0, sync_ns = 0;
+    int batches = 50, batch = 1000;
+    for (int b = 0; null_out && b < batches; b++) {
+        uint64_t start = pheno_monotonic_ns();
+        for (int i = 0; i < batch; i++) {
+            PHENO_DEBUG("[ALLOC] Token allocated: size=%u, zone=%u, addr=%p\n",
+                        (unsigned)i, (unsigned)(i & 15), (void*)wide);
+        }
+        async_ns += pheno_monotonic_ns() - start;
+        pheno_log_flush();
+        start = pheno_monotonic_ns();
+        for (int i = 0; i < batch; i++) {
+            fprintf(null_out, "[ALLOC] Token allocated: size=%u, zone=%u, addr=%p\n",
+                    (unsigned)i, (unsigned)(i & 15), (void*)wide);
+        }
+        sync_ns += pheno_monotonic_ns() - start;
+    }
+    pheno_log_set_output(NULL);
+    pheno_log_get_stats(&after);
+    pheno_log_set_level(was_level);
+    double per_async = (double)async_ns / (batches * batch);
+    double per_sync = (double)sync_ns / (batches * batch);
+    ok = ok && null_out && after.written - before.written == (uint64_t)(batches * batch) &&
+         after.dropped == before.dropped;
+    if (null_out) fclose(null_out);
+    fclose(sink);
+
+    printf("Records: 1501, log call: %.1f ns, synchronous fprintf: %.1f ns (%s)\n",
+           per_async, per_sync, ok ? "expected" : "UNEXPECTED");
+}
+
+void test_phase_counters(void) {
+    printf("\n=== Testing Phase Counters ===\n");
+
+    char dir[] = "/tmp/gosiuml_phase_XXXXXX";
+    if (!mkdtemp(dir)) return;
+    char tokens[64], svg[64], json[64], line[96];
+    snprintf(tokens, sizeof(tokens), "%s/p.tok", dir);
+    snprintf(svg, sizeof(svg), "%s/p.svg", dir);
+    snprintf(json, sizeof(json), "%s/p.json", dir);
+    append_text(tokens, "w", "");
+    for (int i = 0; i < 300; i++) {
+        snprintf(line, sizeof(line), "TOKEN: 0x%X NODE_%d 0\nRELATION: 0x%X -> 0x%X : next\n",
+                 i, i % 5, i / 2, i);
+        append_text(tokens, "a", line);
+    }
+
+    PhenoTransitionStats* stats = malloc(sizeof(PhenoTransitionStats));
+    if (!stats) return;
+    bool was_stats = pheno_transition_stats_enabled();
+    bool was_perf = pheno_perf_enabled();
+    pheno_transition_stats_enable(true);
+    bool perf = pheno_perf_enable(true);
+    pheno_transition_stats_reset();
+
+    GosiUMLParseOptions options = { .threads = 1 };
+    GosiUMLDocument* doc = gosiuml_parse_document(tokens, &options);
+    Layout layout = {0};
+    bool ok = doc && layout_document(doc, NULL, &layout) &&
+              svg_render_layout(doc->tokens, doc->symbols, &layout, svg) == 0 &&
+              gosiuml_export_document(NULL, doc, FORMAT_JSON, json) == 0;
+    pheno_transition_stats_snapshot(stats, true);
+    for (int p = 0; ok && p < PHENO_PHASE_COUNT; p++) {
+        const PhenoPhaseStats* ph = &stats->phases[p];
+        ok = ph->count == 1 && ph->ns > 0 &&
+             (perf ? ph->counted == 1 && ph->cycles > 0 : ph->counted == 0 && ph->cycles == 0);
+    }
+    double parse_ms = stats->phases[PHENO_PHASE_PARSE].ns / 1e6;
+    double layout_ms = stats->phases[PHENO_PHASE_LAYOUT].ns / 1e6;
+
+    // Unmeasured phases only fire their tracepoints
+    pheno_perf_enable(false);
+    pheno_transition_stats_enable(false);
+    GosiUMLDocument* again = gosiuml_parse_document(tokens, &options);
+    pheno_transition_stats_snapshot(stats, true);
+    ok = ok && again && stats->phases[PHENO_PHASE_PARSE].count == 0;
+
+    pheno_transition_stats_enable(was_stats);
+    pheno_perf_enable(was_perf);
+#ifdef PHENO_TRACE_SDT
+    const char* sdt = "yes";
+#else
+    const char* sdt = "no";
+#endif
+    printf("Parse: %.2f ms, layout: %.2f ms, perf counters: %s, tracepoints: %s (%s)\n",
+           parse_ms, layout_ms, perf ? "yes" : "unavailable", sdt, ok ? "expected" : "UNEXPECTED");
+
+    gosiuml_free_document(again);
+    layout_free(&layout);
+    gosiuml_free_document(doc);
+    free(stats);
+    nftw(dir, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+typedef struct {
+    PhenoPool* pool;
+    bool ok;
+} PoolStatsJob;
+
+typedef struct {
+    PhenoPool* pool;
+    atomic_bool done;
+    uint64_t snapshots;
+    uint64_t ns;
+} PoolStatsReader;
+
+// 200 tokens of 100, 5000 and 70000 bytes in turn; every other one is freed
+static void* pool_stats_worker(void* arg) {
+    PoolStatsJob* job = arg;
+    static const uint32_t sizes[] = { 100, 5000, 70000 };
+    PhenoToken* kept[100];
+    int count = 0;
+    job->ok = true;
+    for (int i = 0; i < 200 && job->ok; i++) {
+        PhenoToken* token = pheno_pool_token_alloc(job->pool, sizes[i % 3]);
+        job->ok = token != NULL;
+        if (!token) break;
+        if (i % 2) {
+            pheno_pool_token_free(job->pool, token);
+        } else {
+            kept[count++] = token;
+        }
+    }
+    for (int i = 0; i < count; i++) pheno_pool_token_free(job->pool, kept[i]);
+    return NULL;
+}
+
+// Samples while the workers allocate; never takes the pool lock
+static void* pool_stats_reader(void* arg) {
+    PoolStatsReader* reader = arg;
+    PhenoMemoryStats stats;
+    while (!atomic_load(&reader->done)) {
+        uint64_t start = pheno_monotonic_ns();
+        pheno_pool_stats_snapshot(reader->pool, &stats);
+        reader->ns += pheno_monotonic_ns() - start;
+        reader->snapshots++;
+        sched_yield();
+    }
+    return NULL;
+}
+
+void test_memory_snapshot(void) {
+    printf("\n=== Testing Pool Statistics Snapshot ===\n");
+
+    PhenoPool* pool = pheno_pool_create(32u << 20, true);
+    if (!pool) return;
+    PhenoLogLevel was_level = pheno_log_get_level();
+    gosiuml_set_debug(false);
+
+    PoolStatsJob jobs[4];
+    PoolStatsReader reader = { .pool = pool };
+    pthread_t tids[4], reader_tid;
+    bool reading = pthread_create(&reader_tid, NULL, pool_stats_reader, &reader) == 0;
+    int started = 0;
+    for (int t = 0; t < 4; t++) {
+        jobs[t].pool = pool;
+        if (pthread_create(&tids[t], NULL, pool_stats_worker, &jobs[t]) != 0) break;
+        started++;
+    }
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    atomic_store(&reader.done, true);
+    if (reading) pthread_join(reader_tid, NULL);
+    bool ok = started == 4 && reading;
+    for (int t = 0; t < started; t++) ok = ok && jobs[t].ok;
+
+    // Everything freed: 800 allocations, blocks carved once per peak
+    PhenoMemoryStats stats;
+    pheno_pool_stats_snapshot(pool, &stats);
+    PhenoPoolUsage usage;
+    pheno_pool_usage(pool, &usage);
+    const PhenoSizeClassStats* small = &stats.classes[1];   // 128-byte blocks
+    const PhenoSizeClassStats* large = &stats.classes[PHENO_POOL_LARGE_CLASS];
+    ok = ok && stats.allocations == 800 && stats.frees == 800 && stats.tokens_live == 0 &&
+         stats.bytes_live == 0 && stats.failures == 0 && stats.high_water == usage.used_size &&
+         small->block_size == 128 && small->live == 0 && small->carved > 0 &&
+         large->carved == 264 && stats.lock_acquisitions >= 1600 &&
+         stats.free_list_bytes + large->carved * 70000 == stats.high_water &&
+         stats.fragmentation == 1.0;
+
+    // Live tokens: requested bytes and the block padding around them;
+    // small blocks come off the free lists
+    uint64_t carved = small->carved;
+    PhenoToken* a = pheno_pool_token_alloc(pool, 100);
+    PhenoToken* b = pheno_pool_token_alloc(pool, 5000);
+    pheno_pool_stats_snapshot(pool, &stats);
+    ok = ok && a && b && stats.tokens_live == 2 && stats.bytes_live == 5100 &&
+         stats.internal_waste == 28 + 3192 && small->carved == carved;
+
+    size_t length = pheno_memory_stats_json(&stats, NULL, 0);
+    char* json = malloc(length + 1);
+    ok = ok && json && pheno_memory_stats_json(&stats, json, length + 1) == length &&
+         strstr(json, "\"allocations\":802,") && strstr(json, "\"tokens_live\":2,") &&
+         strstr(json, "{\"block_size\":128,") && count_text(json, "{") == count_text(json, "}") &&
+         json[length - 1] == '}';
+    free(json);
+    pheno_pool_token_free(pool, a);
+    pheno_pool_token_free(pool, b);
+    pheno_log_set_level(was_level);
+
+    printf("Snapshots during load: %llu (%.0f ns each), lock waits: %llu, fragmentation: %.2f (%s)\n",
+           (unsigned long long)reader.snapshots,
+           reader.snapshots ? (double)reader.ns / reader.snapshots : 0.0,
+           (unsigned long long)stats.lock_contended, stats.fragmentation,
+           ok ? "expected" : "UNEXPECTED");
+    pheno_pool_destroy(pool);
+}
+
+// Compile a token file to .gosib
+int run_gosib_compile(const char* path) {
+    GosibCompileStats stats;
+    uint64_t start = pheno_monotonic_ns();
+    if (!gosib_compile(path, NULL, &stats)) {
+        fprintf(stderr, "Cannot compile %s\n", path);
+        return 1;
+    }
+    printf("\n=== Compiled %s%s ===\n", path, GOSIB_EXTENSION);
+    printf("Tokens: %u, edges: %u, dangling: %u, strings: %u, malformed: %llu, %.3f s\n",
+           stats.tokens, stats.edges, stats.dangling, stats.strings,
+           (unsigned long long)stats.malformed, (pheno_monotonic_ns() - start) / 1e9);
+    return 0;
+}
+
+// Map a .gosib file and report what is available without parsing
+int run_gosib_load(const char* path) {
+    GosibFile file;
+    uint64_t start = pheno_monotonic_ns();
+    if (!gosib_open(&file, path)) {
+        fprintf(stderr, "Cannot load %s\n", path);
+        return 1;
+    }
+    double secs = (pheno_monotonic_ns() - start) / 1e9;
+    printf("\n=== Loaded %s ===\n", path);
+    printf("Tokens: %u, edges: %u, dangling: %u, strings: %u, %.6f s\n",
+           file.header->token_count, file.header->edge_count,
+           file.header->dangling_count, file.header->string_count, secs);
+    gosib_close(&file);
+    return 0;
+}
+
+// Scan a token file without allocating and report throughput
+int run_scan_benchmark(const char* path) {
+    uint64_t sum = 0;
+    TokenScanCallbacks callbacks = { count_token, count_relation, &sum };
+    TokenScanStats stats = {0};
+    
+    uint64_t start = pheno_monotonic_ns();
+    if (token_scan_file(path, &callbacks, &stats) < 0) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+    double secs = (pheno_monotonic_ns() - start) / 1e9;
+    
+    printf("\n=== Token Scan: %s ===\n", path);
+    printf("Bytes: %llu, lines: %llu, tokens: %llu, relations: %llu, malformed: %llu\n",
+           (unsigned long long)stats.bytes, (unsigned long long)stats.lines,
+           (unsigned long long)stats.tokens, (unsigned long long)stats.relations,
+           (unsigned long long)stats.malformed);
+    printf("Elapsed: %.3f s (%.1f MB/s)\n", secs,
+           secs > 0 ? stats.bytes / secs / 1e6 : 0.0);
+    return 0;
+}
+
+void test_parallel_parse(void) {
+    printf("\n=== Testing Parallel Parse ===\n");
+    
+    char path[] = "/tmp/gosiuml_parse_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    FILE* fp = fdopen(fd, "w");
+    for (int i = 0; i < 2000; i++) {
+        fprintf(fp, "TOKEN: 0x%08X NODE_%d %d\n", i, i % 7, i % 16);
+        if (i % 4 == 3) fprintf(fp, "RELATION: 0x%08X -> 0x%08X : link\n", i, i - 1);
+    }
+    fclose(fp);
+    
+    // Serial reference vs many small chunks on four threads
+    GosiUMLRelation* serial_rel = NULL;
+    GosiUMLRelation* parallel_rel = NULL;
+    int serial_count = 0, parallel_count = 0;
+    int serial_rel_count = 0, parallel_rel_count = 0;
+    
+    GosiUMLParseOptions serial = { 1, 0, &serial_rel, &serial_rel_count, NULL, NULL, NULL };
+    GosiUMLParseOptions parallel = { 4, 1024, &parallel_rel, &parallel_rel_count, NULL, NULL, NULL };
+    PhenoToken* a = gosiuml_parse_file_ex(path, &serial, &serial_count);
+    PhenoToken* b = gosiuml_parse_file_ex(path, &parallel, &parallel_count);
+    
+    bool ok = a && b && serial_count == 2000 && parallel_count == serial_count &&
+              serial_rel_count == 500 && parallel_rel_count == serial_rel_count &&
+              memcmp(serial_rel, parallel_rel, serial_rel_count * sizeof(GosiUMLRelation)) == 0;
+    for (int i = 0; ok && i < serial_count; i++) {
+        ok = a[i].token_id == b[i].token_id && a[i].memory_zone == b[i].memory_zone &&
+             strcmp(a[i].sentinel, b[i].sentinel) == 0;
+    }
+    
+    // Document model carries the same arrays from a single arena
+    GosiUMLParseOptions doc_options = { 4, 1024, NULL, NULL, NULL, NULL, NULL };
+    GosiUMLDocument* doc = gosiuml_parse_document(path, &doc_options);
+    ok = ok && doc && doc->token_count == (size_t)serial_count &&
+         doc->relation_count == (size_t)serial_rel_count &&
+         doc->tokens[serial_count - 1].token_id == a[serial_count - 1].token_id;
+    for (int i = 0; ok && i < serial_rel_count; i++) {
+        ok = doc->relations[i].src_id == serial_rel[i].src_id &&
+             doc->relations[i].dst_id == serial_rel[i].dst_id &&
+             strcmp(doc->relations[i].type, serial_rel[i].type) == 0;
+    }
+    gosiuml_free_document(doc);
+    
+    // A caller's pool drives the chunks whatever threads says, and serves
+    // parse after parse
+    PhenoThreadPool* pool = pheno_threadpool_create(3);
+    doc_options.threads = 1;
+    doc_options.pool = pool;
+    for (int round = 0; ok && round < 2; round++) {
+        doc = pool ? gosiuml_parse_document(path, &doc_options) : NULL;
+        ok = doc && doc->token_count == (size_t)serial_count &&
+             doc->relation_count == (size_t)serial_rel_count;
+        for (int i = 0; ok && i < serial_rel_count; i++) {
+            ok = doc->relations[i].src_id == serial_rel[i].src_id &&
+                 doc->relations[i].dst_id == serial_rel[i].dst_id;
+        }
+        gosiuml_free_document(doc);
+    }
+    pheno_threadpool_destroy(pool);
+    
+    printf("Tokens: %d/%d, relations: %d/%d, order preserved (%s)\n",
+           serial_count, parallel_count, serial_rel_count, parallel_rel_count,
+           ok ? "expected" : "UNEXPECTED");
+    
+    unlink(path);
+    gosiuml_free_tokens(a, serial_count);
+    gosiuml_free_tokens(b, parallel_count);
+    gosiuml_free_relations(serial_rel);
+    gosiuml_free_relations(parallel_rel);
+}
+
+void test_symbol_interning(void) {
+    printf("\n=== Testing Symbol Interning ===\n");
+    
+    static const char* long_type = "CLUSTER_CONSENSUS_COORDINATOR_WITH_A_VERY_LONG_NAME";
+    char path[] = "/tmp/gosiuml_symbols_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    FILE* fp = fdopen(fd, "w");
+    for (int i = 0; i < 300; i++) {
+        fprintf(fp, "TOKEN: 0x%X %s zone_%d\n", i, i % 3 ? "NODE_STATE" : long_type, i % 4);
+    }
+    fclose(fp);
+    
+    // Small chunks so several chunk-local tables are merged
+    GosiUMLParseOptions options = { 4, 512, NULL, NULL, NULL, NULL, NULL };
+    GosiUMLDocument* doc = gosiuml_parse_document(path, &options);
+    
+    // Into a caller's table, ids follow what it already holds
+    PhenoSymbolTable* shared = pheno_symbols_create();
+    PhenoSymbol seeded = shared ? pheno_symbols_intern(shared, "NODE_STATE", 10) : PHENO_SYMBOL_NONE;
+    options.symbols = shared;
+    GosiUMLDocument* into = shared ? gosiuml_parse_document(path, &options) : NULL;
+    bool shared_ok = into && into->symbols == shared && into->shared_symbols &&
+                     into->tokens[1].type_symbol == seeded && pheno_symbols_count(shared) == 6;
+    gosiuml_free_document(into);
+    pheno_symbols_destroy(shared);
+    unlink(path);
+    if (!doc) return;
+    
+    PhenoSymbol want = gosiuml_document_symbol(doc, long_type);
+    size_t matches = 0;
+    for (size_t i = 0; i < doc->token_count; i++) {
+        if (doc->tokens[i].type_symbol == want) matches++;
+    }
+    bool ok = want != PHENO_SYMBOL_NONE && matches == 100 &&
+              pheno_symbols_count(doc->symbols) == 6 &&
+              strcmp(pheno_symbols_name(doc->symbols, doc->tokens[0].type_symbol), long_type) == 0 &&
+              strcmp(pheno_symbols_name(doc->symbols, doc->tokens[7].zone_symbol), "zone_3") == 0 &&
+              shared_ok;
+    
+    // The rendered box shows the whole name, not the 16-byte sentinel
+    char svg[] = "/tmp/gosiuml_symbols_svg_XXXXXX";
+    Layout layout = {0};
+    fd = mkstemp(svg);
+    if (fd >= 0) close(fd);
+    size_t svg_len = 0;
+    char* text = fd >= 0 && layout_document(doc, NULL, &layout) &&
+                 svg_render_layout(doc->tokens, doc->symbols, &layout, svg) == 0 ?
+                 read_text(svg, &svg_len) : NULL;
+    ok = ok && text && count_text(text, long_type) == 100;
+    free(text);
+    layout_free(&layout);
+    if (fd >= 0) unlink(svg);
+    printf("Symbols: %zu, long type matches: %zu (%s)\n",
+           pheno_symbols_count(doc->symbols), matches, ok ? "expected" : "UNEXPECTED");
+    gosiuml_free_document(doc);
+}
+
+// Fill the -H template with document figures and write it to the -o file
+static int run_report(const GosiUMLDocument* doc, const char* source) {
+    char error[256];
+    const ReportTemplate* tpl = template_load(g_template, error, sizeof(error));
+    if (!tpl || !g_svg_output) {
+        fprintf(stderr, "Cannot render %s: %s\n", g_template, tpl ? "no -o output" : error);
+        return 1;
+    }
+    
+    char version[32];
+    snprintf(version, sizeof(version), "%d.%d.%d",
+             GOSIUML_VERSION_MAJOR, GOSIUML_VERSION_MINOR, GOSIUML_VERSION_PATCH);
+    TemplateValue values[TEMPLATE_MAX_SLOTS];
+    memset(values, 0, sizeof(values));
+    for (size_t i = 0; i < template_slot_count(tpl); i++) {
+        size_t len;
+        const char* name = template_slot_name(tpl, i, &len);
+        TemplateValue* v = &values[i];
+        if (len == 5 && memcmp(name, "title", 5) == 0) v->str = source;
+        else if (len == 7 && memcmp(name, "version", 7) == 0) v->str = version;
+        else if (len == 6 && memcmp(name, "tokens", 6) == 0) v->u = doc->token_count;
+        else if (len == 9 && memcmp(name, "relations", 9) == 0) v->u = doc->relation_count;
+        else if (len == 9 && memcmp(name, "malformed", 9) == 0) v->u = doc->malformed;
+        else if (len == 11 && memcmp(name, "source_size", 11) == 0) v->u = doc->source_size;
+        v->i = (int64_t)v->u;
+    }
+    
+    uint64_t start = pheno_monotonic_ns();
+    struct stat st;
+    if (template_render_file(tpl, values, g_svg_output) != 0 || stat(g_svg_output, &st) != 0) {
+        fprintf(stderr, "Cannot write %s\n", g_svg_output);
+        return 1;
+    }
+    printf("Report: %s, %lld bytes, %.6f s\n", g_svg_output, (long long)st.st_size,
+           (pheno_monotonic_ns() - start) / 1e9);
+    return 0;
+}
+
+// Parse a token file into a document and report throughput
+int run_parse_benchmark(const char* path, int threads) {
+    GosiUMLParseOptions options = { threads, 0, NULL, NULL, NULL, NULL, NULL };
+    ParseCacheResult cache;
+    
+    uint64_t start = pheno_monotonic_ns();
+    GosiUMLDocument* doc = g_parse_cache ?
+        parse_cache_load_document(g_parse_cache, path, &cache) :
+        gosiuml_parse_document(path, &options);
+    double secs = (pheno_monotonic_ns() - start) / 1e9;
+    if (!doc) {
+        fprintf(stderr, "Cannot parse %s\n", path);
+        return 1;
+    }
+    
+    printf("\n=== Parse: %s (%s threads) ===\n", path, threads > 0 ? "fixed" : "auto");
+    if (g_parse_cache) {
+        printf("Cache: %s (%s)\n", parse_cache_outcome_name(cache.outcome), cache.entry_path);
+    }
+    printf("Tokens: %zu, relations: %zu, malformed: %llu, elapsed: %.3f s\n",
+           doc->token_count, doc->relation_count,
+           (unsigned long long)doc->malformed, secs);
+    
+    if (g_template) {
+        int rc = run_report(doc, path);
+        gosiuml_free_document(doc);
+        return rc;
+    }
+    
+    // -o picks the format from its extension
+    GosiUMLFormat format = g_svg_output ? gosiuml_format_from_path(g_svg_output) : FORMAT_SVG;
+    const char* svg_output = format == FORMAT_SVG ? g_svg_output : NULL;
+    if (format != FORMAT_SVG) {
+        struct stat st;
+        start = pheno_monotonic_ns();
+        if (gosiuml_export_document(NULL, doc, format, g_svg_output) != 0 ||
+            stat(g_svg_output, &st) != 0) {
+            gosiuml_free_document(doc);
+            return 1;
+        }
+        secs = (pheno_monotonic_ns() - start) / 1e9;
+        printf("%s: %s, %lld bytes, %.3f s (%.1f MB/s)\n", format == FORMAT_XML ? "XML" : "JSON",
+               g_svg_output, (long long)st.st_size, secs, secs > 0 ? st.st_size / secs / 1e6 : 0.0);
+    }
+    
+    if (svg_output || g_tile_dir) {
+        LayoutOptions layout_options;
+        layout_defaults(&layout_options);
+        layout_options.mode = g_layout_mode;
+        layout_options.threads = threads;
+        
+        Layout layout;
+        struct stat st;
+        if (!layout_document(doc, &layout_options, &layout)) {
+            gosiuml_free_document(doc);
+            return 1;
+        }
+        printf("Layout: %s, %zu nodes, %zu edges, %.0fx%.0f, %.3f s\n",
+               layout_mode_name(layout.mode), layout.node_count, layout.edge_count,
+               layout.width, layout.height, layout.seconds);
+        
+        if (g_tile_dir) {
+            TileOptions tile_options;
+            TileStats tiles;
+            tile_defaults(&tile_options);
+            snprintf(tile_options.dir, sizeof(tile_options.dir), "%s", g_tile_dir);
+            tile_options.threads = threads;
+            if (!tile_pyramid_write(doc, &layout, &tile_options, &tiles)) {
+                fprintf(stderr, "Cannot write tiles to %s\n", g_tile_dir);
+                layout_free(&layout);
+                gosiuml_free_document(doc);
+                return 1;
+            }
+            printf("Tiles: %s, %u levels (detail %u), %llu tiles, %llu aggregates, %llu bytes, %.3f s\n",
+                   g_tile_dir, tiles.levels, tiles.detail_level, (unsigned long long)tiles.tiles,
+                   (unsigned long long)tiles.aggregates, (unsigned long long)tiles.bytes, tiles.seconds);
+        }
+        
+        start = pheno_monotonic_ns();
+        int rc = svg_output ? svg_render_layout(doc->tokens, doc->symbols, &layout, svg_output) : 0;
+        layout_free(&layout);
+        if (svg_output && (rc != 0 || stat(svg_output, &st) != 0)) {
+            gosiuml_free_document(doc);
+            return 1;
+        }
+        secs = (pheno_monotonic_ns() - start) / 1e9;
+        if (svg_output) {
+            printf("SVG: %s, %lld bytes, %.3f s (%.1f MB/s)\n", svg_output, (long long)st.st_size,
+                   secs, secs > 0 ? st.st_size / secs / 1e6 : 0.0);
+        }
+    }
+    gosiuml_free_document(doc);
+    return 0;
+}
+
+// Render every file of a manifest or glob; outputs default to the -o directory
+int run_batch(const char* spec, int threads) {
+    BatchList list;
+    if (!batch_list_load(spec, g_svg_output, &list)) {
+        fprintf(stderr, "Cannot load batch %s\n", spec);
+        return 1;
+    }
+    BatchOptions options;
+    BatchStats stats;
+    batch_defaults(&options);
+    options.threads = threads;
+    options.layout = g_layout_mode;
+    bool ok = batch_run(&list, &options, &stats);
+    batch_list_free(&list);
+    
+    double secs = stats.seconds;
+    printf("\n=== Batch: %s ===\n", spec);
+    printf("Files: %llu, failed: %llu, workers: %d, tokens: %llu, relations: %llu\n",
+           (unsigned long long)stats.files, (unsigned long long)stats.failed, stats.workers,
+           (unsigned long long)stats.tokens, (unsigned long long)stats.relations);
+    printf("In: %.1f MB, out: %.1f MB, %.3f s (%.1f files/s, %.1f MB/s in)\n",
+           stats.input_bytes / 1e6, stats.output_bytes / 1e6, secs,
+           secs > 0 ? stats.files / secs : 0.0, secs > 0 ? stats.input_bytes / secs / 1e6 : 0.0);
+    printf("Stages (worker s): parse %.3f, layout %.3f, render %.3f; arena peak: %zu bytes\n",
+           stats.parse_seconds, stats.layout_seconds, stats.render_seconds, stats.arena_peak);
+    return ok ? 0 : 1;
+}
+
+static void* daemon_signal_run(void* arg) {
+    sigset_t* set = arg;
+    int sig;
+    if (sigwait(set, &sig) == 0 && g_daemon) daemon_shutdown(g_daemon);
+    return NULL;
+}
+
+// Serve on socket_path until a SHUTDOWN request, SIGINT or SIGTERM
+int run_daemon(const char* socket_path, int threads) {
+    DaemonOptions options;
+    daemon_defaults(&options);
+    snprintf(options.socket_path, sizeof(options.socket_path), "%s", socket_path);
+    options.threads = threads;
+    options.layout = g_layout_mode;
+    options.parse_cache = g_parse_cache;
+    
+    // Signals are taken by a thread so shutdown runs outside a handler
+    static sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    g_daemon = daemon_start(&options);
+    if (!g_daemon) return 1;
+    pthread_t signals;
+    bool watching = pthread_create(&signals, NULL, daemon_signal_run, &set) == 0;
+    
+    daemon_wait(g_daemon);
+    DaemonStats stats;
+    daemon_get_stats(g_daemon, &stats);
+    daemon_stop(g_daemon);
+    g_daemon = NULL;
+    if (watching) {
+        pthread_kill(signals, SIGTERM);
+        pthread_join(signals, NULL);
+    }
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+    
+    printf("Daemon: %llu requests, %llu errors, %llu parses, %llu hits, %llu renders, "
+           "p50 %.1f us, p99 %.1f us\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.errors,
+           (unsigned long long)stats.parses, (unsigned long long)stats.hits,
+           (unsigned long long)stats.renders, stats.p50_ns / 1e3, stats.p99_ns / 1e3);
+    return 0;
+}
+
+// Relative paths are resolved here, not in the daemon's working directory
+static const char* absolute_path(const char* path, char* buf, size_t size) {
+    char cwd[1024];
+    if (path[0] == '/' || !getcwd(cwd, sizeof(cwd))) return path;
+    snprintf(buf, size, "%s/%s", cwd, path);
+    return buf;
+}
+
+// Thin client: one request per run, or g_client_repeat for latency
+int run_client(const char* socket_path, int argc, char** argv) {
+    DaemonOp op = argc > 0 ? daemon_parse_op(argv[0]) : 0;
+    if (!op || argc - 1 > DAEMON_MAX_ARGS) {
+        fprintf(stderr, "Usage: --client <socket> ping|parse|render|query|stats|shutdown [args]\n");
+        return 1;
+    }
+    
+    char paths[2][1200];
+    const char* args[DAEMON_MAX_ARGS];
+    int count = argc - 1;
+    for (int i = 0; i < count; i++) {
+        // parse/render/query: file arguments come first (input, render output)
+        bool file = op != DAEMON_PING && op != DAEMON_STATS && i < (op == DAEMON_RENDER ? 2 : 1);
+        args[i] = file ? absolute_path(argv[i + 1], paths[i], sizeof(paths[i])) : argv[i + 1];
+    }
+    
+    int fd = daemon_connect(socket_path);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot connect to %s\n", socket_path);
+        return 1;
+    }
+    static char reply[1 << 16];
+    int repeat = g_client_repeat > 0 ? g_client_repeat : 1;
+    int status = 0;
+    uint64_t start = pheno_monotonic_ns();
+    for (int i = 0; i < repeat && status == DAEMON_OK; i++) {
+        status = daemon_request(fd, op, count, args, reply, sizeof(reply));
+    }
+    double secs = (pheno_monotonic_ns() - start) / 1e9;
+    daemon_disconnect(fd);
+    
+    if (status < 0) {
+        fprintf(stderr, "Connection to %s lost\n", socket_path);
+        return 1;
+    }
+    printf("%s\n", status == DAEMON_OK ? reply : "{}");
+    if (repeat > 1) printf("Round trip: %.1f us over %d requests\n", secs * 1e6 / repeat, repeat);
+    return status == DAEMON_OK ? 0 : 1;
+}
+
+static void watch_on_signal(int sig) {
+    (void)sig;
+    watch_stop(g_watch);
+}
+
+// Re-render changed token files under path until SIGINT or SIGTERM
+int run_watch(const char* path, int threads) {
+    WatchOptions options;
+    watch_defaults(&options);
+    options.threads = threads;
+    options.layout = g_layout_mode;
+    options.out_dir = g_svg_output;
+    g_watch = watch_create(&options);
+    if (!g_watch || !watch_add(g_watch, path)) {
+        fprintf(stderr, "Cannot watch %s\n", path);
+        watch_destroy(g_watch);
+        g_watch = NULL;
+        return 1;
+    }
+    
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    printf("[WATCH] Watching %s\n", path);
+    fflush(stdout);
+    int rc = watch_run(g_watch);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    
+    WatchStats stats;
+    watch_get_stats(g_watch, &stats);
+    printf("Watch: %llu files, %llu events, %llu batches, %llu renders, %llu failed, "
+           "%.1f MB parsed, latency p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           (unsigned long long)stats.files, (unsigned long long)stats.events,
+           (unsigned long long)stats.batches, (unsigned long long)stats.renders,
+           (unsigned long long)stats.failed, stats.parsed_bytes / 1e6,
+           stats.p50_ns / 1e6, stats.p99_ns / 1e6, stats.max_ns / 1e6);
+    watch_destroy(g_watch);
+    g_watch = NULL;
+    return rc == 0 ? 0 : 1;
+}
+
 void test_concurrent_access(void) {
     printf("\n=== Testing Concurrent Token Access ===\n");
     
@@ -127,46 +2115,213 @@ void test_memory_zones(void) {
     }
 }
 
-void run_stress_test(int iterations) {
-    printf("\n=== Running Stress Test (%d iterations) ===\n", iterations);
+void test_transition_stats(void) {
+    printf("\n=== Testing Transition Instrumentation ===\n");
     
-    clock_t start = clock();
-    int success_count = 0;
-    int failure_count = 0;
+    bool was_enabled = pheno_transition_stats_enabled();
+    pheno_transition_stats_enable(true);
+    pheno_transition_stats_reset();
     
-    for (int i = 0; i < iterations; i++) {
-        StateMachine* sm = create_state_machine();
-        if (!sm) {
-            failure_count++;
-            continue;
-        }
-        
-        initialize_state_machine(sm);
+    StateMachine* sm = create_state_machine();
+    initialize_state_machine(sm);
+    step_state_machine(sm, EVENT_ALLOC);
+    step_state_machine(sm, EVENT_LOCK);
+    step_state_machine(sm, EVENT_VALIDATE);
+    step_state_machine(sm, EVENT_FREE);
+    destroy_state_machine(sm);
+    
+    PhenoTransitionStats* stats = malloc(sizeof(PhenoTransitionStats));
+    if (stats) {
+        pheno_transition_stats_snapshot(stats, true);
         
-        // Random state transitions
-        int num_events = rand() % 10 + 1;
-        for (int j = 0; j < num_events; j++) {
-            PhenoEvent event = (PhenoEvent)(rand() % 8);
-            step_state_machine(sm, event);
+        // One sample per step and one dwell per state left
+        static const struct { PhenoState from; PhenoEvent event; } path[] = {
+            { STATE_NIL, EVENT_ALLOC }, { STATE_ALLOCATED, EVENT_LOCK },
+            { STATE_LOCKED, EVENT_VALIDATE }, { STATE_ACTIVE, EVENT_FREE }
+        };
+        bool ok = true;
+        for (size_t i = 0; i < sizeof(path) / sizeof(path[0]); i++) {
+            uint64_t steps = stats->transition_latency[path[i].from][path[i].event].total_count;
+            uint64_t dwell = stats->time_in_state[path[i].from].total_count;
+            printf("%s+%s samples: %llu, %s dwell samples: %llu\n",
+                   get_state_name(path[i].from), get_event_name(path[i].event),
+                   (unsigned long long)steps, get_state_name(path[i].from),
+                   (unsigned long long)dwell);
+            ok = ok && steps == 1 && dwell == 1;
         }
-        
-        destroy_state_machine(sm);
-        success_count++;
-        
-        if ((i + 1) % 100 == 0) {
-            printf("Progress: %d/%d\r", i + 1, iterations);
-            fflush(stdout);
+        printf("Transition coverage (%s)\n", ok ? "expected" : "UNEXPECTED");
+        free(stats);
+    }
+    
+    pheno_transition_stats_enable(was_enabled);
+}
+
+void test_journal_replay(void) {
+    printf("\n=== Testing Journal Record/Replay ===\n");
+    
+    const char* path = "test_journal.pjnl";
+    static const PhenoEvent script[] = {
+        EVENT_ALLOC, EVENT_LOCK, EVENT_LOCK, EVENT_VALIDATE,
+        EVENT_SHARE, EVENT_FREE, EVENT_DEGRADE, EVENT_RECOVER
+    };
+    
+    PhenoJournalWriter* writer = pheno_journal_open(path);
+    if (!writer) return;
+    for (uint32_t m = 0; m < 4; m++) {
+        for (size_t e = 0; e < sizeof(script) / sizeof(script[0]); e++) {
+            pheno_journal_record(writer, 1000 + m * 7, script[(e + m) % 8]);
         }
     }
+    pheno_journal_close(writer);
+    
+    PhenoReplayStats single, multi;
+    bool ok = pheno_journal_replay(path, 1, &single) &&
+              pheno_journal_replay(path, 2, &multi);
+    printf("Replayed %zu events over %zu machines: digest %016llx/%016llx (%s)\n",
+           single.events, single.machines,
+           (unsigned long long)single.state_digest,
+           (unsigned long long)multi.state_digest,
+           (ok && single.events == 32 && single.machines == 4 &&
+            single.state_digest == multi.state_digest) ? "expected" : "UNEXPECTED");
+    
+    // A journal closed before any event still has its header
+    writer = pheno_journal_open(path);
+    if (!writer) return;
+    pheno_journal_close(writer);
+    PhenoReplayStats empty;
+    ok = pheno_journal_replay(path, 1, &empty);
+    printf("Empty journal: %s, %zu events (%s)\n", ok ? "loaded" : "rejected",
+           ok ? empty.events : 0, (ok && empty.events == 0) ? "expected" : "UNEXPECTED");
+    
+    // More machines than the process pool has 4 KB tokens for
+    writer = pheno_journal_open(path);
+    if (!writer) return;
+    uint32_t many = 8000;
+    for (uint32_t m = 0; m < many; m++) {
+        pheno_journal_record(writer, m, EVENT_ALLOC);
+        if (m % 2) pheno_journal_record(writer, m, EVENT_LOCK);
+    }
+    pheno_journal_close(writer);
+    PhenoLogLevel was_level = pheno_log_get_level();
+    gosiuml_set_debug(false);
+    PhenoReplayStats wide;
+    ok = pheno_journal_replay(path, 2, &wide);
+    pheno_log_set_level(was_level);
+    ok = ok && wide.machines == many && wide.final_states[STATE_ALLOCATED] == many / 2 &&
+         wide.final_states[STATE_LOCKED] == many / 2;
+    printf("Wide journal: %zu machines replayed (%s)\n", ok ? wide.machines : 0,
+           ok ? "expected" : "UNEXPECTED");
+    
+    unlink(path);
+}
+
+void test_load_replay(void) {
+    printf("\n=== Testing Load Generator Journal Replay ===\n");
+    
+    const char* path = "test_load.pjnl";
+    LoadGenConfig config;
+    load_generator_defaults(&config);
+    config.threads = 4;
+    config.machines = 16;
+    config.shared_ratio = 0.5;
+    config.duration_sec = 0.0;
+    config.max_steps = 20000;
+    config.seed = 7;
+    config.journal = pheno_journal_open(path);
+    if (!config.journal) return;
+    
+    // Shared machines are stepped from every thread; the journal must still
+    // reproduce each machine's history, recycles included
+    LoadGenResult live;
+    bool ok = load_generator_run(&config, &live);
+    ok = pheno_journal_close(config.journal) && ok;
+    
+    PhenoLogLevel was_level = pheno_log_get_level();
+    gosiuml_set_debug(false);
+    PhenoReplayStats replay;
+    ok = ok && pheno_journal_replay(path, 2, &replay);
+    pheno_log_set_level(was_level);
+    
+    // Machines that never saw an event stay NIL and are not in the journal
+    if (ok) replay.final_states[STATE_NIL] += (uint32_t)config.machines - (uint32_t)replay.machines;
+    for (int st = 0; ok && st < PHENO_STATE_COUNT; st++) {
+        ok = live.final_states[st] == replay.final_states[st];
+    }
+    printf("Steps %llu, recycled %llu, replayed %zu events: final states %s (%s)\n",
+           (unsigned long long)live.steps, (unsigned long long)live.recycled,
+           ok ? replay.events : 0, ok ? "match" : "differ",
+           (ok && live.recycled > 0 && replay.events == live.steps + live.recycled) ?
+           "expected" : "UNEXPECTED");
+    unlink(path);
+    
+    // A machine set larger than the process pool still runs in full
+    config.journal = NULL;
+    config.threads = 2;
+    config.machines = 8000;
+    config.max_steps = 20000;
+    LoadGenResult wide;
+    ok = load_generator_run(&config, &wide);
+    uint32_t accounted = 0;
+    for (int st = 0; ok && st < PHENO_STATE_COUNT; st++) accounted += wide.final_states[st];
+    ok = ok && accounted == 8000 && wide.steps == 20000;
+    printf("Wide load: %u machines, %llu steps (%s)\n", accounted,
+           (unsigned long long)(ok ? wide.steps : 0), ok ? "expected" : "UNEXPECTED");
+}
+
+// Run the load generator and report (JSON too when requested)
+int run_load_test(LoadGenConfig* config) {
+    config->journal = g_journal;
+    
+    printf("\n=== Running Load Test (%d threads, %d machines) ===\n",
+           config->threads, config->machines);
+    
+    LoadGenResult result;
+    if (!load_generator_run(config, &result)) {
+        fprintf(stderr, "Load test failed\n");
+        return 1;
+    }
+    load_generator_print(stdout, config, &result);
     
-    clock_t end = clock();
-    double cpu_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+    if (config->json_path[0]) {
+        bool to_stdout = strcmp(config->json_path, "-") == 0;
+        FILE* out = to_stdout ? stdout : fopen(config->json_path, "w");
+        if (!out) {
+            perror("Failed to create JSON report");
+            return 1;
+        }
+        load_generator_write_json(out, config, &result);
+        if (!to_stdout) fclose(out);
+    }
+    return 0;
+}
+
+// Single-threaded run over n machines, ~10 events each
+int run_stress_test(int iterations) {
+    LoadGenConfig config;
+    load_generator_defaults(&config);
+    config.threads = 1;
+    config.machines = iterations > 0 ? iterations : 1;
+    config.shared_ratio = 0.0;
+    config.duration_sec = 0.0;
+    config.max_steps = (uint64_t)config.machines * 10;
+    return run_load_test(&config);
+}
+
+// Process pool statistics as one JSON line ("-" = stdout)
+static int write_memory_json(const char* path) {
+    PhenoMemoryStats stats;
+    pheno_memory_stats_snapshot(&stats);
+    size_t length = pheno_memory_stats_json(&stats, NULL, 0);
+    char* json = malloc(length + 1);
+    if (!json) return -1;
+    pheno_memory_stats_json(&stats, json, length + 1);
     
-    printf("\nStress Test Results:\n");
-    printf("  Successful: %d\n", success_count);
-    printf("  Failed:     %d\n", failure_count);
-    printf("  Time:       %.3f seconds\n", cpu_time);
-    printf("  Rate:       %.1f ops/sec\n", iterations / cpu_time);
+    bool to_stdout = strcmp(path, "-") == 0;
+    FILE* out = to_stdout ? stdout : fopen(path, "w");
+    bool ok = out && fprintf(out, "%s\n", json) > 0;
+    if (out && !to_stdout) ok = fclose(out) == 0 && ok;
+    free(json);
+    return ok ? 0 : -1;
 }
 
 void print_usage(const char* prog_name) {
@@ -177,8 +2332,34 @@ void print_usage(const char* prog_name) {
     printf("  -d      Test degradation/recovery\n");
     printf("  -c      Test concurrent access\n");
     printf("  -z      Test memory zones\n");
-    printf("  -s <n>  Run stress test with n iterations\n");
+    printf("  -s <n>  Run single-threaded load test over n machines\n");
+    printf("  -L <spec> Run load generator, spec is comma separated key=value:\n");
+    printf("          threads, machines, shared (0-1), duration (s), steps,\n");
+    printf("          mix (alloc:15/lock:15/...), seed, json (path or -)\n");
+    printf("  -P <f>  Scan token file f and report throughput\n");
+    printf("  -F <f>  Parse token file f with gosiuml_parse_file (threads from -T)\n");
+    printf("  -K <d>  Use parse cache directory d for -F (\"-\" for the default)\n");
+    printf("  -o <f>  Write the -F document to f: .xml, .json, else SVG (before -F)\n");
+    printf("  -Y <m>  Layout for -o and -M: auto, grid, layered or force (before -F)\n");
+    printf("  -M <d>  Write the -F document as zoomable SVG tiles under d (before -F)\n");
+    printf("  -H <t>  Render template t for the -F document into the -o file (before -F)\n");
+    printf("  -B <s>  Render every file of manifest or glob s into the -o directory (threads from -T)\n");
+    printf("  -C <f>  Compile token file f to f%s\n", GOSIB_EXTENSION);
+    printf("  -G <f>  Load compiled token file f\n");
     printf("  -m      Show memory statistics\n");
+    printf("  -l      Record transition latency histograms (printed on exit)\n");
+    printf("  -J <f>  Record stress test events to journal f (before -s)\n");
+    printf("  -T <n>  Use n threads for journal replay and parsing (before -R/-F)\n");
+    printf("  -R <f>  Replay journal f at maximum speed\n");
+    printf("  --daemon <s>  Serve parse/render/query requests on Unix socket s (-T, -Y, -K before)\n");
+    printf("  --client <s> <op> [args]  Send one request to the daemon on s:\n");
+    printf("          ping, parse f, render f out [layout], query f [id], stats, shutdown\n");
+    printf("  --repeat <n>  Send the --client request n times and report round-trip time\n");
+    printf("  --watch <p>  Re-render token file p, or the .tok files of directory p, as they\n");
+    printf("          change; SVGs go to the -o directory (-T, -Y before)\n");
+    printf("  --log-level <l>  Diagnostics to write: error, warn, info, debug (default) or trace\n");
+    printf("  --memory-json <f>  Write process pool statistics as JSON to f (\"-\" for stdout) on exit\n");
+    printf("  --perf  Count cycles and cache misses per parse/layout/render/export phase (implies -l)\n");
     printf("  -h      Show this help\n");
 }
 
@@ -188,25 +2369,66 @@ int main(int argc, char* argv[]) {
     printf("   OBINexus Platform v1.0.0              \n");
     printf("===========================================\n");
     
-    // Seed random number generator
-    srand(time(NULL));
-    
     if (argc < 2) {
         print_usage(argv[0]);
         return 0;
     }
     
+    enum { OPT_DAEMON = 256, OPT_CLIENT, OPT_REPEAT, OPT_WATCH, OPT_LOG_LEVEL, OPT_PERF, OPT_MEMORY_JSON };
+    static const struct option long_options[] = {
+        { "daemon", required_argument, NULL, OPT_DAEMON },
+        { "client", required_argument, NULL, OPT_CLIENT },
+        { "repeat", required_argument, NULL, OPT_REPEAT },
+        { "watch", required_argument, NULL, OPT_WATCH },
+        { "log-level", required_argument, NULL, OPT_LOG_LEVEL },
+        { "perf", no_argument, NULL, OPT_PERF },
+        { "memory-json", required_argument, NULL, OPT_MEMORY_JSON },
+        { NULL, 0, NULL, 0 }
+    };
     int opt;
-    while ((opt = getopt(argc, argv, "tbdczs:mh")) != -1) {
+    while ((opt = getopt_long(argc, argv, "tbdczs:L:P:F:K:o:Y:M:H:B:C:G:mlJ:T:R:h",
+                              long_options, NULL)) != -1) {
         switch (opt) {
-            case 't':
-                // Run all tests
-                test_basic_transitions();
-                test_degradation_recovery();
-                test_concurrent_access();
-                test_memory_zones();
+            case 't': {
+                // Run all tests; each one's diagnostics are written before the next starts
+                static void (*const tests[])(void) = {
+                    test_basic_transitions,
+                    test_degradation_recovery,
+                    test_recovery_scheduler,
+                    test_substate_pipeline,
+                    test_token_scanner,
+                    test_token_follow,
+                    test_parallel_parse,
+                    test_symbol_interning,
+                    test_gosib_roundtrip,
+                    test_parse_cache,
+                    test_svg_writer,
+                    test_layout_engine,
+                    test_tile_pyramid,
+                    test_svg_cache,
+                    test_exporters,
+                    test_report_template,
+                    test_batch_render,
+                    test_daemon,
+                    test_token_watch,
+                    test_contexts,
+                    test_async_logging,
+                    test_output_order,
+                    test_phase_counters,
+                    test_memory_snapshot,
+                    test_concurrent_access,
+                    test_memory_zones,
+                    test_transition_stats,
+                    test_journal_replay,
+                    test_load_replay,
+                };
+                for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+                    tests[i]();
+                    pheno_log_flush();
+                }
                 run_stress_test(100);
                 break;
+            }
                 
             case 'b':
                 test_basic_transitions();
@@ -225,18 +2447,163 @@ int main(int argc, char* argv[]) {
                 break;
                 
             case 's':
-                run_stress_test(atoi(optarg));
+                if (run_stress_test(atoi(optarg)) != 0) return 1;
+                break;
+                
+            case 'L': {
+                LoadGenConfig config;
+                load_generator_defaults(&config);
+                if (!load_generator_parse_spec(optarg, &config) ||
+                    run_load_test(&config) != 0) {
+                    return 1;
+                }
+                break;
+            }
+                
+            case 'P':
+                if (run_scan_benchmark(optarg) != 0) return 1;
+                break;
+                
+            case 'F':
+                if (run_parse_benchmark(optarg, g_replay_threads) != 0) return 1;
+                break;
+                
+            case 'K': {
+                static ParseCacheConfig cache_config;
+                parse_cache_defaults(&cache_config);
+                if (strcmp(optarg, "-") != 0) {
+                    snprintf(cache_config.dir, sizeof(cache_config.dir), "%s", optarg);
+                }
+                g_parse_cache = &cache_config;
+                break;
+            }
+                
+            case 'o':
+                g_svg_output = optarg;
+                break;
+                
+            case 'M':
+                g_tile_dir = optarg;
+                break;
+                
+            case 'H':
+                g_template = optarg;
+                break;
+                
+            case 'Y':
+                if (!layout_parse_mode(optarg, &g_layout_mode)) {
+                    fprintf(stderr, "Unknown layout: %s\n", optarg);
+                    return 1;
+                }
+                break;
+                
+            case 'B':
+                if (run_batch(optarg, g_replay_threads) != 0) return 1;
+                break;
+                
+            case 'C':
+                if (run_gosib_compile(optarg) != 0) return 1;
+                break;
+                
+            case 'G':
+                if (run_gosib_load(optarg) != 0) return 1;
                 break;
                 
             case 'm':
                 pheno_memory_stats();
                 break;
                 
+            case 'l':
+                pheno_transition_stats_enable(true);
+                break;
+                
+            case 'J':
+                if (g_journal) pheno_journal_close(g_journal);
+                g_journal = pheno_journal_open(optarg);
+                break;
+                
+            case 'T':
+                g_replay_threads = atoi(optarg);
+                break;
+                
+            case 'R': {
+                PhenoReplayStats stats;
+                if (!pheno_journal_replay(optarg, g_replay_threads, &stats)) {
+                    fprintf(stderr, "Replay failed: %s\n", optarg);
+                    return 1;
+                }
+                pheno_journal_print_replay(stdout, &stats);
+                break;
+            }
+                
+            case OPT_DAEMON:
+                if (run_daemon(optarg, g_replay_threads) != 0) return 1;
+                break;
+                
+            case OPT_CLIENT:
+                g_client_socket = optarg;
+                break;
+                
+            case OPT_REPEAT:
+                g_client_repeat = atoi(optarg);
+                break;
+                
+            case OPT_WATCH:
+                if (run_watch(optarg, g_replay_threads) != 0) return 1;
+                break;
+                
+            case OPT_LOG_LEVEL: {
+                int level = pheno_log_parse_level(optarg);
+                if (level < 0) {
+                    fprintf(stderr, "Unknown log level: %s\n", optarg);
+                    return 1;
+                }
+                pheno_log_set_level((PhenoLogLevel)level);
+                break;
+            }
+                
+            case OPT_PERF:
+                // Phase totals are printed with the transition histograms on exit
+                pheno_transition_stats_enable(true);
+                if (!pheno_perf_enable(true)) {
+                    fprintf(stderr, "perf_event_open unavailable; phases are timed without counters\n");
+                }
+                break;
+                
+            case OPT_MEMORY_JSON:
+                g_memory_json = optarg;
+                break;
+                
             case 'h':
             default:
                 print_usage(argv[0]);
                 return opt != 'h';
         }
+        // Each action's diagnostics are out before the next one prints
+        pheno_log_flush();
+    }
+    
+    if (g_client_socket && run_client(g_client_socket, argc - optind, argv + optind) != 0) {
+        return 1;
+    }
+    
+    if (g_journal) {
+        printf("Journal: %llu events recorded\n",
+               (unsigned long long)pheno_journal_count(g_journal));
+        pheno_journal_close(g_journal);
+    }
+    
+    if (pheno_transition_stats_enabled()) {
+        PhenoTransitionStats* stats = malloc(sizeof(PhenoTransitionStats));
+        if (stats) {
+            pheno_transition_stats_snapshot(stats, false);
+            pheno_transition_stats_print(stdout, stats);
+            free(stats);
+        }
+    }
+    
+    if (g_memory_json && write_memory_json(g_memory_json) != 0) {
+        fprintf(stderr, "Cannot write memory statistics: %s\n", g_memory_json);
     }
     
     // Final cleanup
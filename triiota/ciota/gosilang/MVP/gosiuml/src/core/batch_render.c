@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <glob.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include "batch_render.h"
+#include "gosiuml.h"
+#include "svg_generator.h"
+#include "pheno_arena.h"
+#include "pheno_threadpool.h"
+#include "pheno_histogram.h"
+
+#define BATCH_ARENA_BLOCK (8u << 20)
+
+void batch_defaults(BatchOptions* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->layout = LAYOUT_AUTO;
+    options->arena_block = BATCH_ARENA_BLOCK;
+}
+
+bool batch_output_path(const char* input, const char* out_dir, char* out, size_t size) {
+    const char* base = strrchr(input, '/');
+    base = base ? base + 1 : input;
+    const char* dot = strrchr(base, '.');
+    int stem = (int)(dot && dot != base ? (size_t)(dot - base) : strlen(base));
+
+    int n;
+    if (out_dir) {
+        n = snprintf(out, size, "%s/%.*s.svg", out_dir, stem, base);
+    } else if (base != input) {
+        n = snprintf(out, size, "%.*s/%.*s.svg", (int)(base - input) - 1, input, stem, base);
+    } else {
+        n = snprintf(out, size, "%.*s.svg", stem, base);
+    }
+    return n >= 0 && (size_t)n < size;
+}
+
+static char* default_output(PhenoArena* strings, const char* input, const char* out_dir) {
+    size_t size = (out_dir ? strlen(out_dir) : 0) + strlen(input) + 6;
+    char* path = pheno_arena_alloc(strings, size, 1);
+    return path && batch_output_path(input, out_dir, path, size) ? path : NULL;
+}
+
+bool batch_list_add(BatchList* list, const char* input, const char* output, const char* out_dir) {
+    if (!list->strings && !(list->strings = pheno_arena_create(0))) return false;
+    if (list->count == list->capacity) {
+        size_t cap = list->capacity ? list->capacity * 2 : 64;
+        BatchJob* grown = realloc(list->jobs, cap * sizeof(BatchJob));
+        if (!grown) return false;
+        list->jobs = grown;
+        list->capacity = cap;
+    }
+
+    BatchJob* job = &list->jobs[list->count];
+    job->input = pheno_arena_strndup(list->strings, input, strlen(input));
+    job->output = output ? pheno_arena_strndup(list->strings, output, strlen(output))
+                         : default_output(list->strings, input, out_dir);
+    if (!job->input || !job->output) return false;
+    list->count++;
+    return true;
+}
+
+void batch_list_free(BatchList* list) {
+    if (!list) return;
+    free(list->jobs);
+    pheno_arena_destroy(list->strings);
+    memset(list, 0, sizeof(*list));
+}
+
+static bool load_manifest(const char* path, const char* out_dir, BatchList* list) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return false;
+
+    char line[4096];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        char* p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        char* input = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        if (*p) *p++ = '\0';
+        while (isspace((unsigned char)*p)) p++;
+        char* output = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        *p = '\0';
+        ok = batch_list_add(list, input, *output ? output : NULL, out_dir);
+    }
+    fclose(fp);
+    return ok;
+}
+
+bool batch_list_load(const char* spec, const char* out_dir, BatchList* list) {
+    memset(list, 0, sizeof(*list));
+    if (!spec) return false;
+    if (!strpbrk(spec, "*?[")) {
+        if (load_manifest(spec, out_dir, list)) return true;
+        batch_list_free(list);
+        return false;
+    }
+
+    glob_t matches;
+    int rc = glob(spec, 0, NULL, &matches);
+    if (rc == GLOB_NOMATCH) return true;
+    if (rc != 0) return false;
+    bool ok = true;
+    for (size_t i = 0; ok && i < matches.gl_pathc; i++) {
+        ok = batch_list_add(list, matches.gl_pathv[i], NULL, out_dir);
+    }
+    globfree(&matches);
+    if (!ok) batch_list_free(list);
+    return ok;
+}
+
+typedef struct {
+    const BatchList* list;
+    const BatchOptions* options;
+    atomic_size_t* next;           // Next unclaimed job
+    BatchStats stats;              // This worker's share
+} BatchWorker;
+
+// parse -> layout -> render for one job; the document lives in arena
+static bool run_job(const BatchJob* job, const BatchOptions* options, PhenoArena* arena,
+                    BatchStats* stats) {
+    GosiUMLParseOptions parse = { 1, 0, NULL, NULL, arena, NULL, NULL };
+    uint64_t start = pheno_monotonic_ns();
+    GosiUMLDocument* doc = gosiuml_parse_document(job->input, &parse);
+    uint64_t parsed = pheno_monotonic_ns();
+    stats->parse_seconds += (parsed - start) / 1e9;
+    if (!doc) return false;
+    stats->tokens += doc->token_count;
+    stats->relations += doc->relation_count;
+    stats->input_bytes += doc->source_size;
+
+    int rc;
+    GosiUMLFormat format = gosiuml_format_from_path(job->output);
+    if (format == FORMAT_SVG) {
+        LayoutOptions layout_options;
+        layout_defaults(&layout_options);
+        layout_options.mode = options->layout;
+        layout_options.threads = 1;
+        Layout layout;
+        rc = layout_document(doc, &layout_options, &layout) ? 0 : -1;
+        uint64_t laid_out = pheno_monotonic_ns();
+        stats->layout_seconds += (laid_out - parsed) / 1e9;
+        if (rc == 0) {
+            rc = svg_render_layout(doc->tokens, doc->symbols, &layout, job->output);
+            layout_free(&layout);
+        }
+        stats->render_seconds += (pheno_monotonic_ns() - laid_out) / 1e9;
+    } else {
+        rc = gosiuml_export_document(NULL, doc, format, job->output);
+        stats->render_seconds += (pheno_monotonic_ns() - parsed) / 1e9;
+    }
+    gosiuml_free_document(doc);
+
+    struct stat st;
+    if (rc == 0 && stat(job->output, &st) == 0) stats->output_bytes += (uint64_t)st.st_size;
+    return rc == 0;
+}
+
+static void batch_worker(void* arg) {
+    BatchWorker* worker = arg;
+    const BatchOptions* options = worker->options;
+    PhenoArena* arena = pheno_arena_create(options->arena_block ? options->arena_block : BATCH_ARENA_BLOCK);
+
+    for (;;) {
+        size_t i = atomic_fetch_add(worker->next, 1);
+        if (i >= worker->list->count) break;
+        const BatchJob* job = &worker->list->jobs[i];
+
+        worker->stats.files++;
+        if (!arena || !run_job(job, options, arena, &worker->stats)) {
+            worker->stats.failed++;
+            if (!options->quiet) fprintf(stderr, "[BATCH] Failed: %s -> %s\n", job->input, job->output);
+        }
+        size_t reserved = pheno_arena_reserved(arena);
+        if (reserved > worker->stats.arena_peak) worker->stats.arena_peak = reserved;
+        pheno_arena_reset(arena);
+    }
+    pheno_arena_destroy(arena);
+}
+
+bool batch_run(const BatchList* list, const BatchOptions* options, BatchStats* stats) {
+    BatchOptions defaults;
+    BatchStats local;
+    if (!options) {
+        batch_defaults(&defaults);
+        options = &defaults;
+    }
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!list) return false;
+
+    int workers = options->threads > 0 ? options->threads : pheno_cpu_count();
+    if ((size_t)workers > list->count) workers = list->count ? (int)list->count : 1;
+    BatchWorker* state = calloc((size_t)workers, sizeof(BatchWorker));
+    if (!state) return false;
+
+    atomic_size_t next = 0;
+    for (int i = 0; i < workers; i++) {
+        state[i].list = list;
+        state[i].options = options;
+        state[i].next = &next;
+    }
+
+    uint64_t start = pheno_monotonic_ns();
+    if (workers == 1) {
+        batch_worker(&state[0]);
+    } else {
+        // One long-running task per worker; jobs are claimed from next
+        bool own_pool = options->threads > 1;
+        PhenoThreadPool* pool = own_pool ? pheno_threadpool_create(workers) : pheno_threadpool_default();
+        PhenoTaskGroup group;
+        pheno_taskgroup_init(&group);
+        for (int i = 0; i < workers; i++) pheno_threadpool_submit(pool, &group, batch_worker, &state[i]);
+        pheno_taskgroup_wait(pool, &group);
+        pheno_taskgroup_destroy(&group);
+        if (own_pool) pheno_threadpool_destroy(pool);
+    }
+    stats->seconds = (pheno_monotonic_ns() - start) / 1e9;
+
+    for (int i = 0; i < workers; i++) {
+        const BatchStats* s = &state[i].stats;
+        stats->files += s->files;
+        stats->failed += s->failed;
+        stats->tokens += s->tokens;
+        stats->relations += s->relations;
+        stats->input_bytes += s->input_bytes;
+        stats->output_bytes += s->output_bytes;
+        stats->parse_seconds += s->parse_seconds;
+        stats->layout_seconds += s->layout_seconds;
+        stats->render_seconds += s->render_seconds;
+        if (s->arena_peak > stats->arena_peak) stats->arena_peak = s->arena_peak;
+    }
+    stats->workers = workers;
+    free(state);
+    return stats->failed == 0;
+}
@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gosib.h"
+#include "token_scanner.h"
+#include "pheno_symbols.h"
+#include "pheno_hash.h"
+
+#define ALIGN8(x) (((x) + 7) & ~(uint64_t)7)
+
+// Growable array of fixed-size records
+typedef struct {
+    void* data;
+    size_t count;
+    size_t capacity;
+    size_t elem_size;
+} Vec;
+
+static void* vec_push(Vec* v) {
+    if (v->count == v->capacity) {
+        size_t cap = v->capacity ? v->capacity * 2 : 256;
+        void* grown = realloc(v->data, cap * v->elem_size);
+        if (!grown) return NULL;
+        v->data = grown;
+        v->capacity = cap;
+    }
+    return (char*)v->data + v->elem_size * v->count++;
+}
+
+// String index = symbol id - 1
+typedef struct {
+    PhenoSymbolTable* strings;
+    Vec tokens;                 // GosibToken
+    Vec relations;              // GosibRelation (raw ids)
+    bool failed;
+} CompileState;
+
+static bool compile_on_token(const TokenScanToken* tok, void* user) {
+    CompileState* st = user;
+    GosibToken* out = vec_push(&st->tokens);
+    PhenoSymbol type = pheno_symbols_intern(st->strings, tok->type.ptr, tok->type.len);
+    PhenoSymbol zone = pheno_symbols_intern(st->strings, tok->zone.ptr, tok->zone.len);
+    if (!out || type == PHENO_SYMBOL_NONE || zone == PHENO_SYMBOL_NONE) {
+        st->failed = true;
+        return false;
+    }
+    *out = (GosibToken){ tok->id, type - 1, tok->zone_value, zone - 1 };
+    return true;
+}
+
+static bool compile_on_relation(const TokenScanRelation* rel, void* user) {
+    CompileState* st = user;
+    GosibRelation* out = vec_push(&st->relations);
+    PhenoSymbol type = pheno_symbols_intern(st->strings, rel->type.ptr, rel->type.len);
+    if (!out || type == PHENO_SYMBOL_NONE) {
+        st->failed = true;
+        return false;
+    }
+    *out = (GosibRelation){ rel->src_id, rel->dst_id, type - 1, 0 };
+    return true;
+}
+
+// Token id -> first token index with that id
+typedef struct {
+    uint32_t* keys;
+    uint32_t* values;           // Index + 1, 0 = empty
+    size_t mask;
+} IdMap;
+
+static bool idmap_build(IdMap* map, const GosibToken* tokens, size_t count) {
+    size_t cap = 16;
+    while (cap < count * 2) cap <<= 1;
+    map->keys = malloc(cap * sizeof(uint32_t));
+    map->values = calloc(cap, sizeof(uint32_t));
+    map->mask = cap - 1;
+    if (!map->keys || !map->values) return false;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t pos = (tokens[i].id * 0x9E3779B1u) & map->mask;
+        while (map->values[pos] && map->keys[pos] != tokens[i].id) {
+            pos = (pos + 1) & map->mask;
+        }
+        if (!map->values[pos]) {
+            map->keys[pos] = tokens[i].id;
+            map->values[pos] = (uint32_t)i + 1;
+        }
+    }
+    return true;
+}
+
+static uint32_t idmap_find(const IdMap* map, uint32_t id) {
+    size_t pos = (id * 0x9E3779B1u) & map->mask;
+    while (map->values[pos]) {
+        if (map->keys[pos] == id) return map->values[pos] - 1;
+        pos = (pos + 1) & map->mask;
+    }
+    return UINT32_MAX;
+}
+
+static bool write_section(FILE* fp, const void* data, size_t size, uint64_t* pos) {
+    static const char pad[8] = {0};
+    if (size && fwrite(data, 1, size, fp) != size) return false;
+    *pos += size;
+    size_t fill = (size_t)(ALIGN8(*pos) - *pos);
+    if (fill && fwrite(pad, 1, fill, fp) != fill) return false;
+    *pos += fill;
+    return true;
+}
+
+bool gosib_compile(const char* src_path, const char* out_path, GosibCompileStats* stats) {
+    TokenScanFile src;
+    if (!src_path || !token_scan_open(&src, src_path)) return false;
+
+    struct stat st;
+    if (fstat(src.fd, &st) != 0) {
+        token_scan_close(&src);
+        return false;
+    }
+
+    CompileState state = {0};
+    state.strings = pheno_symbols_create();
+    state.failed = state.strings == NULL;
+    state.tokens.elem_size = sizeof(GosibToken);
+    state.relations.elem_size = sizeof(GosibRelation);
+
+    TokenScanCallbacks callbacks = { compile_on_token, compile_on_relation, &state };
+    TokenScanStats scan = {0};
+    token_scan_buffer(src.data, src.size, true, 1, &callbacks, &scan);
+    uint64_t content_hash = pheno_xxh64(src.data, src.size, 0);
+    token_scan_close(&src);
+
+    const GosibToken* tokens = state.tokens.data;
+    const GosibRelation* relations = state.relations.data;
+    size_t token_count = state.tokens.count;
+    size_t relation_count = state.relations.count;
+
+    // Resolve endpoints and build the CSR row starts
+    IdMap ids = {0};
+    uint32_t* index = calloc(token_count + 1, sizeof(uint32_t));
+    uint32_t* src_index = malloc((relation_count + 1) * sizeof(uint32_t));
+    uint32_t* dst_index = malloc((relation_count + 1) * sizeof(uint32_t));
+    bool ok = !state.failed && index && src_index && dst_index &&
+              idmap_build(&ids, tokens, token_count);
+
+    size_t edge_count = 0;
+    for (size_t r = 0; ok && r < relation_count; r++) {
+        src_index[r] = idmap_find(&ids, relations[r].src_id);
+        dst_index[r] = idmap_find(&ids, relations[r].dst_id);
+        if (src_index[r] != UINT32_MAX && dst_index[r] != UINT32_MAX) {
+            index[src_index[r] + 1]++;
+            edge_count++;
+        }
+    }
+    for (size_t i = 0; ok && i < token_count; i++) {
+        index[i + 1] += index[i];
+    }
+
+    GosibEdge* edges = malloc((edge_count + 1) * sizeof(GosibEdge));
+    GosibRelation* dangling = malloc((relation_count - edge_count + 1) * sizeof(GosibRelation));
+    uint32_t* cursor = malloc((token_count + 1) * sizeof(uint32_t));
+    ok = ok && edges && dangling && cursor;
+
+    size_t dangling_count = 0;
+    if (ok) {
+        memcpy(cursor, index, (token_count + 1) * sizeof(uint32_t));
+        for (size_t r = 0; r < relation_count; r++) {
+            if (src_index[r] != UINT32_MAX && dst_index[r] != UINT32_MAX) {
+                edges[cursor[src_index[r]]++] =
+                    (GosibEdge){ dst_index[r], relations[r].type, (uint32_t)r };
+            } else {
+                dangling[dangling_count] = relations[r];
+                dangling[dangling_count++].ordinal = (uint32_t)r;
+            }
+        }
+    }
+
+    // String table: offsets then names, in symbol order
+    size_t string_count = pheno_symbols_count(state.strings);
+    uint32_t* string_offsets = malloc((string_count + 1) * sizeof(uint32_t));
+    size_t blob_size = 0;
+    ok = ok && string_offsets;
+    for (size_t i = 0; ok && i < string_count; i++) {
+        string_offsets[i] = (uint32_t)blob_size;
+        blob_size += pheno_symbols_length(state.strings, (PhenoSymbol)(i + 1)) + 1;
+    }
+    if (ok) string_offsets[string_count] = (uint32_t)blob_size;
+
+    // Lay out sections
+    GosibHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GOSIB_MAGIC, 4);
+    header.version = GOSIB_VERSION;
+    header.byte_order = GOSIB_BYTE_ORDER;
+    header.header_size = sizeof(GosibHeader);
+    header.token_count = (uint32_t)token_count;
+    header.edge_count = (uint32_t)edge_count;
+    header.dangling_count = (uint32_t)dangling_count;
+    header.string_count = (uint32_t)string_count;
+    header.source_size = (uint64_t)st.st_size;
+    header.source_mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    header.content_hash = content_hash;
+    header.malformed = scan.malformed;
+    header.strings_offset = ALIGN8(sizeof(GosibHeader));
+    header.strings_size = (string_count + 1) * sizeof(uint32_t) + blob_size;
+    header.tokens_offset = ALIGN8(header.strings_offset + header.strings_size);
+    header.index_offset = header.tokens_offset + ALIGN8(token_count * sizeof(GosibToken));
+    header.edges_offset = header.index_offset + ALIGN8((token_count + 1) * sizeof(uint32_t));
+    header.dangling_offset = header.edges_offset + ALIGN8(edge_count * sizeof(GosibEdge));
+    header.file_size = header.dangling_offset + ALIGN8(dangling_count * sizeof(GosibRelation));
+
+    // Write to a temporary file and rename into place
+    char default_out[4096];
+    if (!out_path) {
+        snprintf(default_out, sizeof(default_out), "%s%s", src_path, GOSIB_EXTENSION);
+        out_path = default_out;
+    }
+    // mkstemp names the file uniquely next to its target, so concurrent
+    // compiles of one source from several threads or processes never share it
+    char tmp_path[4200];
+    int tmp_fd = -1;
+    if (ok && (size_t)snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.XXXXXX", out_path) < sizeof(tmp_path)) {
+        tmp_fd = mkstemp(tmp_path);
+        if (tmp_fd >= 0) fchmod(tmp_fd, 0644);
+    }
+
+    FILE* fp = tmp_fd >= 0 ? fdopen(tmp_fd, "wb") : NULL;
+    if (!fp && tmp_fd >= 0) {
+        close(tmp_fd);
+        unlink(tmp_path);
+    }
+    if (fp) {
+        uint64_t pos = 0;
+        ok = write_section(fp, &header, sizeof(header), &pos) &&
+             fwrite(string_offsets, sizeof(uint32_t), string_count + 1, fp) == string_count + 1;
+        pos += (string_count + 1) * sizeof(uint32_t);
+        for (size_t i = 0; ok && i < string_count; i++) {
+            PhenoSymbol sym = (PhenoSymbol)(i + 1);
+            size_t len = pheno_symbols_length(state.strings, sym) + 1;
+            ok = fwrite(pheno_symbols_name(state.strings, sym), 1, len, fp) == len;
+            pos += len;
+        }
+        ok = ok &&
+             write_section(fp, NULL, 0, &pos) &&
+             write_section(fp, tokens, token_count * sizeof(GosibToken), &pos) &&
+             write_section(fp, index, (token_count + 1) * sizeof(uint32_t), &pos) &&
+             write_section(fp, edges, edge_count * sizeof(GosibEdge), &pos) &&
+             write_section(fp, dangling, dangling_count * sizeof(GosibRelation), &pos) &&
+             pos == header.file_size;
+        ok = (fclose(fp) == 0) && ok;
+        if (ok) ok = rename(tmp_path, out_path) == 0;
+        if (!ok) unlink(tmp_path);
+    } else {
+        ok = false;
+    }
+
+    if (stats) {
+        stats->tokens = (uint32_t)token_count;
+        stats->edges = (uint32_t)edge_count;
+        stats->dangling = (uint32_t)dangling_count;
+        stats->strings = (uint32_t)string_count;
+        stats->malformed = scan.malformed;
+    }
+
+    free(ids.keys);
+    free(ids.values);
+    free(index);
+    free(src_index);
+    free(dst_index);
+    free(edges);
+    free(dangling);
+    free(cursor);
+    free(string_offsets);
+    pheno_symbols_destroy(state.strings);
+    free(state.tokens.data);
+    free(state.relations.data);
+    return ok;
+}
+
+static bool section_ok(const GosibHeader* h, uint64_t offset, uint64_t size) {
+    return (offset & 7) == 0 && offset <= h->file_size && size <= h->file_size - offset;
+}
+
+// Contents the readers index with: string offsets inside a NUL-terminated
+// blob, a monotonic row index ending at edge_count, edge endpoints in range
+// and relation ordinals that number every relation exactly once
+static bool contents_ok(const GosibHeader* h, const char* base) {
+    const uint32_t* offsets = (const uint32_t*)(base + h->strings_offset);
+    const char* blob = (const char*)(offsets + h->string_count + 1);
+    uint64_t blob_size = h->strings_size - ((uint64_t)h->string_count + 1) * sizeof(uint32_t);
+    if (h->string_count && (blob_size == 0 || blob[blob_size - 1] != '\0')) return false;
+    for (uint32_t i = 0; i < h->string_count; i++) {
+        if (offsets[i] >= blob_size) return false;
+    }
+
+    const uint32_t* index = (const uint32_t*)(base + h->index_offset);
+    if (index[0] != 0 || index[h->token_count] != h->edge_count) return false;
+    for (uint32_t i = 0; i < h->token_count; i++) {
+        if (index[i] > index[i + 1]) return false;
+    }
+
+    const GosibEdge* edges = (const GosibEdge*)(base + h->edges_offset);
+    for (uint32_t e = 0; e < h->edge_count; e++) {
+        if (edges[e].dst >= h->token_count) return false;
+    }
+
+    const GosibRelation* dangling = (const GosibRelation*)(base + h->dangling_offset);
+    uint64_t relation_count = (uint64_t)h->edge_count + h->dangling_count;
+    uint8_t* seen = calloc(relation_count + 1, 1);
+    bool ok = seen != NULL;
+    for (uint64_t r = 0; ok && r < relation_count; r++) {
+        uint32_t ordinal = r < h->edge_count ? edges[r].ordinal
+                                             : dangling[r - h->edge_count].ordinal;
+        ok = ordinal < relation_count && !seen[ordinal];
+        if (ok) seen[ordinal] = 1;
+    }
+    free(seen);
+    return ok;
+}
+
+bool gosib_open(GosibFile* file, const char* path) {
+    if (!file || !path) return false;
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(GosibHeader)) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    // Structural checks, then one pass over the index, edges and string
+    // offsets; after that the records are used in place without checks
+    const GosibHeader* h = map;
+    bool ok = memcmp(h->magic, GOSIB_MAGIC, 4) == 0 &&
+              h->version == GOSIB_VERSION &&
+              h->byte_order == GOSIB_BYTE_ORDER &&
+              h->header_size == sizeof(GosibHeader) &&
+              h->file_size == size &&
+              h->strings_size >= ((uint64_t)h->string_count + 1) * sizeof(uint32_t) &&
+              section_ok(h, h->strings_offset, h->strings_size) &&
+              section_ok(h, h->tokens_offset, (uint64_t)h->token_count * sizeof(GosibToken)) &&
+              section_ok(h, h->index_offset, ((uint64_t)h->token_count + 1) * sizeof(uint32_t)) &&
+              section_ok(h, h->edges_offset, (uint64_t)h->edge_count * sizeof(GosibEdge)) &&
+              section_ok(h, h->dangling_offset,
+                         (uint64_t)h->dangling_count * sizeof(GosibRelation)) &&
+              contents_ok(h, map);
+    if (!ok) {
+        munmap(map, size);
+        return false;
+    }
+
+    const char* base = map;
+    file->header = h;
+    file->string_offsets = (const uint32_t*)(base + h->strings_offset);
+    file->string_data = (const char*)(file->string_offsets + h->string_count + 1);
+    file->tokens = (const GosibToken*)(base + h->tokens_offset);
+    file->index = (const uint32_t*)(base + h->index_offset);
+    file->edges = (const GosibEdge*)(base + h->edges_offset);
+    file->dangling = (const GosibRelation*)(base + h->dangling_offset);
+    file->map = map;
+    file->size = size;
+    return true;
+}
+
+void gosib_close(GosibFile* file) {
+    if (!file || !file->map) return;
+    munmap(file->map, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+bool gosib_is_current(const GosibFile* file, const char* source_path) {
+    if (!file || !file->header || !source_path) return false;
+
+    struct stat st;
+    if (stat(source_path, &st) != 0) return false;
+
+    int64_t mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return (uint64_t)st.st_size == file->header->source_size &&
+           mtime == file->header->source_mtime_ns;
+}
+
+const char* gosib_string(const GosibFile* file, uint32_t index) {
+    if (!file || !file->header || index >= file->header->string_count) return "";
+
+    uint64_t blob_size = file->header->strings_size -
+                         ((uint64_t)file->header->string_count + 1) * sizeof(uint32_t);
+    uint32_t offset = file->string_offsets[index];
+    return offset < blob_size ? file->string_data + offset : "";
+}
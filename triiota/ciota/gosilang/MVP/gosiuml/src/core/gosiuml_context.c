@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "gosiuml.h"
+#include "pheno_arena.h"
+
+#define CONTEXT_POOL_KB  1024          // Default private pool
+#define CONTEXT_ERROR    256
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+struct GosiUMLContext {
+    int options[GOSIUML_OPT_COUNT];
+    PhenoPool* pool;                   // Created on first use
+    PhenoArena* arena;                 // Documents, created on first parse
+    PhenoSymbolTable* symbols;
+    GosiUMLDocument** documents;       // Parsed since the last reset
+    size_t document_count;
+    size_t document_capacity;
+    GosiUMLContextStats stats;
+    char error[CONTEXT_ERROR];
+};
+
+static _Thread_local char g_last_error[CONTEXT_ERROR];
+
+int gosiuml_init(void) {
+    return pheno_pool_default() ? 0 : -1;
+}
+
+void gosiuml_cleanup(void) {
+    pheno_memory_cleanup();
+}
+
+const char* gosiuml_version(void) {
+    return STR(GOSIUML_VERSION_MAJOR) "." STR(GOSIUML_VERSION_MINOR) "." STR(GOSIUML_VERSION_PATCH);
+}
+
+const char* gosiuml_get_error(void) {
+    return g_last_error;
+}
+
+void gosiuml_context_set_error(GosiUMLContext* ctx, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(g_last_error, sizeof(g_last_error), format, args);
+    va_end(args);
+    if (ctx) memcpy(ctx->error, g_last_error, sizeof(ctx->error));
+}
+
+const char* gosiuml_context_error(const GosiUMLContext* ctx) {
+    return ctx ? ctx->error : "";
+}
+
+GosiUMLContext* gosiuml_create_context(void) {
+    GosiUMLContext* ctx = calloc(1, sizeof(GosiUMLContext));
+    if (!ctx) return NULL;
+    ctx->symbols = pheno_symbols_create();
+    if (!ctx->symbols) {
+        free(ctx);
+        return NULL;
+    }
+    ctx->options[GOSIUML_OPT_STATE_MACHINE] = 1;
+    ctx->options[GOSIUML_OPT_POOL_KB] = CONTEXT_POOL_KB;
+    return ctx;
+}
+
+void gosiuml_free_context(GosiUMLContext* ctx) {
+    if (!ctx) return;
+    gosiuml_context_reset(ctx);
+    pheno_arena_destroy(ctx->arena);
+    pheno_symbols_destroy(ctx->symbols);
+    pheno_pool_destroy(ctx->pool);
+    free(ctx->documents);
+    free(ctx);
+}
+
+int gosiuml_set_option(GosiUMLContext* ctx, GosiUMLOption option, int value) {
+    if (!ctx || option < GOSIUML_OPT_VERBOSE || option >= GOSIUML_OPT_COUNT) {
+        gosiuml_context_set_error(ctx, "unknown option %d", (int)option);
+        return -1;
+    }
+    if (option == GOSIUML_OPT_POOL_KB && (ctx->pool || value <= 0)) {
+        gosiuml_context_set_error(ctx, "pool size %d KB cannot be applied", value);
+        return -1;
+    }
+    ctx->options[option] = value;
+    return 0;
+}
+
+int gosiuml_get_option(const GosiUMLContext* ctx, GosiUMLOption option) {
+    if (!ctx || option < GOSIUML_OPT_VERBOSE || option >= GOSIUML_OPT_COUNT) return -1;
+    return ctx->options[option];
+}
+
+static PhenoPool* context_pool(GosiUMLContext* ctx) {
+    if (!ctx->pool) {
+        ctx->pool = pheno_pool_create((size_t)ctx->options[GOSIUML_OPT_POOL_KB] << 10, false);
+        if (!ctx->pool) gosiuml_context_set_error(ctx, "cannot create a %d KB pool",
+                                                  ctx->options[GOSIUML_OPT_POOL_KB]);
+    }
+    return ctx->pool;
+}
+
+PhenoToken* gosiuml_context_alloc_token(GosiUMLContext* ctx, uint32_t size) {
+    if (!ctx || !context_pool(ctx)) return NULL;
+    PhenoToken* token = pheno_pool_token_alloc(ctx->pool, size);
+    if (!token) {
+        gosiuml_context_set_error(ctx, "pool exhausted allocating %u bytes", size);
+        return NULL;
+    }
+    ctx->stats.tokens_allocated++;
+    if (ctx->options[GOSIUML_OPT_MEMORY_TRACKING]) {
+        ctx->stats.bytes_in_use += size;
+        if (ctx->stats.bytes_in_use > ctx->stats.bytes_peak) ctx->stats.bytes_peak = ctx->stats.bytes_in_use;
+    }
+    return token;
+}
+
+void gosiuml_context_free_token(GosiUMLContext* ctx, PhenoToken* token) {
+    if (!ctx || !ctx->pool || !token) return;
+    if (ctx->options[GOSIUML_OPT_MEMORY_TRACKING]) {
+        ctx->stats.bytes_in_use -= token->data_size < ctx->stats.bytes_in_use ?
+                                   token->data_size : ctx->stats.bytes_in_use;
+    }
+    ctx->stats.tokens_freed++;
+    pheno_pool_token_free(ctx->pool, token);
+}
+
+StateMachine* gosiuml_context_create_machine(GosiUMLContext* ctx) {
+    if (!ctx) return NULL;
+    if (!ctx->options[GOSIUML_OPT_STATE_MACHINE]) {
+        gosiuml_context_set_error(ctx, "state machines are disabled for this context");
+        return NULL;
+    }
+    StateMachine* sm = context_pool(ctx) ? create_state_machine() : NULL;
+    if (!sm) return NULL;
+    sm->pool = ctx->pool;
+    if (!initialize_state_machine(sm)) {
+        gosiuml_context_set_error(ctx, "pool exhausted creating a state machine");
+        destroy_state_machine(sm);
+        return NULL;
+    }
+    ctx->stats.machines++;
+    return sm;
+}
+
+PhenoSymbol gosiuml_context_intern(GosiUMLContext* ctx, const char* name) {
+    if (!ctx || !name) return PHENO_SYMBOL_NONE;
+    return pheno_symbols_intern(ctx->symbols, name, strlen(name));
+}
+
+const PhenoSymbolTable* gosiuml_context_symbols(const GosiUMLContext* ctx) {
+    return ctx ? ctx->symbols : NULL;
+}
+
+GosiUMLDocument* gosiuml_context_parse(GosiUMLContext* ctx, const char* filename) {
+    if (!ctx) return NULL;
+    if (ctx->document_count == ctx->document_capacity) {
+        size_t cap = ctx->document_capacity ? ctx->document_capacity * 2 : 8;
+        GosiUMLDocument** grown = realloc(ctx->documents, cap * sizeof(GosiUMLDocument*));
+        if (!grown) return NULL;
+        ctx->documents = grown;
+        ctx->document_capacity = cap;
+    }
+    if (!ctx->arena && !(ctx->arena = pheno_arena_create(0))) return NULL;
+
+    // Serial: a context never borrows the shared thread pool, and names
+    // go straight into the context table
+    GosiUMLParseOptions options = { 1, 0, NULL, NULL, ctx->arena, ctx->symbols, NULL };
+    GosiUMLDocument* doc = gosiuml_parse_document(filename, &options);
+    if (!doc) {
+        gosiuml_context_set_error(ctx, "cannot parse %s", filename ? filename : "(null)");
+        return NULL;
+    }
+    ctx->documents[ctx->document_count++] = doc;
+    ctx->stats.documents++;
+    return doc;
+}
+
+void gosiuml_context_reset(GosiUMLContext* ctx) {
+    if (!ctx) return;
+    for (size_t i = 0; i < ctx->document_count; i++) gosiuml_free_document(ctx->documents[i]);
+    ctx->document_count = 0;
+    ctx->stats.documents = 0;
+    if (ctx->arena) pheno_arena_reset(ctx->arena);
+}
+
+// Processing log line: id, zone and, with SHOW_BITFIELDS, the flag word
+static void log_token(const GosiUMLContext* ctx, const PhenoToken* token, bool valid) {
+    fprintf(stderr, "[GOSIUML] token 0x%08X %.16s zone %u%s", token->token_id, token->sentinel,
+            token->memory_zone, valid ? "" : " INVALID");
+    if (ctx->options[GOSIUML_OPT_SHOW_BITFIELDS]) {
+        uint32_t flags = atomic_load(&token->mem_flags.flags);
+        fprintf(stderr, " flags=0x%08X refs=%u", flags, atomic_load(&token->mem_flags.ref_count));
+    }
+    fputc('\n', stderr);
+}
+
+int gosiuml_process_token(GosiUMLContext* ctx, PhenoToken* token) {
+    if (!ctx || !token) {
+        gosiuml_context_set_error(ctx, "no token to process");
+        return -1;
+    }
+    ctx->stats.tokens_processed++;
+    bool valid = pheno_token_validate(token);
+    if (ctx->options[GOSIUML_OPT_VERBOSE]) log_token(ctx, token, valid);
+    if (!valid) {
+        ctx->stats.tokens_rejected++;
+        gosiuml_context_set_error(ctx, "token 0x%08X failed validation", token->token_id);
+        return -1;
+    }
+    return 0;
+}
+
+void gosiuml_context_stats(const GosiUMLContext* ctx, GosiUMLContextStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!ctx) return;
+    *stats = ctx->stats;
+    if (ctx->pool) {
+        PhenoPoolUsage usage;
+        pheno_pool_usage(ctx->pool, &usage);
+        stats->pool_size = usage.total_size;
+        stats->pool_used = usage.used_size;
+    }
+    stats->arena_reserved = ctx->arena ? pheno_arena_reserved(ctx->arena) : 0;
+    stats->symbols = pheno_symbols_count(ctx->symbols);
+}
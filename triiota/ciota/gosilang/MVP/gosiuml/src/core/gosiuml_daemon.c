@@ -0,0 +1,765 @@
+#define _GNU_SOURCE  // accept4()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "gosiuml_daemon.h"
+#include "gosiuml.h"
+#include "svg_writer.h"
+#include "svg_generator.h"
+#include "pheno_histogram.h"
+#include "pheno_threadpool.h"
+
+#define DAEMON_MAX_DOCUMENTS 64
+#define DAEMON_REPLY_SIZE    (64u << 10)
+
+// Resident document; refs counts the table's reference plus one per request
+typedef struct {
+    char* path;
+    off_t size;
+    struct timespec mtime;
+    GosiUMLDocument* doc;
+    int refs;                      // Under GosiUMLDaemon.lock
+    uint64_t last_used;
+
+    pthread_mutex_t lock;          // Everything below
+    Layout layout;
+    bool has_layout;
+    LayoutMode layout_mode;        // Mode requested for layout
+    uint64_t* index;               // (token_id << 32 | token index), sorted
+    SvgFragmentCache* svg;
+} DaemonDocument;
+
+struct GosiUMLDaemon {
+    DaemonOptions options;
+    PhenoThreadPool* pool;         // threads > 1: parse/layout workers for every request
+    int listen_fd;
+    pthread_t acceptor;
+
+    pthread_mutex_t lock;          // Tables and flags below
+    pthread_cond_t changed;
+    bool stopping;
+    DaemonDocument** docs;
+    int doc_count;
+    uint64_t clock;                // LRU stamps
+    int* conns;                    // Open connection fds
+    int conn_count;
+    int conn_capacity;
+
+    _Atomic uint64_t requests;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t parses;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t renders;
+    _Atomic uint64_t connections;
+    PhenoHistogram latency;
+};
+
+typedef struct {
+    GosiUMLDaemon* daemon;
+    int fd;
+} DaemonConnection;
+
+void daemon_defaults(DaemonOptions* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->max_documents = DAEMON_MAX_DOCUMENTS;
+    options->layout = LAYOUT_AUTO;
+}
+
+DaemonOp daemon_parse_op(const char* name) {
+    static const char* names[] = { "ping", "parse", "render", "query", "stats", "shutdown" };
+    for (size_t i = 0; name && i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i]) == 0) return (DaemonOp)(DAEMON_PING + i);
+    }
+    return 0;
+}
+
+// Full reads and writes; MSG_NOSIGNAL so a vanished peer is an error, not SIGPIPE
+static bool read_full(int fd, void* buf, size_t len) {
+    char* p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool send_frame(int fd, uint16_t op, uint16_t status, const void* payload, size_t len) {
+    DaemonFrame frame = { DAEMON_MAGIC, op, status, (uint32_t)len };
+    struct iovec iov[2] = { { &frame, sizeof(frame) }, { (void*)payload, len } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = len ? 2 : 1 };
+    size_t left = sizeof(frame) + len;
+    while (left > 0) {
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        left -= (size_t)n;
+        // Partial send: advance the iovecs past what went out
+        while (n > 0 && msg.msg_iovlen > 0) {
+            size_t step = (size_t)n < msg.msg_iov->iov_len ? (size_t)n : msg.msg_iov->iov_len;
+            msg.msg_iov->iov_base = (char*)msg.msg_iov->iov_base + step;
+            msg.msg_iov->iov_len -= step;
+            n -= (ssize_t)step;
+            if (msg.msg_iov->iov_len == 0) {
+                msg.msg_iov++;
+                msg.msg_iovlen--;
+            }
+        }
+    }
+    return true;
+}
+
+static bool discard(int fd, size_t len) {
+    char sink[4096];
+    while (len > 0) {
+        size_t step = len < sizeof(sink) ? len : sizeof(sink);
+        if (!read_full(fd, sink, step)) return false;
+        len -= step;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Resident documents
+// ---------------------------------------------------------------------------
+
+static void document_free(DaemonDocument* e) {
+    gosiuml_free_document(e->doc);
+    if (e->has_layout) layout_free(&e->layout);
+    svg_cache_destroy(e->svg);
+    free(e->index);
+    free(e->path);
+    pthread_mutex_destroy(&e->lock);
+    free(e);
+}
+
+// Caller holds d->lock
+static void document_unref(DaemonDocument* e) {
+    if (--e->refs == 0) document_free(e);
+}
+
+static void document_release(GosiUMLDaemon* d, DaemonDocument* e) {
+    pthread_mutex_lock(&d->lock);
+    document_unref(e);
+    pthread_mutex_unlock(&d->lock);
+}
+
+// Caller holds d->lock
+static void table_remove(GosiUMLDaemon* d, int i) {
+    DaemonDocument* e = d->docs[i];
+    d->docs[i] = d->docs[--d->doc_count];
+    document_unref(e);
+}
+
+static bool same_stamp(const DaemonDocument* e, const struct stat* st) {
+    return e->size == st->st_size && e->mtime.tv_sec == st->st_mtim.tv_sec &&
+           e->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static GosiUMLDocument* parse_source(GosiUMLDaemon* d, const char* path) {
+    if (d->options.parse_cache) {
+        ParseCacheResult result;
+        return parse_cache_load_document(d->options.parse_cache, path, &result);
+    }
+    GosiUMLParseOptions options = { d->options.threads, 0, NULL, NULL, NULL, NULL, d->pool };
+    return gosiuml_parse_document(path, &options);
+}
+
+// Resident document for path, parsed if missing or changed on disk;
+// *hit tells which. Release with document_release().
+static DaemonDocument* document_acquire(GosiUMLDaemon* d, const char* path, bool* hit) {
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+
+    pthread_mutex_lock(&d->lock);
+    for (int i = 0; i < d->doc_count; i++) {
+        DaemonDocument* e = d->docs[i];
+        if (strcmp(e->path, path) != 0) continue;
+        if (same_stamp(e, &st)) {
+            e->refs++;
+            e->last_used = ++d->clock;
+            pthread_mutex_unlock(&d->lock);
+            *hit = true;
+            return e;
+        }
+        table_remove(d, i);
+        break;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    // Parse outside the lock; a concurrent parse of the same file may win
+    *hit = false;
+    GosiUMLDocument* doc = parse_source(d, path);
+    DaemonDocument* e = doc ? calloc(1, sizeof(DaemonDocument)) : NULL;
+    if (e) e->path = strdup(path);
+    if (!e || !e->path) {
+        free(e);
+        gosiuml_free_document(doc);
+        return NULL;
+    }
+    atomic_fetch_add_explicit(&d->parses, 1, memory_order_relaxed);
+    e->size = st.st_size;
+    e->mtime = st.st_mtim;
+    e->doc = doc;
+    e->refs = 2;
+    pthread_mutex_init(&e->lock, NULL);
+
+    pthread_mutex_lock(&d->lock);
+    for (int i = 0; i < d->doc_count; i++) {
+        if (strcmp(d->docs[i]->path, path) != 0) continue;
+        if (same_stamp(d->docs[i], &st)) {
+            DaemonDocument* winner = d->docs[i];
+            winner->refs++;
+            winner->last_used = ++d->clock;
+            pthread_mutex_unlock(&d->lock);
+            document_free(e);
+            return winner;
+        }
+        table_remove(d, i);
+        break;
+    }
+    int max = d->options.max_documents > 0 ? d->options.max_documents : DAEMON_MAX_DOCUMENTS;
+    while (d->doc_count >= max) {
+        int oldest = 0;
+        for (int i = 1; i < d->doc_count; i++) {
+            if (d->docs[i]->last_used < d->docs[oldest]->last_used) oldest = i;
+        }
+        table_remove(d, oldest);
+    }
+    e->last_used = ++d->clock;
+    d->docs[d->doc_count++] = e;
+    pthread_mutex_unlock(&d->lock);
+    return e;
+}
+
+// Caller holds e->lock
+static bool document_layout(GosiUMLDaemon* d, DaemonDocument* e, LayoutMode mode) {
+    if (e->has_layout && e->layout_mode == mode) return true;
+    if (e->has_layout) layout_free(&e->layout);
+    e->has_layout = false;
+
+    LayoutOptions options;
+    layout_defaults(&options);
+    options.mode = mode;
+    options.threads = d->options.threads;
+    options.pool = d->pool;
+    if (!layout_document(e->doc, &options, &e->layout)) return false;
+    e->has_layout = true;
+    e->layout_mode = mode;
+    return true;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Token index of id, or -1; caller holds e->lock
+static long document_find(DaemonDocument* e, uint32_t id) {
+    size_t n = e->doc->token_count;
+    if (!e->index && n > 0) {
+        e->index = malloc(n * sizeof(uint64_t));
+        if (!e->index) return -1;
+        for (size_t i = 0; i < n; i++) e->index[i] = (uint64_t)e->doc->tokens[i].token_id << 32 | i;
+        qsort(e->index, n, sizeof(uint64_t), compare_u64);
+    }
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((uint32_t)(e->index[mid] >> 32) < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < n && (uint32_t)(e->index[lo] >> 32) == id ? (long)(uint32_t)e->index[lo] : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Requests
+// ---------------------------------------------------------------------------
+
+static void json_string(SvgWriter* w, const char* s) {
+    svg_puts(w, "\"");
+    svg_put_json_escaped(w, s, strlen(s));
+    svg_puts(w, "\"");
+}
+
+static void json_bool(SvgWriter* w, bool value) {
+    if (value) {
+        svg_puts(w, "true");
+    } else {
+        svg_puts(w, "false");
+    }
+}
+
+static void reply_summary(SvgWriter* w, const DaemonDocument* e, bool hit) {
+    const GosiUMLDocument* doc = e->doc;
+    svg_puts(w, "{\"path\":");
+    json_string(w, e->path);
+    svg_puts(w, ",\"tokens\":");
+    svg_put_u64(w, doc->token_count);
+    svg_puts(w, ",\"relations\":");
+    svg_put_u64(w, doc->relation_count);
+    svg_puts(w, ",\"malformed\":");
+    svg_put_u64(w, doc->malformed);
+    svg_puts(w, ",\"source_size\":");
+    svg_put_u64(w, doc->source_size);
+    svg_puts(w, ",\"resident\":");
+    json_bool(w, hit);
+    svg_puts(w, "}");
+}
+
+static void reply_token(SvgWriter* w, const GosiUMLDocument* doc, const PhenoToken* token) {
+    svg_puts(w, "{\"id\":");
+    svg_put_u32(w, token->token_id);
+    svg_puts(w, ",\"sentinel\":\"");
+    svg_put_json_escaped(w, token->sentinel, strnlen(token->sentinel, sizeof(token->sentinel)));
+    svg_puts(w, "\",\"type\":\"");
+    svg_put_json_escaped(w, pheno_symbols_name(doc->symbols, token->type_symbol),
+                         pheno_symbols_length(doc->symbols, token->type_symbol));
+    svg_puts(w, "\",\"zone_name\":\"");
+    svg_put_json_escaped(w, pheno_symbols_name(doc->symbols, token->zone_symbol),
+                         pheno_symbols_length(doc->symbols, token->zone_symbol));
+    svg_puts(w, "\",\"memory_zone\":");
+    svg_put_u32(w, token->memory_zone);
+    svg_puts(w, ",\"flags\":");
+    svg_put_u32(w, atomic_load(&token->mem_flags.flags));
+    svg_puts(w, ",\"ref_count\":");
+    svg_put_u32(w, atomic_load(&token->mem_flags.ref_count));
+    svg_puts(w, ",\"data_size\":");
+    svg_put_u64(w, token->data_size);
+    svg_puts(w, "}");
+}
+
+static DaemonStatus handle_render(GosiUMLDaemon* d, DaemonDocument* e, const char* output,
+                                  const char* mode_name, SvgWriter* w) {
+    LayoutMode mode = d->options.layout;
+    if (mode_name && !layout_parse_mode(mode_name, &mode)) return DAEMON_BAD_REQUEST;
+
+    uint64_t start = pheno_monotonic_ns();
+    GosiUMLFormat format = gosiuml_format_from_path(output);
+    struct stat st;
+    SvgCacheStats cache = {0};
+    LayoutMode rendered = mode;
+    int rc;
+    if (format != FORMAT_SVG) {
+        rc = gosiuml_export_document(NULL, e->doc, format, output);
+    } else {
+        // Layout and fragment cache are per document and single-writer
+        pthread_mutex_lock(&e->lock);
+        if (!e->svg) e->svg = svg_cache_create();
+        rc = e->svg && document_layout(d, e, mode) ?
+            svg_render_layout_cached(e->svg, e->doc->tokens, e->doc->symbols, &e->layout, output, &cache) : -1;
+        rendered = e->layout.mode;     // Another render may relayout once unlocked
+        pthread_mutex_unlock(&e->lock);
+    }
+    if (rc != 0 || stat(output, &st) != 0) return DAEMON_FAILED;
+    atomic_fetch_add_explicit(&d->renders, 1, memory_order_relaxed);
+
+    svg_puts(w, "{\"output\":");
+    json_string(w, output);
+    svg_puts(w, ",\"bytes\":");
+    svg_put_u64(w, (uint64_t)st.st_size);
+    if (format == FORMAT_SVG) {
+        svg_puts(w, ",\"layout\":");
+        json_string(w, layout_mode_name(rendered));
+        svg_puts(w, ",\"reformatted\":");
+        svg_put_u64(w, cache.reformatted);
+    }
+    svg_puts(w, ",\"us\":");
+    svg_put_u64(w, (pheno_monotonic_ns() - start) / 1000);
+    svg_puts(w, "}");
+    return DAEMON_OK;
+}
+
+static DaemonStatus handle_query(DaemonDocument* e, const char* id_text, bool hit, SvgWriter* w) {
+    if (!id_text) {
+        reply_summary(w, e, hit);
+        return DAEMON_OK;
+    }
+    char* end;
+    unsigned long id = strtoul(id_text, &end, 0);
+    if (*id_text == '\0' || *end != '\0' || id > UINT32_MAX) return DAEMON_BAD_REQUEST;
+
+    pthread_mutex_lock(&e->lock);
+    long i = document_find(e, (uint32_t)id);
+    pthread_mutex_unlock(&e->lock);
+    if (i < 0) return DAEMON_NOT_FOUND;
+    reply_token(w, e->doc, &e->doc->tokens[i]);
+    return DAEMON_OK;
+}
+
+static void reply_stats(GosiUMLDaemon* d, SvgWriter* w) {
+    DaemonStats stats;
+    daemon_get_stats(d, &stats);
+    const struct { const char* name; uint64_t value; } fields[] = {
+        { "requests", stats.requests }, { "errors", stats.errors }, { "parses", stats.parses },
+        { "hits", stats.hits }, { "renders", stats.renders }, { "connections", stats.connections },
+        { "documents", stats.documents }, { "p50_ns", stats.p50_ns }, { "p99_ns", stats.p99_ns },
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (i == 0) {
+            svg_puts(w, "{\"");
+        } else {
+            svg_puts(w, ",\"");
+        }
+        svg_put(w, fields[i].name, strlen(fields[i].name));
+        svg_puts(w, "\":");
+        svg_put_u64(w, fields[i].value);
+    }
+    
+    // Process pool counters, read without its lock
+    PhenoMemoryStats memory;
+    char json[2048];
+    pheno_memory_stats_snapshot(&memory);
+    size_t length = pheno_memory_stats_json(&memory, json, sizeof(json));
+    if (length < sizeof(json)) {
+        svg_puts(w, ",\"memory\":");
+        svg_put(w, json, length);
+    }
+    svg_puts(w, "}");
+}
+
+void daemon_shutdown(GosiUMLDaemon* d) {
+    if (!d) return;
+    pthread_mutex_lock(&d->lock);
+    if (!d->stopping) {
+        d->stopping = true;
+        shutdown(d->listen_fd, SHUT_RDWR);  // Wakes accept()
+        pthread_cond_broadcast(&d->changed);
+    }
+    pthread_mutex_unlock(&d->lock);
+}
+
+static DaemonStatus dispatch(GosiUMLDaemon* d, DaemonOp op, int argc, char** argv, SvgWriter* w) {
+    switch (op) {
+        case DAEMON_PING:
+            svg_puts(w, "{\"pong\":true}");
+            return DAEMON_OK;
+        case DAEMON_STATS:
+            reply_stats(d, w);
+            return DAEMON_OK;
+        case DAEMON_SHUTDOWN:
+            svg_puts(w, "{\"stopping\":true}");
+            return DAEMON_OK;
+        case DAEMON_PARSE:
+        case DAEMON_RENDER:
+        case DAEMON_QUERY:
+            break;
+        default:
+            return DAEMON_BAD_REQUEST;
+    }
+    if (argc < 1 || (op == DAEMON_RENDER && argc < 2)) return DAEMON_BAD_REQUEST;
+
+    bool hit;
+    DaemonDocument* e = document_acquire(d, argv[0], &hit);
+    if (!e) return DAEMON_NOT_FOUND;
+    if (hit) atomic_fetch_add_explicit(&d->hits, 1, memory_order_relaxed);
+
+    DaemonStatus status = DAEMON_OK;
+    if (op == DAEMON_PARSE) {
+        reply_summary(w, e, hit);
+    } else if (op == DAEMON_RENDER) {
+        status = handle_render(d, e, argv[1], argc > 2 ? argv[2] : NULL, w);
+    } else {
+        status = handle_query(e, argc > 1 ? argv[1] : NULL, hit, w);
+    }
+    document_release(d, e);
+    return status;
+}
+
+// NUL-terminated arguments; false if the payload is not a whole number of them
+static bool split_args(char* payload, size_t len, int* argc, char** argv) {
+    *argc = 0;
+    if (len == 0) return true;
+    if (payload[len - 1] != '\0') return false;
+    for (size_t pos = 0; pos < len; pos += strlen(payload + pos) + 1) {
+        if (*argc == DAEMON_MAX_ARGS) return false;
+        argv[(*argc)++] = payload + pos;
+    }
+    return true;
+}
+
+static void* connection_run(void* arg) {
+    DaemonConnection* conn = arg;
+    GosiUMLDaemon* d = conn->daemon;
+    int fd = conn->fd;
+    free(conn);
+
+    char* reply = malloc(DAEMON_REPLY_SIZE);
+    char* payload = NULL;
+    size_t payload_cap = 0;
+    DaemonFrame frame;
+    while (reply && read_full(fd, &frame, sizeof(frame))) {
+        uint64_t start = pheno_monotonic_ns();
+        if (frame.magic != DAEMON_MAGIC) break;
+        atomic_fetch_add_explicit(&d->requests, 1, memory_order_relaxed);
+
+        DaemonStatus status = DAEMON_BAD_REQUEST;
+        SvgWriter w;
+        svg_writer_init_memory(&w, reply, DAEMON_REPLY_SIZE);
+        if (frame.length > DAEMON_MAX_PAYLOAD) {
+            if (!discard(fd, frame.length)) break;
+        } else {
+            if (frame.length + 1 > payload_cap) {
+                char* grown = realloc(payload, frame.length + 1);
+                if (!grown) break;
+                payload = grown;
+                payload_cap = frame.length + 1;
+            }
+            if (!read_full(fd, payload, frame.length)) break;
+            int argc;
+            char* argv[DAEMON_MAX_ARGS];
+            if (split_args(payload, frame.length, &argc, argv)) {
+                status = dispatch(d, (DaemonOp)frame.op, argc, argv, &w);
+            }
+        }
+        if (w.failed) status = DAEMON_FAILED;
+        if (status != DAEMON_OK) {
+            atomic_fetch_add_explicit(&d->errors, 1, memory_order_relaxed);
+            w.used = 0;
+        }
+        bool sent = send_frame(fd, frame.op, (uint16_t)status, reply, w.used);
+        pheno_hist_record(&d->latency, pheno_monotonic_ns() - start);
+        if (status == DAEMON_OK && frame.op == DAEMON_SHUTDOWN) daemon_shutdown(d);
+        if (!sent) break;
+    }
+    free(payload);
+    free(reply);
+
+    pthread_mutex_lock(&d->lock);
+    for (int i = 0; i < d->conn_count; i++) {
+        if (d->conns[i] == fd) {
+            d->conns[i] = d->conns[--d->conn_count];
+            break;
+        }
+    }
+    close(fd);
+    pthread_cond_broadcast(&d->changed);
+    pthread_mutex_unlock(&d->lock);
+    return NULL;
+}
+
+static bool add_connection(GosiUMLDaemon* d, int fd) {
+    if (d->conn_count == d->conn_capacity) {
+        int cap = d->conn_capacity ? d->conn_capacity * 2 : 16;
+        int* grown = realloc(d->conns, (size_t)cap * sizeof(int));
+        if (!grown) return false;
+        d->conns = grown;
+        d->conn_capacity = cap;
+    }
+    d->conns[d->conn_count++] = fd;
+    return true;
+}
+
+// One detached thread per connection: requests on a connection are
+// served in order, connections run in parallel
+static void* acceptor_run(void* arg) {
+    GosiUMLDaemon* d = arg;
+    for (;;) {
+        int fd = accept4(d->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+
+        pthread_mutex_lock(&d->lock);
+        DaemonConnection* conn = d->stopping ? NULL : malloc(sizeof(DaemonConnection));
+        bool started = false;
+        if (conn && add_connection(d, fd)) {
+            conn->daemon = d;
+            conn->fd = fd;
+            pthread_t thread;
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+            started = pthread_create(&thread, &attr, connection_run, conn) == 0;
+            pthread_attr_destroy(&attr);
+            if (!started) d->conn_count--;
+        }
+        pthread_mutex_unlock(&d->lock);
+        if (!started) {
+            free(conn);
+            close(fd);
+            continue;
+        }
+        atomic_fetch_add_explicit(&d->connections, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Lifecycle
+// ---------------------------------------------------------------------------
+
+static bool socket_address(const char* path, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (!path || strlen(path) >= sizeof(addr->sun_path)) return false;
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+static int bind_socket(const char* path) {
+    struct sockaddr_un addr;
+    if (!socket_address(path, &addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        // Replace the socket file only if nobody answers on it
+        bool stale = errno == EADDRINUSE;
+        int probe = stale ? daemon_connect(path) : -1;
+        if (probe >= 0) {
+            daemon_disconnect(probe);
+            stale = false;
+        }
+        if (stale) unlink(path);
+        if (!stale || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, 64) != 0) {
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+GosiUMLDaemon* daemon_start(const DaemonOptions* options) {
+    if (!options) return NULL;
+    GosiUMLDaemon* d = calloc(1, sizeof(GosiUMLDaemon));
+    if (!d) return NULL;
+    d->options = *options;
+    int max = options->max_documents > 0 ? options->max_documents : DAEMON_MAX_DOCUMENTS;
+    d->docs = calloc((size_t)max, sizeof(DaemonDocument*));
+    if (options->threads > 1) d->pool = pheno_threadpool_create(options->threads);
+    bool ready = d->docs && (options->threads <= 1 || d->pool);
+    d->listen_fd = ready ? bind_socket(options->socket_path) : -1;
+    if (d->listen_fd < 0) {
+        if (!options->quiet && ready) {
+            fprintf(stderr, "[DAEMON] Cannot listen on %s\n", options->socket_path);
+        }
+        pheno_threadpool_destroy(d->pool);
+        free(d->docs);
+        free(d);
+        return NULL;
+    }
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->changed, NULL);
+    if (pthread_create(&d->acceptor, NULL, acceptor_run, d) != 0) {
+        close(d->listen_fd);
+        unlink(options->socket_path);
+        pthread_cond_destroy(&d->changed);
+        pthread_mutex_destroy(&d->lock);
+        pheno_threadpool_destroy(d->pool);
+        free(d->docs);
+        free(d);
+        return NULL;
+    }
+    if (!options->quiet) printf("[DAEMON] Listening on %s\n", options->socket_path);
+    return d;
+}
+
+void daemon_wait(GosiUMLDaemon* d) {
+    if (!d) return;
+    pthread_mutex_lock(&d->lock);
+    while (!d->stopping) pthread_cond_wait(&d->changed, &d->lock);
+    pthread_mutex_unlock(&d->lock);
+}
+
+void daemon_stop(GosiUMLDaemon* d) {
+    if (!d) return;
+    daemon_shutdown(d);
+    pthread_join(d->acceptor, NULL);
+
+    // Unblock every connection's read and wait for the threads to leave
+    pthread_mutex_lock(&d->lock);
+    for (int i = 0; i < d->conn_count; i++) shutdown(d->conns[i], SHUT_RDWR);
+    while (d->conn_count > 0) pthread_cond_wait(&d->changed, &d->lock);
+    while (d->doc_count > 0) table_remove(d, d->doc_count - 1);
+    pthread_mutex_unlock(&d->lock);
+
+    close(d->listen_fd);
+    unlink(d->options.socket_path);
+    pthread_cond_destroy(&d->changed);
+    pthread_mutex_destroy(&d->lock);
+    pheno_threadpool_destroy(d->pool);
+    free(d->conns);
+    free(d->docs);
+    free(d);
+}
+
+void daemon_get_stats(GosiUMLDaemon* d, DaemonStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!d) return;
+    stats->requests = atomic_load_explicit(&d->requests, memory_order_relaxed);
+    stats->errors = atomic_load_explicit(&d->errors, memory_order_relaxed);
+    stats->parses = atomic_load_explicit(&d->parses, memory_order_relaxed);
+    stats->hits = atomic_load_explicit(&d->hits, memory_order_relaxed);
+    stats->renders = atomic_load_explicit(&d->renders, memory_order_relaxed);
+    stats->connections = atomic_load_explicit(&d->connections, memory_order_relaxed);
+    pthread_mutex_lock(&d->lock);
+    stats->documents = (uint64_t)d->doc_count;
+    pthread_mutex_unlock(&d->lock);
+
+    PhenoHistogramSnapshot* snap = malloc(sizeof(PhenoHistogramSnapshot));
+    if (snap) {
+        pheno_hist_snapshot(&d->latency, snap, false);
+        stats->p50_ns = pheno_hist_percentile(snap, 50.0);
+        stats->p99_ns = pheno_hist_percentile(snap, 99.0);
+        free(snap);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Client
+// ---------------------------------------------------------------------------
+
+int daemon_connect(const char* socket_path) {
+    struct sockaddr_un addr;
+    if (!socket_address(socket_path, &addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int daemon_request(int fd, DaemonOp op, int argc, const char* const* argv,
+                   char* reply, size_t reply_size) {
+    if (fd < 0 || argc < 0 || argc > DAEMON_MAX_ARGS) return -1;
+    char payload[4096];
+    size_t len = 0;
+    for (int i = 0; i < argc; i++) {
+        size_t n = strlen(argv[i]) + 1;
+        if (len + n > sizeof(payload)) return -1;
+        memcpy(payload + len, argv[i], n);
+        len += n;
+    }
+    if (!send_frame(fd, (uint16_t)op, 0, payload, len)) return -1;
+
+    DaemonFrame frame;
+    if (!read_full(fd, &frame, sizeof(frame)) || frame.magic != DAEMON_MAGIC) return -1;
+    size_t keep = reply_size > 0 ? reply_size - 1 : 0;
+    if (keep > frame.length) keep = frame.length;
+    if (keep > 0 && !read_full(fd, reply, keep)) return -1;
+    if (reply_size > 0) reply[keep] = '\0';
+    if (!discard(fd, frame.length - keep)) return -1;
+    return frame.status;
+}
+
+void daemon_disconnect(int fd) {
+    if (fd >= 0) close(fd);
+}
@@ -0,0 +1,803 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "layout_engine.h"
+#include "pheno_threadpool.h"
+#include "pheno_histogram.h"
+#include "pheno_trace.h"
+
+#define LAYOUT_DEFAULT_ITERATIONS 50
+#define LAYOUT_DEFAULT_THETA      1.2
+#define LAYOUT_DEFAULT_SWEEPS     4
+#define LAYOUT_CHUNK              2048     // Nodes per task
+#define LAYOUT_PARALLEL_MIN       8192     // Smaller inputs stay on the caller
+#define LAYOUT_MIN_WRAP           32       // Layer rows never wrap below this
+#define LAYOUT_LAYER_GAP          60       // Extra space between layers
+#define LAYOUT_QUAD_DEPTH         48       // Deeper cells aggregate coincident nodes
+#define LAYOUT_FORCE_K            160.0    // Ideal edge length
+#define LAYOUT_DEEP_RATIO         4        // AUTO layers DAGs up to 4 * sqrt(n) deep
+#define LAYOUT_GRAVITY            1.0      // Pull towards the origin, keeps components together
+
+void layout_defaults(LayoutOptions* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->mode = LAYOUT_AUTO;
+    options->iterations = LAYOUT_DEFAULT_ITERATIONS;
+    options->theta = LAYOUT_DEFAULT_THETA;
+    options->sweeps = LAYOUT_DEFAULT_SWEEPS;
+}
+
+const char* layout_mode_name(LayoutMode mode) {
+    switch (mode) {
+        case LAYOUT_AUTO:    return "auto";
+        case LAYOUT_GRID:    return "grid";
+        case LAYOUT_LAYERED: return "layered";
+        case LAYOUT_FORCE:   return "force";
+    }
+    return "unknown";
+}
+
+bool layout_parse_mode(const char* name, LayoutMode* mode) {
+    static const LayoutMode modes[] = { LAYOUT_AUTO, LAYOUT_GRID, LAYOUT_LAYERED, LAYOUT_FORCE };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (name && strcmp(name, layout_mode_name(modes[i])) == 0) {
+            *mode = modes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void layout_free(Layout* layout) {
+    if (!layout) return;
+    free(layout->nodes);
+    free(layout->edges);
+    memset(layout, 0, sizeof(*layout));
+}
+
+static void finish_canvas(Layout* layout, double width, double height) {
+    layout->width = (float)(width < LAYOUT_MIN_WIDTH ? LAYOUT_MIN_WIDTH : width);
+    layout->height = (float)(height < LAYOUT_MIN_HEIGHT ? LAYOUT_MIN_HEIGHT : height);
+}
+
+bool layout_grid(size_t count, Layout* layout) {
+    memset(layout, 0, sizeof(*layout));
+    layout->mode = LAYOUT_GRID;
+    layout->nodes = malloc((count ? count : 1) * sizeof(LayoutPoint));
+    if (!layout->nodes) return false;
+    layout->node_count = count;
+
+    // Square-ish, never narrower than the original four columns
+    size_t cols = 4;
+    while (cols * cols < count) cols++;
+    size_t rows = (count + cols - 1) / cols;
+    for (size_t i = 0; i < count; i++) {
+        layout->nodes[i].x = (float)(LAYOUT_MARGIN + (i % cols) * LAYOUT_H_SPACING + LAYOUT_NODE_WIDTH / 2);
+        layout->nodes[i].y = (float)(LAYOUT_MARGIN + (i / cols) * LAYOUT_V_SPACING + LAYOUT_NODE_HEIGHT / 2);
+    }
+    finish_canvas(layout, 2.0 * LAYOUT_MARGIN + (cols - 1) * (double)LAYOUT_H_SPACING + LAYOUT_NODE_WIDTH,
+                  LAYOUT_MARGIN + rows * (double)LAYOUT_V_SPACING + 40);
+    return true;
+}
+
+// Relation graph over token indices, both directions in CSR form
+typedef struct {
+    size_t n;
+    size_t m;
+    uint32_t* pairs;               // m (src, dst) pairs, relation order
+    uint32_t* out_start;           // n + 1
+    uint32_t* out;
+    uint32_t* in_start;            // n + 1
+    uint32_t* in;
+} Graph;
+
+static void graph_free(Graph* g) {
+    free(g->pairs);
+    free(g->out_start);
+    free(g->out);
+    free(g->in_start);
+    free(g->in);
+}
+
+// Token id -> index + 1 (first token wins for duplicate ids)
+typedef struct {
+    uint32_t* keys;
+    uint32_t* values;
+    int bits;
+} IdMap;
+
+static inline size_t id_slot(const IdMap* map, uint32_t id) {
+    return (size_t)((id * 0x9E3779B97F4A7C15ULL) >> (64 - map->bits));
+}
+
+static uint32_t id_find(const IdMap* map, uint32_t id) {
+    size_t mask = ((size_t)1 << map->bits) - 1;
+    for (size_t s = id_slot(map, id); map->values[s]; s = (s + 1) & mask) {
+        if (map->keys[s] == id) return map->values[s];
+    }
+    return 0;
+}
+
+static bool build_graph(const GosiUMLDocument* doc, Graph* g) {
+    memset(g, 0, sizeof(*g));
+    size_t n = doc->token_count;
+    g->n = n;
+
+    IdMap map = { NULL, NULL, 4 };
+    while (((size_t)1 << map.bits) < n * 2) map.bits++;
+    size_t slots = (size_t)1 << map.bits;
+    map.keys = malloc(slots * sizeof(uint32_t));
+    map.values = calloc(slots, sizeof(uint32_t));
+    g->pairs = malloc((doc->relation_count ? doc->relation_count : 1) * 2 * sizeof(uint32_t));
+    g->out_start = calloc(n + 2, sizeof(uint32_t));
+    g->in_start = calloc(n + 2, sizeof(uint32_t));
+    bool ok = map.keys && map.values && g->pairs && g->out_start && g->in_start;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        uint32_t id = doc->tokens[i].token_id;
+        size_t s = id_slot(&map, id);
+        while (map.values[s] && map.keys[s] != id) s = (s + 1) & (slots - 1);
+        if (!map.values[s]) {
+            map.keys[s] = id;
+            map.values[s] = (uint32_t)i + 1;
+        }
+    }
+
+    // Degree of token i is counted in slot i + 2 (src/dst are index + 1)
+    for (size_t r = 0; ok && r < doc->relation_count; r++) {
+        uint32_t src = id_find(&map, doc->relations[r].src_id);
+        uint32_t dst = id_find(&map, doc->relations[r].dst_id);
+        if (!src || !dst || src == dst) continue;
+        g->pairs[g->m * 2] = src - 1;
+        g->pairs[g->m * 2 + 1] = dst - 1;
+        g->out_start[src + 1]++;
+        g->in_start[dst + 1]++;
+        g->m++;
+    }
+    free(map.keys);
+    free(map.values);
+
+    if (ok) {
+        for (size_t i = 1; i <= n; i++) {
+            g->out_start[i + 1] += g->out_start[i];
+            g->in_start[i + 1] += g->in_start[i];
+        }
+        g->out = malloc((g->m ? g->m : 1) * sizeof(uint32_t));
+        g->in = malloc((g->m ? g->m : 1) * sizeof(uint32_t));
+        ok = g->out && g->in;
+    }
+    if (ok) {
+        // Slot i + 1 now holds the start of row i; using it as the fill
+        // cursor leaves slot i + 1 at the end of row i, i.e. the start of
+        // row i + 1
+        for (size_t e = 0; e < g->m; e++) {
+            uint32_t src = g->pairs[e * 2], dst = g->pairs[e * 2 + 1];
+            g->out[g->out_start[src + 1]++] = dst;
+            g->in[g->in_start[dst + 1]++] = src;
+        }
+    }
+    if (!ok) graph_free(g);
+    return ok;
+}
+
+// Kahn's algorithm; false when the graph has a cycle
+static bool topo_order(const Graph* g, uint32_t* order) {
+    uint32_t* indegree = malloc((g->n ? g->n : 1) * sizeof(uint32_t));
+    if (!indegree) return false;
+
+    size_t head = 0, tail = 0;
+    for (size_t v = 0; v < g->n; v++) {
+        indegree[v] = g->in_start[v + 1] - g->in_start[v];
+        if (indegree[v] == 0) order[tail++] = (uint32_t)v;
+    }
+    while (head < tail) {
+        uint32_t v = order[head++];
+        for (uint32_t e = g->out_start[v]; e < g->out_start[v + 1]; e++) {
+            if (--indegree[g->out[e]] == 0) order[tail++] = g->out[e];
+        }
+    }
+    free(indegree);
+    return tail == g->n;
+}
+
+// Range work split across the pool
+typedef void (*RangeFunc)(void* ctx, size_t begin, size_t end);
+
+typedef struct {
+    RangeFunc func;
+    void* ctx;
+    size_t begin;
+    size_t end;
+} RangeTask;
+
+static void run_range(void* arg) {
+    RangeTask* task = arg;
+    task->func(task->ctx, task->begin, task->end);
+}
+
+static void parallel_for(PhenoThreadPool* pool, size_t count, RangeFunc func, void* ctx) {
+    size_t tasks = (count + LAYOUT_CHUNK - 1) / LAYOUT_CHUNK;
+    RangeTask* t = pool && tasks > 1 ? malloc(tasks * sizeof(RangeTask)) : NULL;
+    if (!t) {
+        func(ctx, 0, count);
+        return;
+    }
+
+    PhenoTaskGroup group;
+    pheno_taskgroup_init(&group);
+    for (size_t i = 0; i < tasks; i++) {
+        size_t end = (i + 1) * LAYOUT_CHUNK;
+        t[i] = (RangeTask){ func, ctx, i * LAYOUT_CHUNK, end < count ? end : count };
+        pheno_threadpool_submit(pool, &group, run_range, &t[i]);
+    }
+    pheno_taskgroup_wait(pool, &group);
+    pheno_taskgroup_destroy(&group);
+    free(t);
+}
+
+// --- Layered ---------------------------------------------------------------
+
+typedef struct {
+    const Graph* g;
+    const uint32_t* row;
+    const double* pos;
+    double* key;
+    bool down;
+} BarycenterStep;
+
+static void barycenter_range(void* ctx, size_t begin, size_t end) {
+    BarycenterStep* st = ctx;
+    const uint32_t* start = st->down ? st->g->in_start : st->g->out_start;
+    const uint32_t* adj = st->down ? st->g->in : st->g->out;
+
+    for (size_t i = begin; i < end; i++) {
+        uint32_t v = st->row[i];
+        uint32_t lo = start[v], hi = start[v + 1];
+        if (lo == hi) {
+            st->key[i] = st->pos[v];
+            continue;
+        }
+        double sum = 0;
+        for (uint32_t e = lo; e < hi; e++) sum += st->pos[adj[e]];
+        st->key[i] = sum / (hi - lo);
+    }
+}
+
+typedef struct {
+    double key;
+    double pos;
+    uint32_t v;
+} OrderEntry;
+
+static int compare_order(const void* a, const void* b) {
+    const OrderEntry* x = a;
+    const OrderEntry* y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+// Longest path from the sources; returns the layer count
+static uint32_t assign_layers(const Graph* g, const uint32_t* topo, uint32_t* layer) {
+    uint32_t layers = 0;
+    memset(layer, 0, g->n * sizeof(uint32_t));
+    for (size_t i = 0; i < g->n; i++) {
+        uint32_t v = topo[i];
+        for (uint32_t e = g->out_start[v]; e < g->out_start[v + 1]; e++) {
+            uint32_t w = g->out[e];
+            if (layer[w] < layer[v] + 1) layer[w] = layer[v] + 1;
+        }
+        if (layer[v] + 1 > layers) layers = layer[v] + 1;
+    }
+    return layers;
+}
+
+static bool layout_layered(const Graph* g, const uint32_t* topo, const uint32_t* layer,
+                           uint32_t layers, int sweeps, PhenoThreadPool* pool, Layout* layout) {
+    size_t n = g->n;
+    double* pos = malloc((n ? n : 1) * sizeof(double));
+    double* key = malloc((n ? n : 1) * sizeof(double));
+    uint32_t* members = malloc((n ? n : 1) * sizeof(uint32_t));
+    OrderEntry* scratch = malloc((n ? n : 1) * sizeof(OrderEntry));
+    uint32_t* layer_start = NULL;
+    bool ok = pos && key && members && scratch;
+
+    // Bucket by layer, topological order within each layer
+    layer_start = ok ? calloc((size_t)layers + 2, sizeof(uint32_t)) : NULL;
+    ok = ok && layer_start;
+    if (ok) {
+        for (size_t v = 0; v < n; v++) layer_start[layer[v] + 2]++;
+        for (uint32_t l = 0; l < layers; l++) layer_start[l + 2] += layer_start[l + 1];
+        for (size_t i = 0; i < n; i++) {
+            uint32_t v = topo[i];
+            members[layer_start[layer[v] + 1]++] = v;
+        }
+        for (uint32_t l = 0; l < layers; l++) {
+            uint32_t size = layer_start[l + 1] - layer_start[l];
+            for (uint32_t i = 0; i < size; i++) {
+                pos[members[layer_start[l] + i]] = (i + 0.5) / size;
+            }
+        }
+    }
+
+    // Barycenter sweeps, alternating down (in-edges) and up (out-edges).
+    // Positions are normalised per layer so long edges compare fairly.
+    for (int s = 0; ok && s < sweeps && layers > 1; s++) {
+        bool down = (s % 2) == 0;
+        for (uint32_t k = 1; k < layers; k++) {
+            uint32_t l = down ? k : layers - 1 - k;
+            uint32_t* row = members + layer_start[l];
+            uint32_t size = layer_start[l + 1] - layer_start[l];
+            BarycenterStep step = { g, row, pos, key, down };
+            parallel_for(size >= LAYOUT_PARALLEL_MIN ? pool : NULL, size, barycenter_range, &step);
+
+            for (uint32_t i = 0; i < size; i++) {
+                scratch[i] = (OrderEntry){ key[i], pos[row[i]], row[i] };
+            }
+            qsort(scratch, size, sizeof(OrderEntry), compare_order);
+            for (uint32_t i = 0; i < size; i++) {
+                row[i] = scratch[i].v;
+                pos[row[i]] = (i + 0.5) / size;
+            }
+        }
+    }
+
+    // Wrap wide layers into rows and centre every row
+    if (ok) {
+        uint32_t wrap = 1;
+        while ((size_t)wrap * wrap < n) wrap++;
+        wrap = wrap * 2 < LAYOUT_MIN_WRAP ? LAYOUT_MIN_WRAP : wrap * 2;
+
+        uint32_t widest = 1;
+        for (uint32_t l = 0; l < layers; l++) {
+            uint32_t size = layer_start[l + 1] - layer_start[l];
+            if (size > widest) widest = size;
+        }
+        if (widest > wrap) widest = wrap;
+        double max_width = (widest - 1) * (double)LAYOUT_H_SPACING + LAYOUT_NODE_WIDTH;
+
+        double y = LAYOUT_MARGIN;
+        for (uint32_t l = 0; l < layers; l++) {
+            uint32_t size = layer_start[l + 1] - layer_start[l];
+            for (uint32_t first = 0; first < size; first += wrap) {
+                uint32_t count = size - first < wrap ? size - first : wrap;
+                double row_width = (count - 1) * (double)LAYOUT_H_SPACING + LAYOUT_NODE_WIDTH;
+                double x = LAYOUT_MARGIN + (max_width - row_width) / 2 + LAYOUT_NODE_WIDTH / 2;
+                for (uint32_t i = 0; i < count; i++) {
+                    LayoutPoint* p = &layout->nodes[members[layer_start[l] + first + i]];
+                    p->x = (float)(x + i * (double)LAYOUT_H_SPACING);
+                    p->y = (float)(y + LAYOUT_NODE_HEIGHT / 2);
+                }
+                y += LAYOUT_V_SPACING;
+            }
+            y += LAYOUT_LAYER_GAP;
+        }
+        layout->layers = layers;
+        finish_canvas(layout, 2.0 * LAYOUT_MARGIN + max_width,
+                      y - LAYOUT_LAYER_GAP - (LAYOUT_V_SPACING - LAYOUT_NODE_HEIGHT) + LAYOUT_MARGIN);
+    }
+
+    free(pos);
+    free(key);
+    free(members);
+    free(scratch);
+    free(layer_start);
+    return ok;
+}
+
+// --- Force-directed (Barnes-Hut) -------------------------------------------
+
+typedef struct {
+    double x, y;
+} Vec2;
+
+// Build cell: double sums, centres of mass resolved when compacting
+typedef struct {
+    double sx, sy;                 // Sum of body positions
+    double x, y, half;             // Cell centre and half extent
+    uint32_t mass;
+    int32_t child[4];
+    int32_t body;                  // Leaf body, -1 for internal cells
+} BuildCell;
+
+// Traversal cell, stored in depth-first preorder
+typedef struct {
+    float cx, cy;                  // Centre of mass
+    float mass;
+    float size2;                   // Squared cell width
+    int32_t child[4];
+    int32_t body;
+} QuadCell;
+
+typedef struct {
+    BuildCell* cells;
+    size_t count;
+    size_t capacity;
+    int32_t* next;                 // Further bodies of an aggregated leaf
+    QuadCell* tree;
+    size_t tree_capacity;
+} QuadTree;
+
+static int32_t quad_add(QuadTree* t, double x, double y, double half) {
+    if (t->count == t->capacity) {
+        size_t cap = t->capacity ? t->capacity * 2 : 1024;
+        BuildCell* grown = realloc(t->cells, cap * sizeof(BuildCell));
+        if (!grown) return -1;
+        t->cells = grown;
+        t->capacity = cap;
+    }
+    BuildCell* q = &t->cells[t->count];
+    memset(q, 0, sizeof(*q));
+    q->x = x;
+    q->y = y;
+    q->half = half;
+    q->child[0] = q->child[1] = q->child[2] = q->child[3] = -1;
+    q->body = -1;
+    return (int32_t)t->count++;
+}
+
+static inline int quadrant(const BuildCell* q, double x, double y) {
+    return (x >= q->x) | ((y >= q->y) << 1);
+}
+
+static int32_t quad_child(QuadTree* t, int32_t parent, int c) {
+    const BuildCell* p = &t->cells[parent];
+    double h = p->half / 2;
+    int32_t child = quad_add(t, p->x + ((c & 1) ? h : -h), p->y + ((c & 2) ? h : -h), h);
+    if (child >= 0) t->cells[parent].child[c] = child;
+    return child;
+}
+
+static bool quad_insert(QuadTree* t, const Vec2* p, uint32_t v) {
+    int32_t cur = 0;
+    for (int depth = 0; ; depth++) {
+        BuildCell* q = &t->cells[cur];
+        uint32_t m = q->mass++;
+        q->sx += p[v].x;
+        q->sy += p[v].y;
+        if (m == 0) {
+            q->body = (int32_t)v;
+            t->next[v] = -1;
+            return true;
+        }
+
+        if (q->body >= 0) {
+            // Coincident nodes stay aggregated in one deep leaf
+            if (depth >= LAYOUT_QUAD_DEPTH) {
+                t->next[v] = t->next[q->body];
+                t->next[q->body] = (int32_t)v;
+                return true;
+            }
+            uint32_t b = (uint32_t)q->body;
+            q->body = -1;
+            int32_t child = quad_child(t, cur, quadrant(q, p[b].x, p[b].y));
+            if (child < 0) return false;
+            BuildCell* c = &t->cells[child];
+            c->sx = p[b].x;
+            c->sy = p[b].y;
+            c->mass = 1;
+            c->body = (int32_t)b;
+            q = &t->cells[cur];
+        }
+
+        int quad = quadrant(q, p[v].x, p[v].y);
+        int32_t next = q->child[quad];
+        if (next < 0 && (next = quad_child(t, cur, quad)) < 0) return false;
+        cur = next;
+    }
+}
+
+// Bodies are inserted in the previous traversal order, which keeps the
+// insertion paths cache-resident
+static bool quad_build(QuadTree* t, const Vec2* p, const uint32_t* order, size_t n) {
+    double minx = p[0].x, maxx = p[0].x, miny = p[0].y, maxy = p[0].y;
+    for (size_t v = 1; v < n; v++) {
+        if (p[v].x < minx) minx = p[v].x;
+        if (p[v].x > maxx) maxx = p[v].x;
+        if (p[v].y < miny) miny = p[v].y;
+        if (p[v].y > maxy) maxy = p[v].y;
+    }
+    double half = fmax(maxx - minx, maxy - miny) / 2 + 1;
+
+    t->count = 0;
+    if (quad_add(t, (minx + maxx) / 2, (miny + maxy) / 2, half) < 0) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (!quad_insert(t, p, order[i])) return false;
+    }
+    return true;
+}
+
+// Lay the traversal tree out in depth-first preorder and list the bodies
+// in the same order, so consecutive nodes walk mostly the same cells
+static bool quad_compact(QuadTree* t, uint32_t* order) {
+    if (t->tree_capacity < t->count) {
+        QuadCell* grown = realloc(t->tree, t->count * sizeof(QuadCell));
+        if (!grown) return false;
+        t->tree = grown;
+        t->tree_capacity = t->count;
+    }
+
+    // (build cell, destination parent, quadrant)
+    int32_t stack[(LAYOUT_QUAD_DEPTH * 4 + 8) * 3];
+    int sp = 0;
+    size_t count = 0, bodies = 0;
+    stack[sp++] = 0;
+    stack[sp++] = -1;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        int c = stack[--sp];
+        int32_t parent = stack[--sp];
+        const BuildCell* src = &t->cells[stack[--sp]];
+        int32_t dst = (int32_t)count++;
+        QuadCell* q = &t->tree[dst];
+        q->cx = (float)(src->sx / src->mass);
+        q->cy = (float)(src->sy / src->mass);
+        q->mass = (float)src->mass;
+        q->size2 = (float)(4 * src->half * src->half);
+        q->child[0] = q->child[1] = q->child[2] = q->child[3] = -1;
+        q->body = src->body;
+        if (parent >= 0) t->tree[parent].child[c] = dst;
+
+        for (int32_t b = src->body; b >= 0; b = t->next[b]) order[bodies++] = (uint32_t)b;
+        for (int i = 3; i >= 0; i--) {
+            if (src->child[i] < 0) continue;
+            stack[sp++] = src->child[i];
+            stack[sp++] = dst;
+            stack[sp++] = i;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    const Graph* g;
+    const QuadCell* cells;
+    const uint32_t* order;
+    const Vec2* p;
+    Vec2* d;
+    double k;
+    float theta2;
+} ForceStep;
+
+// Repulsion k^2/d from the tree, attraction d^2/k along relations
+static void force_range(void* ctx, size_t begin, size_t end) {
+    ForceStep* st = ctx;
+    const QuadCell* cells = st->cells;
+    double k2 = st->k * st->k;
+    int32_t stack[LAYOUT_QUAD_DEPTH * 4 + 8];
+
+    for (size_t i = begin; i < end; i++) {
+        size_t v = st->order[i];
+        double x = st->p[v].x, y = st->p[v].y;
+        double fx = 0, fy = 0;
+
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const QuadCell* q = &cells[stack[--sp]];
+            float ddx = (float)x - q->cx, ddy = (float)y - q->cy;
+            float d2 = ddx * ddx + ddy * ddy;
+            float m = q->mass;
+
+            if (q->body >= 0) {
+                if ((size_t)q->body == v) m -= 1;
+                if (m <= 0) continue;
+            } else if (q->size2 >= st->theta2 * d2) {
+                for (int c = 0; c < 4; c++) {
+                    if (q->child[c] >= 0) stack[sp++] = q->child[c];
+                }
+                continue;
+            }
+
+            if (d2 < 1e-6f) {
+                // Coincident: push apart in a direction fixed per node
+                double angle = (double)((uint32_t)v * 2654435761u) * (6.283185307179586 / 4294967296.0);
+                fx += cos(angle) * st->k * m;
+                fy += sin(angle) * st->k * m;
+                continue;
+            }
+            double f = k2 * m / d2;
+            fx += ddx * f;
+            fy += ddy * f;
+        }
+
+        const Graph* g = st->g;
+        for (int dir = 0; dir < 2; dir++) {
+            const uint32_t* start = dir ? g->in_start : g->out_start;
+            const uint32_t* adj = dir ? g->in : g->out;
+            for (uint32_t e = start[v]; e < start[v + 1]; e++) {
+                double ddx = x - st->p[adj[e]].x, ddy = y - st->p[adj[e]].y;
+                double d = sqrt(ddx * ddx + ddy * ddy);
+                fx -= ddx * d / st->k;
+                fy -= ddy * d / st->k;
+            }
+        }
+
+        st->d[v].x = fx - LAYOUT_GRAVITY * x;
+        st->d[v].y = fy - LAYOUT_GRAVITY * y;
+    }
+}
+
+// Breadth-first rank over the undirected graph so related nodes start close
+static bool bfs_rank(const Graph* g, uint32_t* rank) {
+    size_t n = g->n;
+    uint32_t* queue = malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!queue) return false;
+    for (size_t v = 0; v < n; v++) rank[v] = UINT32_MAX;
+
+    size_t next = 0;
+    for (size_t root = 0; root < n; root++) {
+        if (rank[root] != UINT32_MAX) continue;
+        size_t head = next, tail = next;
+        queue[tail++] = (uint32_t)root;
+        rank[root] = (uint32_t)next++;
+        while (head < tail) {
+            uint32_t v = queue[head++];
+            for (int dir = 0; dir < 2; dir++) {
+                const uint32_t* start = dir ? g->in_start : g->out_start;
+                const uint32_t* adj = dir ? g->in : g->out;
+                for (uint32_t e = start[v]; e < start[v + 1]; e++) {
+                    uint32_t w = adj[e];
+                    if (rank[w] != UINT32_MAX) continue;
+                    rank[w] = (uint32_t)next++;
+                    queue[tail++] = w;
+                }
+            }
+        }
+    }
+    free(queue);
+    return true;
+}
+
+static bool layout_force(const Graph* g, int iterations, double theta,
+                         PhenoThreadPool* pool, Layout* layout) {
+    size_t n = g->n;
+    double k = LAYOUT_FORCE_K;
+    Vec2* p = malloc(n * sizeof(Vec2));
+    Vec2* d = malloc(n * sizeof(Vec2));
+    uint32_t* rank = malloc(n * sizeof(uint32_t));
+    uint32_t* order = malloc(n * sizeof(uint32_t));
+    QuadTree tree = { NULL, 0, 0, malloc(n * sizeof(int32_t)), NULL, 0 };
+    bool ok = p && d && rank && order && tree.next && bfs_rank(g, rank);
+
+    // Sunflower spiral: even density, one node per k^2-ish area
+    for (size_t v = 0; ok && v < n; v++) {
+        double r = k * sqrt(rank[v] + 0.5);
+        double a = rank[v] * 2.399963229728653;
+        p[v].x = r * cos(a);
+        p[v].y = r * sin(a);
+        order[rank[v]] = (uint32_t)v;
+    }
+
+    double t0 = k * (1 + 0.1 * sqrt((double)n));
+    ForceStep step = { g, NULL, order, p, d, k, (float)(theta * theta) };
+    for (int it = 0; ok && it < iterations; it++) {
+        ok = quad_build(&tree, p, order, n) && quad_compact(&tree, order);
+        if (!ok) break;
+        step.cells = tree.tree;
+        parallel_for(n >= LAYOUT_PARALLEL_MIN ? pool : NULL, n, force_range, &step);
+
+        // Linear cooling caps the per-iteration move
+        double t = t0 * (1.0 - (double)it / iterations) + 1.0;
+        for (size_t v = 0; v < n; v++) {
+            double len = sqrt(d[v].x * d[v].x + d[v].y * d[v].y);
+            if (!(len > 0)) continue;
+            double scale = len > t ? t / len : 1.0;
+            p[v].x += d[v].x * scale;
+            p[v].y += d[v].y * scale;
+        }
+    }
+
+    // Dense graphs settle tighter than the node boxes allow: spread the
+    // result to at least one grid cell of area per node, then translate so
+    // the top-left node box sits on the margin
+    if (ok) {
+        double minx = p[0].x, miny = p[0].y, maxx = p[0].x, maxy = p[0].y;
+        for (size_t v = 1; v < n; v++) {
+            minx = fmin(minx, p[v].x);
+            miny = fmin(miny, p[v].y);
+            maxx = fmax(maxx, p[v].x);
+            maxy = fmax(maxy, p[v].y);
+        }
+        double area = (maxx - minx + LAYOUT_NODE_WIDTH) * (maxy - miny + LAYOUT_NODE_HEIGHT);
+        double scale = sqrt(n * (double)LAYOUT_H_SPACING * LAYOUT_V_SPACING / area);
+        if (scale < 1) scale = 1;
+
+        for (size_t v = 0; v < n; v++) {
+            layout->nodes[v].x = (float)(LAYOUT_MARGIN + LAYOUT_NODE_WIDTH / 2 + (p[v].x - minx) * scale);
+            layout->nodes[v].y = (float)(LAYOUT_MARGIN + LAYOUT_NODE_HEIGHT / 2 + (p[v].y - miny) * scale);
+        }
+        finish_canvas(layout, (maxx - minx) * scale + LAYOUT_NODE_WIDTH + 2.0 * LAYOUT_MARGIN,
+                      (maxy - miny) * scale + LAYOUT_NODE_HEIGHT + 2.0 * LAYOUT_MARGIN);
+    }
+
+    free(p);
+    free(d);
+    free(rank);
+    free(order);
+    free(tree.cells);
+    free(tree.next);
+    free(tree.tree);
+    return ok;
+}
+
+static bool compute_layout(const GosiUMLDocument* doc, const LayoutOptions* options, Layout* layout) {
+    LayoutOptions defaults;
+    layout_defaults(&defaults);
+    if (!options) options = &defaults;
+    if (!doc || !layout) return false;
+
+    uint64_t start = pheno_monotonic_ns();
+    if (options->mode == LAYOUT_GRID || doc->token_count == 0) {
+        if (!layout_grid(doc->token_count, layout)) return false;
+        layout->seconds = (pheno_monotonic_ns() - start) / 1e9;
+        return true;
+    }
+
+    memset(layout, 0, sizeof(*layout));
+    Graph g;
+    if (!build_graph(doc, &g)) return false;
+    uint32_t* topo = malloc(g.n * sizeof(uint32_t));
+    layout->nodes = malloc(g.n * sizeof(LayoutPoint));
+    layout->node_count = g.n;
+    bool ok = topo && layout->nodes;
+
+    // Layering needs a DAG; AUTO also passes on DAGs so deep that the
+    // layered drawing would be a thin strip
+    LayoutMode mode = options->mode;
+    uint32_t* layer = NULL;
+    uint32_t layers = 0;
+    if (ok && mode != LAYOUT_FORCE && topo_order(&g, topo)) {
+        layer = malloc(g.n * sizeof(uint32_t));
+        ok = layer != NULL;
+        if (ok) layers = assign_layers(&g, topo, layer);
+        if (ok && mode == LAYOUT_AUTO && layers > LAYOUT_DEEP_RATIO * sqrt((double)g.n)) {
+            free(layer);
+            layer = NULL;
+        }
+    }
+    mode = layer ? LAYOUT_LAYERED : LAYOUT_FORCE;
+    layout->mode = mode;
+
+    PhenoThreadPool* pool = NULL;
+    bool own_pool = false;
+    if (ok && (options->pool || options->threads != 1) && g.n >= LAYOUT_PARALLEL_MIN) {
+        pool = options->pool;
+        own_pool = !pool && options->threads > 1;
+        if (!pool) pool = own_pool ? pheno_threadpool_create(options->threads)
+                                   : pheno_threadpool_default();
+    }
+
+    if (ok && mode == LAYOUT_LAYERED) {
+        int sweeps = options->sweeps > 0 ? options->sweeps : LAYOUT_DEFAULT_SWEEPS;
+        ok = layout_layered(&g, topo, layer, layers, sweeps, pool, layout);
+    } else if (ok) {
+        int iterations = options->iterations > 0 ? options->iterations : LAYOUT_DEFAULT_ITERATIONS;
+        double theta = options->theta > 0 ? options->theta : LAYOUT_DEFAULT_THETA;
+        ok = layout_force(&g, iterations, theta, pool, layout);
+    }
+    if (own_pool) pheno_threadpool_destroy(pool);
+    free(topo);
+    free(layer);
+
+    // Hand the relation pairs over for edge rendering
+    layout->edges = g.pairs;
+    layout->edge_count = g.m;
+    g.pairs = NULL;
+    graph_free(&g);
+
+    if (!ok) {
+        layout_free(layout);
+        return false;
+    }
+    layout->seconds = (pheno_monotonic_ns() - start) / 1e9;
+    return true;
+}
+
+bool layout_document(const GosiUMLDocument* doc, const LayoutOptions* options, Layout* layout) {
+    PhenoPhaseScope phase;
+    pheno_phase_begin(&phase, PHENO_PHASE_LAYOUT);
+    bool ok = compute_layout(doc, options, layout);
+    pheno_phase_end(&phase);
+    return ok;
+}
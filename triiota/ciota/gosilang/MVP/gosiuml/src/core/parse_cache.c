@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include "parse_cache.h"
+#include "token_scanner.h"
+#include "pheno_hash.h"
+#include "pheno_arena.h"
+
+#define PARSE_CACHE_DEFAULT_BYTES (256ULL << 20)
+
+void parse_cache_defaults(ParseCacheConfig* config) {
+    if (!config) return;
+    memset(config, 0, sizeof(*config));
+    config->max_bytes = PARSE_CACHE_DEFAULT_BYTES;
+}
+
+const char* parse_cache_outcome_name(ParseCacheOutcome outcome) {
+    switch (outcome) {
+        case PARSE_CACHE_MISS:         return "miss";
+        case PARSE_CACHE_HIT:          return "hit";
+        case PARSE_CACHE_HIT_REHASHED: return "hit (rehashed)";
+        case PARSE_CACHE_BYPASS:       return "bypass";
+    }
+    return "unknown";
+}
+
+static bool make_dirs(const char* path) {
+    char buf[1024];
+    size_t len = strlen(path);
+    if (len == 0 || len >= sizeof(buf)) return false;
+    memcpy(buf, path, len + 1);
+
+    for (char* p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return false;
+        *p = '/';
+    }
+    return mkdir(buf, 0755) == 0 || errno == EEXIST;
+}
+
+// Resolve and create the cache directory
+static bool cache_dir(const ParseCacheConfig* config, char* out, size_t size) {
+    const char* env;
+    if (config && config->dir[0]) {
+        snprintf(out, size, "%s", config->dir);
+    } else if ((env = getenv("GOSIUML_CACHE_DIR")) && *env) {
+        snprintf(out, size, "%s", env);
+    } else if ((env = getenv("XDG_CACHE_HOME")) && *env) {
+        snprintf(out, size, "%s/gosiuml", env);
+    } else if ((env = getenv("HOME")) && *env) {
+        snprintf(out, size, "%s/.cache/gosiuml", env);
+    } else {
+        return false;
+    }
+    return make_dirs(out);
+}
+
+static int64_t mtime_ns(const struct stat* st) {
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+static bool hash_file(const char* path, uint64_t* hash) {
+    TokenScanFile file;
+    if (!token_scan_open(&file, path)) return false;
+    *hash = pheno_xxh64(file.data, file.size, 0);
+    token_scan_close(&file);
+    return true;
+}
+
+// Try the existing entry; on success file stays open
+static bool try_hit(const char* entry, const char* source, const struct stat* st,
+                    GosibFile* file, ParseCacheOutcome* outcome) {
+    if (!gosib_open(file, entry)) return false;
+
+    const GosibHeader* h = file->header;
+    if (h->source_size == (uint64_t)st->st_size) {
+        if (h->source_mtime_ns == mtime_ns(st)) {
+            *outcome = PARSE_CACHE_HIT;
+            return true;
+        }
+
+        // Touched but possibly unchanged: compare content
+        uint64_t hash;
+        if (hash_file(source, &hash) && hash == h->content_hash) {
+            // Record the new mtime so the next hit is stat-only. An entry
+            // that cannot be refreshed is treated as a miss and rebuilt.
+            int64_t mtime = mtime_ns(st);
+            int fd = open(entry, O_WRONLY);
+            bool refreshed = fd >= 0 &&
+                pwrite(fd, &mtime, sizeof(mtime), offsetof(GosibHeader, source_mtime_ns)) ==
+                    (ssize_t)sizeof(mtime);
+            if (fd >= 0) refreshed = close(fd) == 0 && refreshed;
+            if (refreshed) {
+                *outcome = PARSE_CACHE_HIT_REHASHED;
+                return true;
+            }
+        }
+    }
+
+    gosib_close(file);
+    return false;
+}
+
+bool parse_cache_open(const ParseCacheConfig* config, const char* source,
+                      GosibFile* file, ParseCacheResult* result) {
+    ParseCacheResult local;
+    if (!result) result = &local;
+    memset(result, 0, sizeof(*result));
+    if (!source || !file) return false;
+
+    struct stat st;
+    char resolved[PATH_MAX];
+    if (stat(source, &st) != 0 || !realpath(source, resolved)) return false;
+
+    char dir[1024];
+    if (!cache_dir(config, dir, sizeof(dir))) {
+        // No usable cache: compile to a temporary entry and unlink it once mapped
+        char tmp[] = "/tmp/gosiuml_cache_XXXXXX";
+        int fd = mkstemp(tmp);
+        if (fd < 0) return false;
+        close(fd);
+        bool ok = gosib_compile(source, tmp, NULL) && gosib_open(file, tmp);
+        unlink(tmp);
+        result->outcome = PARSE_CACHE_BYPASS;
+        return ok;
+    }
+
+    uint64_t key = pheno_xxh64(resolved, strlen(resolved), 0);
+    snprintf(result->entry_path, sizeof(result->entry_path), "%s/%016llx%s",
+             dir, (unsigned long long)key, GOSIB_EXTENSION);
+
+    if (try_hit(result->entry_path, source, &st, file, &result->outcome)) {
+        utimensat(AT_FDCWD, result->entry_path, NULL, 0);  // LRU stamp
+        return true;
+    }
+
+    result->outcome = PARSE_CACHE_MISS;
+    if (!gosib_compile(source, result->entry_path, NULL)) return false;
+    if (!gosib_open(file, result->entry_path)) return false;
+
+    parse_cache_evict(config, result);
+    return true;
+}
+
+typedef struct {
+    char name[64];
+    uint64_t size;
+    int64_t mtime;
+} CacheEntry;
+
+static int compare_age(const void* a, const void* b) {
+    const CacheEntry* x = a;
+    const CacheEntry* y = b;
+    return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+void parse_cache_evict(const ParseCacheConfig* config, ParseCacheResult* result) {
+    char dir[1024];
+    if (!config || config->max_bytes == 0 || !cache_dir(config, dir, sizeof(dir))) return;
+
+    DIR* d = opendir(dir);
+    if (!d) return;
+
+    CacheEntry* entries = NULL;
+    size_t count = 0, capacity = 0;
+    uint64_t total = 0;
+    size_t ext_len = strlen(GOSIB_EXTENSION);
+
+    struct dirent* de;
+    while ((de = readdir(d)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len <= ext_len || len >= sizeof(entries->name) ||
+            strcmp(de->d_name + len - ext_len, GOSIB_EXTENSION) != 0) continue;
+
+        struct stat st;
+        if (fstatat(dirfd(d), de->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            CacheEntry* grown = realloc(entries, capacity * sizeof(CacheEntry));
+            if (!grown) break;
+            entries = grown;
+        }
+        memcpy(entries[count].name, de->d_name, len + 1);
+        entries[count].size = (uint64_t)st.st_size;
+        entries[count].mtime = mtime_ns(&st);
+        total += entries[count].size;
+        count++;
+    }
+
+    if (total > config->max_bytes) {
+        qsort(entries, count, sizeof(CacheEntry), compare_age);
+        for (size_t i = 0; i < count && total > config->max_bytes; i++) {
+            if (unlinkat(dirfd(d), entries[i].name, 0) != 0) continue;
+            total -= entries[i].size;
+            if (result) {
+                result->evicted_entries++;
+                result->evicted_bytes += entries[i].size;
+            }
+        }
+    }
+
+    closedir(d);
+    free(entries);
+}
+
+GosiUMLDocument* parse_cache_load_document(const ParseCacheConfig* config, const char* source,
+                                           ParseCacheResult* result) {
+    GosibFile file;
+    if (!parse_cache_open(config, source, &file, result)) return NULL;
+
+    const GosibHeader* h = file.header;
+    size_t relation_count = (size_t)h->edge_count + h->dangling_count;
+    size_t bytes = sizeof(GosiUMLDocument) + 64 +
+                   h->token_count * sizeof(PhenoToken) +
+                   relation_count * sizeof(GosiUMLRelation);
+
+    PhenoArena* arena = pheno_arena_create(bytes);
+    PhenoSymbolTable* symbols = pheno_symbols_create();
+    GosiUMLDocument* doc = arena ? PHENO_ARENA_NEW(arena, GosiUMLDocument, 1) : NULL;
+    PhenoToken* tokens = doc ? PHENO_ARENA_NEW(arena, PhenoToken, h->token_count) : NULL;
+    GosiUMLRelation* relations = tokens ?
+        PHENO_ARENA_NEW(arena, GosiUMLRelation, relation_count) : NULL;
+    bool ok = symbols && relations;
+
+    // String index i becomes symbol i + 1
+    for (uint32_t i = 0; ok && i < h->string_count; i++) {
+        const char* name = gosib_string(&file, i);
+        ok = pheno_symbols_intern(symbols, name, strlen(name)) == i + 1;
+    }
+
+    for (uint32_t i = 0; ok && i < h->token_count; i++) {
+        const GosibToken* src = &file.tokens[i];
+        PhenoToken* token = &tokens[i];
+        memset(token, 0, sizeof(*token));
+        token->token_id = src->id;
+        strncpy(token->sentinel, gosib_string(&file, src->type), sizeof(token->sentinel) - 1);
+        token->memory_zone = (uint8_t)src->zone;
+        token->type_symbol = src->type + 1;
+        token->zone_symbol = src->zone_name + 1;
+    }
+
+    // Ordinals are a checked permutation, so every slot is filled once and
+    // the relations come back in file order, as a fresh parse returns them
+    for (uint32_t i = 0; ok && i < h->token_count; i++) {
+        for (uint32_t e = gosib_edge_begin(&file, i); e < gosib_edge_end(&file, i); e++) {
+            GosiUMLRelation* rel = &relations[file.edges[e].ordinal];
+            memset(rel, 0, sizeof(*rel));
+            rel->src_id = file.tokens[i].id;
+            rel->dst_id = file.tokens[file.edges[e].dst].id;
+            strncpy(rel->type, gosib_string(&file, file.edges[e].type), sizeof(rel->type) - 1);
+            rel->type_symbol = file.edges[e].type + 1;
+        }
+    }
+    for (uint32_t i = 0; ok && i < h->dangling_count; i++) {
+        GosiUMLRelation* rel = &relations[file.dangling[i].ordinal];
+        memset(rel, 0, sizeof(*rel));
+        rel->src_id = file.dangling[i].src_id;
+        rel->dst_id = file.dangling[i].dst_id;
+        strncpy(rel->type, gosib_string(&file, file.dangling[i].type), sizeof(rel->type) - 1);
+        rel->type_symbol = file.dangling[i].type + 1;
+    }
+
+    if (!ok) {
+        gosib_close(&file);
+        pheno_symbols_destroy(symbols);
+        pheno_arena_destroy(arena);
+        return NULL;
+    }
+
+    memset(doc, 0, sizeof(*doc));
+    doc->tokens = tokens;
+    doc->token_count = h->token_count;
+    doc->relations = relations;
+    doc->relation_count = relation_count;
+    doc->malformed = h->malformed;
+    doc->source_size = h->source_size;
+    doc->symbols = symbols;
+    doc->arena = arena;
+    gosib_close(&file);
+    return doc;
+}
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pheno_arena.h"
+
+#define ARENA_DEFAULT_BLOCK (64u << 10)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    _Alignas(16) unsigned char data[];
+} ArenaBlock;
+
+struct PhenoArena {
+    ArenaBlock* head;           // Current block, older blocks follow
+    size_t block_size;
+    size_t used;
+    size_t reserved;
+};
+
+static ArenaBlock* block_new(size_t size) {
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + size);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+PhenoArena* pheno_arena_create(size_t block_size) {
+    PhenoArena* arena = calloc(1, sizeof(PhenoArena));
+    if (!arena) return NULL;
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK;
+    return arena;
+}
+
+void pheno_arena_destroy(PhenoArena* arena) {
+    if (!arena) return;
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void pheno_arena_reset(PhenoArena* arena) {
+    if (!arena || !arena->head) return;
+
+    // Keep the oldest block and release the rest
+    ArenaBlock* keep = arena->head;
+    while (keep->next) {
+        ArenaBlock* next = keep->next;
+        free(keep);
+        keep = next;
+    }
+    keep->used = 0;
+    arena->head = keep;
+    arena->used = 0;
+    arena->reserved = keep->size;
+}
+
+// Offset in block of the next allocation aligned to align
+static size_t aligned_offset(const ArenaBlock* block, size_t align) {
+    uintptr_t base = (uintptr_t)block->data;
+    uintptr_t p = (base + block->used + align - 1) & ~(uintptr_t)(align - 1);
+    return (size_t)(p - base);
+}
+
+void* pheno_arena_alloc(PhenoArena* arena, size_t size, size_t align) {
+    if (!arena) return NULL;
+    if (align == 0 || (align & (align - 1))) align = 16;
+    if (size == 0) size = 1;
+
+    ArenaBlock* block = arena->head;
+    if (block) {
+        size_t offset = aligned_offset(block, align);
+        if (offset + size <= block->size) {
+            block->used = offset + size;
+            arena->used += size;
+            return block->data + offset;
+        }
+    }
+
+    size_t need = size + align;
+    ArenaBlock* fresh = block_new(need > arena->block_size ? need : arena->block_size);
+    if (!fresh) return NULL;
+    arena->reserved += fresh->size;
+
+    // Oversized requests get a dedicated block behind the current one so
+    // the current block keeps serving small allocations
+    if (block && need > arena->block_size) {
+        fresh->next = block->next;
+        block->next = fresh;
+    } else {
+        fresh->next = block;
+        arena->head = fresh;
+    }
+
+    size_t offset = aligned_offset(fresh, align);
+    fresh->used = offset + size;
+    arena->used += size;
+    return fresh->data + offset;
+}
+
+void* pheno_arena_calloc(PhenoArena* arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void* p = pheno_arena_alloc(arena, count * size, 16);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
+
+char* pheno_arena_strndup(PhenoArena* arena, const char* str, size_t len) {
+    char* p = pheno_arena_alloc(arena, len + 1, 1);
+    if (!p) return NULL;
+    memcpy(p, str, len);
+    p[len] = '\0';
+    return p;
+}
+
+size_t pheno_arena_used(const PhenoArena* arena) {
+    return arena ? arena->used : 0;
+}
+
+size_t pheno_arena_reserved(const PhenoArena* arena) {
+    return arena ? arena->reserved : 0;
+}
@@ -0,0 +1,81 @@
+#include "pheno_histogram.h"
+
+// Clear all buckets
+void pheno_hist_reset(PhenoHistogram* hist) {
+    if (!hist) return;
+
+    for (uint32_t i = 0; i < PHENO_HIST_BUCKETS; i++) {
+        atomic_store_explicit(&hist->counts[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&hist->total_sum, 0, memory_order_relaxed);
+}
+
+// Copy (and optionally drain) a live histogram.
+// Draining uses exchange so concurrent records are never lost.
+void pheno_hist_snapshot(PhenoHistogram* hist, PhenoHistogramSnapshot* out, bool reset) {
+    if (!hist || !out) return;
+
+    out->total_count = 0;
+    for (uint32_t i = 0; i < PHENO_HIST_BUCKETS; i++) {
+        uint64_t count = reset
+            ? atomic_exchange_explicit(&hist->counts[i], 0, memory_order_relaxed)
+            : atomic_load_explicit(&hist->counts[i], memory_order_relaxed);
+        out->counts[i] = count;
+        out->total_count += count;
+    }
+    out->total_sum = reset
+        ? atomic_exchange_explicit(&hist->total_sum, 0, memory_order_relaxed)
+        : atomic_load_explicit(&hist->total_sum, memory_order_relaxed);
+}
+
+// Accumulate src into dst
+void pheno_hist_snapshot_merge(PhenoHistogramSnapshot* dst, const PhenoHistogramSnapshot* src) {
+    if (!dst || !src) return;
+
+    for (uint32_t i = 0; i < PHENO_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total_count += src->total_count;
+    dst->total_sum += src->total_sum;
+}
+
+// Smallest value mapped to a bucket
+uint64_t pheno_hist_bucket_lower(uint32_t index) {
+    if (index < PHENO_HIST_SUB_COUNT) return index;
+
+    uint32_t shift = index / PHENO_HIST_SUB_COUNT - 1;
+    uint64_t sub = index % PHENO_HIST_SUB_COUNT;
+    return (PHENO_HIST_SUB_COUNT + sub) << shift;
+}
+
+// Largest value mapped to a bucket
+uint64_t pheno_hist_bucket_upper(uint32_t index) {
+    if (index < PHENO_HIST_SUB_COUNT) return index;
+
+    uint32_t shift = index / PHENO_HIST_SUB_COUNT - 1;
+    return pheno_hist_bucket_lower(index) + (1ULL << shift) - 1;
+}
+
+// Value at the given percentile (0-100), reported as the bucket upper bound
+uint64_t pheno_hist_percentile(const PhenoHistogramSnapshot* snap, double percentile) {
+    if (!snap || snap->total_count == 0) return 0;
+
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+
+    uint64_t target = (uint64_t)((percentile / 100.0) * (double)snap->total_count + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < PHENO_HIST_BUCKETS; i++) {
+        seen += snap->counts[i];
+        if (seen >= target) return pheno_hist_bucket_upper(i);
+    }
+    return pheno_hist_bucket_upper(PHENO_HIST_BUCKETS - 1);
+}
+
+// Arithmetic mean of recorded values
+uint64_t pheno_hist_mean(const PhenoHistogramSnapshot* snap) {
+    if (!snap || snap->total_count == 0) return 0;
+    return snap->total_sum / snap->total_count;
+}
@@ -0,0 +1,431 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pheno_journal.h"
+
+#define JOURNAL_BUFFER_SIZE (64 * 1024)
+#define JOURNAL_MAX_RECORD  21   // tag + two 10-byte varints
+
+struct PhenoJournalWriter {
+    FILE* fp;
+    pthread_mutex_t mutex;
+    uint64_t prev_timestamp;
+    uint32_t prev_machine;
+    uint64_t record_count;
+    bool io_error;
+    size_t used;
+    uint8_t buffer[JOURNAL_BUFFER_SIZE];
+};
+
+// Zigzag + LEB128 helpers
+static inline uint64_t zigzag_encode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline size_t varint_put(uint8_t* dst, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        dst[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    dst[n++] = (uint8_t)value;
+    return n;
+}
+
+static inline bool varint_get(const uint8_t** cursor, const uint8_t* end, uint64_t* out) {
+    const uint8_t* p = *cursor;
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *cursor = p;
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool journal_flush(PhenoJournalWriter* writer) {
+    if (writer->used == 0) return true;
+    if (fwrite(writer->buffer, 1, writer->used, writer->fp) != writer->used) {
+        writer->io_error = true;
+    }
+    writer->used = 0;
+    return !writer->io_error;
+}
+
+// Open a journal for writing
+PhenoJournalWriter* pheno_journal_open(const char* path) {
+    if (!path) return NULL;
+
+    PhenoJournalWriter* writer = calloc(1, sizeof(PhenoJournalWriter));
+    if (!writer) return NULL;
+
+    writer->fp = fopen(path, "wb");
+    if (!writer->fp) {
+        perror("Failed to create journal");
+        free(writer);
+        return NULL;
+    }
+
+    // The header goes out with the first flush, so an empty journal
+    // still loads; its timestamp is the base for the first delta
+    PhenoJournalHeader header = {0};
+    memcpy(header.magic, PHENO_JOURNAL_MAGIC, 4);
+    header.version = PHENO_JOURNAL_VERSION;
+    header.base_timestamp_ns = pheno_monotonic_ns();
+    memcpy(writer->buffer, &header, sizeof(header));
+    writer->used = sizeof(header);
+    writer->prev_timestamp = header.base_timestamp_ns;
+
+    pthread_mutex_init(&writer->mutex, NULL);
+    return writer;
+}
+
+static bool journal_append(PhenoJournalWriter* writer, uint32_t machine_id,
+                           uint8_t tag, uint64_t timestamp_ns) {
+    if (!writer) return false;
+
+    pthread_mutex_lock(&writer->mutex);
+
+    if (writer->used + JOURNAL_MAX_RECORD > JOURNAL_BUFFER_SIZE) {
+        journal_flush(writer);
+    }
+
+    uint8_t* dst = writer->buffer + writer->used;
+    size_t n = 0;
+    dst[n++] = tag;
+    n += varint_put(dst + n, zigzag_encode((int64_t)machine_id - (int64_t)writer->prev_machine));
+    n += varint_put(dst + n, zigzag_encode((int64_t)(timestamp_ns - writer->prev_timestamp)));
+    writer->used += n;
+
+    writer->prev_machine = machine_id;
+    writer->prev_timestamp = timestamp_ns;
+    writer->record_count++;
+
+    pthread_mutex_unlock(&writer->mutex);
+    return true;
+}
+
+bool pheno_journal_record_at(PhenoJournalWriter* writer, uint32_t machine_id,
+                             PhenoEvent event, uint64_t timestamp_ns) {
+    return journal_append(writer, machine_id, (uint8_t)event, timestamp_ns);
+}
+
+bool pheno_journal_record(PhenoJournalWriter* writer, uint32_t machine_id, PhenoEvent event) {
+    return journal_append(writer, machine_id, (uint8_t)event, pheno_monotonic_ns());
+}
+
+bool pheno_journal_record_reset(PhenoJournalWriter* writer, uint32_t machine_id) {
+    return journal_append(writer, machine_id, PHENO_JOURNAL_RESET, pheno_monotonic_ns());
+}
+
+uint64_t pheno_journal_count(PhenoJournalWriter* writer) {
+    if (!writer) return 0;
+
+    pthread_mutex_lock(&writer->mutex);
+    uint64_t count = writer->record_count;
+    pthread_mutex_unlock(&writer->mutex);
+    return count;
+}
+
+// Flush and close; returns false if any write failed
+bool pheno_journal_close(PhenoJournalWriter* writer) {
+    if (!writer) return false;
+
+    pthread_mutex_lock(&writer->mutex);
+    journal_flush(writer);
+    bool ok = !writer->io_error;
+    if (fclose(writer->fp) != 0) ok = false;
+    pthread_mutex_unlock(&writer->mutex);
+
+    pthread_mutex_destroy(&writer->mutex);
+    free(writer);
+    return ok;
+}
+
+// Decode a whole journal into memory
+PhenoJournalEntry* pheno_journal_load(const char* path, size_t* count) {
+    if (count) *count = 0;
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("[JOURNAL] Could not open file: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PhenoJournalHeader)) {
+        printf("[JOURNAL] Truncated journal: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    const uint8_t* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+    madvise((void*)base, size, MADV_SEQUENTIAL);
+
+    PhenoJournalHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, PHENO_JOURNAL_MAGIC, 4) != 0 ||
+        header.version < 1 || header.version > PHENO_JOURNAL_VERSION) {
+        printf("[JOURNAL] Bad journal header: %s\n", path);
+        munmap((void*)base, size);
+        return NULL;
+    }
+
+    // Records are at least 3 bytes
+    size_t capacity = (size - sizeof(header)) / 3 + 1;
+    PhenoJournalEntry* entries = malloc(capacity * sizeof(PhenoJournalEntry));
+    if (!entries) {
+        munmap((void*)base, size);
+        return NULL;
+    }
+
+    const uint8_t* cursor = base + sizeof(header);
+    const uint8_t* end = base + size;
+    uint64_t timestamp = header.base_timestamp_ns;
+    int64_t machine = 0;
+    size_t n = 0;
+
+    while (cursor < end && n < capacity) {
+        uint8_t event = *cursor++;
+        uint64_t machine_delta, time_delta;
+        if (event > PHENO_JOURNAL_RESET ||
+            !varint_get(&cursor, end, &machine_delta) ||
+            !varint_get(&cursor, end, &time_delta)) {
+            printf("[JOURNAL] Corrupt record at offset %zu, stopping\n",
+                   (size_t)(cursor - base));
+            break;
+        }
+        machine += zigzag_decode(machine_delta);
+        timestamp += (uint64_t)zigzag_decode(time_delta);
+
+        entries[n].timestamp_ns = timestamp;
+        entries[n].machine_id = (uint32_t)machine;
+        entries[n].event = event;
+        n++;
+    }
+
+    munmap((void*)base, size);
+    if (count) *count = n;
+    return entries;
+}
+
+// Open-addressing map from journal machine id to dense index
+typedef struct {
+    uint32_t* keys;
+    uint32_t* values;
+    size_t mask;
+    size_t used;
+} MachineIndex;
+
+static bool machine_index_init(MachineIndex* idx, size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) capacity <<= 1;
+    idx->keys = malloc(capacity * sizeof(uint32_t));
+    idx->values = malloc(capacity * sizeof(uint32_t));
+    if (!idx->keys || !idx->values) return false;
+    memset(idx->values, 0xFF, capacity * sizeof(uint32_t));
+    idx->mask = capacity - 1;
+    idx->used = 0;
+    return true;
+}
+
+static uint32_t machine_index_get(MachineIndex* idx, uint32_t key) {
+    size_t slot = (key * 0x9E3779B1u) & idx->mask;
+    while (idx->values[slot] != UINT32_MAX) {
+        if (idx->keys[slot] == key) return idx->values[slot];
+        slot = (slot + 1) & idx->mask;
+    }
+    idx->keys[slot] = key;
+    idx->values[slot] = (uint32_t)idx->used;
+    return (uint32_t)idx->used++;
+}
+
+typedef struct {
+    StateMachine** machines;
+    uint32_t* machine_of;   // Dense machine index per event
+    uint8_t* events;
+    size_t count;
+} ReplayLane;
+
+static void* replay_lane_run(void* arg) {
+    ReplayLane* lane = arg;
+    for (size_t i = 0; i < lane->count; i++) {
+        StateMachine* sm = lane->machines[lane->machine_of[i]];
+        if (lane->events[i] == PHENO_JOURNAL_RESET) {
+            reset_state_machine(sm);
+        } else {
+            step_state_machine(sm, (PhenoEvent)lane->events[i]);
+        }
+    }
+    return NULL;
+}
+
+// Replay a journal as fast as possible. Events are partitioned by machine,
+// so per-machine order (and therefore the final states) is preserved for
+// any thread count.
+bool pheno_journal_replay(const char* path, int threads, PhenoReplayStats* stats) {
+    size_t count = 0;
+    PhenoJournalEntry* entries = pheno_journal_load(path, &count);
+    if (!entries) return false;
+
+    if (threads < 1) threads = 1;
+
+    MachineIndex index = {0};
+    uint32_t* dense = malloc((count ? count : 1) * sizeof(uint32_t));
+    ReplayLane* lanes = calloc((size_t)threads, sizeof(ReplayLane));
+    size_t* lane_fill = calloc((size_t)threads, sizeof(size_t));
+    bool ok = dense && lanes && lane_fill && machine_index_init(&index, count);
+
+    StateMachine** machines = NULL;
+    size_t machine_count = 0;
+    PhenoPool* pool = NULL;
+
+    if (ok) {
+        for (size_t i = 0; i < count; i++) {
+            dense[i] = machine_index_get(&index, entries[i].machine_id);
+        }
+        machine_count = index.used;
+
+        machines = calloc(machine_count ? machine_count : 1, sizeof(StateMachine*));
+        ok = machines != NULL;
+    }
+
+    // Machines are created up front so only stepping is timed. Their
+    // tokens come from a pool sized for the journal, not the process pool,
+    // so any machine count that fits in memory replays; lanes on several
+    // threads share it, so it is locked then.
+    if (ok) {
+        pool = pheno_pool_create(pheno_pool_size_for(machine_count, PHENO_MACHINE_TOKEN_SIZE),
+                                 threads > 1);
+        if (!pool) {
+            printf("[JOURNAL] Could not create a token pool for %zu machines\n", machine_count);
+            ok = false;
+        }
+    }
+    for (size_t m = 0; ok && m < machine_count; m++) {
+        machines[m] = create_state_machine();
+        if (machines[m]) machines[m]->pool = pool;
+        if (!machines[m] || !initialize_state_machine(machines[m])) {
+            printf("[JOURNAL] Could not initialize machine %zu for replay\n", m);
+            ok = false;
+            break;
+        }
+    }
+
+    // Split the stream into per-thread lanes
+    for (size_t i = 0; ok && i < count; i++) {
+        lanes[dense[i] % (uint32_t)threads].count++;
+    }
+    for (int t = 0; ok && t < threads; t++) {
+        lanes[t].machines = machines;
+        lanes[t].machine_of = malloc((lanes[t].count + 1) * sizeof(uint32_t));
+        lanes[t].events = malloc(lanes[t].count + 1);
+        if (!lanes[t].machine_of || !lanes[t].events) ok = false;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        int t = (int)(dense[i] % (uint32_t)threads);
+        lanes[t].machine_of[lane_fill[t]] = dense[i];
+        lanes[t].events[lane_fill[t]] = entries[i].event;
+        lane_fill[t]++;
+    }
+
+    if (ok) {
+        uint64_t start = pheno_monotonic_ns();
+        if (threads == 1) {
+            replay_lane_run(&lanes[0]);
+        } else {
+            pthread_t* tids = malloc((size_t)threads * sizeof(pthread_t));
+            int started = 0;
+            for (int t = 0; tids && t < threads; t++) {
+                if (pthread_create(&tids[t], NULL, replay_lane_run, &lanes[t]) != 0) break;
+                started++;
+            }
+            // Run any lanes we could not hand to a thread inline
+            for (int t = started; t < threads; t++) replay_lane_run(&lanes[t]);
+            for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+            free(tids);
+        }
+        uint64_t elapsed = pheno_monotonic_ns() - start;
+
+        if (stats) {
+            memset(stats, 0, sizeof(*stats));
+            stats->events = count;
+            stats->machines = machine_count;
+            stats->threads = threads;
+            stats->elapsed_sec = (double)elapsed / 1e9;
+            stats->events_per_sec = elapsed ? (double)count * 1e9 / (double)elapsed : 0.0;
+
+            // FNV-1a over (dense index, final state, retry count) in
+            // first-seen order; token ids are excluded as they are global
+            uint64_t digest = 0xcbf29ce484222325ULL;
+            for (size_t m = 0; m < machine_count; m++) {
+                uint32_t fields[3] = {
+                    (uint32_t)m,
+                    (uint32_t)machines[m]->current_state,
+                    machines[m]->retry_count
+                };
+                const uint8_t* bytes = (const uint8_t*)fields;
+                for (size_t b = 0; b < sizeof(fields); b++) {
+                    digest = (digest ^ bytes[b]) * 0x100000001b3ULL;
+                }
+                if (machines[m]->current_state < PHENO_STATE_COUNT) {
+                    stats->final_states[machines[m]->current_state]++;
+                }
+            }
+            stats->state_digest = digest;
+        }
+    }
+
+    for (size_t m = 0; machines && m < machine_count; m++) {
+        destroy_state_machine(machines[m]);
+    }
+    pheno_pool_destroy(pool);
+    for (int t = 0; lanes && t < threads; t++) {
+        free(lanes[t].machine_of);
+        free(lanes[t].events);
+    }
+    free(index.keys);
+    free(index.values);
+    free(machines);
+    free(lanes);
+    free(lane_fill);
+    free(dense);
+    free(entries);
+    return ok;
+}
+
+void pheno_journal_print_replay(FILE* out, const PhenoReplayStats* stats) {
+    if (!out || !stats) return;
+
+    fprintf(out, "\n=== Journal Replay ===\n");
+    fprintf(out, "Events:    %zu\n", stats->events);
+    fprintf(out, "Machines:  %zu\n", stats->machines);
+    fprintf(out, "Threads:   %d\n", stats->threads);
+    fprintf(out, "Time:      %.3f seconds\n", stats->elapsed_sec);
+    fprintf(out, "Rate:      %.1f events/sec\n", stats->events_per_sec);
+    fprintf(out, "Digest:    %016llx\n", (unsigned long long)stats->state_digest);
+    for (int s = 0; s < PHENO_STATE_COUNT; s++) {
+        if (stats->final_states[s] == 0) continue;
+        fprintf(out, "  %-10s %u\n", get_state_name((PhenoState)s), stats->final_states[s]);
+    }
+    fprintf(out, "======================\n\n");
+}
@@ -0,0 +1,355 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "pheno_log.h"
+
+#define RING_MASK      (PHENO_LOG_RING_RECORDS - 1)
+#define LINE_MAX_BYTES 512
+
+// One message; string arguments hold an offset into text
+typedef struct {
+    uint64_t sequence;                 // Process-wide order of log calls
+    const char* format;
+    uint8_t argc;
+    uint8_t kinds[PHENO_LOG_MAX_ARGS];
+    uint64_t args[PHENO_LOG_MAX_ARGS];
+    char text[PHENO_LOG_TEXT];
+} LogRecord;
+
+// Single producer (the owning thread), single consumer (whoever holds
+// g_log.mutex). head is published with release after the record is
+// filled; tail with release after it has been formatted.
+typedef struct LogRing {
+    _Atomic uint64_t head;
+    char pad_head[56];
+    _Atomic uint64_t tail;
+    char pad_tail[56];
+    _Atomic uint64_t dropped;
+    _Atomic bool orphaned;             // Owner exited; freed once drained
+    struct LogRing* next;
+    LogRecord records[PHENO_LOG_RING_RECORDS];
+} LogRing;
+
+static struct {
+    pthread_mutex_t mutex;             // Ring list and the consumer side
+    LogRing* rings;
+    FILE* out;
+    pthread_t thread;
+    bool running;
+    _Atomic bool stop;
+    // The drain thread blocks on wake while every ring is empty; a writer
+    // that finds sleeping set signals it after publishing
+    pthread_mutex_t wake_mutex;
+    pthread_cond_t wake;
+    _Atomic bool sleeping;
+    uint64_t written;
+    uint64_t dropped;                  // From rings already freed
+    uint64_t ring_count;
+    pthread_key_t key;
+} g_log = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wake_mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+_Atomic int pheno_log_level = PHENO_LOG_DEBUG;
+
+static pthread_once_t g_log_once = PTHREAD_ONCE_INIT;
+static _Atomic uint64_t g_log_sequence;
+static _Thread_local LogRing* t_ring;
+
+void pheno_log_set_level(PhenoLogLevel level) {
+    atomic_store(&pheno_log_level, (int)level);
+}
+
+PhenoLogLevel pheno_log_get_level(void) {
+    return (PhenoLogLevel)atomic_load(&pheno_log_level);
+}
+
+int pheno_log_parse_level(const char* name) {
+    static const char* names[] = { "error", "warn", "info", "debug", "trace" };
+    for (int i = 0; name && i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// Format one record into line; returns the length written
+static size_t format_record(const LogRecord* rec, char* line, size_t size) {
+    size_t len = 0;
+    int arg = 0;
+    const char* f = rec->format;
+    while (*f && len + 1 < size) {
+        if (*f != '%') {
+            line[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            line[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; drop the length modifier
+        char spec[32];
+        size_t n = 0;
+        spec[n++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && n < sizeof(spec) - 4) spec[n++] = *f++;
+        while (*f && strchr("hljztL", *f)) f++;
+        char conv = *f;
+        if (!conv) break;
+        f++;
+        if (arg >= rec->argc) continue;
+
+        int kind = rec->kinds[arg];
+        uint64_t value = rec->args[arg++];
+        int w = 0;
+        size_t room = size - len;
+        switch (conv) {
+            case 'd': case 'i':
+                spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+                w = snprintf(line + len, room, spec, (long long)value);
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+                w = snprintf(line + len, room, spec, (unsigned long long)value);
+                break;
+            case 'c':
+                spec[n++] = 'c'; spec[n] = '\0';
+                w = snprintf(line + len, room, spec, (int)value);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                double d = 0;
+                if (kind == PHENO_ARG_DOUBLE) memcpy(&d, &value, sizeof(d));
+                else d = kind == PHENO_ARG_INT ? (double)(int64_t)value : (double)value;
+                spec[n++] = conv; spec[n] = '\0';
+                w = snprintf(line + len, room, spec, d);
+                break;
+            }
+            case 's':
+                spec[n++] = 's'; spec[n] = '\0';
+                w = snprintf(line + len, room, spec,
+                             kind == PHENO_ARG_STRING ? rec->text + value : "(?)");
+                break;
+            case 'p':
+                spec[n++] = 'p'; spec[n] = '\0';
+                w = snprintf(line + len, room, spec, (void*)(uintptr_t)value);
+                break;
+            default:
+                break;
+        }
+        if (w > 0) len += (size_t)w < room ? (size_t)w : room - 1;
+    }
+    line[len] = '\0';
+    return len;
+}
+
+// Write out every record published so far, in call order across rings.
+// Caller holds g_log.mutex.
+static uint64_t drain_locked(void) {
+    FILE* out = g_log.out ? g_log.out : stderr;
+    char line[LINE_MAX_BYTES];
+    uint64_t count = 0;
+    for (;;) {
+        LogRing* oldest = NULL;
+        const LogRecord* first = NULL;
+        for (LogRing* r = g_log.rings; r; r = r->next) {
+            uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            if (tail == atomic_load_explicit(&r->head, memory_order_acquire)) continue;
+            const LogRecord* rec = &r->records[tail & RING_MASK];
+            if (!first || rec->sequence < first->sequence) {
+                oldest = r;
+                first = rec;
+            }
+        }
+        if (!oldest) break;
+
+        // Whatever the program printed before these calls goes out first,
+        // so a shared terminal or 2>&1 file keeps each message after the
+        // output that preceded it
+        if (count == 0 && out != stdout) fflush(stdout);
+        size_t len = format_record(first, line, sizeof(line));
+        fwrite(line, 1, len, out);
+        atomic_store_explicit(&oldest->tail, atomic_load_explicit(&oldest->tail, memory_order_relaxed) + 1,
+                              memory_order_release);
+        count++;
+    }
+
+    // Release rings of exited threads once they are empty
+    for (LogRing** link = &g_log.rings; *link;) {
+        LogRing* r = *link;
+        if (atomic_load(&r->orphaned) && atomic_load(&r->tail) == atomic_load(&r->head)) {
+            *link = r->next;
+            g_log.dropped += atomic_load(&r->dropped);
+            free(r);
+        } else {
+            link = &r->next;
+        }
+    }
+    if (count) fflush(out);
+    g_log.written += count;
+    return count;
+}
+
+static bool rings_empty(void) {
+    pthread_mutex_lock(&g_log.mutex);
+    bool empty = true;
+    for (LogRing* r = g_log.rings; empty && r; r = r->next) {
+        empty = atomic_load(&r->tail) == atomic_load(&r->head);
+    }
+    pthread_mutex_unlock(&g_log.mutex);
+    return empty;
+}
+
+// Set sleeping, then look at the rings once more: a writer publishes its
+// head before reading sleeping, so either it signals or the record is seen.
+// The first writer to see the flag clears it and signals, so it is set
+// again before every check (a flush may have taken the record meanwhile).
+static void drain_wait(void) {
+    pthread_mutex_lock(&g_log.wake_mutex);
+    while (!atomic_load(&g_log.stop)) {
+        atomic_store(&g_log.sleeping, true);
+        if (!rings_empty()) break;
+        pthread_cond_wait(&g_log.wake, &g_log.wake_mutex);
+    }
+    atomic_store(&g_log.sleeping, false);
+    pthread_mutex_unlock(&g_log.wake_mutex);
+}
+
+static void drain_wake(void) {
+    pthread_mutex_lock(&g_log.wake_mutex);
+    pthread_cond_signal(&g_log.wake);
+    pthread_mutex_unlock(&g_log.wake_mutex);
+}
+
+static void* drain_thread(void* arg) {
+    (void)arg;
+    while (!atomic_load(&g_log.stop)) {
+        pthread_mutex_lock(&g_log.mutex);
+        uint64_t count = drain_locked();
+        pthread_mutex_unlock(&g_log.mutex);
+        // After writing, let writers batch up before the next pass instead
+        // of sleeping (and being woken) once per record
+        if (count) sched_yield();
+        else drain_wait();
+    }
+    return NULL;
+}
+
+static void ring_release(void* ring) {
+    atomic_store(&((LogRing*)ring)->orphaned, true);
+}
+
+static void log_start(void) {
+    pthread_key_create(&g_log.key, ring_release);
+    atomic_store(&g_log.stop, false);
+    if (pthread_create(&g_log.thread, NULL, drain_thread, NULL) == 0) {
+        g_log.running = true;
+        atexit(pheno_log_shutdown);
+    }
+}
+
+static LogRing* ring_register(void) {
+    pthread_once(&g_log_once, log_start);
+    LogRing* ring = calloc(1, sizeof(LogRing));
+    if (!ring) return NULL;
+    pthread_setspecific(g_log.key, ring);
+    pthread_mutex_lock(&g_log.mutex);
+    ring->next = g_log.rings;
+    g_log.rings = ring;
+    g_log.ring_count++;
+    pthread_mutex_unlock(&g_log.mutex);
+    return t_ring = ring;
+}
+
+void pheno_log_write(PhenoLogLevel level, const char* format, int argc, const PhenoLogArg* args) {
+    (void)level;
+    LogRing* ring = t_ring ? t_ring : ring_register();
+    if (!ring) return;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= PHENO_LOG_RING_RECORDS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    LogRecord* rec = &ring->records[head & RING_MASK];
+    rec->sequence = atomic_fetch_add_explicit(&g_log_sequence, 1, memory_order_relaxed);
+    rec->format = format;
+    rec->argc = (uint8_t)(argc < PHENO_LOG_MAX_ARGS ? argc : PHENO_LOG_MAX_ARGS);
+    size_t text = 0;
+    for (int i = 0; i < rec->argc; i++) {
+        rec->kinds[i] = (uint8_t)args[i].kind;
+        switch (args[i].kind) {
+            case PHENO_ARG_STRING: {
+                // Copy what fits; later strings are empty once the area is full
+                const char* s = args[i].v.s ? args[i].v.s : "(null)";
+                size_t n = strnlen(s, PHENO_LOG_TEXT - 1 - text);
+                memcpy(rec->text + text, s, n);
+                rec->text[text + n] = '\0';
+                rec->args[i] = text;
+                text += n + 1;
+                if (text > PHENO_LOG_TEXT - 1) text = PHENO_LOG_TEXT - 1;
+                break;
+            }
+            case PHENO_ARG_DOUBLE:
+                memcpy(&rec->args[i], &args[i].v.d, sizeof(double));
+                break;
+            case PHENO_ARG_POINTER:
+                rec->args[i] = (uint64_t)(uintptr_t)args[i].v.p;
+                break;
+            default:
+                rec->args[i] = args[i].v.u;
+                break;
+        }
+    }
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    // Orders the head store before the sleeping load (see drain_wait); only
+    // the writer that clears the flag pays for the wakeup
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&g_log.sleeping, memory_order_relaxed) &&
+        atomic_exchange(&g_log.sleeping, false)) {
+        drain_wake();
+    }
+}
+
+void pheno_log_flush(void) {
+    pthread_mutex_lock(&g_log.mutex);
+    drain_locked();
+    fflush(g_log.out ? g_log.out : stderr);
+    pthread_mutex_unlock(&g_log.mutex);
+}
+
+void pheno_log_set_output(FILE* out) {
+    pthread_mutex_lock(&g_log.mutex);
+    drain_locked();
+    fflush(g_log.out ? g_log.out : stderr);
+    g_log.out = out;
+    pthread_mutex_unlock(&g_log.mutex);
+}
+
+void pheno_log_shutdown(void) {
+    pthread_mutex_lock(&g_log.mutex);
+    bool running = g_log.running;
+    g_log.running = false;
+    pthread_mutex_unlock(&g_log.mutex);
+    if (running) {
+        atomic_store(&g_log.stop, true);
+        drain_wake();
+        pthread_join(g_log.thread, NULL);
+    }
+    pheno_log_flush();
+}
+
+void pheno_log_get_stats(PhenoLogStats* stats) {
+    pthread_mutex_lock(&g_log.mutex);
+    stats->written = g_log.written;
+    stats->dropped = g_log.dropped;
+    for (LogRing* r = g_log.rings; r; r = r->next) stats->dropped += atomic_load(&r->dropped);
+    stats->rings = g_log.ring_count;
+    pthread_mutex_unlock(&g_log.mutex);
+}
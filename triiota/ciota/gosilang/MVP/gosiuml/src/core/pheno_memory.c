@@ -1,20 +1,115 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include "phenomemory_platform.h"
 
-// Global memory pool for phenomenological tokens
+#define LARGE_CLASS PHENO_POOL_LARGE_CLASS
+
+// Statistics of the threads mapped to one shard. Token counts live only
+// in the per-class counters; totals are summed on read.
 typedef struct {
+    _Alignas(64) _Atomic uint64_t class_allocs[POOL_SIZE_CLASSES + 1];
+    _Atomic uint64_t class_frees[POOL_SIZE_CLASSES + 1];
+    _Atomic uint64_t bytes_allocated;     // Requested sizes
+    _Atomic uint64_t bytes_freed;
+    _Atomic uint64_t large_bytes_allocated;
+    _Atomic uint64_t large_bytes_freed;
+    _Atomic uint64_t failures;
+    _Atomic uint64_t lock_acquisitions;
+    _Atomic uint64_t lock_contended;
+    _Atomic uint64_t lock_wait_ns;
+} PoolShard;
+
+// Token pool: one mapping carved into size-class blocks. The process pool
+// behind pheno_token_alloc() is shared and locked; private pools owned by
+// a context skip the mutex.
+struct PhenoPool {
     void* base_addr;
     size_t total_size;
-    size_t used_size;
+    _Atomic size_t used_size;             // Written under the lock, read by snapshots
     atomic_uint32_t active_tokens;
     pthread_mutex_t pool_mutex;
-} MemoryPool;
+    bool shared;                          // Lock around every operation
+    bool mapped;                          // base_addr came from mmap
+    void* free_lists[POOL_SIZE_CLASSES];  // Singly linked through block heads
+    _Atomic uint64_t carved[POOL_SIZE_CLASSES + 1];
+    PoolShard shards[PHENO_POOL_STAT_SHARDS];
+};
+
+static PhenoPool g_pool = {0};
+
+// Shard of the calling thread, assigned round-robin on first use
+static _Thread_local int t_shard = -1;
+static atomic_uint g_next_shard = ATOMIC_VAR_INIT(0);
+
+static inline PoolShard* pool_shard(PhenoPool* pool) {
+    if (t_shard < 0) t_shard = (int)(atomic_fetch_add(&g_next_shard, 1) % PHENO_POOL_STAT_SHARDS);
+    return &pool->shards[t_shard];
+}
+
+static inline void stat_add(_Atomic uint64_t* counter, uint64_t value) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+// Toggle hot-path diagnostic output; warnings and errors still pass
+void gosiuml_set_debug(bool enable) {
+    pheno_log_set_level(enable ? PHENO_LOG_DEBUG : PHENO_LOG_WARN);
+}
+
+// Size class for a request, or -1 for blocks that are never recycled
+static int pool_size_class(size_t size) {
+    size_t block = (size_t)1 << POOL_MIN_CLASS_SHIFT;
+    for (int cls = 0; cls < POOL_SIZE_CLASSES; cls++, block <<= 1) {
+        if (size <= block) return cls;
+    }
+    return -1;
+}
+
+// Block size actually reserved for a request (8-byte aligned)
+static size_t pool_block_size(size_t size) {
+    int cls = pool_size_class(size);
+    if (cls >= 0) return (size_t)1 << (cls + POOL_MIN_CLASS_SHIFT);
+    return (size + 7) & ~(size_t)7;
+}
+
+static bool pool_setup(PhenoPool* pool, size_t size, bool shared) {
+    pool->total_size = size;
+    pool->base_addr = mmap(NULL, pool->total_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1, 0);
+    pool->mapped = pool->base_addr != MAP_FAILED;
+    
+    if (!pool->mapped) {
+        perror("mmap failed");
+        pool->base_addr = malloc(pool->total_size);
+    }
+    
+    atomic_store(&pool->used_size, 0);
+    pool->shared = shared;
+    atomic_store(&pool->active_tokens, 0);
+    pthread_mutex_init(&pool->pool_mutex, NULL);
+    return pool->base_addr != NULL;
+}
+
+// Uncontended acquisitions cost one trylock; only waits are timed
+static inline void pool_lock(PhenoPool* pool, PoolShard* shard) {
+    if (!pool->shared) return;
+    if (pthread_mutex_trylock(&pool->pool_mutex) != 0) {
+        uint64_t start = pheno_monotonic_ns();
+        pthread_mutex_lock(&pool->pool_mutex);
+        stat_add(&shard->lock_wait_ns, pheno_monotonic_ns() - start);
+        stat_add(&shard->lock_contended, 1);
+    }
+    stat_add(&shard->lock_acquisitions, 1);
+}
 
-static MemoryPool g_pool = {0};
+static inline void pool_unlock(PhenoPool* pool) {
+    if (pool->shared) pthread_mutex_unlock(&pool->pool_mutex);
+}
 
 // Initialize memory pool
 static void init_memory_pool(void) {
@@ -22,49 +117,98 @@ static void init_memory_pool(void) {
     
     if (atomic_exchange(&initialized, true)) return;
     
-    g_pool.total_size = 16 * 1024 * 1024; // 16MB pool
-    g_pool.base_addr = mmap(NULL, g_pool.total_size,
-                            PROT_READ | PROT_WRITE,
-                            MAP_PRIVATE | MAP_ANONYMOUS,
-                            -1, 0);
-    
-    if (g_pool.base_addr == MAP_FAILED) {
-        perror("mmap failed");
-        g_pool.base_addr = malloc(g_pool.total_size);
-    }
-    
-    g_pool.used_size = 0;
-    atomic_store(&g_pool.active_tokens, 0);
-    pthread_mutex_init(&g_pool.pool_mutex, NULL);
+    pool_setup(&g_pool, 16 * 1024 * 1024, true); // 16MB pool
 }
 
-// Allocate a phenomenological token
-PhenoToken* pheno_token_alloc(uint32_t size) {
+PhenoPool* pheno_pool_default(void) {
     init_memory_pool();
-    
-    pthread_mutex_lock(&g_pool.pool_mutex);
-    
-    // Check if we have space
-    if (g_pool.used_size + sizeof(PhenoToken) + size > g_pool.total_size) {
-        pthread_mutex_unlock(&g_pool.pool_mutex);
+    return &g_pool;
+}
+
+PhenoPool* pheno_pool_create(size_t size, bool shared) {
+    PhenoPool* pool = aligned_alloc(_Alignof(PhenoPool), sizeof(PhenoPool));
+    if (!pool) return NULL;
+    memset(pool, 0, sizeof(*pool));
+    if (!pool_setup(pool, size ? size : PHENO_POOL_DEFAULT_SIZE, shared)) {
+        pthread_mutex_destroy(&pool->pool_mutex);
+        free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void pheno_pool_destroy(PhenoPool* pool) {
+    if (!pool || pool == &g_pool) return;
+    if (pool->mapped) {
+        munmap(pool->base_addr, pool->total_size);
+    } else {
+        free(pool->base_addr);
+    }
+    pthread_mutex_destroy(&pool->pool_mutex);
+    free(pool);
+}
+
+size_t pheno_pool_size_for(size_t count, uint32_t size) {
+    return count * pool_block_size(size);
+}
+
+void pheno_pool_usage(PhenoPool* pool, PhenoPoolUsage* usage) {
+    memset(usage, 0, sizeof(*usage));
+    if (!pool) return;
+    usage->total_size = pool->total_size;
+    usage->used_size = atomic_load_explicit(&pool->used_size, memory_order_relaxed);
+    usage->active_tokens = atomic_load(&pool->active_tokens);
+}
+
+// Allocate a phenomenological token from pool
+PhenoToken* pheno_pool_token_alloc(PhenoPool* pool, uint32_t size) {
+    if (!pool || !pool->base_addr) return NULL;
+    
+    PoolShard* shard = pool_shard(pool);
+    pool_lock(pool, shard);
+    
+    int cls = pool_size_class(size);
+    size_t block_size = pool_block_size(size);
+    size_t used = atomic_load_explicit(&pool->used_size, memory_order_relaxed);
+    void* block = NULL;
+    
+    // Reuse a freed block of the same class before growing the pool
+    if (cls >= 0 && pool->free_lists[cls]) {
+        block = pool->free_lists[cls];
+        pool->free_lists[cls] = *(void**)block;
+        *(void**)block = NULL;  // Freed blocks are zeroed apart from the link
+    } else if (used + block_size > pool->total_size) {
+        pool_unlock(pool);
+        stat_add(&shard->failures, 1);
         return NULL;
     }
     
     // Allocate token structure
     PhenoToken* token = (PhenoToken*)calloc(1, sizeof(PhenoToken));
     if (!token) {
-        pthread_mutex_unlock(&g_pool.pool_mutex);
+        if (block) {
+            *(void**)block = pool->free_lists[cls];
+            pool->free_lists[cls] = block;
+        }
+        pool_unlock(pool);
+        stat_add(&shard->failures, 1);
         return NULL;
     }
     
-    // Allocate data buffer from pool
-    token->data_ptr = (uint8_t*)g_pool.base_addr + g_pool.used_size;
+    // Carve a new block from the pool
+    int stat_cls = cls >= 0 ? cls : LARGE_CLASS;
+    if (!block) {
+        block = (uint8_t*)pool->base_addr + used;
+        atomic_store_explicit(&pool->used_size, used + block_size, memory_order_relaxed);
+        stat_add(&pool->carved[stat_cls], 1);
+    }
+    token->data_ptr = block;
     token->data_size = size;
-    g_pool.used_size += size;
     
     // Initialize token
     strncpy(token->sentinel, "PHENO_NIL", 16);
-    token->memory_zone = g_pool.used_size / (g_pool.total_size / MAX_MEMORY_ZONES);
+    token->memory_zone = (size_t)((uint8_t*)block - (uint8_t*)pool->base_addr) /
+                         (pool->total_size / MAX_MEMORY_ZONES);
     
     // Initialize atomic flags
     atomic_store(&token->mem_flags.flags, 0);
@@ -74,39 +218,65 @@ PhenoToken* pheno_token_alloc(uint32_t size) {
     // Set allocated flag
     set_flag(&token->mem_flags, FLAG_ALLOCATED_BIT);
     
-    atomic_fetch_add(&g_pool.active_tokens, 1);
+    atomic_fetch_add(&pool->active_tokens, 1);
     
-    pthread_mutex_unlock(&g_pool.pool_mutex);
+    pool_unlock(pool);
     
-    printf("[ALLOC] Token allocated: size=%u, zone=%u, addr=%p\n",
-           size, token->memory_zone, token->data_ptr);
+    stat_add(&shard->class_allocs[stat_cls], 1);
+    stat_add(&shard->bytes_allocated, size);
+    if (cls < 0) stat_add(&shard->large_bytes_allocated, block_size);
+    
+    PHENO_TRACE3(token_alloc, token, size, token->memory_zone);
+    PHENO_DEBUG("[ALLOC] Token allocated: size=%u, zone=%u, addr=%p\n",
+                size, token->memory_zone, token->data_ptr);
     
     return token;
 }
 
-// Free a phenomenological token
-void pheno_token_free(PhenoToken* token) {
-    if (!token) return;
+// Free a phenomenological token back to the pool it came from
+void pheno_pool_token_free(PhenoPool* pool, PhenoToken* token) {
+    if (!pool || !token) return;
     
-    pthread_mutex_lock(&g_pool.pool_mutex);
+    PoolShard* shard = pool_shard(pool);
+    pool_lock(pool, shard);
     
     // Clear sensitive data
     if (token->data_ptr && token->data_size > 0) {
         memset(token->data_ptr, 0, token->data_size);
     }
     
+    // Return recyclable blocks to their size class
+    int cls = pool_size_class(token->data_size);
+    if (token->data_ptr && cls >= 0) {
+        *(void**)token->data_ptr = pool->free_lists[cls];
+        pool->free_lists[cls] = token->data_ptr;
+    }
+    stat_add(&shard->class_frees[cls >= 0 ? cls : LARGE_CLASS], 1);
+    stat_add(&shard->bytes_freed, token->data_size);
+    if (cls < 0) stat_add(&shard->large_bytes_freed, pool_block_size(token->data_size));
+    
     // Clear flags
     atomic_store(&token->mem_flags.flags, 0);
     atomic_store(&token->mem_flags.ref_count, 0);
     
-    uint32_t active = atomic_fetch_sub(&g_pool.active_tokens, 1) - 1;
+    uint32_t active = atomic_fetch_sub(&pool->active_tokens, 1) - 1;
     
-    printf("[FREE] Token freed: id=0x%08X, remaining=%u\n",
-           token->token_id, active);
+    PHENO_TRACE2(token_free, token, token->token_id);
+    PHENO_DEBUG("[FREE] Token freed: id=0x%08X, remaining=%u\n",
+                token->token_id, active);
     
     free(token);
     
-    pthread_mutex_unlock(&g_pool.pool_mutex);
+    pool_unlock(pool);
+}
+
+PhenoToken* pheno_token_alloc(uint32_t size) {
+    init_memory_pool();
+    return pheno_pool_token_alloc(&g_pool, size);
+}
+
+void pheno_token_free(PhenoToken* token) {
+    pheno_pool_token_free(&g_pool, token);
 }
 
 // Lock a token for exclusive access
@@ -119,8 +289,9 @@ bool pheno_token_lock(PhenoToken* token) {
     }
     
     token->thread_owner = pthread_self();
-    printf("[LOCK] Token locked by thread %lu\n",
-           (unsigned long)token->thread_owner);
+    PHENO_TRACE2(token_lock, token, (unsigned long)token->thread_owner);
+    PHENO_DEBUG("[LOCK] Token locked by thread %lu\n",
+                (unsigned long)token->thread_owner);
     
     return true;
 }
@@ -131,16 +302,17 @@ void pheno_token_unlock(PhenoToken* token) {
     
     // Check if current thread owns the lock
     if (token->thread_owner != pthread_self()) {
-        printf("[UNLOCK] Warning: thread %lu trying to unlock token owned by %lu\n",
-               (unsigned long)pthread_self(),
-               (unsigned long)token->thread_owner);
+        PHENO_DEBUG("[UNLOCK] Warning: thread %lu trying to unlock token owned by %lu\n",
+                    (unsigned long)pthread_self(),
+                    (unsigned long)token->thread_owner);
         return;
     }
     
     clear_flag(&token->mem_flags, FLAG_LOCKED_BIT);
     token->thread_owner = 0;
     
-    printf("[UNLOCK] Token unlocked\n");
+    PHENO_TRACE1(token_unlock, token);
+    PHENO_DEBUG("[UNLOCK] Token unlocked\n");
 }
 
 // Validate token integrity
@@ -149,54 +321,156 @@ bool pheno_token_validate(PhenoToken* token) {
     
     // Check sentinel
     if (strncmp(token->sentinel, "PHENO_", 6) != 0) {
-        printf("[VALIDATE] Invalid sentinel: %s\n", token->sentinel);
+        PHENO_DEBUG("[VALIDATE] Invalid sentinel: %s\n", token->sentinel);
         return false;
     }
     
     // Check memory zone
     if (token->memory_zone >= MAX_MEMORY_ZONES) {
-        printf("[VALIDATE] Invalid memory zone: %u\n", token->memory_zone);
+        PHENO_DEBUG("[VALIDATE] Invalid memory zone: %u\n", token->memory_zone);
         return false;
     }
     
     // Check flags consistency
     uint32_t flags = atomic_load(&token->mem_flags.flags);
     if ((flags & (1 << FLAG_NIL_BIT)) && (flags & (1 << FLAG_ALLOCATED_BIT))) {
-        printf("[VALIDATE] Inconsistent flags: NIL and ALLOCATED both set\n");
+        PHENO_DEBUG("[VALIDATE] Inconsistent flags: NIL and ALLOCATED both set\n");
         return false;
     }
     
     // Check data pointer alignment
     if (token->data_ptr && ((uintptr_t)token->data_ptr & 0x7) != 0) {
-        printf("[VALIDATE] Misaligned data pointer: %p\n", token->data_ptr);
+        PHENO_DEBUG("[VALIDATE] Misaligned data pointer: %p\n", token->data_ptr);
         return false;
     }
     
-    printf("[VALIDATE] Token valid: id=0x%08X\n", token->token_id);
+    PHENO_DEBUG("[VALIDATE] Token valid: id=0x%08X\n", token->token_id);
     return true;
 }
 
-// Get memory pool statistics
+void pheno_pool_stats_snapshot(PhenoPool* pool, PhenoMemoryStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!pool) return;
+    
+    uint64_t allocs[POOL_SIZE_CLASSES + 1] = {0}, frees[POOL_SIZE_CLASSES + 1] = {0};
+    uint64_t bytes_in = 0, bytes_out = 0, large_in = 0, large_out = 0;
+    for (int i = 0; i < PHENO_POOL_STAT_SHARDS; i++) {
+        PoolShard* shard = &pool->shards[i];
+        for (int c = 0; c <= LARGE_CLASS; c++) {
+            allocs[c] += atomic_load_explicit(&shard->class_allocs[c], memory_order_relaxed);
+            frees[c] += atomic_load_explicit(&shard->class_frees[c], memory_order_relaxed);
+        }
+        bytes_in += atomic_load_explicit(&shard->bytes_allocated, memory_order_relaxed);
+        bytes_out += atomic_load_explicit(&shard->bytes_freed, memory_order_relaxed);
+        large_in += atomic_load_explicit(&shard->large_bytes_allocated, memory_order_relaxed);
+        large_out += atomic_load_explicit(&shard->large_bytes_freed, memory_order_relaxed);
+        stats->failures += atomic_load_explicit(&shard->failures, memory_order_relaxed);
+        stats->lock_acquisitions += atomic_load_explicit(&shard->lock_acquisitions, memory_order_relaxed);
+        stats->lock_contended += atomic_load_explicit(&shard->lock_contended, memory_order_relaxed);
+        stats->lock_wait_ns += atomic_load_explicit(&shard->lock_wait_ns, memory_order_relaxed);
+    }
+    
+    // Shards are read one by one, so a free may be seen before its alloc
+    uint64_t block_bytes_live = large_in > large_out ? large_in - large_out : 0;
+    for (int c = 0; c <= LARGE_CLASS; c++) {
+        PhenoSizeClassStats* cls = &stats->classes[c];
+        cls->block_size = c < LARGE_CLASS ? (uint64_t)1 << (c + POOL_MIN_CLASS_SHIFT) : 0;
+        cls->carved = atomic_load_explicit(&pool->carved[c], memory_order_relaxed);
+        cls->live = allocs[c] > frees[c] ? allocs[c] - frees[c] : 0;
+        stats->allocations += allocs[c];
+        stats->frees += frees[c];
+        if (c < LARGE_CLASS) {
+            block_bytes_live += cls->live * cls->block_size;
+            if (cls->carved > cls->live) stats->free_list_bytes += (cls->carved - cls->live) * cls->block_size;
+        }
+    }
+    stats->tokens_live = stats->allocations > stats->frees ? stats->allocations - stats->frees : 0;
+    stats->bytes_live = bytes_in > bytes_out ? bytes_in - bytes_out : 0;
+    stats->internal_waste = block_bytes_live > stats->bytes_live ? block_bytes_live - stats->bytes_live : 0;
+    stats->pool_size = pool->total_size;
+    stats->high_water = atomic_load_explicit(&pool->used_size, memory_order_relaxed);
+    if (stats->high_water > stats->bytes_live) {
+        stats->fragmentation = 1.0 - (double)stats->bytes_live / (double)stats->high_water;
+    }
+}
+
+void pheno_memory_stats_snapshot(PhenoMemoryStats* stats) {
+    pheno_pool_stats_snapshot(pheno_pool_default(), stats);
+}
+
+typedef struct {
+    char* buffer;
+    size_t size;
+    size_t length;
+} JsonOut;
+
+static void json_printf(JsonOut* out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void json_printf(JsonOut* out, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool room = out->length < out->size;
+    int n = vsnprintf(room ? out->buffer + out->length : NULL, room ? out->size - out->length : 0,
+                      format, args);
+    va_end(args);
+    if (n > 0) out->length += (size_t)n;
+}
+
+size_t pheno_memory_stats_json(const PhenoMemoryStats* stats, char* buffer, size_t size) {
+    JsonOut out = { buffer, size, 0 };
+    if (buffer && size) buffer[0] = '\0';
+    json_printf(&out, "{\"allocations\":%llu,\"frees\":%llu,\"failures\":%llu,"
+                "\"tokens_live\":%llu,\"bytes_live\":%llu,\"pool_size\":%llu,"
+                "\"high_water\":%llu,\"free_list_bytes\":%llu,\"internal_waste\":%llu,"
+                "\"fragmentation\":%.4f,\"lock_acquisitions\":%llu,\"lock_contended\":%llu,"
+                "\"lock_wait_ns\":%llu,\"classes\":[",
+                (unsigned long long)stats->allocations, (unsigned long long)stats->frees,
+                (unsigned long long)stats->failures, (unsigned long long)stats->tokens_live,
+                (unsigned long long)stats->bytes_live, (unsigned long long)stats->pool_size,
+                (unsigned long long)stats->high_water, (unsigned long long)stats->free_list_bytes,
+                (unsigned long long)stats->internal_waste, stats->fragmentation,
+                (unsigned long long)stats->lock_acquisitions, (unsigned long long)stats->lock_contended,
+                (unsigned long long)stats->lock_wait_ns);
+    for (int c = 0; c <= LARGE_CLASS; c++) {
+        const PhenoSizeClassStats* cls = &stats->classes[c];
+        json_printf(&out, "%s{\"block_size\":%llu,\"carved\":%llu,\"live\":%llu}", c ? "," : "",
+                    (unsigned long long)cls->block_size, (unsigned long long)cls->carved,
+                    (unsigned long long)cls->live);
+    }
+    json_printf(&out, "]}");
+    return out.length;
+}
+
+// Print process pool statistics; reads counters only, never the pool lock
 void pheno_memory_stats(void) {
-    init_memory_pool();
+    pheno_log_flush();
     
-    pthread_mutex_lock(&g_pool.pool_mutex);
+    PhenoMemoryStats stats;
+    pheno_memory_stats_snapshot(&stats);
     
     printf("\n=== Phenomenological Memory Statistics ===\n");
-    printf("Total Pool Size:  %zu bytes\n", g_pool.total_size);
-    printf("Used Pool Size:   %zu bytes (%.1f%%)\n",
-           g_pool.used_size,
-           (double)g_pool.used_size / g_pool.total_size * 100.0);
-    printf("Active Tokens:    %u\n", atomic_load(&g_pool.active_tokens));
+    printf("Total Pool Size:  %llu bytes\n", (unsigned long long)stats.pool_size);
+    printf("Used Pool Size:   %llu bytes (%.1f%%)\n",
+           (unsigned long long)stats.high_water,
+           (double)stats.high_water / stats.pool_size * 100.0);
+    printf("Active Tokens:    %llu (%llu bytes)\n",
+           (unsigned long long)stats.tokens_live, (unsigned long long)stats.bytes_live);
+    printf("Allocs / Frees:   %llu / %llu (%llu failed)\n",
+           (unsigned long long)stats.allocations, (unsigned long long)stats.frees,
+           (unsigned long long)stats.failures);
+    printf("Fragmentation:    %.1f%% (%llu free-list bytes)\n",
+           stats.fragmentation * 100.0, (unsigned long long)stats.free_list_bytes);
+    printf("Lock Waits:       %llu of %llu (%llu ns)\n",
+           (unsigned long long)stats.lock_contended, (unsigned long long)stats.lock_acquisitions,
+           (unsigned long long)stats.lock_wait_ns);
     printf("Memory Zones:     %d\n", MAX_MEMORY_ZONES);
     printf("Base Address:     %p\n", g_pool.base_addr);
     printf("==========================================\n\n");
-    
-    pthread_mutex_unlock(&g_pool.pool_mutex);
 }
 
 // Cleanup memory pool (called at exit)
 void pheno_memory_cleanup(void) {
+    pheno_log_flush();
     pthread_mutex_lock(&g_pool.pool_mutex);
     
     if (g_pool.base_addr) {
@@ -206,6 +480,7 @@ void pheno_memory_cleanup(void) {
         }
         g_pool.base_addr = NULL;
     }
+    memset(g_pool.free_lists, 0, sizeof(g_pool.free_lists));
     
     pthread_mutex_unlock(&g_pool.pool_mutex);
     pthread_mutex_destroy(&g_pool.pool_mutex);
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pheno_pipeline.h"
+
+typedef struct {
+    const char* name;
+    PhenoStageFunc func;
+    void* ctx;
+} PhenoStage;
+
+struct PhenoPipeline {
+    PhenoStage stages[PHENO_SUBSTATE_COUNT][PHENO_PIPELINE_MAX_STAGES];
+    size_t stage_count[PHENO_SUBSTATE_COUNT];
+    _Atomic uint64_t batches;
+    _Atomic uint64_t tokens[PHENO_SUBSTATE_COUNT];
+    _Atomic uint64_t bytes[PHENO_SUBSTATE_COUNT];
+    _Atomic uint64_t skipped;
+};
+
+// Built-in default pipeline (no stages) and the current override
+static PhenoPipeline g_builtin_pipeline;
+static _Atomic(PhenoPipeline*) g_default_pipeline = NULL;
+
+PhenoPipeline* pheno_pipeline_create(void) {
+    return calloc(1, sizeof(PhenoPipeline));
+}
+
+void pheno_pipeline_destroy(PhenoPipeline* pipeline) {
+    if (!pipeline || pipeline == &g_builtin_pipeline) return;
+
+    // Fall back to the built-in pipeline if this one was the default
+    PhenoPipeline* expected = pipeline;
+    atomic_compare_exchange_strong(&g_default_pipeline, &expected, NULL);
+    free(pipeline);
+}
+
+bool pheno_pipeline_add_stage(PhenoPipeline* pipeline, PhenoSubstate substate,
+                              const char* name, PhenoStageFunc func, void* ctx) {
+    if (!pipeline || !func) return false;
+    if (substate == SUBSTATE_NONE || substate >= PHENO_SUBSTATE_COUNT) return false;
+
+    size_t n = pipeline->stage_count[substate];
+    if (n >= PHENO_PIPELINE_MAX_STAGES) return false;
+
+    pipeline->stages[substate][n] = (PhenoStage){ name, func, ctx };
+    pipeline->stage_count[substate] = n + 1;
+    return true;
+}
+
+size_t pheno_pipeline_stage_count(const PhenoPipeline* pipeline, PhenoSubstate substate) {
+    if (!pipeline || substate >= PHENO_SUBSTATE_COUNT) return 0;
+    return pipeline->stage_count[substate];
+}
+
+// Run the substate's chain stage-major over the batch
+static void run_chain(PhenoPipeline* pipeline, PhenoSubstate substate,
+                      PhenoSpan* spans, size_t count) {
+    if (count == 0) return;
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += spans[i].size;
+    }
+
+    const PhenoStage* stages = pipeline->stages[substate];
+    for (size_t s = 0; s < pipeline->stage_count[substate]; s++) {
+        stages[s].func(spans, count, stages[s].ctx);
+    }
+
+    atomic_fetch_add_explicit(&pipeline->tokens[substate], count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pipeline->bytes[substate], bytes, memory_order_relaxed);
+}
+
+static bool span_for(StateMachine* sm, PhenoSpan* span) {
+    if (sm->current_state != STATE_ACTIVE) return false;
+    if (sm->current_substate == SUBSTATE_NONE ||
+        sm->current_substate >= PHENO_SUBSTATE_COUNT) return false;
+    if (!sm->token || !sm->token->data_ptr) return false;
+
+    span->token = sm->token;
+    span->data = sm->token->data_ptr;
+    span->size = sm->token->data_size;
+    return true;
+}
+
+bool pheno_pipeline_process(PhenoPipeline* pipeline, StateMachine* sm) {
+    if (!pipeline || !sm) return false;
+
+    PhenoSpan span;
+    if (!span_for(sm, &span)) return false;
+
+    run_chain(pipeline, sm->current_substate, &span, 1);
+    atomic_fetch_add_explicit(&pipeline->batches, 1, memory_order_relaxed);
+    return true;
+}
+
+size_t pheno_pipeline_run(PhenoPipeline* pipeline, StateMachine** machines, size_t count) {
+    if (!pipeline || !machines) return 0;
+
+    StateMachine* held[PHENO_PIPELINE_BATCH];
+    PhenoSpan spans[PHENO_SUBSTATE_COUNT][PHENO_PIPELINE_BATCH];
+    size_t span_count[PHENO_SUBSTATE_COUNT] = {0};
+    size_t held_count = 0;
+    size_t processed = 0;
+    uint64_t skipped = 0;
+
+    for (size_t i = 0; i <= count; i++) {
+        if (i < count) {
+            StateMachine* sm = machines[i];
+            if (!sm || pthread_mutex_trylock(&sm->mutex) != 0) {
+                skipped++;
+                continue;
+            }
+
+            PhenoSpan span;
+            if (!span_for(sm, &span)) {
+                pthread_mutex_unlock(&sm->mutex);
+                skipped++;
+                continue;
+            }
+
+            PhenoSubstate sub = sm->current_substate;
+            spans[sub][span_count[sub]++] = span;
+            held[held_count++] = sm;
+            if (held_count < PHENO_PIPELINE_BATCH) continue;
+        }
+
+        if (held_count == 0) continue;
+
+        // Flush: each substate chain runs over its slice of the batch
+        for (int sub = SUBSTATE_READING; sub < PHENO_SUBSTATE_COUNT; sub++) {
+            run_chain(pipeline, (PhenoSubstate)sub, spans[sub], span_count[sub]);
+            span_count[sub] = 0;
+        }
+        for (size_t h = 0; h < held_count; h++) {
+            pthread_mutex_unlock(&held[h]->mutex);
+        }
+        processed += held_count;
+        held_count = 0;
+        atomic_fetch_add_explicit(&pipeline->batches, 1, memory_order_relaxed);
+    }
+
+    if (skipped) {
+        atomic_fetch_add_explicit(&pipeline->skipped, skipped, memory_order_relaxed);
+    }
+    return processed;
+}
+
+void pheno_pipeline_get_stats(PhenoPipeline* pipeline, PhenoPipelineStats* stats) {
+    if (!pipeline || !stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->batches = atomic_load_explicit(&pipeline->batches, memory_order_relaxed);
+    stats->skipped = atomic_load_explicit(&pipeline->skipped, memory_order_relaxed);
+    for (int s = 0; s < PHENO_SUBSTATE_COUNT; s++) {
+        stats->tokens[s] = atomic_load_explicit(&pipeline->tokens[s], memory_order_relaxed);
+        stats->bytes[s] = atomic_load_explicit(&pipeline->bytes[s], memory_order_relaxed);
+    }
+}
+
+PhenoPipeline* pheno_pipeline_default(void) {
+    PhenoPipeline* pipeline = atomic_load_explicit(&g_default_pipeline, memory_order_acquire);
+    return pipeline ? pipeline : &g_builtin_pipeline;
+}
+
+void pheno_pipeline_set_default(PhenoPipeline* pipeline) {
+    atomic_store_explicit(&g_default_pipeline, pipeline, memory_order_release);
+}
+
+// Built-in stages
+
+// Word-at-a-time FNV-style mix over four independent lanes
+uint64_t pheno_pipeline_checksum(const void* data, size_t size) {
+    const uint64_t prime = 0x100000001B3ULL;
+    const uint8_t* p = data;
+    uint64_t lane[4] = {
+        0xCBF29CE484222325ULL, 0x84222325CBF29CE4ULL,
+        0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL
+    };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t w;
+            memcpy(&w, p + i + l * 8, sizeof(w));
+            lane[l] = (lane[l] ^ w) * prime;
+        }
+    }
+
+    uint64_t h = lane[0] ^ (lane[1] << 1) ^ (lane[2] << 2) ^ (lane[3] << 3);
+    for (; i < size; i++) {
+        h = (h ^ p[i]) * prime;
+    }
+    return h ^ (uint64_t)size;
+}
+
+void pheno_stage_checksum(PhenoSpan* spans, size_t count, void* ctx) {
+    _Atomic uint64_t* acc = ctx;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += pheno_pipeline_checksum(spans[i].data, spans[i].size);
+    }
+    if (acc) atomic_fetch_add_explicit(acc, sum, memory_order_relaxed);
+}
+
+void pheno_stage_fill(PhenoSpan* spans, size_t count, void* ctx) {
+    uint8_t value = ctx ? *(const uint8_t*)ctx : 0;
+    for (size_t i = 0; i < count; i++) {
+        memset(spans[i].data, value, spans[i].size);
+    }
+}
+
+void pheno_stage_xor(PhenoSpan* spans, size_t count, void* ctx) {
+    uint8_t key = ctx ? *(const uint8_t*)ctx : 0;
+    uint64_t wide = 0x0101010101010101ULL * key;
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* p = spans[i].data;
+        size_t size = spans[i].size;
+        size_t j = 0;
+        for (; j + 8 <= size; j += 8) {
+            uint64_t w;
+            memcpy(&w, p + j, sizeof(w));
+            w ^= wide;
+            memcpy(p + j, &w, sizeof(w));
+        }
+        for (; j < size; j++) {
+            p[j] ^= key;
+        }
+    }
+}
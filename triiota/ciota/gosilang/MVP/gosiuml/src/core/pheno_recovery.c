@@ -0,0 +1,479 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pheno_recovery.h"
+
+#define WHEEL_MASK (PHENO_WHEEL_SLOTS - 1)
+#define WHEEL_SPAN ((uint64_t)1 << (PHENO_WHEEL_LEVELS * PHENO_WHEEL_SLOT_BITS))
+
+// One entry per attached machine
+typedef struct PhenoRecoveryEntry {
+    struct PhenoRecoveryEntry* next;      // Wheel slot or due list
+    struct PhenoRecoveryEntry** pprev;
+    struct PhenoRecoveryEntry* all_next;  // Attached list
+    struct PhenoRecoveryEntry** all_pprev;
+    PhenoRecoveryScheduler* sched;
+    StateMachine* sm;
+    uint64_t expires;                     // Absolute tick
+    uint32_t attempts;                    // Consecutive failed recoveries
+    bool linked;
+    bool in_due;
+    bool running;
+    bool rearm;                           // Degraded again while running
+    bool detached;
+} PhenoRecoveryEntry;
+
+typedef enum {
+    OUTCOME_IDLE,
+    OUTCOME_RETRY,
+    OUTCOME_RECOVERED,
+    OUTCOME_RETIRED
+} RecoveryOutcome;
+
+struct PhenoRecoveryScheduler {
+    PhenoRecoveryConfig config;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    pthread_t thread;
+    bool thread_running;
+    bool stop;
+    bool closing;
+    uint64_t origin_ns;
+    uint64_t current_tick;
+    size_t on_wheel;                      // Linked entries not yet due
+    PhenoRecoveryEntry* slots[PHENO_WHEEL_LEVELS][PHENO_WHEEL_SLOTS];
+    PhenoRecoveryEntry* due;
+    PhenoRecoveryEntry** due_tail;
+    PhenoRecoveryEntry* attached;
+    PhenoRecoveryEntry** batch;
+    RecoveryOutcome* outcomes;
+    PhenoRecoveryStats stats;
+};
+
+void pheno_recovery_config_defaults(PhenoRecoveryConfig* config) {
+    if (!config) return;
+
+    config->tick_ms = 1;
+    config->base_delay_ms = 10;
+    config->max_delay_ms = 5000;
+    config->max_attempts = 16;
+    config->batch_size = 256;
+}
+
+static uint64_t now_tick(const PhenoRecoveryScheduler* sched) {
+    return (pheno_monotonic_ns() - sched->origin_ns) / (sched->config.tick_ms * 1000000ULL);
+}
+
+static uint64_t delay_ticks(const PhenoRecoveryScheduler* sched, uint32_t attempts) {
+    uint64_t delay = sched->config.base_delay_ms;
+    for (uint32_t i = 0; i < attempts && delay < sched->config.max_delay_ms; i++) {
+        delay <<= 1;
+    }
+    if (delay > sched->config.max_delay_ms) delay = sched->config.max_delay_ms;
+
+    uint64_t ticks = (delay + sched->config.tick_ms - 1) / sched->config.tick_ms;
+    return ticks ? ticks : 1;
+}
+
+// List helpers (caller holds the scheduler mutex)
+static void entry_unlink(PhenoRecoveryScheduler* sched, PhenoRecoveryEntry* e) {
+    if (!e->linked) return;
+
+    if (e->next) {
+        e->next->pprev = e->pprev;
+    } else if (e->in_due) {
+        sched->due_tail = e->pprev;
+    }
+    *e->pprev = e->next;
+    if (!e->in_due) sched->on_wheel--;
+    e->next = NULL;
+    e->pprev = NULL;
+    e->linked = false;
+    e->in_due = false;
+    sched->stats.pending--;
+}
+
+static void push_front(PhenoRecoveryEntry** head, PhenoRecoveryEntry* e) {
+    e->next = *head;
+    if (e->next) e->next->pprev = &e->next;
+    e->pprev = head;
+    *head = e;
+}
+
+static void push_due(PhenoRecoveryScheduler* sched, PhenoRecoveryEntry* e) {
+    e->in_due = true;
+    e->next = NULL;
+    e->pprev = sched->due_tail;
+    *sched->due_tail = e;
+    sched->due_tail = &e->next;
+}
+
+// Place an entry by distance to its expiry
+static void wheel_insert(PhenoRecoveryScheduler* sched, PhenoRecoveryEntry* e) {
+    uint64_t now = sched->current_tick;
+    if (!e->linked) sched->stats.pending++;
+    e->linked = true;
+
+    if (e->expires <= now) {
+        push_due(sched, e);
+        return;
+    }
+
+    uint64_t delta = e->expires - now;
+    if (delta >= WHEEL_SPAN) {
+        e->expires = now + WHEEL_SPAN - 1;
+        delta = WHEEL_SPAN - 1;
+    }
+
+    int level = 0;
+    while (level < PHENO_WHEEL_LEVELS - 1 &&
+           delta >= ((uint64_t)1 << ((level + 1) * PHENO_WHEEL_SLOT_BITS))) {
+        level++;
+    }
+    size_t slot = (e->expires >> (level * PHENO_WHEEL_SLOT_BITS)) & WHEEL_MASK;
+    push_front(&sched->slots[level][slot], e);
+    sched->on_wheel++;
+}
+
+static void schedule_entry(PhenoRecoveryScheduler* sched, PhenoRecoveryEntry* e) {
+    e->expires = sched->current_tick + delay_ticks(sched, e->attempts);
+    wheel_insert(sched, e);
+    sched->stats.scheduled++;
+}
+
+// Re-insert every entry of a higher-level slot one level down
+static void cascade(PhenoRecoveryScheduler* sched, int level, size_t slot) {
+    PhenoRecoveryEntry* e = sched->slots[level][slot];
+    sched->slots[level][slot] = NULL;
+
+    while (e) {
+        PhenoRecoveryEntry* next = e->next;
+        e->linked = false;
+        sched->on_wheel--;
+        sched->stats.pending--;
+        wheel_insert(sched, e);
+        e = next;
+    }
+}
+
+// Move the wheel forward to `target`, collecting expired entries
+static void wheel_advance(PhenoRecoveryScheduler* sched, uint64_t target) {
+    while (sched->current_tick < target) {
+        // Nothing left on the wheel: jump straight to the target
+        if (sched->on_wheel == 0) {
+            sched->current_tick = target;
+            return;
+        }
+
+        uint64_t tick = ++sched->current_tick;
+
+        // Cascade higher levels when their lower level wraps
+        for (int level = 1; level < PHENO_WHEEL_LEVELS; level++) {
+            uint64_t lower = tick & (((uint64_t)1 << (level * PHENO_WHEEL_SLOT_BITS)) - 1);
+            if (lower != 0) break;
+            cascade(sched, level, (tick >> (level * PHENO_WHEEL_SLOT_BITS)) & WHEEL_MASK);
+        }
+
+        PhenoRecoveryEntry* e = sched->slots[0][tick & WHEEL_MASK];
+        sched->slots[0][tick & WHEEL_MASK] = NULL;
+        while (e) {
+            PhenoRecoveryEntry* next = e->next;
+            sched->on_wheel--;
+            push_due(sched, e);
+            e = next;
+        }
+    }
+}
+
+PhenoRecoveryScheduler* pheno_recovery_create(const PhenoRecoveryConfig* config) {
+    PhenoRecoveryScheduler* sched = calloc(1, sizeof(PhenoRecoveryScheduler));
+    if (!sched) return NULL;
+
+    if (config) {
+        sched->config = *config;
+    } else {
+        pheno_recovery_config_defaults(&sched->config);
+    }
+    if (sched->config.tick_ms == 0) sched->config.tick_ms = 1;
+    if (sched->config.batch_size == 0) sched->config.batch_size = 1;
+    if (sched->config.max_attempts == 0) sched->config.max_attempts = 1;
+
+    sched->batch = malloc(sched->config.batch_size * sizeof(PhenoRecoveryEntry*));
+    sched->outcomes = malloc(sched->config.batch_size * sizeof(RecoveryOutcome));
+    if (!sched->batch || !sched->outcomes) {
+        free(sched->batch);
+        free(sched->outcomes);
+        free(sched);
+        return NULL;
+    }
+
+    pthread_mutex_init(&sched->mutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sched->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&sched->idle, NULL);
+    sched->origin_ns = pheno_monotonic_ns();
+    sched->due_tail = &sched->due;
+    return sched;
+}
+
+bool pheno_recovery_attach(PhenoRecoveryScheduler* sched, StateMachine* sm) {
+    if (!sched || !sm || sm->recovery) return false;
+
+    PhenoRecoveryEntry* e = calloc(1, sizeof(PhenoRecoveryEntry));
+    if (!e) return false;
+    e->sched = sched;
+    e->sm = sm;
+
+    pthread_mutex_lock(&sched->mutex);
+    e->all_next = sched->attached;
+    if (e->all_next) e->all_next->all_pprev = &e->all_next;
+    e->all_pprev = &sched->attached;
+    sched->attached = e;
+    sched->stats.attached++;
+    pthread_mutex_unlock(&sched->mutex);
+
+    pthread_mutex_lock(&sm->mutex);
+    sm->recovery = e;
+    bool degraded = sm->current_state == STATE_DEGRADED;
+    pthread_mutex_unlock(&sm->mutex);
+
+    // Already degraded machines are picked up straight away
+    if (degraded) pheno_recovery_notify_degraded(sm);
+    return true;
+}
+
+void pheno_recovery_detach(StateMachine* sm) {
+    if (!sm || !sm->recovery) return;
+
+    PhenoRecoveryEntry* e = sm->recovery;
+    PhenoRecoveryScheduler* sched = e->sched;
+
+    pthread_mutex_lock(&sched->mutex);
+    entry_unlink(sched, e);
+    e->detached = true;
+    while (e->running) pthread_cond_wait(&sched->idle, &sched->mutex);
+
+    *e->all_pprev = e->all_next;
+    if (e->all_next) e->all_next->all_pprev = e->all_pprev;
+    sched->stats.attached--;
+    pthread_mutex_unlock(&sched->mutex);
+
+    sm->recovery = NULL;
+    free(e);
+}
+
+// Called from the ACTIVE -> DEGRADED transition (machine mutex held)
+void pheno_recovery_notify_degraded(StateMachine* sm) {
+    if (!sm || !sm->recovery) return;
+
+    PhenoRecoveryEntry* e = sm->recovery;
+    PhenoRecoveryScheduler* sched = e->sched;
+
+    pthread_mutex_lock(&sched->mutex);
+    if (!sched->closing && !e->detached) {
+        if (e->running) {
+            e->rearm = true;
+        } else if (!e->linked) {
+            e->attempts = 0;
+            schedule_entry(sched, e);
+            pthread_cond_signal(&sched->wake);
+        }
+    }
+    pthread_mutex_unlock(&sched->mutex);
+}
+
+// Step one machine (no scheduler lock held)
+static RecoveryOutcome recover_machine(PhenoRecoveryScheduler* sched, PhenoRecoveryEntry* e) {
+    StateMachine* sm = e->sm;
+
+    step_state_machine(sm, EVENT_RECOVER);
+
+    pthread_mutex_lock(&sm->mutex);
+    PhenoState state = sm->current_state;
+    pthread_mutex_unlock(&sm->mutex);
+
+    if (state == STATE_DEGRADED && e->attempts + 1 >= sched->config.max_attempts) {
+        // Out of attempts: push towards FREED (succeeds once retries are spent)
+        step_state_machine(sm, EVENT_FREE);
+
+        pthread_mutex_lock(&sm->mutex);
+        state = sm->current_state;
+        pthread_mutex_unlock(&sm->mutex);
+    }
+
+    switch (state) {
+        case STATE_DEGRADED: return OUTCOME_RETRY;
+        case STATE_ACTIVE:   return OUTCOME_RECOVERED;
+        case STATE_FREED:    return OUTCOME_RETIRED;
+        default:             return OUTCOME_IDLE;
+    }
+}
+
+// Process at most one batch of due entries; returns machines stepped
+static size_t process_batch(PhenoRecoveryScheduler* sched) {
+    size_t n = 0;
+    while (sched->due && n < sched->config.batch_size) {
+        PhenoRecoveryEntry* e = sched->due;
+        entry_unlink(sched, e);
+        e->running = true;
+        sched->batch[n++] = e;
+    }
+    if (n == 0) return 0;
+
+    sched->stats.batches++;
+    sched->stats.attempts += n;
+    pthread_mutex_unlock(&sched->mutex);
+
+    for (size_t i = 0; i < n; i++) {
+        sched->outcomes[i] = recover_machine(sched, sched->batch[i]);
+    }
+
+    pthread_mutex_lock(&sched->mutex);
+    bool wake_detachers = false;
+    for (size_t i = 0; i < n; i++) {
+        PhenoRecoveryEntry* e = sched->batch[i];
+        e->running = false;
+
+        if (e->detached || sched->closing) {
+            wake_detachers = true;
+            continue;
+        }
+
+        switch (sched->outcomes[i]) {
+            case OUTCOME_RETRY:
+                e->attempts++;
+                schedule_entry(sched, e);
+                break;
+            case OUTCOME_RECOVERED:
+                sched->stats.recovered++;
+                e->attempts = 0;
+                break;
+            case OUTCOME_RETIRED:
+                sched->stats.retired++;
+                break;
+            case OUTCOME_IDLE:
+                break;
+        }
+
+        if (e->rearm) {
+            e->rearm = false;
+            if (!e->linked && sched->outcomes[i] != OUTCOME_RETIRED) {
+                e->attempts = 0;
+                schedule_entry(sched, e);
+            }
+        }
+    }
+    if (wake_detachers) pthread_cond_broadcast(&sched->idle);
+    return n;
+}
+
+size_t pheno_recovery_poll(PhenoRecoveryScheduler* sched) {
+    if (!sched) return 0;
+
+    pthread_mutex_lock(&sched->mutex);
+    wheel_advance(sched, now_tick(sched));
+    size_t total = 0, n;
+    while ((n = process_batch(sched)) > 0) total += n;
+    pthread_mutex_unlock(&sched->mutex);
+    return total;
+}
+
+static void* recovery_thread(void* arg) {
+    PhenoRecoveryScheduler* sched = arg;
+
+    pthread_mutex_lock(&sched->mutex);
+    while (!sched->stop) {
+        wheel_advance(sched, now_tick(sched));
+        if (process_batch(sched) > 0) continue;
+
+        if (sched->stats.pending > 0) {
+            // Sleep until the next tick boundary
+            uint64_t wake_ns = sched->origin_ns +
+                (sched->current_tick + 1) * sched->config.tick_ms * 1000000ULL;
+            struct timespec deadline = {
+                .tv_sec = (time_t)(wake_ns / 1000000000ULL),
+                .tv_nsec = (long)(wake_ns % 1000000000ULL)
+            };
+            pthread_cond_timedwait(&sched->wake, &sched->mutex, &deadline);
+        } else {
+            pthread_cond_wait(&sched->wake, &sched->mutex);
+        }
+    }
+    pthread_mutex_unlock(&sched->mutex);
+    return NULL;
+}
+
+bool pheno_recovery_start(PhenoRecoveryScheduler* sched) {
+    if (!sched) return false;
+
+    pthread_mutex_lock(&sched->mutex);
+    if (sched->thread_running) {
+        pthread_mutex_unlock(&sched->mutex);
+        return true;
+    }
+    sched->stop = false;
+    int rc = pthread_create(&sched->thread, NULL, recovery_thread, sched);
+    sched->thread_running = rc == 0;
+    pthread_mutex_unlock(&sched->mutex);
+
+    if (rc != 0) {
+        errno = rc;
+        perror("Failed to start recovery scheduler");
+    }
+    return rc == 0;
+}
+
+void pheno_recovery_stop(PhenoRecoveryScheduler* sched) {
+    if (!sched) return;
+
+    pthread_mutex_lock(&sched->mutex);
+    bool running = sched->thread_running;
+    sched->stop = true;
+    sched->thread_running = false;
+    pthread_cond_broadcast(&sched->wake);
+    pthread_mutex_unlock(&sched->mutex);
+
+    if (running) pthread_join(sched->thread, NULL);
+}
+
+// Machines must not be destroyed concurrently with the scheduler
+void pheno_recovery_destroy(PhenoRecoveryScheduler* sched) {
+    if (!sched) return;
+
+    pheno_recovery_stop(sched);
+
+    pthread_mutex_lock(&sched->mutex);
+    sched->closing = true;
+    PhenoRecoveryEntry* e = sched->attached;
+    sched->attached = NULL;
+    pthread_mutex_unlock(&sched->mutex);
+
+    while (e) {
+        PhenoRecoveryEntry* next = e->all_next;
+        pthread_mutex_lock(&e->sm->mutex);
+        e->sm->recovery = NULL;
+        pthread_mutex_unlock(&e->sm->mutex);
+        free(e);
+        e = next;
+    }
+
+    pthread_cond_destroy(&sched->wake);
+    pthread_cond_destroy(&sched->idle);
+    pthread_mutex_destroy(&sched->mutex);
+    free(sched->batch);
+    free(sched->outcomes);
+    free(sched);
+}
+
+void pheno_recovery_get_stats(PhenoRecoveryScheduler* sched, PhenoRecoveryStats* stats) {
+    if (!sched || !stats) return;
+
+    pthread_mutex_lock(&sched->mutex);
+    *stats = sched->stats;
+    pthread_mutex_unlock(&sched->mutex);
+}
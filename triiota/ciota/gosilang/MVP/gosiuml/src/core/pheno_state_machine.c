@@ -3,6 +3,15 @@
 #include <string.h>
 #include <stdbool.h>
 #include "phenomemory_platform.h"
+#include "pheno_recovery.h"
+#include "pheno_pipeline.h"
+
+#ifndef PHENO_NO_TRANSITION_STATS
+// Transition instrumentation - off until enabled at runtime
+static atomic_bool g_transition_stats_enabled = ATOMIC_VAR_INIT(false);
+static PhenoHistogram g_transition_latency[PHENO_STATE_COUNT][PHENO_EVENT_COUNT];
+static PhenoHistogram g_time_in_state[PHENO_STATE_COUNT];
+#endif
 
 // State name lookup
 const char* get_state_name(PhenoState state) {
@@ -29,6 +38,37 @@ const char* get_event_name(PhenoEvent event) {
 }
 
 // Create state machine
+// Tokens come from the machine's pool, the process pool by default
+static PhenoToken* machine_token_alloc(StateMachine* sm, uint32_t size) {
+    return sm->pool ? pheno_pool_token_alloc(sm->pool, size) : pheno_token_alloc(size);
+}
+
+static void machine_token_free(StateMachine* sm, PhenoToken* token) {
+    if (sm->pool) {
+        pheno_pool_token_free(sm->pool, token);
+    } else {
+        pheno_token_free(token);
+    }
+}
+
+// Token ownership is the LOCKED flag plus thread_owner. It is taken on
+// ALLOCATED -> LOCKED, carried through ACTIVE while the owner processes
+// the token, and dropped on UNLOCK or when the token is cleaned up. The
+// spinlock only makes the flag and owner change together; it is never
+// held across steps.
+static void take_token_ownership(StateMachine* sm) {
+    pthread_spin_lock(&sm->spinlock);
+    sm->token->thread_owner = pthread_self();
+    pthread_spin_unlock(&sm->spinlock);
+}
+
+static void release_token_ownership(StateMachine* sm) {
+    pthread_spin_lock(&sm->spinlock);
+    clear_flag(&sm->token->mem_flags, FLAG_LOCKED_BIT);
+    sm->token->thread_owner = 0;
+    pthread_spin_unlock(&sm->spinlock);
+}
+
 StateMachine* create_state_machine(void) {
     StateMachine* sm = (StateMachine*)calloc(1, sizeof(StateMachine));
     if (!sm) return NULL;
@@ -38,6 +78,9 @@ StateMachine* create_state_machine(void) {
     sm->retry_count = 0;
     sm->confidence_score = 1.0f;
     sm->is_initialized = false;
+#ifndef PHENO_NO_TRANSITION_STATS
+    sm->state_entered_ns = pheno_transition_stats_enabled() ? pheno_monotonic_ns() : 0;
+#endif
     
     pthread_mutex_init(&sm->mutex, NULL);
     pthread_spin_init(&sm->spinlock, PTHREAD_PROCESS_PRIVATE);
@@ -49,7 +92,7 @@ StateMachine* create_state_machine(void) {
 bool initialize_state_machine(StateMachine* sm) {
     if (!sm) return false;
     
-    sm->token = pheno_token_alloc(4096);  // Default size
+    sm->token = machine_token_alloc(sm, PHENO_MACHINE_TOKEN_SIZE);
     if (!sm->token) return false;
     
     sm->is_initialized = true;
@@ -60,8 +103,12 @@ bool initialize_state_machine(StateMachine* sm) {
 void destroy_state_machine(StateMachine* sm) {
     if (!sm) return;
     
+    if (sm->recovery) {
+        pheno_recovery_detach(sm);
+    }
+    
     if (sm->token) {
-        pheno_token_free(sm->token);
+        machine_token_free(sm, sm->token);
     }
     
     pthread_mutex_destroy(&sm->mutex);
@@ -69,19 +116,54 @@ void destroy_state_machine(StateMachine* sm) {
     free(sm);
 }
 
+// Return a machine to NIL with a fresh token so it can be reused.
+// Caller holds sm->mutex.
+bool reset_state_machine_locked(StateMachine* sm) {
+    if (sm->token) {
+        machine_token_free(sm, sm->token);
+        sm->token = NULL;
+    }
+    
+    sm->current_state = STATE_NIL;
+    sm->current_substate = SUBSTATE_NONE;
+    sm->retry_count = 0;
+    sm->confidence_score = 1.0f;
+    sm->token = machine_token_alloc(sm, PHENO_MACHINE_TOKEN_SIZE);
+    sm->is_initialized = sm->token != NULL;
+#ifndef PHENO_NO_TRANSITION_STATS
+    sm->state_entered_ns = pheno_transition_stats_enabled() ? pheno_monotonic_ns() : 0;
+#endif
+    return sm->is_initialized;
+}
+
+bool reset_state_machine(StateMachine* sm) {
+    if (!sm) return false;
+    
+    pthread_mutex_lock(&sm->mutex);
+    bool ok = reset_state_machine_locked(sm);
+    pthread_mutex_unlock(&sm->mutex);
+    return ok;
+}
+
 // Transition: NIL -> ALLOCATED
 static bool transition_nil_to_allocated(StateMachine* sm) {
     if (!memory_available()) return false;
     
-    sm->token = pheno_token_alloc(4096);
+    // Release the placeholder token from initialize/reset
+    if (sm->token) {
+        machine_token_free(sm, sm->token);
+        sm->token = NULL;
+    }
+    
+    sm->token = machine_token_alloc(sm, PHENO_MACHINE_TOKEN_SIZE);
     if (!sm->token) return false;
     
     assign_token_id(sm->token);
     set_flag(&sm->token->mem_flags, FLAG_ALLOCATED_BIT);
     sm->current_state = STATE_ALLOCATED;
     
-    printf("[TRANSITION] NIL -> ALLOCATED (token_id: 0x%08X)\n", 
-           sm->token->token_id);
+    PHENO_DEBUG("[TRANSITION] NIL -> ALLOCATED (token_id: 0x%08X)\n", 
+                sm->token->token_id);
     return true;
 }
 
@@ -94,12 +176,11 @@ static bool transition_allocated_to_locked(StateMachine* sm) {
         return false;  // Already locked
     }
     
-    pthread_spin_lock(&sm->spinlock);
-    sm->token->thread_owner = pthread_self();
+    take_token_ownership(sm);
     sm->current_state = STATE_LOCKED;
     
-    printf("[TRANSITION] ALLOCATED -> LOCKED (thread: %lu)\n",
-           (unsigned long)sm->token->thread_owner);
+    PHENO_DEBUG("[TRANSITION] ALLOCATED -> LOCKED (thread: %lu)\n",
+                (unsigned long)sm->token->thread_owner);
     return true;
 }
 
@@ -112,7 +193,7 @@ static bool transition_locked_to_active(StateMachine* sm) {
     sm->current_state = STATE_ACTIVE;
     sm->current_substate = SUBSTATE_READING;
     
-    printf("[TRANSITION] LOCKED -> ACTIVE\n");
+    PHENO_DEBUG("[TRANSITION] LOCKED -> ACTIVE\n");
     return true;
 }
 
@@ -125,9 +206,10 @@ static bool transition_active_to_degraded(StateMachine* sm) {
     clear_flag(&sm->token->mem_flags, FLAG_COHERENT_BIT);
     sm->current_state = STATE_DEGRADED;
     initiate_recovery(sm);
+    pheno_recovery_notify_degraded(sm);
     
-    printf("[TRANSITION] ACTIVE -> DEGRADED (score: %.2f)\n", 
-           degradation_score);
+    PHENO_DEBUG("[TRANSITION] ACTIVE -> DEGRADED (score: %.2f)\n", 
+                degradation_score);
     return true;
 }
 
@@ -139,7 +221,7 @@ static bool transition_degraded_to_active(StateMachine* sm) {
     set_flag(&sm->token->mem_flags, FLAG_COHERENT_BIT);
     sm->current_state = STATE_ACTIVE;
     
-    printf("[TRANSITION] DEGRADED -> ACTIVE (recovered)\n");
+    PHENO_DEBUG("[TRANSITION] DEGRADED -> ACTIVE (recovered)\n");
     return true;
 }
 
@@ -151,7 +233,7 @@ static bool transition_degraded_to_freed(StateMachine* sm) {
     clear_flag(&sm->token->mem_flags, FLAG_ALLOCATED_BIT);
     sm->current_state = STATE_FREED;
     
-    printf("[TRANSITION] DEGRADED -> FREED (max retries)\n");
+    PHENO_DEBUG("[TRANSITION] DEGRADED -> FREED (max retries)\n");
     return true;
 }
 
@@ -161,8 +243,8 @@ static bool transition_active_to_shared(StateMachine* sm) {
     set_flag(&sm->token->mem_flags, FLAG_SHARED_BIT);
     sm->current_state = STATE_SHARED;
     
-    printf("[TRANSITION] ACTIVE -> SHARED (ref_count: %u)\n",
-           get_ref_count(&sm->token->mem_flags));
+    PHENO_DEBUG("[TRANSITION] ACTIVE -> SHARED (ref_count: %u)\n",
+                get_ref_count(&sm->token->mem_flags));
     return true;
 }
 
@@ -171,25 +253,29 @@ static bool transition_to_freed(StateMachine* sm) {
     cleanup_resources(sm);
     
     if (sm->token) {
-        pheno_token_free(sm->token);
+        machine_token_free(sm, sm->token);
         sm->token = NULL;
     }
     
     sm->current_state = STATE_FREED;
-    printf("[TRANSITION] %s -> FREED\n", 
-           get_state_name(sm->current_state));
+    PHENO_DEBUG("[TRANSITION] %s -> FREED\n", 
+                get_state_name(sm->current_state));
     return true;
 }
 
-// Main state machine step function
-void step_state_machine(StateMachine* sm, PhenoEvent event) {
-    if (!sm || !sm->is_initialized) return;
-    
-    pthread_mutex_lock(&sm->mutex);
+// Main state machine step function. Caller holds sm->mutex.
+void step_state_machine_locked(StateMachine* sm, PhenoEvent event) {
+    if (!sm->is_initialized) return;
     
     bool transition_success = false;
     PhenoState old_state = sm->current_state;
     
+#ifndef PHENO_NO_TRANSITION_STATS
+    bool track = atomic_load_explicit(&g_transition_stats_enabled,
+                                      memory_order_relaxed);
+    uint64_t step_start = track ? pheno_monotonic_ns() : 0;
+#endif
+    
     switch (sm->current_state) {
         case STATE_NIL:
             if (event == EVENT_ALLOC) {
@@ -209,8 +295,7 @@ void step_state_machine(StateMachine* sm, PhenoEvent event) {
             if (event == EVENT_VALIDATE) {
                 transition_success = transition_locked_to_active(sm);
             } else if (event == EVENT_UNLOCK) {
-                clear_flag(&sm->token->mem_flags, FLAG_LOCKED_BIT);
-                pthread_spin_unlock(&sm->spinlock);
+                release_token_ownership(sm);
                 sm->current_state = STATE_ALLOCATED;
                 transition_success = true;
             }
@@ -250,15 +335,138 @@ void step_state_machine(StateMachine* sm, PhenoEvent event) {
     }
     
     if (transition_success) {
-        printf("[STATE_MACHINE] %s + %s -> %s\n",
-               get_state_name(old_state),
-               get_event_name(event),
-               get_state_name(sm->current_state));
+        PHENO_TRACE4(transition, sm, (int)old_state, (int)sm->current_state, (int)event);
+        PHENO_DEBUG("[STATE_MACHINE] %s + %s -> %s\n",
+                    get_state_name(old_state),
+                    get_event_name(event),
+                    get_state_name(sm->current_state));
     }
     
+#ifndef PHENO_NO_TRANSITION_STATS
+    if (track && transition_success) {
+        uint64_t now = pheno_monotonic_ns();
+        pheno_hist_record(&g_transition_latency[old_state][event], now - step_start);
+        if (sm->state_entered_ns != 0 && sm->current_state != old_state) {
+            pheno_hist_record(&g_time_in_state[old_state], now - sm->state_entered_ns);
+        }
+        sm->state_entered_ns = now;
+    } else if (transition_success) {
+        // Stale entry stamps would inflate time-in-state once re-enabled
+        sm->state_entered_ns = 0;
+    }
+#endif
+}
+
+void step_state_machine(StateMachine* sm, PhenoEvent event) {
+    if (!sm || !sm->is_initialized) return;
+    
+    pthread_mutex_lock(&sm->mutex);
+    step_state_machine_locked(sm, event);
     pthread_mutex_unlock(&sm->mutex);
 }
 
+// Enable or disable transition instrumentation at runtime
+void pheno_transition_stats_enable(bool enable) {
+#ifndef PHENO_NO_TRANSITION_STATS
+    atomic_store(&g_transition_stats_enabled, enable);
+#else
+    (void)enable;
+#endif
+}
+
+bool pheno_transition_stats_enabled(void) {
+#ifndef PHENO_NO_TRANSITION_STATS
+    return atomic_load_explicit(&g_transition_stats_enabled, memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+// Copy the transition histograms, optionally draining them
+void pheno_transition_stats_snapshot(PhenoTransitionStats* out, bool reset) {
+    if (!out) return;
+    
+#ifndef PHENO_NO_TRANSITION_STATS
+    for (int s = 0; s < PHENO_STATE_COUNT; s++) {
+        for (int e = 0; e < PHENO_EVENT_COUNT; e++) {
+            pheno_hist_snapshot(&g_transition_latency[s][e],
+                                &out->transition_latency[s][e], reset);
+        }
+        pheno_hist_snapshot(&g_time_in_state[s], &out->time_in_state[s], reset);
+    }
+    pheno_phase_stats_snapshot(out->phases, reset);
+#else
+    (void)reset;
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+void pheno_transition_stats_reset(void) {
+#ifndef PHENO_NO_TRANSITION_STATS
+    for (int s = 0; s < PHENO_STATE_COUNT; s++) {
+        for (int e = 0; e < PHENO_EVENT_COUNT; e++) {
+            pheno_hist_reset(&g_transition_latency[s][e]);
+        }
+        pheno_hist_reset(&g_time_in_state[s]);
+    }
+    PhenoPhaseStats discard[PHENO_PHASE_COUNT];
+    pheno_phase_stats_snapshot(discard, true);
+#endif
+}
+
+// Print non-empty histograms as percentile rows (nanoseconds)
+void pheno_transition_stats_print(FILE* out, const PhenoTransitionStats* stats) {
+    if (!out || !stats) return;
+    
+    fprintf(out, "\n=== Transition Latency (ns) ===\n");
+    fprintf(out, "%-10s %-9s %10s %8s %8s %8s %8s\n",
+            "FROM", "EVENT", "count", "p50", "p99", "p999", "max");
+    for (int s = 0; s < PHENO_STATE_COUNT; s++) {
+        for (int e = 0; e < PHENO_EVENT_COUNT; e++) {
+            const PhenoHistogramSnapshot* h = &stats->transition_latency[s][e];
+            if (h->total_count == 0) continue;
+            fprintf(out, "%-10s %-9s %10llu %8llu %8llu %8llu %8llu\n",
+                    get_state_name((PhenoState)s), get_event_name((PhenoEvent)e),
+                    (unsigned long long)h->total_count,
+                    (unsigned long long)pheno_hist_percentile(h, 50.0),
+                    (unsigned long long)pheno_hist_percentile(h, 99.0),
+                    (unsigned long long)pheno_hist_percentile(h, 99.9),
+                    (unsigned long long)pheno_hist_percentile(h, 100.0));
+        }
+    }
+    
+    fprintf(out, "\n=== Time In State (ns) ===\n");
+    fprintf(out, "%-10s %10s %12s %12s %12s\n",
+            "STATE", "count", "p50", "p99", "max");
+    for (int s = 0; s < PHENO_STATE_COUNT; s++) {
+        const PhenoHistogramSnapshot* h = &stats->time_in_state[s];
+        if (h->total_count == 0) continue;
+        fprintf(out, "%-10s %10llu %12llu %12llu %12llu\n",
+                get_state_name((PhenoState)s),
+                (unsigned long long)h->total_count,
+                (unsigned long long)pheno_hist_percentile(h, 50.0),
+                (unsigned long long)pheno_hist_percentile(h, 99.0),
+                (unsigned long long)pheno_hist_percentile(h, 100.0));
+    }
+    
+    fprintf(out, "\n=== Phases ===\n");
+    fprintf(out, "%-10s %10s %12s %14s %14s\n",
+            "PHASE", "count", "mean ns", "cycles/run", "misses/run");
+    for (int p = 0; p < PHENO_PHASE_COUNT; p++) {
+        const PhenoPhaseStats* ph = &stats->phases[p];
+        if (ph->count == 0) continue;
+        fprintf(out, "%-10s %10llu %12llu", pheno_phase_name((PhenoPhase)p),
+                (unsigned long long)ph->count, (unsigned long long)(ph->ns / ph->count));
+        if (ph->counted) {
+            fprintf(out, " %14llu %14llu\n", (unsigned long long)(ph->cycles / ph->counted),
+                    (unsigned long long)(ph->cache_misses / ph->counted));
+        } else {
+            fprintf(out, " %14s %14s\n", "-", "-");
+        }
+    }
+    fprintf(out, "===============================\n\n");
+}
+
 // Placeholder implementations for utility functions
 bool memory_available(void) {
     // Check available memory
@@ -282,21 +490,21 @@ bool verify_integrity(StateMachine* sm) {
 }
 
 void initiate_recovery(StateMachine* sm) {
-    printf("[RECOVERY] Initiating recovery process...\n");
+    PHENO_DEBUG("[RECOVERY] Initiating recovery process...\n");
     sm->confidence_score *= 0.9f;
 }
 
 void attempt_hitl_recovery(StateMachine* sm) {
-    printf("[HITL] Human-in-the-loop recovery attempt %u/63\n", 
-           sm->retry_count);
+    PHENO_DEBUG("[HITL] Human-in-the-loop recovery attempt %u/63\n", 
+                sm->retry_count);
 }
 
 void cleanup_resources(StateMachine* sm) {
-    printf("[CLEANUP] Releasing resources...\n");
+    PHENO_DEBUG("[CLEANUP] Releasing resources...\n");
     if (sm->token) {
         clear_flag(&sm->token->mem_flags, FLAG_ALLOCATED_BIT);
-        clear_flag(&sm->token->mem_flags, FLAG_LOCKED_BIT);
         clear_flag(&sm->token->mem_flags, FLAG_PROCESSING_BIT);
+        release_token_ownership(sm);
     }
 }
 
@@ -311,15 +519,17 @@ void process_token_operations(StateMachine* sm) {
     
     switch (sm->current_substate) {
         case SUBSTATE_READING:
-            printf("[PROCESS] Reading token data...\n");
+            PHENO_DEBUG("[PROCESS] Reading token data...\n");
             break;
         case SUBSTATE_WRITING:
-            printf("[PROCESS] Writing token data...\n");
+            PHENO_DEBUG("[PROCESS] Writing token data...\n");
             break;
         case SUBSTATE_TRANSFORMING:
-            printf("[PROCESS] Transforming token data...\n");
+            PHENO_DEBUG("[PROCESS] Transforming token data...\n");
             break;
         default:
             break;
     }
+    
+    pheno_pipeline_process(pheno_pipeline_default(), sm);
 }
@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pheno_symbols.h"
+#include "pheno_arena.h"
+
+typedef struct {
+    const char* name;
+    uint32_t len;
+    uint32_t hash;
+} SymbolEntry;
+
+struct PhenoSymbolTable {
+    PhenoArena* names;
+    SymbolEntry* entries;       // Index = symbol id, entry 0 unused
+    size_t count;               // Symbols interned
+    size_t capacity;
+    PhenoSymbol* slots;         // Open addressing, PHENO_SYMBOL_NONE = empty
+    size_t slot_mask;
+};
+
+// Word-at-a-time multiplicative hash; names are short and hot
+static uint32_t symbol_hash(const char* p, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ len;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    if (i < len) {
+        uint64_t w = 0;
+        memcpy(&w, p + i, len - i);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return (uint32_t)(h >> 32);
+}
+
+PhenoSymbolTable* pheno_symbols_create(void) {
+    PhenoSymbolTable* table = calloc(1, sizeof(PhenoSymbolTable));
+    if (!table) return NULL;
+
+    table->names = pheno_arena_create(16u << 10);
+    table->capacity = 64;
+    table->entries = calloc(table->capacity, sizeof(SymbolEntry));
+    table->slot_mask = 127;
+    table->slots = calloc(table->slot_mask + 1, sizeof(PhenoSymbol));
+    if (!table->names || !table->entries || !table->slots) {
+        pheno_symbols_destroy(table);
+        return NULL;
+    }
+
+    table->entries[0].name = "";
+    return table;
+}
+
+void pheno_symbols_destroy(PhenoSymbolTable* table) {
+    if (!table) return;
+    pheno_arena_destroy(table->names);
+    free(table->entries);
+    free(table->slots);
+    free(table);
+}
+
+static bool rehash(PhenoSymbolTable* table) {
+    size_t mask = table->slot_mask * 2 + 1;
+    PhenoSymbol* slots = calloc(mask + 1, sizeof(PhenoSymbol));
+    if (!slots) return false;
+
+    for (size_t id = 1; id <= table->count; id++) {
+        size_t pos = table->entries[id].hash & mask;
+        while (slots[pos]) pos = (pos + 1) & mask;
+        slots[pos] = (PhenoSymbol)id;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_mask = mask;
+    return true;
+}
+
+// Slot holding name, or the empty slot where it would go
+static size_t probe(const PhenoSymbolTable* table, const char* name, size_t len, uint32_t hash) {
+    size_t pos = hash & table->slot_mask;
+    for (;;) {
+        PhenoSymbol id = table->slots[pos];
+        if (id == PHENO_SYMBOL_NONE) return pos;
+
+        const SymbolEntry* e = &table->entries[id];
+        if (e->hash == hash && e->len == len && memcmp(e->name, name, len) == 0) return pos;
+        pos = (pos + 1) & table->slot_mask;
+    }
+}
+
+PhenoSymbol pheno_symbols_intern(PhenoSymbolTable* table, const char* name, size_t len) {
+    if (!table || !name || len > UINT32_MAX) return PHENO_SYMBOL_NONE;
+
+    uint32_t hash = symbol_hash(name, len);
+    size_t pos = probe(table, name, len, hash);
+    if (table->slots[pos]) return table->slots[pos];
+
+    // Keep the load factor at or below one half
+    if ((table->count + 1) * 2 > table->slot_mask + 1) {
+        if (!rehash(table)) return PHENO_SYMBOL_NONE;
+        pos = probe(table, name, len, hash);
+    }
+    if (table->count + 1 >= table->capacity) {
+        size_t cap = table->capacity * 2;
+        SymbolEntry* grown = realloc(table->entries, cap * sizeof(SymbolEntry));
+        if (!grown) return PHENO_SYMBOL_NONE;
+        table->entries = grown;
+        table->capacity = cap;
+    }
+
+    char* copy = pheno_arena_strndup(table->names, name, len);
+    if (!copy) return PHENO_SYMBOL_NONE;
+
+    PhenoSymbol id = (PhenoSymbol)++table->count;
+    table->entries[id] = (SymbolEntry){ copy, (uint32_t)len, hash };
+    table->slots[pos] = id;
+    return id;
+}
+
+PhenoSymbol pheno_symbols_find(const PhenoSymbolTable* table, const char* name, size_t len) {
+    if (!table || !name) return PHENO_SYMBOL_NONE;
+    return table->slots[probe(table, name, len, symbol_hash(name, len))];
+}
+
+const char* pheno_symbols_name(const PhenoSymbolTable* table, PhenoSymbol symbol) {
+    if (!table || symbol > table->count) return "";
+    return table->entries[symbol].name;
+}
+
+size_t pheno_symbols_length(const PhenoSymbolTable* table, PhenoSymbol symbol) {
+    if (!table || symbol > table->count) return 0;
+    return table->entries[symbol].len;
+}
+
+size_t pheno_symbols_count(const PhenoSymbolTable* table) {
+    return table ? table->count : 0;
+}
+
+bool pheno_symbols_merge(PhenoSymbolTable* dst, const PhenoSymbolTable* src, PhenoSymbol* remap) {
+    if (!dst || !src || !remap) return false;
+
+    remap[PHENO_SYMBOL_NONE] = PHENO_SYMBOL_NONE;
+    for (size_t id = 1; id <= src->count; id++) {
+        const SymbolEntry* e = &src->entries[id];
+        remap[id] = pheno_symbols_intern(dst, e->name, e->len);
+        if (remap[id] == PHENO_SYMBOL_NONE) return false;
+    }
+    return true;
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "pheno_threadpool.h"
+
+typedef struct PhenoTask {
+    struct PhenoTask* next;
+    PhenoTaskFunc func;
+    void* arg;
+    PhenoTaskGroup* group;
+} PhenoTask;
+
+struct PhenoThreadPool {
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    PhenoTask* head;
+    PhenoTask* tail;
+    pthread_t* threads;
+    int thread_count;
+    bool shutdown;
+};
+
+static PhenoThreadPool* g_default_pool = NULL;
+static pthread_once_t g_default_once = PTHREAD_ONCE_INIT;
+
+int pheno_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static void task_finish(PhenoTaskGroup* group) {
+    pthread_mutex_lock(&group->mutex);
+    if (--group->pending == 0) {
+        pthread_cond_broadcast(&group->done);
+    }
+    pthread_mutex_unlock(&group->mutex);
+}
+
+// Pop the next task (caller holds pool->mutex)
+static PhenoTask* task_pop(PhenoThreadPool* pool) {
+    PhenoTask* task = pool->head;
+    if (task) {
+        pool->head = task->next;
+        if (!pool->head) pool->tail = NULL;
+    }
+    return task;
+}
+
+static void task_run(PhenoTask* task) {
+    PhenoTaskGroup* group = task->group;
+    task->func(task->arg);
+    free(task);
+    if (group) task_finish(group);
+}
+
+static void* worker_main(void* arg) {
+    PhenoThreadPool* pool = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        PhenoTask* task = task_pop(pool);
+        if (!task) {
+            if (pool->shutdown) break;
+            pthread_cond_wait(&pool->work, &pool->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        task_run(task);
+        pthread_mutex_lock(&pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+PhenoThreadPool* pheno_threadpool_create(int threads) {
+    if (threads <= 0) threads = pheno_cpu_count();
+
+    PhenoThreadPool* pool = calloc(1, sizeof(PhenoThreadPool));
+    if (!pool) return NULL;
+    pool->threads = calloc((size_t)threads, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) break;
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        pheno_threadpool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void pheno_threadpool_destroy(PhenoThreadPool* pool) {
+    if (!pool) return;
+
+    // Workers drain the queue before exiting
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    if (pool == g_default_pool) g_default_pool = NULL;
+    free(pool);
+}
+
+int pheno_threadpool_size(const PhenoThreadPool* pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+static void create_default_pool(void) {
+    g_default_pool = pheno_threadpool_create(0);
+}
+
+PhenoThreadPool* pheno_threadpool_default(void) {
+    pthread_once(&g_default_once, create_default_pool);
+    return g_default_pool;
+}
+
+void pheno_taskgroup_init(PhenoTaskGroup* group) {
+    pthread_mutex_init(&group->mutex, NULL);
+    pthread_cond_init(&group->done, NULL);
+    group->pending = 0;
+}
+
+void pheno_taskgroup_destroy(PhenoTaskGroup* group) {
+    pthread_cond_destroy(&group->done);
+    pthread_mutex_destroy(&group->mutex);
+}
+
+void pheno_threadpool_submit(PhenoThreadPool* pool, PhenoTaskGroup* group,
+                             PhenoTaskFunc func, void* arg) {
+    PhenoTask* task = pool ? malloc(sizeof(PhenoTask)) : NULL;
+    if (!task) {
+        func(arg);
+        return;
+    }
+
+    task->next = NULL;
+    task->func = func;
+    task->arg = arg;
+    task->group = group;
+
+    if (group) {
+        pthread_mutex_lock(&group->mutex);
+        group->pending++;
+        pthread_mutex_unlock(&group->mutex);
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->tail) {
+        pool->tail->next = task;
+    } else {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void pheno_taskgroup_wait(PhenoThreadPool* pool, PhenoTaskGroup* group) {
+    for (;;) {
+        pthread_mutex_lock(&group->mutex);
+        bool finished = group->pending == 0;
+        pthread_mutex_unlock(&group->mutex);
+        if (finished) return;
+
+        // Help with queued work rather than idling
+        PhenoTask* task = NULL;
+        if (pool) {
+            pthread_mutex_lock(&pool->mutex);
+            task = task_pop(pool);
+            pthread_mutex_unlock(&pool->mutex);
+        }
+        if (task) {
+            task_run(task);
+            continue;
+        }
+
+        pthread_mutex_lock(&group->mutex);
+        while (group->pending > 0) {
+            pthread_cond_wait(&group->done, &group->mutex);
+        }
+        pthread_mutex_unlock(&group->mutex);
+        return;
+    }
+}
@@ -0,0 +1,144 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "pheno_trace.h"
+#include "phenomemory_platform.h"
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t ns;
+    _Atomic uint64_t counted;
+    _Atomic uint64_t cycles;
+    _Atomic uint64_t cache_misses;
+} PhaseCounters;
+
+// Counter group of one thread: cycles leads, cache misses follow, and one
+// read returns both. leader is -2 until the thread first tries to open it
+// and -1 when it cannot.
+typedef struct {
+    int leader;
+    int member;
+} PerfGroup;
+
+static PhaseCounters g_phases[PHENO_PHASE_COUNT];
+static atomic_bool g_perf_enabled = ATOMIC_VAR_INIT(false);
+static pthread_once_t g_perf_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_perf_key;
+static _Thread_local PerfGroup t_perf = { -2, -1 };
+
+static const char* const g_phase_names[PHENO_PHASE_COUNT] = {
+    "PARSE", "LAYOUT", "RENDER", "EXPORT"
+};
+
+const char* pheno_phase_name(PhenoPhase phase) {
+    return phase < PHENO_PHASE_COUNT ? g_phase_names[phase] : "UNKNOWN";
+}
+
+static void perf_close(void* arg) {
+    PerfGroup* group = arg;
+    if (group->member >= 0) close(group->member);
+    if (group->leader >= 0) close(group->leader);
+    group->leader = group->member = -1;
+}
+
+static void perf_key_create(void) {
+    pthread_key_create(&g_perf_key, perf_close);
+}
+
+static int perf_open(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Counter group of the calling thread, opened on first use
+static PerfGroup* perf_group(void) {
+    if (t_perf.leader == -2) {
+        t_perf.leader = perf_open(PERF_COUNT_HW_CPU_CYCLES, -1);
+        t_perf.member = t_perf.leader >= 0 ? perf_open(PERF_COUNT_HW_CACHE_MISSES, t_perf.leader) : -1;
+        if (t_perf.member < 0) {
+            perf_close(&t_perf);
+        } else {
+            pthread_once(&g_perf_once, perf_key_create);
+            pthread_setspecific(g_perf_key, &t_perf);
+        }
+    }
+    return t_perf.leader >= 0 ? &t_perf : NULL;
+}
+
+static bool perf_read(const PerfGroup* group, uint64_t* cycles, uint64_t* misses) {
+    struct { uint64_t nr; uint64_t values[2]; } data;
+    if (read(group->leader, &data, sizeof(data)) != (ssize_t)sizeof(data) || data.nr != 2) {
+        return false;
+    }
+    *cycles = data.values[0];
+    *misses = data.values[1];
+    return true;
+}
+
+bool pheno_perf_enable(bool enable) {
+    if (enable && !perf_group()) return false;
+    atomic_store(&g_perf_enabled, enable);
+    return true;
+}
+
+bool pheno_perf_enabled(void) {
+    return atomic_load_explicit(&g_perf_enabled, memory_order_relaxed);
+}
+
+void pheno_phase_begin(PhenoPhaseScope* scope, PhenoPhase phase) {
+    scope->phase = phase;
+    scope->start_ns = 0;
+    scope->counted = false;
+    PHENO_TRACE1(phase_begin, (int)phase);
+    bool perf = pheno_perf_enabled();
+    if (!perf && !pheno_transition_stats_enabled()) return;
+
+    PerfGroup* group = perf ? perf_group() : NULL;
+    scope->counted = group && perf_read(group, &scope->cycles, &scope->cache_misses);
+    scope->start_ns = pheno_monotonic_ns();
+}
+
+void pheno_phase_end(PhenoPhaseScope* scope) {
+    uint64_t ns = scope->start_ns ? pheno_monotonic_ns() - scope->start_ns : 0;
+    PHENO_TRACE2(phase_end, (int)scope->phase, ns);
+    if (!scope->start_ns) return;
+
+    PhaseCounters* c = &g_phases[scope->phase];
+    atomic_fetch_add_explicit(&c->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->ns, ns, memory_order_relaxed);
+    uint64_t cycles, misses;
+    if (scope->counted && perf_read(&t_perf, &cycles, &misses)) {
+        atomic_fetch_add_explicit(&c->counted, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&c->cycles, cycles - scope->cycles, memory_order_relaxed);
+        atomic_fetch_add_explicit(&c->cache_misses, misses - scope->cache_misses, memory_order_relaxed);
+    }
+}
+
+void pheno_phase_stats_snapshot(PhenoPhaseStats stats[PHENO_PHASE_COUNT], bool reset) {
+    for (int p = 0; p < PHENO_PHASE_COUNT; p++) {
+        PhaseCounters* c = &g_phases[p];
+        if (reset) {
+            stats[p].count = atomic_exchange(&c->count, 0);
+            stats[p].ns = atomic_exchange(&c->ns, 0);
+            stats[p].counted = atomic_exchange(&c->counted, 0);
+            stats[p].cycles = atomic_exchange(&c->cycles, 0);
+            stats[p].cache_misses = atomic_exchange(&c->cache_misses, 0);
+        } else {
+            stats[p].count = atomic_load(&c->count);
+            stats[p].ns = atomic_load(&c->ns);
+            stats[p].counted = atomic_load(&c->counted);
+            stats[p].cycles = atomic_load(&c->cycles);
+            stats[p].cache_misses = atomic_load(&c->cache_misses);
+        }
+    }
+}
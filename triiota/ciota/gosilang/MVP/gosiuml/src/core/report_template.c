@@ -0,0 +1,259 @@
+#define _GNU_SOURCE  // memmem()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "report_template.h"
+
+typedef struct {
+    size_t offset;                 // Literal text before the slot
+    size_t length;
+    int slot;                      // -1 for the trailing literal
+} TemplateSegment;
+
+typedef struct {
+    size_t name;                   // Offset of the name in the source
+    size_t name_len;
+    TemplateSlotType type;
+} TemplateSlot;
+
+struct ReportTemplate {
+    char* source;                  // Private copy; literals point into it
+    size_t source_len;
+    TemplateSegment* segments;
+    size_t segment_count;
+    TemplateSlot slots[TEMPLATE_MAX_SLOTS];
+    size_t slot_count;
+};
+
+static const struct {
+    const char* name;
+    TemplateSlotType type;
+} slot_types[] = {
+    { "str", TEMPLATE_STR }, { "json", TEMPLATE_JSON }, { "raw", TEMPLATE_RAW },
+    { "int", TEMPLATE_INT }, { "uint", TEMPLATE_UINT }, { "hex", TEMPLATE_HEX },
+};
+
+static bool parse_type(const char* s, size_t len, TemplateSlotType* type) {
+    for (size_t i = 0; i < sizeof(slot_types) / sizeof(slot_types[0]); i++) {
+        if (strlen(slot_types[i].name) == len && memcmp(slot_types[i].name, s, len) == 0) {
+            *type = slot_types[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool name_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Slot for name, added on first sight; -1 on a type clash or overflow
+static int intern_slot(ReportTemplate* tpl, size_t name, size_t name_len, TemplateSlotType type) {
+    for (size_t i = 0; i < tpl->slot_count; i++) {
+        const TemplateSlot* s = &tpl->slots[i];
+        if (s->name_len == name_len && memcmp(tpl->source + s->name, tpl->source + name, name_len) == 0) {
+            return s->type == type ? (int)i : -1;
+        }
+    }
+    if (tpl->slot_count == TEMPLATE_MAX_SLOTS) return -1;
+    tpl->slots[tpl->slot_count] = (TemplateSlot){ name, name_len, type };
+    return (int)tpl->slot_count++;
+}
+
+static ReportTemplate* fail(ReportTemplate* tpl, char* error, size_t error_size, size_t line,
+                            const char* reason) {
+    if (error && error_size) snprintf(error, error_size, "line %zu: %s", line, reason);
+    template_free(tpl);
+    return NULL;
+}
+
+ReportTemplate* template_compile(const char* text, size_t len, char* error, size_t error_size) {
+    ReportTemplate* tpl = calloc(1, sizeof(ReportTemplate));
+    if (!tpl) return NULL;
+    tpl->source = malloc(len + 1);
+    if (!tpl->source) return fail(tpl, error, error_size, 0, "out of memory");
+    memcpy(tpl->source, text, len);
+    tpl->source[len] = '\0';
+    tpl->source_len = len;
+
+    // At most one placeholder per four bytes, plus the trailing literal
+    tpl->segments = malloc((len / 4 + 1) * sizeof(TemplateSegment));
+    if (!tpl->segments) return fail(tpl, error, error_size, 0, "out of memory");
+
+    const char* src = tpl->source;
+    size_t literal = 0, pos = 0, line = 1, line_pos = 0;
+    while (pos + 1 < len) {
+        const char* open = memmem(src + pos, len - pos, "{{", 2);
+        if (!open) break;
+        size_t start = (size_t)(open - src);
+        for (; line_pos < start; line_pos++) line += src[line_pos] == '\n';
+
+        const char* close = memmem(open + 2, len - start - 2, "}}", 2);
+        if (!close) return fail(tpl, error, error_size, line, "unterminated placeholder");
+
+        // name[:type]
+        size_t name = start + 2, end = (size_t)(close - src), name_end = name;
+        while (name_end < end && name_char(src[name_end])) name_end++;
+        TemplateSlotType type = TEMPLATE_STR;
+        if (name_end == name) return fail(tpl, error, error_size, line, "placeholder without a name");
+        if (name_end < end && (src[name_end] != ':' ||
+                               !parse_type(src + name_end + 1, end - name_end - 1, &type))) {
+            return fail(tpl, error, error_size, line, "unknown placeholder type");
+        }
+        int slot = intern_slot(tpl, name, name_end - name, type);
+        if (slot < 0) return fail(tpl, error, error_size, line, "placeholder type clash or too many names");
+
+        tpl->segments[tpl->segment_count++] = (TemplateSegment){ literal, start - literal, slot };
+        pos = literal = end + 2;
+    }
+    tpl->segments[tpl->segment_count++] = (TemplateSegment){ literal, len - literal, -1 };
+    return tpl;
+}
+
+void template_free(ReportTemplate* tpl) {
+    if (!tpl) return;
+    free(tpl->segments);
+    free(tpl->source);
+    free(tpl);
+}
+
+size_t template_slot_count(const ReportTemplate* tpl) {
+    return tpl ? tpl->slot_count : 0;
+}
+
+int template_slot(const ReportTemplate* tpl, const char* name) {
+    size_t len = strlen(name);
+    for (size_t i = 0; tpl && i < tpl->slot_count; i++) {
+        if (tpl->slots[i].name_len == len && memcmp(tpl->source + tpl->slots[i].name, name, len) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+const char* template_slot_name(const ReportTemplate* tpl, size_t slot, size_t* len) {
+    *len = tpl->slots[slot].name_len;
+    return tpl->source + tpl->slots[slot].name;
+}
+
+TemplateSlotType template_slot_type(const ReportTemplate* tpl, size_t slot) {
+    return tpl->slots[slot].type;
+}
+
+static void render_value(SvgWriter* w, TemplateSlotType type, const TemplateValue* v) {
+    size_t len = v->str && !v->len ? strlen(v->str) : v->len;
+    switch (type) {
+        case TEMPLATE_STR:
+            if (v->str) svg_put_escaped(w, v->str, len);
+            break;
+        case TEMPLATE_JSON:
+            if (v->str) svg_put_json_escaped(w, v->str, len);
+            break;
+        case TEMPLATE_RAW:
+            if (v->emit) {
+                v->emit(w, v->user);
+            } else if (v->str) {
+                svg_put(w, v->str, len);
+            }
+            break;
+        case TEMPLATE_INT:
+            if (v->i < 0) {
+                svg_puts(w, "-");
+                svg_put_u64(w, 0 - (uint64_t)v->i);
+            } else {
+                svg_put_u64(w, (uint64_t)v->i);
+            }
+            break;
+        case TEMPLATE_UINT:
+            svg_put_u64(w, v->u);
+            break;
+        case TEMPLATE_HEX:
+            svg_puts(w, "0x");
+            svg_put_hex32(w, (uint32_t)v->u);
+            break;
+    }
+}
+
+void template_render(const ReportTemplate* tpl, const TemplateValue* values, SvgWriter* w) {
+    for (size_t i = 0; i < tpl->segment_count && !w->failed; i++) {
+        const TemplateSegment* s = &tpl->segments[i];
+        svg_put_static(w, tpl->source + s->offset, s->length);
+        if (s->slot >= 0) render_value(w, tpl->slots[s->slot].type, &values[s->slot]);
+    }
+}
+
+int template_render_file(const ReportTemplate* tpl, const TemplateValue* values, const char* path) {
+    if (!tpl || (tpl->slot_count > 0 && !values) || !path) return -1;
+    SvgWriter w;
+    if (!svg_writer_open(&w, path)) return -1;
+    template_render(tpl, values, &w);
+    return svg_writer_close(&w) ? 0 : -1;
+}
+
+// Compiled templates by path, kept for the life of the process
+typedef struct TemplateEntry {
+    struct TemplateEntry* next;
+    ReportTemplate* tpl;
+    char path[];
+} TemplateEntry;
+
+static TemplateEntry* g_templates = NULL;
+static pthread_mutex_t g_templates_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char* read_file(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    char* text = NULL;
+    if (fseek(fp, 0, SEEK_END) == 0) {
+        long len = ftell(fp);
+        text = len >= 0 && fseek(fp, 0, SEEK_SET) == 0 ? malloc((size_t)len + 1) : NULL;
+        if (text) *size = fread(text, 1, (size_t)len, fp);
+    }
+    fclose(fp);
+    return text;
+}
+
+const ReportTemplate* template_load(const char* path, char* error, size_t error_size) {
+    pthread_mutex_lock(&g_templates_lock);
+    for (TemplateEntry* e = g_templates; e; e = e->next) {
+        if (strcmp(e->path, path) == 0) {
+            pthread_mutex_unlock(&g_templates_lock);
+            return e->tpl;
+        }
+    }
+
+    size_t size = 0;
+    char* text = read_file(path, &size);
+    ReportTemplate* tpl = NULL;
+    if (!text) {
+        if (error && error_size) snprintf(error, error_size, "cannot read %s", path);
+    } else {
+        tpl = template_compile(text, size, error, error_size);
+        free(text);
+    }
+
+    TemplateEntry* entry = tpl ? malloc(sizeof(TemplateEntry) + strlen(path) + 1) : NULL;
+    if (entry) {
+        entry->tpl = tpl;
+        strcpy(entry->path, path);
+        entry->next = g_templates;
+        g_templates = entry;
+    } else {
+        template_free(tpl);
+        tpl = NULL;
+    }
+    pthread_mutex_unlock(&g_templates_lock);
+    return tpl;
+}
+
+void template_cache_clear(void) {
+    pthread_mutex_lock(&g_templates_lock);
+    while (g_templates) {
+        TemplateEntry* next = g_templates->next;
+        template_free(g_templates->tpl);
+        free(g_templates);
+        g_templates = next;
+    }
+    pthread_mutex_unlock(&g_templates_lock);
+}
@@ -1,58 +1,415 @@
 #include "phenomemory_platform.h"
+#include "gosiuml.h"
+#include "svg_generator.h"
+#include "pheno_hash.h"
+#include "pheno_histogram.h"
 #include <stdio.h>
+#include <stdlib.h>
 
-void generate_svg_from_tokens(PhenoToken* tokens, int count, const char* output_file) {
-    FILE* svg = fopen(output_file, "w");
-    if (!svg) {
+// Shared styling keeps per-element markup to geometry and text. Cluster
+// (.c/.k) and aggregate edge (.a) sizes depend on the zoom level, so they
+// are set per element.
+static const char svg_style[] =
+    "  <style>\n"
+    "    .n{fill:#e8f4f8;stroke:#2196F3;stroke-width:2}\n"
+    "    .e{fill:none;stroke:#90A4AE;stroke-width:1.5}\n"
+    "    .a{fill:none;stroke:#90A4AE;stroke-opacity:0.6}\n"
+    "    .c{fill:#e8f4f8;stroke:#2196F3}\n"
+    "    .s{font-family:monospace;font-size:14px;font-weight:bold;text-anchor:middle}\n"
+    "    .i{font-family:monospace;font-size:12px;text-anchor:middle}\n"
+    "    .k{font-family:monospace;font-weight:bold;text-anchor:middle}\n"
+    "    .t{font-family:monospace;font-size:18px;font-weight:bold;text-anchor:middle}\n"
+    "  </style>\n";
+
+void svg_emit_prologue(SvgWriter* w, uint32_t view_x, uint32_t view_y,
+                       uint32_t view_w, uint32_t view_h, uint32_t width, uint32_t height) {
+    svg_puts(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+    svg_put_u32(w, width);
+    svg_puts(w, "\" height=\"");
+    svg_put_u32(w, height);
+    svg_puts(w, "\" viewBox=\"");
+    svg_put_u32(w, view_x);
+    svg_puts(w, " ");
+    svg_put_u32(w, view_y);
+    svg_puts(w, " ");
+    svg_put_u32(w, view_w);
+    svg_puts(w, " ");
+    svg_put_u32(w, view_h);
+    svg_puts(w, "\">\n  <title>PhenoMemory State Machine Visualization</title>\n");
+    svg_put_static(w, svg_style, sizeof(svg_style) - 1);
+
+    svg_puts(w, "  <rect x=\"");
+    svg_put_u32(w, view_x);
+    svg_puts(w, "\" y=\"");
+    svg_put_u32(w, view_y);
+    svg_puts(w, "\" width=\"");
+    svg_put_u32(w, view_w);
+    svg_puts(w, "\" height=\"");
+    svg_put_u32(w, view_h);
+    svg_puts(w, "\" fill=\"#f5f5f5\"/>\n");
+}
+
+void svg_emit_token(SvgWriter* w, const PhenoSymbolTable* symbols, const PhenoToken* token,
+                    uint32_t x, uint32_t y) {
+    size_t name_len;
+    const char* name = svg_token_name(symbols, token, &name_len);
+    svg_puts(w, "  <rect class=\"n\" x=\"");
+    svg_put_u32(w, x);
+    svg_puts(w, "\" y=\"");
+    svg_put_u32(w, y);
+    svg_puts(w, "\" width=\"180\" height=\"120\" rx=\"5\"/>\n  <text class=\"s\" x=\"");
+    svg_put_u32(w, x + LAYOUT_NODE_WIDTH / 2);
+    svg_puts(w, "\" y=\"");
+    svg_put_u32(w, y + 25);
+    svg_puts(w, "\">");
+    svg_put_escaped(w, name, name_len);
+    svg_puts(w, "</text>\n  <text class=\"i\" x=\"");
+    svg_put_u32(w, x + LAYOUT_NODE_WIDTH / 2);
+    svg_puts(w, "\" y=\"");
+    svg_put_u32(w, y + 45);
+    svg_puts(w, "\">ID: 0x");
+    svg_put_hex32(w, token->token_id);
+    svg_puts(w, "</text>\n");
+}
+
+void svg_emit_epilogue(SvgWriter* w) {
+    svg_puts(w, "</svg>\n");
+}
+
+void svg_emit_edges(SvgWriter* w, const Layout* layout) {
+    for (size_t e = 0; e < layout->edge_count; e++) {
+        if (e % SVG_EDGES_PER_PATH == 0) {
+            if (e > 0) svg_puts(w, "\"/>\n");
+            svg_puts(w, "  <path class=\"e\" d=\"");
+        }
+        const LayoutPoint* a = &layout->nodes[layout->edges[e * 2]];
+        const LayoutPoint* b = &layout->nodes[layout->edges[e * 2 + 1]];
+        svg_puts(w, "M");
+        svg_put_u32(w, svg_pixel(a->x));
+        svg_puts(w, " ");
+        svg_put_u32(w, svg_pixel(a->y));
+        svg_puts(w, "L");
+        svg_put_u32(w, svg_pixel(b->x));
+        svg_puts(w, " ");
+        svg_put_u32(w, svg_pixel(b->y));
+    }
+    if (layout->edge_count > 0) svg_puts(w, "\"/>\n");
+}
+
+// Prologue over the whole canvas plus the diagram title
+static void emit_header(SvgWriter* w, const Layout* layout) {
+    uint32_t width = svg_pixel(layout->width);
+    uint32_t height = svg_pixel(layout->height);
+    svg_emit_prologue(w, 0, 0, width, height, width, height);
+    svg_puts(w, "  <text class=\"t\" x=\"");
+    svg_put_u32(w, width / 2);
+    svg_puts(w, "\" y=\"30\">PhenoMemory Token State Visualization</text>\n");
+}
+
+static int render_layout(const PhenoToken* tokens, const PhenoSymbolTable* symbols,
+                         const Layout* layout, const char* output_file) {
+    if (!output_file || !layout || (layout->node_count > 0 && !tokens)) return -1;
+
+    SvgWriter w;
+    if (!svg_writer_open(&w, output_file)) {
+        perror("Failed to create SVG file");
+        return -1;
+    }
+
+    emit_header(&w, layout);
+
+    // Edges first so node boxes cover their ends
+    svg_emit_edges(&w, layout);
+    for (size_t i = 0; i < layout->node_count; i++) {
+        svg_emit_token(&w, symbols, &tokens[i], svg_pixel(layout->nodes[i].x - LAYOUT_NODE_WIDTH / 2),
+                       svg_pixel(layout->nodes[i].y - LAYOUT_NODE_HEIGHT / 2));
+    }
+
+    svg_emit_epilogue(&w);
+    if (!svg_writer_close(&w)) {
+        perror("Failed to write SVG file");
+        return -1;
+    }
+    return 0;
+}
+
+int svg_render_layout(const PhenoToken* tokens, const PhenoSymbolTable* symbols,
+                      const Layout* layout, const char* output_file) {
+    PhenoPhaseScope phase;
+    pheno_phase_begin(&phase, PHENO_PHASE_RENDER);
+    int rc = render_layout(tokens, symbols, layout, output_file);
+    pheno_phase_end(&phase);
+    return rc;
+}
+
+// Upper bound of one svg_emit_token() fragment apart from its name, and
+// the most one name byte can grow when escaped ("&quot;")
+#define SVG_TOKEN_BYTES     512
+#define SVG_ESCAPE_MAX      6
+#define SVG_CACHE_MIN_STORE (1u << 20)
+
+typedef struct {
+    uint64_t hash;                 // XXH64 of the visible fields
+    uint64_t offset;               // Into the store
+    uint32_t length;               // 0 = not rendered yet
+} SvgFragment;
+
+struct SvgFragmentCache {
+    SvgFragment* fragments;        // One per layout node
+    size_t count;
+    char* store;
+    size_t used;
+    size_t size;
+    size_t dead;                   // Store bytes no fragment refers to
+    SvgFragment edges;             // The relation layer as one block
+    uint64_t* name_hashes;         // Per symbol id this render, 0 = not hashed yet
+    size_t name_capacity;
+};
+
+// What a token fragment shows: id, type name and box corner. The name is
+// keyed by symbol id plus its hash, since ids are only unique per table
+// and a reparse may hand the cache a different table.
+typedef struct {
+    uint32_t token_id;
+    uint32_t x, y;
+    uint32_t type_symbol;
+    uint64_t name_hash;
+} SvgTokenKey;
+
+SvgFragmentCache* svg_cache_create(void) {
+    return calloc(1, sizeof(SvgFragmentCache));
+}
+
+void svg_cache_destroy(SvgFragmentCache* cache) {
+    if (!cache) return;
+    free(cache->fragments);
+    free(cache->store);
+    free(cache->name_hashes);
+    free(cache);
+}
+
+static bool store_reserve(SvgFragmentCache* cache, size_t n) {
+    if (cache->size - cache->used >= n) return true;
+    size_t size = cache->size ? cache->size : SVG_CACHE_MIN_STORE;
+    while (size - cache->used < n) size *= 2;
+    char* grown = realloc(cache->store, size);
+    if (!grown) return false;
+    cache->store = grown;
+    cache->size = size;
+    return true;
+}
+
+// Drop a fragment's bytes from the live set
+static inline void retire(SvgFragmentCache* cache, SvgFragment* f) {
+    cache->dead += f->length;
+    f->length = 0;
+}
+
+// Rewrite the store in output order once most of it is dead, so
+// unchanged neighbours are contiguous again
+static bool compact(SvgFragmentCache* cache) {
+    size_t live = cache->used - cache->dead;
+    char* store = malloc(live > SVG_CACHE_MIN_STORE ? live : SVG_CACHE_MIN_STORE);
+    if (!store) return false;
+
+    size_t used = 0;
+    memcpy(store, cache->store + cache->edges.offset, cache->edges.length);
+    cache->edges.offset = 0;
+    used += cache->edges.length;
+    for (size_t i = 0; i < cache->count; i++) {
+        SvgFragment* f = &cache->fragments[i];
+        memcpy(store + used, cache->store + f->offset, f->length);
+        f->offset = used;
+        used += f->length;
+    }
+    free(cache->store);
+    cache->store = store;
+    cache->size = live > SVG_CACHE_MIN_STORE ? live : SVG_CACHE_MIN_STORE;
+    cache->used = used;
+    cache->dead = 0;
+    return true;
+}
+
+static bool resize_fragments(SvgFragmentCache* cache, size_t count) {
+    for (size_t i = count; i < cache->count; i++) retire(cache, &cache->fragments[i]);
+    if (count > cache->count) {
+        SvgFragment* grown = realloc(cache->fragments, count * sizeof(SvgFragment));
+        if (!grown) return false;
+        memset(grown + cache->count, 0, (count - cache->count) * sizeof(SvgFragment));
+        cache->fragments = grown;
+    }
+    cache->count = count;
+    return true;
+}
+
+// Format into the store tail and point f at it
+static bool render_fragment(SvgFragmentCache* cache, SvgFragment* f, uint64_t hash, size_t bound,
+                            const PhenoSymbolTable* symbols, const PhenoToken* token,
+                            const Layout* layout, uint32_t x, uint32_t y) {
+    if (!store_reserve(cache, bound)) return false;
+    SvgWriter w;
+    svg_writer_init_memory(&w, cache->store + cache->used, bound);
+    if (token) {
+        svg_emit_token(&w, symbols, token, x, y);
+    } else {
+        svg_emit_edges(&w, layout);
+    }
+    if (w.failed) return false;
+
+    retire(cache, f);
+    f->hash = hash;
+    f->offset = cache->used;
+    f->length = (uint32_t)w.used;
+    cache->used += w.used;
+    return true;
+}
+
+// Hash of a token's name, computed once per symbol per render
+static uint64_t name_hash(SvgFragmentCache* cache, const PhenoSymbolTable* symbols,
+                          const PhenoToken* token) {
+    size_t len;
+    const char* name = svg_token_name(symbols, token, &len);
+    if (!symbols || !token->type_symbol) return pheno_xxh64(name, len, 0) | 1;
+    uint64_t* slot = &cache->name_hashes[token->type_symbol];
+    if (!*slot) *slot = pheno_xxh64(name, len, 0) | 1;
+    return *slot;
+}
+
+// Refresh every stale fragment; the store may move, so nothing is written yet
+static bool refresh(SvgFragmentCache* cache, const PhenoToken* tokens,
+                    const PhenoSymbolTable* symbols, const Layout* layout, SvgCacheStats* stats) {
+    if (!resize_fragments(cache, layout->node_count)) return false;
+
+    size_t symbol_count = symbols ? pheno_symbols_count(symbols) + 1 : 0;
+    if (symbol_count > cache->name_capacity) {
+        uint64_t* grown = realloc(cache->name_hashes, symbol_count * sizeof(uint64_t));
+        if (!grown) return false;
+        cache->name_hashes = grown;
+        cache->name_capacity = symbol_count;
+    }
+    if (symbol_count) memset(cache->name_hashes, 0, symbol_count * sizeof(uint64_t));
+
+    // A first render fills the store in one go; untouched reserve stays unmapped
+    if (cache->used == 0 &&
+        !store_reserve(cache, layout->edge_count * SVG_EDGE_BYTES + 64 + layout->node_count * SVG_TOKEN_BYTES)) {
+        return false;
+    }
+
+    uint64_t edge_hash = pheno_xxh64(layout->edges, layout->edge_count * 2 * sizeof(uint32_t),
+                                     layout->edge_count);
+    edge_hash = pheno_xxh64(layout->nodes, layout->node_count * sizeof(LayoutPoint), edge_hash);
+    if (layout->edge_count > 0 && (!cache->edges.length || cache->edges.hash != edge_hash)) {
+        size_t bound = layout->edge_count * SVG_EDGE_BYTES + 64;
+        if (bound > UINT32_MAX ||
+            !render_fragment(cache, &cache->edges, edge_hash, bound, NULL, NULL, layout, 0, 0)) {
+            return false;
+        }
+        stats->edges_reformatted = true;
+    } else if (layout->edge_count == 0) {
+        retire(cache, &cache->edges);
+    }
+
+    for (size_t i = 0; i < layout->node_count; i++) {
+        SvgTokenKey key;
+        memset(&key, 0, sizeof(key));
+        key.token_id = tokens[i].token_id;
+        key.x = svg_pixel(layout->nodes[i].x - LAYOUT_NODE_WIDTH / 2);
+        key.y = svg_pixel(layout->nodes[i].y - LAYOUT_NODE_HEIGHT / 2);
+        key.type_symbol = symbols ? tokens[i].type_symbol : PHENO_SYMBOL_NONE;
+        key.name_hash = name_hash(cache, symbols, &tokens[i]);
+        uint64_t hash = pheno_xxh64(&key, sizeof(key), 0);
+
+        SvgFragment* f = &cache->fragments[i];
+        if (f->length && f->hash == hash) continue;
+        size_t name_len;
+        svg_token_name(symbols, &tokens[i], &name_len);
+        size_t bound = SVG_TOKEN_BYTES + name_len * SVG_ESCAPE_MAX;
+        if (bound > UINT32_MAX ||
+            !render_fragment(cache, f, hash, bound, symbols, &tokens[i], layout, key.x, key.y)) {
+            return false;
+        }
+        stats->reformatted++;
+    }
+
+    if (cache->dead > cache->used / 2 && cache->dead > SVG_CACHE_MIN_STORE) return compact(cache);
+    return true;
+}
+
+static int render_layout_cached(SvgFragmentCache* cache, const PhenoToken* tokens,
+                                const PhenoSymbolTable* symbols, const Layout* layout,
+                                const char* output_file, SvgCacheStats* stats) {
+    SvgCacheStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!cache || !output_file || !layout || (layout->node_count > 0 && !tokens)) return -1;
+
+    uint64_t start = pheno_monotonic_ns();
+    if (!refresh(cache, tokens, symbols, layout, stats)) return -1;
+
+    SvgWriter w;
+    if (!svg_writer_open(&w, output_file)) {
         perror("Failed to create SVG file");
-        return;
-    }
-    
-    // SVG header
-    fprintf(svg, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-    fprintf(svg, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1200\" height=\"800\" viewBox=\"0 0 1200 800\">\n");
-    fprintf(svg, "  <title>PhenoMemory State Machine Visualization</title>\n");
-    
-    // Background
-    fprintf(svg, "  <rect width=\"1200\" height=\"800\" fill=\"#f5f5f5\"/>\n");
-    
-    // Title
-    fprintf(svg, "  <text x=\"600\" y=\"30\" text-anchor=\"middle\" ");
-    fprintf(svg, "font-family=\"monospace\" font-size=\"18\" font-weight=\"bold\">");
-    fprintf(svg, "PhenoMemory Token State Visualization</text>\n");
-    
-    // Generate nodes for each token
-    int x_offset = 100;
-    int y_offset = 100;
-    int node_width = 180;
-    int node_height = 120;
-    int h_spacing = 220;
-    int cols = 4;
-    
-    for (int i = 0; i < count && i < 12; i++) {
-        PhenoToken* token = &tokens[i];
-        int col = i % cols;
-        int row = i / cols;
-        int x = x_offset + col * h_spacing;
-        int y = y_offset + row * (node_height + 60);
-        
-        // Draw node rectangle
-        fprintf(svg, "  <rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" ", 
-                x, y, node_width, node_height);
-        fprintf(svg, "fill=\"#e8f4f8\" stroke=\"#2196F3\" stroke-width=\"2\" rx=\"5\"/>\n");
-        
-        // Token info
-        fprintf(svg, "  <text x=\"%d\" y=\"%d\" text-anchor=\"middle\" ",
-                x + node_width/2, y + 25);
-        fprintf(svg, "font-family=\"monospace\" font-size=\"14\" font-weight=\"bold\">");
-        fprintf(svg, "%s</text>\n", token->sentinel);
-        
-        fprintf(svg, "  <text x=\"%d\" y=\"%d\" text-anchor=\"middle\" ",
-                x + node_width/2, y + 45);
-        fprintf(svg, "font-family=\"monospace\" font-size=\"12\">");
-        fprintf(svg, "ID: 0x%08X</text>\n", token->token_id);
-    }
-    
-    fprintf(svg, "</svg>\n");
-    fclose(svg);
+        return -1;
+    }
+    emit_header(&w, layout);
+    svg_put_static(&w, cache->store + cache->edges.offset, cache->edges.length);
+
+    // Adjacent fragments go out as one segment
+    size_t run = 0, run_end = 0;
+    for (size_t i = 0; i < cache->count; i++) {
+        const SvgFragment* f = &cache->fragments[i];
+        if (f->offset != run_end) {
+            svg_put_static(&w, cache->store + run, run_end - run);
+            run = f->offset;
+        }
+        run_end = f->offset + f->length;
+    }
+    svg_put_static(&w, cache->store + run, run_end - run);
+    svg_emit_epilogue(&w);
+
+    bool ok = svg_writer_close(&w);
+    stats->tokens = layout->node_count;
+    stats->bytes = w.bytes;
+    stats->seconds = (pheno_monotonic_ns() - start) / 1e9;
+    if (!ok) {
+        perror("Failed to write SVG file");
+        return -1;
+    }
+    return 0;
+}
+
+int svg_render_layout_cached(SvgFragmentCache* cache, const PhenoToken* tokens,
+                             const PhenoSymbolTable* symbols, const Layout* layout,
+                             const char* output_file, SvgCacheStats* stats) {
+    PhenoPhaseScope phase;
+    pheno_phase_begin(&phase, PHENO_PHASE_RENDER);
+    int rc = render_layout_cached(cache, tokens, symbols, layout, output_file, stats);
+    pheno_phase_end(&phase);
+    return rc;
+}
+
+int gosiuml_generate_svg(GosiUMLContext* ctx, PhenoToken* tokens, int count, const char* output_file) {
+    (void)ctx;
+    if (count < 0) return -1;
+
+    Layout layout;
+    if (!layout_grid((size_t)count, &layout)) return -1;
+    int rc = svg_render_layout(tokens, NULL, &layout, output_file);
+    layout_free(&layout);
+    return rc;
+}
+
+int gosiuml_generate_document_svg(GosiUMLContext* ctx, const GosiUMLDocument* doc,
+                                  const char* output_file) {
+    (void)ctx;
+    Layout layout;
+    if (!doc || !layout_document(doc, NULL, &layout)) return -1;
+    int rc = svg_render_layout(doc->tokens, doc->symbols, &layout, output_file);
+    layout_free(&layout);
+    return rc;
+}
+
+void generate_svg_from_tokens(PhenoToken* tokens, int count, const char* output_file) {
+    gosiuml_generate_svg(NULL, tokens, count, output_file);
 }
@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "svg_writer.h"
+
+static const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static const char hex_digits[16] = "0123456789ABCDEF";
+
+bool svg_writer_open(SvgWriter* w, const char* path) {
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    w->buffer = malloc(SVG_WRITER_BUFFER);
+    if (!w->buffer) return false;
+    w->capacity = SVG_WRITER_BUFFER;
+
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (w->fd < 0) {
+        free(w->buffer);
+        w->buffer = NULL;
+        return false;
+    }
+    return true;
+}
+
+void svg_writer_init_memory(SvgWriter* w, char* buffer, size_t capacity) {
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    w->buffer = buffer;
+    w->capacity = capacity;
+}
+
+bool svg_writer_close(SvgWriter* w) {
+    bool ok = svg_writer_flush(w);
+    if (w->fd >= 0 && close(w->fd) != 0) ok = false;
+    free(w->buffer);
+    w->buffer = NULL;
+    w->capacity = w->used = 0;
+    w->fd = -1;
+    return ok;
+}
+
+// Queue buffered bytes written since the last queued segment
+static void queue_segment(SvgWriter* w) {
+    if (w->used > w->segment) {
+        w->iov[w->iov_count].iov_base = w->buffer + w->segment;
+        w->iov[w->iov_count].iov_len = w->used - w->segment;
+        w->iov_count++;
+        w->segment = w->used;
+    }
+}
+
+bool svg_writer_flush(SvgWriter* w) {
+    if (!w->failed) {
+        queue_segment(w);
+        struct iovec* iov = w->iov;
+        int count = w->iov_count;
+
+        while (count > 0) {
+            ssize_t n = writev(w->fd, iov, count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                w->failed = true;
+                break;
+            }
+            w->bytes += (uint64_t)n;
+
+            // Skip fully written segments, trim a partially written one
+            while (count > 0 && (size_t)n >= iov->iov_len) {
+                n -= (ssize_t)iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->iov_base = (char*)iov->iov_base + n;
+                iov->iov_len -= (size_t)n;
+            }
+        }
+        w->flushes++;
+    }
+
+    w->used = w->segment = 0;
+    w->iov_count = 0;
+    return !w->failed;
+}
+
+char* svg_writer_make_room(SvgWriter* w, size_t n) {
+    if (n > w->capacity || !svg_writer_flush(w)) return NULL;
+    return w->buffer;
+}
+
+void svg_put_static(SvgWriter* w, const char* s, size_t len) {
+    if (len < SVG_WRITER_STATIC_MIN || w->fd < 0) {
+        svg_put(w, s, len);
+        return;
+    }
+
+    // Needs a slot for pending bytes, one for s, and one spare for the flush
+    if (w->iov_count + 3 > SVG_WRITER_IOV && !svg_writer_flush(w)) return;
+    queue_segment(w);
+    w->iov[w->iov_count].iov_base = (void*)s;
+    w->iov[w->iov_count].iov_len = len;
+    w->iov_count++;
+}
+
+void svg_put_u32(SvgWriter* w, uint32_t value) {
+    char tmp[10];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+
+    while (value >= 100) {
+        uint32_t r = (value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        memcpy(p, digit_pairs + r, 2);
+    }
+    if (value >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + value * 2, 2);
+    } else {
+        *--p = (char)('0' + value);
+    }
+    svg_put(w, p, (size_t)(end - p));
+}
+
+void svg_put_i32(SvgWriter* w, int32_t value) {
+    if (value < 0) {
+        svg_puts(w, "-");
+        svg_put_u32(w, 0u - (uint32_t)value);
+    } else {
+        svg_put_u32(w, (uint32_t)value);
+    }
+}
+
+void svg_put_hex32(SvgWriter* w, uint32_t value) {
+    char* p = svg_reserve(w, 8);
+    if (!p) return;
+    for (int i = 7; i >= 0; i--) {
+        p[i] = hex_digits[value & 0xF];
+        value >>= 4;
+    }
+    w->used += 8;
+}
+
+void svg_put_u64(SvgWriter* w, uint64_t value) {
+    if (value <= UINT32_MAX) {
+        svg_put_u32(w, (uint32_t)value);
+        return;
+    }
+    char tmp[20];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+    while (value >= 100) {
+        uint32_t r = (uint32_t)(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        memcpy(p, digit_pairs + r, 2);
+    }
+    if (value >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + value * 2, 2);
+    } else {
+        *--p = (char)('0' + value);
+    }
+    svg_put(w, p, (size_t)(end - p));
+}
+
+// Replacement per byte: 0 = copy, 1 = drop, otherwise an index into the
+// entity list
+static const char* const xml_entities[] = { NULL, "", "&amp;", "&lt;", "&gt;", "&quot;", "&#39;" };
+static const uint8_t xml_entity_len[] = { 0, 0, 5, 4, 4, 6, 5 };
+
+static const uint8_t xml_escape[256] = {
+    [0x00] = 1, [0x01] = 1, [0x02] = 1, [0x03] = 1, [0x04] = 1, [0x05] = 1, [0x06] = 1, [0x07] = 1,
+    [0x08] = 1, [0x0B] = 1, [0x0C] = 1, [0x0E] = 1, [0x0F] = 1,
+    [0x10] = 1, [0x11] = 1, [0x12] = 1, [0x13] = 1, [0x14] = 1, [0x15] = 1, [0x16] = 1, [0x17] = 1,
+    [0x18] = 1, [0x19] = 1, [0x1A] = 1, [0x1B] = 1, [0x1C] = 1, [0x1D] = 1, [0x1E] = 1, [0x1F] = 1,
+    ['&'] = 2, ['<'] = 3, ['>'] = 4, ['"'] = 5, ['\''] = 6,
+};
+
+// Second character of the JSON escape; 'u' means \u00XX
+static const char json_escape[256] = {
+    [0x00] = 'u', [0x01] = 'u', [0x02] = 'u', [0x03] = 'u', [0x04] = 'u', [0x05] = 'u', [0x06] = 'u', [0x07] = 'u',
+    [0x08] = 'b', [0x09] = 't', [0x0A] = 'n', [0x0B] = 'u', [0x0C] = 'f', [0x0D] = 'r', [0x0E] = 'u', [0x0F] = 'u',
+    [0x10] = 'u', [0x11] = 'u', [0x12] = 'u', [0x13] = 'u', [0x14] = 'u', [0x15] = 'u', [0x16] = 'u', [0x17] = 'u',
+    [0x18] = 'u', [0x19] = 'u', [0x1A] = 'u', [0x1B] = 'u', [0x1C] = 'u', [0x1D] = 'u', [0x1E] = 'u', [0x1F] = 'u',
+    ['"'] = '"', ['\\'] = '\\',
+};
+
+void svg_put_escaped(SvgWriter* w, const char* s, size_t len) {
+    const char* run = s;
+    const char* end = s + len;
+
+    for (const char* p = s; p < end; p++) {
+        uint8_t e = xml_escape[(unsigned char)*p];
+        if (!e) continue;
+        svg_put(w, run, (size_t)(p - run));
+        svg_put(w, xml_entities[e], xml_entity_len[e]);
+        run = p + 1;
+    }
+    svg_put(w, run, (size_t)(end - run));
+}
+
+void svg_put_json_escaped(SvgWriter* w, const char* s, size_t len) {
+    const char* run = s;
+    const char* end = s + len;
+
+    for (const char* p = s; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        char e = json_escape[c];
+        if (!e) continue;
+        svg_put(w, run, (size_t)(p - run));
+        char* out = svg_reserve(w, 6);
+        if (!out) return;
+        out[0] = '\\';
+        out[1] = e;
+        if (e == 'u') {
+            memcpy(out + 2, "00", 2);
+            out[4] = hex_digits[c >> 4];
+            out[5] = hex_digits[c & 0xF];
+            w->used += 6;
+        } else {
+            w->used += 2;
+        }
+        run = p + 1;
+    }
+    svg_put(w, run, (size_t)(end - run));
+}
@@ -0,0 +1,616 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "tile_pyramid.h"
+#include "svg_generator.h"
+#include "pheno_threadpool.h"
+#include "pheno_histogram.h"
+
+#define TILE_DEFAULT_SIZE   512
+#define TILE_DEFAULT_NODES  1500
+#define TILE_DEFAULT_CELLS  8
+#define TILE_BATCH          8          // Tiles per render task
+#define TILE_EDGE_BUDGET    4          // Aggregated relations per tile, x max_tile_nodes
+
+// Tile items: kind in the top bit, edges sort (and draw) before nodes
+#define ITEM_NODE  0x80000000u
+#define ITEM_INDEX 0x7FFFFFFFu
+
+void tile_defaults(TileOptions* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->tile_size = TILE_DEFAULT_SIZE;
+    options->max_tile_nodes = TILE_DEFAULT_NODES;
+    options->cells = TILE_DEFAULT_CELLS;
+}
+
+PhenoTokenType tile_default_type(const PhenoToken* token, void* user) {
+    (void)user;
+    PhenoTokenType type;
+    memset(&type, 0, sizeof(type));
+    type.cluster_id = token->type_symbol ? (token->type_symbol - 1) & 0xFF : 0;
+    return type;
+}
+
+typedef struct {
+    float x, y;                    // Centroid
+    uint32_t count;
+    uint32_t first;                // Token that names the aggregate
+} Aggregate;
+
+typedef struct {
+    uint32_t src;
+    uint32_t dst;
+    uint32_t count;
+} AggregateEdge;
+
+// One zoom level, items bucketed by tile
+typedef struct {
+    uint32_t zoom;
+    uint32_t side;                 // Tiles per world side
+    double tile_world;             // World pixels per tile side
+    bool aggregated;
+    Aggregate* aggregates;
+    size_t aggregate_count;
+    AggregateEdge* edges;
+    size_t edge_count;
+    uint32_t* tiles;               // Occupied tile indices (y * side + x), ascending
+    uint32_t* start;               // Item range per occupied tile
+    uint32_t* items;
+    size_t occupied;
+} TileLevel;
+
+typedef struct {
+    uint32_t tile;
+    uint32_t item;
+} TileItem;
+
+typedef struct {
+    TileItem* data;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} ItemVec;
+
+static void level_free(TileLevel* lv) {
+    free(lv->aggregates);
+    free(lv->edges);
+    free(lv->tiles);
+    free(lv->start);
+    free(lv->items);
+    memset(lv, 0, sizeof(*lv));
+}
+
+static void item_push(ItemVec* v, uint32_t tile, uint32_t item) {
+    if (v->count == v->capacity) {
+        size_t cap = v->capacity ? v->capacity * 2 : 4096;
+        TileItem* grown = realloc(v->data, cap * sizeof(TileItem));
+        if (!grown) {
+            v->failed = true;
+            return;
+        }
+        v->data = grown;
+        v->capacity = cap;
+    }
+    v->data[v->count++] = (TileItem){ tile, item };
+}
+
+static inline uint32_t tile_coord(double world, const TileLevel* lv) {
+    if (world <= 0) return 0;
+    double t = floor(world / lv->tile_world);
+    return t >= lv->side ? lv->side - 1 : (uint32_t)t;
+}
+
+// Every tile touched by a box
+static void add_box(ItemVec* v, const TileLevel* lv, double x0, double y0,
+                    double x1, double y1, uint32_t item) {
+    uint32_t tx0 = tile_coord(x0, lv), tx1 = tile_coord(x1, lv);
+    uint32_t ty0 = tile_coord(y0, lv), ty1 = tile_coord(y1, lv);
+    for (uint32_t ty = ty0; ty <= ty1; ty++) {
+        for (uint32_t tx = tx0; tx <= tx1; tx++) item_push(v, ty * lv->side + tx, item);
+    }
+}
+
+// Every tile crossed by a segment (grid traversal)
+static void add_segment(ItemVec* v, const TileLevel* lv, double ax, double ay,
+                        double bx, double by, uint32_t item) {
+    int64_t tx = tile_coord(ax, lv), ty = tile_coord(ay, lv);
+    int64_t ex = tile_coord(bx, lv), ey = tile_coord(by, lv);
+    double dx = bx - ax, dy = by - ay;
+    int sx = dx > 0 ? 1 : -1, sy = dy > 0 ? 1 : -1;
+    double tmax_x = dx != 0 ? ((tx + (sx > 0)) * lv->tile_world - ax) / dx : INFINITY;
+    double tmax_y = dy != 0 ? ((ty + (sy > 0)) * lv->tile_world - ay) / dy : INFINITY;
+    double step_x = dx != 0 ? lv->tile_world / fabs(dx) : INFINITY;
+    double step_y = dy != 0 ? lv->tile_world / fabs(dy) : INFINITY;
+
+    item_push(v, (uint32_t)(ty * lv->side + tx), item);
+    for (uint32_t guard = 0; (tx != ex || ty != ey) && guard < 2 * lv->side; guard++) {
+        if (tmax_x < tmax_y) {
+            tx += sx;
+            tmax_x += step_x;
+        } else {
+            ty += sy;
+            tmax_y += step_y;
+        }
+        if (tx < 0 || ty < 0 || tx >= lv->side || ty >= lv->side) break;
+        item_push(v, (uint32_t)(ty * lv->side + tx), item);
+    }
+}
+
+// Counting sort by tile; insertion order is kept within a tile
+static bool bucket_items(TileLevel* lv, const ItemVec* v) {
+    size_t tiles = (size_t)lv->side * lv->side;
+    uint32_t* cursor = calloc(tiles, sizeof(uint32_t));
+    if (!cursor) return false;
+    for (size_t i = 0; i < v->count; i++) cursor[v->data[i].tile]++;
+
+    size_t occupied = 0;
+    for (size_t t = 0; t < tiles; t++) occupied += cursor[t] != 0;
+    lv->tiles = malloc((occupied ? occupied : 1) * sizeof(uint32_t));
+    lv->start = malloc((occupied + 1) * sizeof(uint32_t));
+    lv->items = malloc((v->count ? v->count : 1) * sizeof(uint32_t));
+    if (!lv->tiles || !lv->start || !lv->items) {
+        free(cursor);
+        return false;
+    }
+
+    uint32_t pos = 0;
+    for (size_t t = 0, k = 0; t < tiles; t++) {
+        if (!cursor[t]) continue;
+        uint32_t count = cursor[t];
+        lv->tiles[k] = (uint32_t)t;
+        lv->start[k++] = pos;
+        cursor[t] = pos;
+        pos += count;
+    }
+    lv->start[occupied] = pos;
+    lv->occupied = occupied;
+    for (size_t i = 0; i < v->count; i++) lv->items[cursor[v->data[i].tile]++] = v->data[i].item;
+    free(cursor);
+    return true;
+}
+
+// Aggregate circle radius in world pixels: grows with sqrt(count), 6..40 px on screen
+static double aggregate_radius(uint32_t count, double world_per_px) {
+    double px = 6 + 3 * sqrt((double)count);
+    return (px > 40 ? 40 : px) * world_per_px;
+}
+
+typedef struct {
+    uint64_t key;                  // cell << 8 | cluster_id
+    uint32_t token;
+} AggregateKey;
+
+static int compare_keys(const void* a, const void* b) {
+    const AggregateKey* x = a;
+    const AggregateKey* y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->token > y->token) - (x->token < y->token);
+}
+
+// Heaviest first, so each tile keeps its strongest relations within budget
+static int compare_weight(const void* a, const void* b) {
+    const AggregateEdge* x = a;
+    const AggregateEdge* y = b;
+    if (x->count != y->count) return x->count > y->count ? -1 : 1;
+    if (x->src != y->src) return x->src < y->src ? -1 : 1;
+    return (x->dst > y->dst) - (x->dst < y->dst);
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Group tokens by (grid cell, cluster) and relations by aggregate pair
+static bool build_aggregates(TileLevel* lv, const GosiUMLDocument* doc, const Layout* layout,
+                             const TileOptions* options, uint32_t cells) {
+    size_t n = layout->node_count;
+    uint64_t per_side = (uint64_t)lv->side * cells;
+    double cell_world = lv->tile_world / cells;
+    TileClassifier classify = options->classify ? options->classify : tile_default_type;
+
+    AggregateKey* keys = malloc((n ? n : 1) * sizeof(AggregateKey));
+    uint32_t* owner = malloc((n ? n : 1) * sizeof(uint32_t));
+    lv->aggregates = malloc((n ? n : 1) * sizeof(Aggregate));
+    bool ok = keys && owner && lv->aggregates;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        uint64_t cx = (uint64_t)fmax(0, floor(layout->nodes[i].x / cell_world));
+        uint64_t cy = (uint64_t)fmax(0, floor(layout->nodes[i].y / cell_world));
+        if (cx >= per_side) cx = per_side - 1;
+        if (cy >= per_side) cy = per_side - 1;
+        uint8_t cluster = (uint8_t)classify(&doc->tokens[i], options->user).cluster_id;
+        keys[i] = (AggregateKey){ ((cy * per_side + cx) << 8) | cluster, (uint32_t)i };
+    }
+    if (ok) qsort(keys, n, sizeof(AggregateKey), compare_keys);
+
+    double sx = 0, sy = 0;
+    for (size_t i = 0; ok && i < n; i++) {
+        uint32_t t = keys[i].token;
+        if (i == 0 || keys[i].key != keys[i - 1].key) {
+            lv->aggregates[lv->aggregate_count++] = (Aggregate){ 0, 0, 0, t };
+            sx = sy = 0;
+        }
+        Aggregate* a = &lv->aggregates[lv->aggregate_count - 1];
+        sx += layout->nodes[t].x;
+        sy += layout->nodes[t].y;
+        a->count++;
+        a->x = (float)(sx / a->count);
+        a->y = (float)(sy / a->count);
+        owner[t] = (uint32_t)lv->aggregate_count - 1;
+    }
+
+    uint64_t* pairs = ok ? malloc((layout->edge_count ? layout->edge_count : 1) * sizeof(uint64_t)) : NULL;
+    ok = ok && pairs;
+    size_t pair_count = 0;
+    for (size_t e = 0; ok && e < layout->edge_count; e++) {
+        uint32_t a = owner[layout->edges[e * 2]], b = owner[layout->edges[e * 2 + 1]];
+        if (a != b) pairs[pair_count++] = ((uint64_t)a << 32) | b;
+    }
+    if (ok) {
+        qsort(pairs, pair_count, sizeof(uint64_t), compare_u64);
+        lv->edges = malloc((pair_count ? pair_count : 1) * sizeof(AggregateEdge));
+        ok = lv->edges != NULL;
+    }
+    for (size_t i = 0; ok && i < pair_count; i++) {
+        if (i == 0 || pairs[i] != pairs[i - 1]) {
+            lv->edges[lv->edge_count++] = (AggregateEdge){ (uint32_t)(pairs[i] >> 32), (uint32_t)pairs[i], 0 };
+        }
+        lv->edges[lv->edge_count - 1].count++;
+    }
+    if (ok) qsort(lv->edges, lv->edge_count, sizeof(AggregateEdge), compare_weight);
+
+    free(keys);
+    free(owner);
+    free(pairs);
+    return ok;
+}
+
+static bool build_level(TileLevel* lv, const GosiUMLDocument* doc, const Layout* layout,
+                        const TileOptions* options, uint32_t cells, double world_per_px) {
+    ItemVec v = { NULL, 0, 0, false };
+    bool ok = true;
+
+    if (lv->aggregated) {
+        ok = build_aggregates(lv, doc, layout, options, cells);
+        for (size_t e = 0; ok && e < lv->edge_count; e++) {
+            const Aggregate* a = &lv->aggregates[lv->edges[e].src];
+            const Aggregate* b = &lv->aggregates[lv->edges[e].dst];
+            add_segment(&v, lv, a->x, a->y, b->x, b->y, (uint32_t)e);
+        }
+        for (size_t i = 0; ok && i < lv->aggregate_count; i++) {
+            const Aggregate* a = &lv->aggregates[i];
+            double r = aggregate_radius(a->count, world_per_px);
+            add_box(&v, lv, a->x - r, a->y - r, a->x + r, a->y + r, ITEM_NODE | (uint32_t)i);
+        }
+    } else {
+        for (size_t e = 0; e < layout->edge_count; e++) {
+            const LayoutPoint* a = &layout->nodes[layout->edges[e * 2]];
+            const LayoutPoint* b = &layout->nodes[layout->edges[e * 2 + 1]];
+            add_segment(&v, lv, a->x, a->y, b->x, b->y, (uint32_t)e);
+        }
+        for (size_t i = 0; i < layout->node_count; i++) {
+            const LayoutPoint* p = &layout->nodes[i];
+            add_box(&v, lv, p->x - LAYOUT_NODE_WIDTH / 2, p->y - LAYOUT_NODE_HEIGHT / 2,
+                    p->x + LAYOUT_NODE_WIDTH / 2, p->y + LAYOUT_NODE_HEIGHT / 2,
+                    ITEM_NODE | (uint32_t)i);
+        }
+    }
+
+    ok = ok && !v.failed && bucket_items(lv, &v);
+    free(v.data);
+    return ok;
+}
+
+// Largest number of token centres in one tile at zoom z
+static uint32_t busiest_tile(const Layout* layout, double world, uint32_t zoom) {
+    TileLevel lv = { .zoom = zoom, .side = 1u << zoom, .tile_world = world / (1u << zoom) };
+    uint32_t* count = calloc((size_t)lv.side * lv.side, sizeof(uint32_t));
+    if (!count) return UINT32_MAX;
+
+    uint32_t busiest = 0;
+    for (size_t i = 0; i < layout->node_count; i++) {
+        uint32_t t = tile_coord(layout->nodes[i].y, &lv) * lv.side + tile_coord(layout->nodes[i].x, &lv);
+        if (++count[t] > busiest) busiest = count[t];
+    }
+    free(count);
+    return busiest;
+}
+
+typedef struct {
+    const GosiUMLDocument* doc;
+    const Layout* layout;
+    const TileLevel* level;
+    const char* dir;
+    uint32_t tile_size;
+    uint32_t edge_budget;          // Aggregated relations drawn per tile
+    size_t begin;
+    size_t end;
+    uint64_t bytes;
+    uint64_t files;
+    bool failed;
+} TileTask;
+
+static void emit_aggregate(SvgWriter* w, const GosiUMLDocument* doc, const Aggregate* a,
+                           double world_per_px) {
+    uint32_t x = svg_pixel(a->x), y = svg_pixel(a->y);
+    uint32_t r = svg_pixel((float)aggregate_radius(a->count, world_per_px));
+    uint32_t stroke = svg_pixel((float)(2 * world_per_px));
+    svg_puts(w, "  <circle class=\"c\" cx=\"");
+    svg_put_u32(w, x);
+    svg_puts(w, "\" cy=\"");
+    svg_put_u32(w, y);
+    svg_puts(w, "\" r=\"");
+    svg_put_u32(w, r);
+    svg_puts(w, "\" stroke-width=\"");
+    svg_put_u32(w, stroke ? stroke : 1);
+    svg_puts(w, "\"/>\n  <text class=\"k\" x=\"");
+    svg_put_u32(w, x);
+    svg_puts(w, "\" y=\"");
+    svg_put_u32(w, y + r + svg_pixel((float)(12 * world_per_px)));
+    svg_puts(w, "\" font-size=\"");
+    svg_put_u32(w, svg_pixel((float)(11 * world_per_px)));
+    svg_puts(w, "\">");
+
+    // Cluster label: the type name where interned, else the sentinel
+    size_t name_len;
+    const char* name = svg_token_name(doc->symbols, &doc->tokens[a->first], &name_len);
+    svg_put_escaped(w, name, name_len);
+    svg_puts(w, " (");
+    svg_put_u32(w, a->count);
+    svg_puts(w, ")</text>\n");
+}
+
+static bool render_tile(TileTask* task, size_t k) {
+    const TileLevel* lv = task->level;
+    const Layout* layout = task->layout;
+    uint32_t tile = lv->tiles[k];
+    uint32_t tx = tile % lv->side, ty = tile / lv->side;
+    double world_per_px = lv->tile_world / task->tile_size;
+
+    char path[1200];
+    snprintf(path, sizeof(path), "%s/%u/%u/%u.svg", task->dir, lv->zoom, tx, ty);
+    SvgWriter w;
+    if (!svg_writer_open(&w, path)) return false;
+
+    uint32_t view = (uint32_t)ceil(lv->tile_world);
+    svg_emit_prologue(&w, svg_pixel((float)(tx * lv->tile_world)), svg_pixel((float)(ty * lv->tile_world)),
+                      view, view, task->tile_size, task->tile_size);
+
+    bool in_path = false;
+    uint32_t aggregated = 0;
+    for (uint32_t i = lv->start[k]; i < lv->start[k + 1]; i++) {
+        uint32_t item = lv->items[i];
+        uint32_t index = item & ITEM_INDEX;
+
+        if (!(item & ITEM_NODE) && !lv->aggregated) {
+            // Relations share one path per tile
+            const LayoutPoint* a = &layout->nodes[layout->edges[index * 2]];
+            const LayoutPoint* b = &layout->nodes[layout->edges[index * 2 + 1]];
+            if (!in_path) svg_puts(&w, "  <path class=\"e\" d=\"");
+            in_path = true;
+            svg_puts(&w, "M");
+            svg_put_u32(&w, svg_pixel(a->x));
+            svg_puts(&w, " ");
+            svg_put_u32(&w, svg_pixel(a->y));
+            svg_puts(&w, "L");
+            svg_put_u32(&w, svg_pixel(b->x));
+            svg_puts(&w, " ");
+            svg_put_u32(&w, svg_pixel(b->y));
+            continue;
+        }
+        if (in_path) {
+            svg_puts(&w, "\"/>\n");
+            in_path = false;
+        }
+
+        if (!(item & ITEM_NODE)) {
+            if (++aggregated > task->edge_budget) continue;
+            // Aggregated relation, 1 px plus one per doubling of the count, up to 8 px
+            const AggregateEdge* e = &lv->edges[index];
+            const Aggregate* a = &lv->aggregates[e->src];
+            const Aggregate* b = &lv->aggregates[e->dst];
+            double px = fmin(8, 1 + log2((double)e->count));
+            uint32_t width = svg_pixel((float)(px * world_per_px));
+            svg_puts(&w, "  <path class=\"a\" stroke-width=\"");
+            svg_put_u32(&w, width ? width : 1);
+            svg_puts(&w, "\" d=\"M");
+            svg_put_u32(&w, svg_pixel(a->x));
+            svg_puts(&w, " ");
+            svg_put_u32(&w, svg_pixel(a->y));
+            svg_puts(&w, "L");
+            svg_put_u32(&w, svg_pixel(b->x));
+            svg_puts(&w, " ");
+            svg_put_u32(&w, svg_pixel(b->y));
+            svg_puts(&w, "\"/>\n");
+        } else if (lv->aggregated) {
+            emit_aggregate(&w, task->doc, &lv->aggregates[index], world_per_px);
+        } else {
+            const LayoutPoint* p = &layout->nodes[index];
+            svg_emit_token(&w, task->doc->symbols, &task->doc->tokens[index],
+                           svg_pixel(p->x - LAYOUT_NODE_WIDTH / 2),
+                           svg_pixel(p->y - LAYOUT_NODE_HEIGHT / 2));
+        }
+    }
+    if (in_path) svg_puts(&w, "\"/>\n");
+
+    svg_emit_epilogue(&w);
+    bool ok = svg_writer_close(&w);
+    task->bytes += w.bytes;
+    task->files++;
+    return ok;
+}
+
+static void render_tiles(void* arg) {
+    TileTask* task = arg;
+    for (size_t k = task->begin; k < task->end; k++) {
+        if (!render_tile(task, k)) task->failed = true;
+    }
+}
+
+static bool make_dir(const char* path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+static bool make_level_dirs(const char* dir, const TileLevel* lv) {
+    char path[1200];
+    snprintf(path, sizeof(path), "%s/%u", dir, lv->zoom);
+    if (!make_dir(path)) return false;
+
+    bool* made = calloc(lv->side, sizeof(bool));
+    if (!made) return false;
+    bool ok = true;
+    for (size_t k = 0; ok && k < lv->occupied; k++) {
+        uint32_t tx = lv->tiles[k] % lv->side;
+        if (made[tx]) continue;
+        made[tx] = true;
+        snprintf(path, sizeof(path), "%s/%u/%u", dir, lv->zoom, tx);
+        ok = make_dir(path);
+    }
+    free(made);
+    return ok;
+}
+
+static bool render_level(const TileLevel* lv, const GosiUMLDocument* doc, const Layout* layout,
+                         const TileOptions* options, PhenoThreadPool* pool, TileStats* stats) {
+    size_t count = (lv->occupied + TILE_BATCH - 1) / TILE_BATCH;
+    TileTask* tasks = calloc(count ? count : 1, sizeof(TileTask));
+    if (!tasks || !make_level_dirs(options->dir, lv)) {
+        free(tasks);
+        return false;
+    }
+
+    PhenoTaskGroup group;
+    if (pool) pheno_taskgroup_init(&group);
+    for (size_t i = 0; i < count; i++) {
+        size_t end = (i + 1) * TILE_BATCH;
+        tasks[i] = (TileTask){ doc, layout, lv, options->dir, options->tile_size,
+                               options->max_tile_nodes * TILE_EDGE_BUDGET, i * TILE_BATCH, end < lv->occupied ? end : lv->occupied, 0, 0, false };
+        if (pool) {
+            pheno_threadpool_submit(pool, &group, render_tiles, &tasks[i]);
+        } else {
+            render_tiles(&tasks[i]);
+        }
+    }
+    if (pool) {
+        pheno_taskgroup_wait(pool, &group);
+        pheno_taskgroup_destroy(&group);
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        stats->bytes += tasks[i].bytes;
+        stats->tiles += tasks[i].files;
+        ok &= !tasks[i].failed;
+    }
+    free(tasks);
+    return ok;
+}
+
+// Level entry of index.json: occupied tiles with their node counts
+static void write_index_level(SvgWriter* w, const TileLevel* lv, bool first) {
+    if (!first) svg_puts(w, ",");
+    svg_puts(w, "\n    {\"zoom\": ");
+    svg_put_u32(w, lv->zoom);
+    if (lv->aggregated) {
+        svg_puts(w, ", \"aggregated\": true");
+    } else {
+        svg_puts(w, ", \"aggregated\": false");
+    }
+    svg_puts(w, ", \"tiles\": [");
+    for (size_t k = 0; k < lv->occupied; k++) {
+        uint32_t nodes = 0;
+        for (uint32_t i = lv->start[k]; i < lv->start[k + 1]; i++) nodes += (lv->items[i] & ITEM_NODE) != 0;
+        if (k) svg_puts(w, ", ");
+        svg_puts(w, "[");
+        svg_put_u32(w, lv->tiles[k] % lv->side);
+        svg_puts(w, ", ");
+        svg_put_u32(w, lv->tiles[k] / lv->side);
+        svg_puts(w, ", ");
+        svg_put_u32(w, nodes);
+        svg_puts(w, "]");
+    }
+    svg_puts(w, "]}");
+}
+
+bool tile_pyramid_write(const GosiUMLDocument* doc, const Layout* layout,
+                        const TileOptions* options, TileStats* stats) {
+    TileStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!doc || !layout || !options || !options->dir[0] || layout->node_count != doc->token_count) {
+        return false;
+    }
+    if (layout->node_count > ITEM_INDEX || layout->edge_count > ITEM_INDEX) return false;
+
+    TileOptions opts = *options;
+    if (opts.tile_size == 0) opts.tile_size = TILE_DEFAULT_SIZE;
+    if (opts.max_tile_nodes == 0) opts.max_tile_nodes = TILE_DEFAULT_NODES;
+    if (opts.cells == 0) opts.cells = TILE_DEFAULT_CELLS;
+
+    uint64_t start = pheno_monotonic_ns();
+    double world = fmax(layout->width, layout->height);
+
+    // Finest zoom: forced, or the first whose busiest tile fits the bound
+    uint32_t detail = 0;
+    if (opts.levels > 0) {
+        detail = (uint32_t)opts.levels - 1;
+        if (detail > TILE_MAX_LEVEL) detail = TILE_MAX_LEVEL;
+    } else {
+        while (detail < TILE_MAX_LEVEL && busiest_tile(layout, world, detail) > opts.max_tile_nodes) {
+            detail++;
+        }
+    }
+    stats->levels = detail + 1;
+    stats->detail_level = detail;
+
+    if (!make_dir(opts.dir)) return false;
+    char index_path[1200];
+    snprintf(index_path, sizeof(index_path), "%s/index.json", opts.dir);
+    SvgWriter index;
+    if (!svg_writer_open(&index, index_path)) return false;
+
+    svg_puts(&index, "{\n  \"format\": \"gosiuml-tiles\",\n  \"version\": 1,\n  \"width\": ");
+    svg_put_u32(&index, svg_pixel(layout->width));
+    svg_puts(&index, ",\n  \"height\": ");
+    svg_put_u32(&index, svg_pixel(layout->height));
+    svg_puts(&index, ",\n  \"world\": ");
+    svg_put_u32(&index, svg_pixel((float)world));
+    svg_puts(&index, ",\n  \"tile_size\": ");
+    svg_put_u32(&index, opts.tile_size);
+    svg_puts(&index, ",\n  \"detail_level\": ");
+    svg_put_u32(&index, detail);
+    svg_puts(&index, ",\n  \"path\": \"{z}/{x}/{y}.svg\",\n  \"levels\": [");
+
+    PhenoThreadPool* pool = NULL;
+    bool own_pool = false;
+    if (opts.pool || opts.threads != 1) {
+        pool = opts.pool;
+        own_pool = !pool && opts.threads > 1;
+        if (!pool) pool = own_pool ? pheno_threadpool_create(opts.threads)
+                                   : pheno_threadpool_default();
+    }
+
+    bool ok = true;
+    for (uint32_t z = 0; ok && z <= detail; z++) {
+        TileLevel lv = { .zoom = z, .side = 1u << z, .tile_world = world / (1u << z),
+                         .aggregated = z < detail };
+        double world_per_px = lv.tile_world / opts.tile_size;
+        ok = build_level(&lv, doc, layout, &opts, opts.cells, world_per_px) &&
+             render_level(&lv, doc, layout, &opts, pool, stats);
+        if (ok) write_index_level(&index, &lv, z == 0);
+        stats->aggregates += lv.aggregate_count;
+        level_free(&lv);
+    }
+    if (own_pool) pheno_threadpool_destroy(pool);
+
+    svg_puts(&index, "\n  ]\n}\n");
+    ok = svg_writer_close(&index) && ok;
+    stats->bytes += index.bytes;
+    stats->seconds = (pheno_monotonic_ns() - start) / 1e9;
+    return ok;
+}
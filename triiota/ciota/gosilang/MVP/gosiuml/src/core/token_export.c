@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <string.h>
+#include "phenomemory_platform.h"
+#include "gosiuml.h"
+#include "svg_writer.h"
+
+// XML and JSON exports share one record walk over SvgWriter; a syntax
+// only decides how each record is spelled. Nothing is allocated per
+// token: numbers are formatted in place and strings escaped through
+// lookup tables straight into the output buffer.
+#define GOSIUML_XML_NAMESPACE "http://obinexus.org/gosiuml/v1"
+
+typedef struct {
+    const PhenoToken* tokens;
+    size_t token_count;
+    const GosiUMLRelation* relations;
+    size_t relation_count;
+    const PhenoSymbolTable* symbols;   // NULL for bare token arrays
+} ExportSource;
+
+typedef struct {
+    void (*begin)(SvgWriter* w, const ExportSource* src);
+    void (*token)(SvgWriter* w, const ExportSource* src, const PhenoToken* token, bool first);
+    void (*relations)(SvgWriter* w, const ExportSource* src);   // Between tokens and relations
+    void (*relation)(SvgWriter* w, const ExportSource* src, const GosiUMLRelation* rel, bool first);
+    void (*end)(SvgWriter* w, const ExportSource* src);
+} ExportSyntax;
+
+static inline size_t sentinel_length(const PhenoToken* token) {
+    return strnlen(token->sentinel, sizeof(token->sentinel));
+}
+
+// Relation type: the interned name when available, else the inline copy
+static inline const char* relation_type(const ExportSource* src, const GosiUMLRelation* rel,
+                                        size_t* len) {
+    if (src->symbols && rel->type_symbol) {
+        *len = pheno_symbols_length(src->symbols, rel->type_symbol);
+        return pheno_symbols_name(src->symbols, rel->type_symbol);
+    }
+    *len = strnlen(rel->type, sizeof(rel->type));
+    return rel->type;
+}
+
+static void xml_hex(SvgWriter* w, uint32_t value) {
+    svg_puts(w, "0x");
+    svg_put_hex32(w, value);
+}
+
+static void xml_begin(SvgWriter* w, const ExportSource* src) {
+    svg_puts(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<stateMachine xmlns=\"" GOSIUML_XML_NAMESPACE "\">\n"
+                "  <metadata>\n"
+                "    <name>PhenoMemoryStateMachine</name>\n"
+                "    <version>");
+    svg_put_u32(w, GOSIUML_VERSION_MAJOR);
+    svg_puts(w, ".");
+    svg_put_u32(w, GOSIUML_VERSION_MINOR);
+    svg_puts(w, ".");
+    svg_put_u32(w, GOSIUML_VERSION_PATCH);
+    svg_puts(w, "</version>\n"
+                "    <type>phenomenological_memory</type>\n"
+                "  </metadata>\n"
+                "  <tokens count=\"");
+    svg_put_u64(w, src->token_count);
+    svg_puts(w, "\">\n");
+}
+
+static void xml_token(SvgWriter* w, const ExportSource* src, const PhenoToken* token, bool first) {
+    (void)first;
+    svg_puts(w, "    <token id=\"");
+    xml_hex(w, token->token_id);
+    svg_puts(w, "\" sentinel=\"");
+    svg_put_escaped(w, token->sentinel, sentinel_length(token));
+    if (src->symbols) {
+        svg_puts(w, "\" type=\"");
+        svg_put_escaped(w, pheno_symbols_name(src->symbols, token->type_symbol),
+                        pheno_symbols_length(src->symbols, token->type_symbol));
+        svg_puts(w, "\" zone_name=\"");
+        svg_put_escaped(w, pheno_symbols_name(src->symbols, token->zone_symbol),
+                        pheno_symbols_length(src->symbols, token->zone_symbol));
+    }
+    svg_puts(w, "\" memory_zone=\"");
+    svg_put_u32(w, token->memory_zone);
+    svg_puts(w, "\" flags=\"");
+    xml_hex(w, atomic_load(&token->mem_flags.flags));
+    svg_puts(w, "\" ref_count=\"");
+    svg_put_u32(w, atomic_load(&token->mem_flags.ref_count));
+    svg_puts(w, "\" data_size=\"");
+    svg_put_u64(w, token->data_size);
+    svg_puts(w, "\"/>\n");
+}
+
+static void xml_relations(SvgWriter* w, const ExportSource* src) {
+    svg_puts(w, "  </tokens>\n  <relations count=\"");
+    svg_put_u64(w, src->relation_count);
+    svg_puts(w, "\">\n");
+}
+
+static void xml_relation(SvgWriter* w, const ExportSource* src, const GosiUMLRelation* rel, bool first) {
+    (void)first;
+    size_t len;
+    const char* type = relation_type(src, rel, &len);
+    svg_puts(w, "    <relation src=\"");
+    xml_hex(w, rel->src_id);
+    svg_puts(w, "\" dst=\"");
+    xml_hex(w, rel->dst_id);
+    svg_puts(w, "\" type=\"");
+    svg_put_escaped(w, type, len);
+    svg_puts(w, "\"/>\n");
+}
+
+static void xml_end(SvgWriter* w, const ExportSource* src) {
+    (void)src;
+    svg_puts(w, "  </relations>\n</stateMachine>\n");
+}
+
+static void json_begin(SvgWriter* w, const ExportSource* src) {
+    (void)src;
+    svg_puts(w, "{\"format\":\"gosiuml\",\"version\":\"");
+    svg_put_u32(w, GOSIUML_VERSION_MAJOR);
+    svg_puts(w, ".");
+    svg_put_u32(w, GOSIUML_VERSION_MINOR);
+    svg_puts(w, ".");
+    svg_put_u32(w, GOSIUML_VERSION_PATCH);
+    svg_puts(w, "\",\n\"tokens\":[");
+}
+
+static void json_token(SvgWriter* w, const ExportSource* src, const PhenoToken* token, bool first) {
+    if (!first) svg_puts(w, ",");
+    svg_puts(w, "\n{\"id\":");
+    svg_put_u32(w, token->token_id);
+    svg_puts(w, ",\"sentinel\":\"");
+    svg_put_json_escaped(w, token->sentinel, sentinel_length(token));
+    if (src->symbols) {
+        svg_puts(w, "\",\"type\":\"");
+        svg_put_json_escaped(w, pheno_symbols_name(src->symbols, token->type_symbol),
+                             pheno_symbols_length(src->symbols, token->type_symbol));
+        svg_puts(w, "\",\"zone_name\":\"");
+        svg_put_json_escaped(w, pheno_symbols_name(src->symbols, token->zone_symbol),
+                             pheno_symbols_length(src->symbols, token->zone_symbol));
+    }
+    svg_puts(w, "\",\"memory_zone\":");
+    svg_put_u32(w, token->memory_zone);
+    svg_puts(w, ",\"flags\":");
+    svg_put_u32(w, atomic_load(&token->mem_flags.flags));
+    svg_puts(w, ",\"ref_count\":");
+    svg_put_u32(w, atomic_load(&token->mem_flags.ref_count));
+    svg_puts(w, ",\"data_size\":");
+    svg_put_u64(w, token->data_size);
+    svg_puts(w, "}");
+}
+
+static void json_relations(SvgWriter* w, const ExportSource* src) {
+    (void)src;
+    svg_puts(w, "],\n\"relations\":[");
+}
+
+static void json_relation(SvgWriter* w, const ExportSource* src, const GosiUMLRelation* rel, bool first) {
+    size_t len;
+    const char* type = relation_type(src, rel, &len);
+    if (!first) svg_puts(w, ",");
+    svg_puts(w, "\n{\"src\":");
+    svg_put_u32(w, rel->src_id);
+    svg_puts(w, ",\"dst\":");
+    svg_put_u32(w, rel->dst_id);
+    svg_puts(w, ",\"type\":\"");
+    svg_put_json_escaped(w, type, len);
+    svg_puts(w, "\"}");
+}
+
+static void json_end(SvgWriter* w, const ExportSource* src) {
+    (void)src;
+    svg_puts(w, "]}\n");
+}
+
+static const ExportSyntax xml_syntax = { xml_begin, xml_token, xml_relations, xml_relation, xml_end };
+static const ExportSyntax json_syntax = { json_begin, json_token, json_relations, json_relation, json_end };
+
+static int write_export(const ExportSyntax* syntax, const ExportSource* src, const char* output_file) {
+    if (!output_file || (src->token_count > 0 && !src->tokens)) return -1;
+
+    SvgWriter w;
+    if (!svg_writer_open(&w, output_file)) {
+        perror("Failed to create export file");
+        return -1;
+    }
+
+    syntax->begin(&w, src);
+    for (size_t i = 0; i < src->token_count && !w.failed; i++) {
+        syntax->token(&w, src, &src->tokens[i], i == 0);
+    }
+    syntax->relations(&w, src);
+    for (size_t i = 0; i < src->relation_count && !w.failed; i++) {
+        syntax->relation(&w, src, &src->relations[i], i == 0);
+    }
+    syntax->end(&w, src);
+
+    if (!svg_writer_close(&w)) {
+        perror("Failed to write export file");
+        return -1;
+    }
+    return 0;
+}
+
+static int export_file(const ExportSyntax* syntax, const ExportSource* src, const char* output_file) {
+    PhenoPhaseScope phase;
+    pheno_phase_begin(&phase, PHENO_PHASE_EXPORT);
+    int rc = write_export(syntax, src, output_file);
+    pheno_phase_end(&phase);
+    return rc;
+}
+
+static const ExportSyntax* export_syntax(GosiUMLFormat format) {
+    switch (format) {
+        case FORMAT_XML:  return &xml_syntax;
+        case FORMAT_JSON: return &json_syntax;
+        default:          return NULL;
+    }
+}
+
+int gosiuml_generate_xml(GosiUMLContext* ctx, PhenoToken* tokens, int count, const char* output_file) {
+    (void)ctx;
+    if (count < 0) return -1;
+    ExportSource src = { tokens, (size_t)count, NULL, 0, NULL };
+    return export_file(&xml_syntax, &src, output_file);
+}
+
+int gosiuml_generate_json(GosiUMLContext* ctx, PhenoToken* tokens, int count, const char* output_file) {
+    (void)ctx;
+    if (count < 0) return -1;
+    ExportSource src = { tokens, (size_t)count, NULL, 0, NULL };
+    return export_file(&json_syntax, &src, output_file);
+}
+
+GosiUMLFormat gosiuml_format_from_path(const char* path) {
+    const char* ext = path ? strrchr(path, '.') : NULL;
+    if (ext && strcmp(ext, ".xml") == 0) return FORMAT_XML;
+    if (ext && strcmp(ext, ".json") == 0) return FORMAT_JSON;
+    return FORMAT_SVG;
+}
+
+int gosiuml_export_document(GosiUMLContext* ctx, const GosiUMLDocument* doc,
+                            GosiUMLFormat format, const char* output_file) {
+    if (!doc) return -1;
+    if (format == FORMAT_SVG) return gosiuml_generate_document_svg(ctx, doc, output_file);
+
+    const ExportSyntax* syntax = export_syntax(format);
+    if (!syntax) return -1;
+    ExportSource src = { doc->tokens, doc->token_count, doc->relations, doc->relation_count,
+                         doc->symbols };
+    return export_file(syntax, &src, output_file);
+}
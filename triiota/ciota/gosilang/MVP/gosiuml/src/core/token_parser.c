@@ -3,63 +3,459 @@
 #include <string.h>
 #include "gosiuml.h"
 #include "phenomemory_platform.h"
+#include "token_scanner.h"
+#include "pheno_threadpool.h"
+#include "pheno_arena.h"
 
-// Parse token file and allocate tokens
+// Chunked parsing: files are split into newline-aligned chunks that are
+// scanned in parallel into per-chunk buffers, then concatenated in order
+#define PARSE_DEFAULT_CHUNK (4u << 20)
+#define PARSE_MIN_CHUNK     (64u << 10)
+
+typedef struct {
+    const char* data;
+    size_t size;
+    PhenoToken* tokens;
+    size_t token_count;
+    size_t token_cap;
+    GosiUMLRelation* relations;
+    size_t relation_count;
+    size_t relation_cap;
+    PhenoSymbolTable* symbols;  // Chunk-local ids, remapped on merge
+    uint64_t malformed;
+    bool want_relations;
+    bool shared_symbols;        // symbols is the caller's table: ids are final
+    bool failed;
+} ParseChunk;
+
+// Parse token file and report its contents; the document is released
+// before returning, so nothing is held beyond the call
 int parse_token_file(const char* filename) {
     printf("[PARSER] Parsing token file: %s\n", filename);
-    
-    FILE* fp = fopen(filename, "r");
-    if (!fp) {
+
+    GosiUMLDocument* doc = gosiuml_parse_document(filename, NULL);
+    if (!doc) {
         printf("[PARSER] Could not open file: %s\n", filename);
         return -1;
     }
-    
-    char line[256];
-    int token_count = 0;
-    
-    while (fgets(line, sizeof(line), fp)) {
-        // Skip comments and empty lines
-        if (line[0] == '#' || line[0] == '\n') continue;
-        
-        // Parse token definitions
-        if (strstr(line, "TOKEN:")) {
-            uint32_t id;
-            char type[32], zone[16];
-            
-            if (sscanf(line, "TOKEN: 0x%x %s %s", &id, type, zone) == 3) {
-                token_count++;
-                printf("[PARSER] Found token: ID=0x%08X TYPE=%s ZONE=%s\n", 
-                       id, type, zone);
-                
-                // Create actual token using pheno_token_alloc
-                PhenoToken* token = pheno_token_alloc(1024);
-                if (token) {
-                    token->token_id = id;
-                    strncpy(token->sentinel, type, 15);
-                    token->sentinel[15] = '\0';  // Ensure null termination
-                    token->memory_zone = atoi(zone);
-                    
-                    // Process the token
-                    printf("[PARSER] Allocated token 0x%08X in zone %u\n",
-                           token->token_id, token->memory_zone);
-                }
+
+    for (size_t i = 0; i < doc->token_count; i++) {
+        PHENO_DEBUG("[PARSER] Found token: ID=0x%08X TYPE=%s ZONE=%s\n",
+                    doc->tokens[i].token_id,
+                    pheno_symbols_name(doc->symbols, doc->tokens[i].type_symbol),
+                    pheno_symbols_name(doc->symbols, doc->tokens[i].zone_symbol));
+    }
+    for (size_t i = 0; i < doc->relation_count; i++) {
+        PHENO_DEBUG("[PARSER] Found relation: 0x%08X -> 0x%08X (%s)\n",
+                    doc->relations[i].src_id, doc->relations[i].dst_id,
+                    pheno_symbols_name(doc->symbols, doc->relations[i].type_symbol));
+    }
+
+    if (doc->malformed) {
+        printf("[PARSER] Skipped %llu malformed lines\n",
+               (unsigned long long)doc->malformed);
+    }
+    int token_count = (int)doc->token_count;
+    printf("[PARSER] Parsed %d tokens\n", token_count);
+    gosiuml_free_document(doc);
+    return token_count;
+}
+
+static bool chunk_on_token(const TokenScanToken* tok, void* user) {
+    ParseChunk* chunk = user;
+    if (chunk->token_count == chunk->token_cap) {
+        size_t cap = chunk->token_cap ? chunk->token_cap * 2 : 256;
+        PhenoToken* grown = realloc(chunk->tokens, cap * sizeof(PhenoToken));
+        if (!grown) {
+            chunk->failed = true;
+            return false;
+        }
+        chunk->tokens = grown;
+        chunk->token_cap = cap;
+    }
+
+    PhenoToken* token = &chunk->tokens[chunk->token_count++];
+    memset(token, 0, sizeof(*token));
+    size_t len = tok->type.len < 15 ? tok->type.len : 15;
+    token->token_id = tok->id;
+    memcpy(token->sentinel, tok->type.ptr, len);
+    token->memory_zone = (uint8_t)tok->zone_value;
+    token->type_symbol = pheno_symbols_intern(chunk->symbols, tok->type.ptr, tok->type.len);
+    token->zone_symbol = pheno_symbols_intern(chunk->symbols, tok->zone.ptr, tok->zone.len);
+    if (!token->type_symbol || !token->zone_symbol) {
+        chunk->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static bool chunk_on_relation(const TokenScanRelation* rel, void* user) {
+    ParseChunk* chunk = user;
+    if (!chunk->want_relations) return true;
+
+    if (chunk->relation_count == chunk->relation_cap) {
+        size_t cap = chunk->relation_cap ? chunk->relation_cap * 2 : 128;
+        GosiUMLRelation* grown = realloc(chunk->relations, cap * sizeof(GosiUMLRelation));
+        if (!grown) {
+            chunk->failed = true;
+            return false;
+        }
+        chunk->relations = grown;
+        chunk->relation_cap = cap;
+    }
+
+    GosiUMLRelation* out = &chunk->relations[chunk->relation_count++];
+    size_t len = rel->type.len < sizeof(out->type) - 1 ? rel->type.len : sizeof(out->type) - 1;
+    memset(out, 0, sizeof(*out));
+    out->src_id = rel->src_id;
+    out->dst_id = rel->dst_id;
+    memcpy(out->type, rel->type.ptr, len);
+    out->type_symbol = pheno_symbols_intern(chunk->symbols, rel->type.ptr, rel->type.len);
+    if (!out->type_symbol) {
+        chunk->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static void parse_chunk(void* arg) {
+    ParseChunk* chunk = arg;
+    if (!chunk->shared_symbols) chunk->symbols = pheno_symbols_create();
+    if (!chunk->symbols) {
+        chunk->failed = true;
+        return;
+    }
+    TokenScanCallbacks callbacks = { chunk_on_token, chunk_on_relation, chunk };
+    TokenScanStats stats = {0};
+    token_scan_buffer(chunk->data, chunk->size, true, 1, &callbacks, &stats);
+    chunk->malformed = stats.malformed;
+}
+
+typedef struct {
+    ParseChunk* chunks;
+    size_t count;
+    size_t total_tokens;
+    size_t total_relations;
+    uint64_t malformed;
+    uint64_t source_size;
+} ParseResult;
+
+static void parse_result_free(ParseResult* result) {
+    for (size_t i = 0; i < result->count; i++) {
+        free(result->chunks[i].tokens);
+        free(result->chunks[i].relations);
+        if (!result->chunks[i].shared_symbols) pheno_symbols_destroy(result->chunks[i].symbols);
+    }
+    free(result->chunks);
+}
+
+// Scan the file into per-chunk buffers, in parallel when worthwhile
+static bool parse_chunks(const char* filename, const GosiUMLParseOptions* options,
+                         bool want_relations, ParseResult* result) {
+    memset(result, 0, sizeof(*result));
+
+    TokenScanFile file;
+    if (!filename || !token_scan_open(&file, filename)) return false;
+    result->source_size = file.size;
+
+    // Pick chunking: never smaller than PARSE_MIN_CHUNK, a few per thread
+    int threads = options->pool ? pheno_threadpool_size(options->pool) :
+                  options->threads > 0 ? options->threads : pheno_cpu_count();
+    size_t target = options->chunk_size ? options->chunk_size : PARSE_DEFAULT_CHUNK;
+    if (!options->chunk_size) {
+        size_t per_thread = file.size / ((size_t)threads * 4) + 1;
+        if (per_thread < target) target = per_thread;
+        if (target < PARSE_MIN_CHUNK) target = PARSE_MIN_CHUNK;
+    }
+    size_t chunk_count = file.size / target + 1;
+    if (threads == 1) chunk_count = 1;
+
+    ParseChunk* chunks = calloc(chunk_count, sizeof(ParseChunk));
+    if (!chunks) {
+        token_scan_close(&file);
+        return false;
+    }
+
+    // Newline-aligned boundaries
+    size_t n = 0;
+    size_t start = 0;
+    while (start < file.size && n < chunk_count) {
+        size_t end = n == chunk_count - 1 ? file.size : start + target;
+        if (end >= file.size) {
+            end = file.size;
+        } else {
+            const char* nl = memchr(file.data + end, '\n', file.size - end);
+            end = nl ? (size_t)(nl - file.data) + 1 : file.size;
+        }
+        chunks[n].data = file.data + start;
+        chunks[n].size = end - start;
+        chunks[n].want_relations = want_relations;
+        n++;
+        start = end;
+    }
+
+    // A single chunk interns straight into the caller's table; parallel
+    // chunks keep local tables since a table is not thread-safe
+    if (n == 1 && options->symbols) {
+        chunks[0].symbols = options->symbols;
+        chunks[0].shared_symbols = true;
+    }
+
+    if (n <= 1 || threads == 1) {
+        for (size_t i = 0; i < n; i++) parse_chunk(&chunks[i]);
+    } else {
+        // A caller's pool is reused across parses; otherwise threads > 1
+        // gets a pool for this parse alone
+        PhenoThreadPool* pool = options->pool;
+        bool own_pool = !pool && options->threads > 1;
+        if (!pool) pool = own_pool ? pheno_threadpool_create(options->threads)
+                                   : pheno_threadpool_default();
+
+        PhenoTaskGroup group;
+        pheno_taskgroup_init(&group);
+        for (size_t i = 0; i < n; i++) {
+            pheno_threadpool_submit(pool, &group, parse_chunk, &chunks[i]);
+        }
+        pheno_taskgroup_wait(pool, &group);
+        pheno_taskgroup_destroy(&group);
+        if (own_pool) pheno_threadpool_destroy(pool);
+    }
+    token_scan_close(&file);
+
+    result->chunks = chunks;
+    result->count = n;
+    bool failed = false;
+    for (size_t i = 0; i < n; i++) {
+        result->total_tokens += chunks[i].token_count;
+        result->total_relations += chunks[i].relation_count;
+        result->malformed += chunks[i].malformed;
+        failed |= chunks[i].failed;
+    }
+    if (failed) {
+        parse_result_free(result);
+        return false;
+    }
+    return true;
+}
+
+// Concatenate chunk buffers in file order. With a symbol table, chunk
+// symbols are interned in chunk order and ids remapped (a chunk that
+// already interned into that table keeps its ids); without one the
+// symbol fields are cleared since the ids would be meaningless.
+static bool merge_chunks(const ParseResult* result, PhenoToken* tokens,
+                         GosiUMLRelation* relations, PhenoSymbolTable* symbols) {
+    size_t t = 0, r = 0;
+    for (size_t i = 0; i < result->count; i++) {
+        const ParseChunk* chunk = &result->chunks[i];
+        PhenoSymbol* remap = NULL;
+        bool keep = symbols && chunk->symbols == symbols;
+        if (symbols && !keep) {
+            remap = malloc((pheno_symbols_count(chunk->symbols) + 1) * sizeof(PhenoSymbol));
+            if (!remap || !pheno_symbols_merge(symbols, chunk->symbols, remap)) {
+                free(remap);
+                return false;
+            }
+        }
+
+        if (tokens && chunk->token_count) {
+            PhenoToken* out = tokens + t;
+            memcpy(out, chunk->tokens, chunk->token_count * sizeof(PhenoToken));
+            for (size_t k = 0; !keep && k < chunk->token_count; k++) {
+                out[k].type_symbol = remap ? remap[out[k].type_symbol] : PHENO_SYMBOL_NONE;
+                out[k].zone_symbol = remap ? remap[out[k].zone_symbol] : PHENO_SYMBOL_NONE;
             }
         }
-        
-        // Parse relation definitions
-        if (strstr(line, "RELATION:")) {
-            uint32_t src_id, dst_id;
-            char rel_type[32];
-            
-            if (sscanf(line, "RELATION: 0x%x -> 0x%x : %s", 
-                      &src_id, &dst_id, rel_type) == 3) {
-                printf("[PARSER] Found relation: 0x%08X -> 0x%08X (%s)\n",
-                       src_id, dst_id, rel_type);
+        if (relations && chunk->relation_count) {
+            GosiUMLRelation* out = relations + r;
+            memcpy(out, chunk->relations, chunk->relation_count * sizeof(GosiUMLRelation));
+            for (size_t k = 0; !keep && k < chunk->relation_count; k++) {
+                out[k].type_symbol = remap ? remap[out[k].type_symbol] : PHENO_SYMBOL_NONE;
             }
         }
+        t += chunk->token_count;
+        r += chunk->relation_count;
+        free(remap);
     }
-    
-    fclose(fp);
-    printf("[PARSER] Parsed %d tokens\n", token_count);
-    return token_count;
+    return true;
+}
+
+static GosiUMLDocument* parse_document(const char* filename, const GosiUMLParseOptions* options) {
+    GosiUMLParseOptions defaults = {0};
+    if (!options) options = &defaults;
+
+    ParseResult result;
+    if (!parse_chunks(filename, options, true, &result)) return NULL;
+
+    // Document, tokens and relations share one arena sized up front
+    size_t bytes = sizeof(GosiUMLDocument) + 64 +
+                   result.total_tokens * sizeof(PhenoToken) +
+                   result.total_relations * sizeof(GosiUMLRelation);
+    PhenoArena* arena = options->arena ? options->arena : pheno_arena_create(bytes);
+    GosiUMLDocument* doc = arena ? PHENO_ARENA_NEW(arena, GosiUMLDocument, 1) : NULL;
+    PhenoToken* tokens = doc ? PHENO_ARENA_NEW(arena, PhenoToken, result.total_tokens) : NULL;
+    GosiUMLRelation* relations = tokens ?
+        PHENO_ARENA_NEW(arena, GosiUMLRelation, result.total_relations) : NULL;
+    PhenoSymbolTable* symbols = !relations ? NULL :
+        options->symbols ? options->symbols : pheno_symbols_create();
+    if (!symbols || !merge_chunks(&result, tokens, relations, symbols)) {
+        if (symbols != options->symbols) pheno_symbols_destroy(symbols);
+        if (!options->arena) pheno_arena_destroy(arena);
+        parse_result_free(&result);
+        return NULL;
+    }
+
+    memset(doc, 0, sizeof(*doc));
+    doc->tokens = tokens;
+    doc->token_count = result.total_tokens;
+    doc->relations = relations;
+    doc->relation_count = result.total_relations;
+    doc->malformed = result.malformed;
+    doc->source_size = result.source_size;
+    doc->symbols = symbols;
+    doc->shared_symbols = options->symbols != NULL;
+    doc->arena = options->arena ? NULL : arena;
+    parse_result_free(&result);
+    return doc;
+}
+
+GosiUMLDocument* gosiuml_parse_document(const char* filename, const GosiUMLParseOptions* options) {
+    PhenoPhaseScope phase;
+    pheno_phase_begin(&phase, PHENO_PHASE_PARSE);
+    GosiUMLDocument* doc = parse_document(filename, options);
+    pheno_phase_end(&phase);
+    return doc;
+}
+
+void gosiuml_free_document(GosiUMLDocument* doc) {
+    if (!doc) return;
+    if (!doc->shared_symbols) pheno_symbols_destroy(doc->symbols);
+    pheno_arena_destroy(doc->arena);
+}
+
+// Symbol id for a type or zone name, PHENO_SYMBOL_NONE if it never occurs
+PhenoSymbol gosiuml_document_symbol(const GosiUMLDocument* doc, const char* name) {
+    if (!doc || !name) return PHENO_SYMBOL_NONE;
+    return pheno_symbols_find(doc->symbols, name, strlen(name));
+}
+
+// Compatibility entry point returning separately allocated arrays
+PhenoToken* gosiuml_parse_file_ex(const char* filename, const GosiUMLParseOptions* options,
+                                  int* count) {
+    GosiUMLParseOptions defaults = {0};
+    if (!options) options = &defaults;
+    if (count) *count = -1;
+    if (options->relations) *options->relations = NULL;
+    if (options->relation_count) *options->relation_count = 0;
+
+    ParseResult result;
+    if (!parse_chunks(filename, options, options->relations != NULL, &result)) return NULL;
+
+    PhenoToken* tokens = result.total_tokens ?
+        malloc(result.total_tokens * sizeof(PhenoToken)) : NULL;
+    GosiUMLRelation* relations = result.total_relations ?
+        malloc(result.total_relations * sizeof(GosiUMLRelation)) : NULL;
+    if ((result.total_tokens && !tokens) || (result.total_relations && !relations)) {
+        free(tokens);
+        free(relations);
+        parse_result_free(&result);
+        return NULL;
+    }
+    if (!merge_chunks(&result, tokens, relations, options->symbols)) {
+        free(tokens);
+        free(relations);
+        parse_result_free(&result);
+        return NULL;
+    }
+
+    if (count) *count = (int)result.total_tokens;
+    if (options->relations) *options->relations = relations;
+    if (options->relation_count) *options->relation_count = (int)result.total_relations;
+    parse_result_free(&result);
+    return tokens;
+}
+
+// Tokens are returned as one array; free it with gosiuml_free_tokens()
+PhenoToken* gosiuml_parse_file(const char* filename, int* count) {
+    return gosiuml_parse_file_ex(filename, NULL, count);
+}
+
+void gosiuml_free_tokens(PhenoToken* tokens, int count) {
+    (void)count;
+    free(tokens);
+}
+
+void gosiuml_free_relations(GosiUMLRelation* relations) {
+    free(relations);
+}
+
+// Followed document: one ParseChunk grown by each refresh
+struct GosiUMLDocumentFollower {
+    TokenFollower follower;
+    ParseChunk chunk;
+    GosiUMLDocument doc;
+};
+
+GosiUMLDocumentFollower* gosiuml_follow_document(const char* filename) {
+    GosiUMLDocumentFollower* f = calloc(1, sizeof(GosiUMLDocumentFollower));
+    if (!f) return NULL;
+    f->chunk.want_relations = true;
+    f->chunk.symbols = pheno_symbols_create();
+    if (!f->chunk.symbols || !token_follow_open(&f->follower, filename)) {
+        gosiuml_follow_free(f);
+        return NULL;
+    }
+    return f;
+}
+
+long gosiuml_follow_refresh(GosiUMLDocumentFollower* f, bool* reset) {
+    if (reset) *reset = false;
+    if (!f) return -1;
+    ParseChunk* chunk = &f->chunk;
+    size_t tokens = chunk->token_count, relations = chunk->relation_count;
+    uint64_t resets = f->follower.resets, malformed = f->follower.stats.malformed;
+
+    TokenScanCallbacks callbacks = { chunk_on_token, chunk_on_relation, chunk };
+    if (token_follow_poll(&f->follower, &callbacks) < 0 || chunk->failed) return -1;
+
+    // A truncated or replaced file was rescanned from its start: keep only
+    // what this poll delivered. Names of vanished tokens stay interned.
+    uint64_t new_malformed = f->follower.stats.malformed - malformed;
+    if (f->follower.resets != resets) {
+        memmove(chunk->tokens, chunk->tokens + tokens,
+                (chunk->token_count - tokens) * sizeof(PhenoToken));
+        memmove(chunk->relations, chunk->relations + relations,
+                (chunk->relation_count - relations) * sizeof(GosiUMLRelation));
+        chunk->token_count -= tokens;
+        chunk->relation_count -= relations;
+        chunk->malformed = 0;
+        tokens = relations = 0;
+        if (reset) *reset = true;
+    }
+    chunk->malformed += new_malformed;
+
+    f->doc.tokens = chunk->tokens;
+    f->doc.token_count = chunk->token_count;
+    f->doc.relations = chunk->relations;
+    f->doc.relation_count = chunk->relation_count;
+    f->doc.malformed = chunk->malformed;
+    f->doc.source_size = f->follower.offset;
+    f->doc.symbols = chunk->symbols;
+    return (long)(chunk->token_count - tokens + chunk->relation_count - relations);
+}
+
+const GosiUMLDocument* gosiuml_follow_get(const GosiUMLDocumentFollower* f) {
+    return f ? &f->doc : NULL;
+}
+
+uint64_t gosiuml_follow_offset(const GosiUMLDocumentFollower* f) {
+    return f ? f->follower.offset : 0;
+}
+
+void gosiuml_follow_free(GosiUMLDocumentFollower* f) {
+    if (!f) return;
+    token_follow_close(&f->follower);
+    free(f->chunk.tokens);
+    free(f->chunk.relations);
+    pheno_symbols_destroy(f->chunk.symbols);
+    free(f);
 }
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "token_scanner.h"
+#include "pheno_hash.h"
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline const char* skip_space(const char* p, const char* end) {
+    while (p < end && is_space(*p)) p++;
+    return p;
+}
+
+static inline int hex_value(unsigned char c) {
+    if ((unsigned)(c - '0') < 10u) return c - '0';
+    c |= 0x20;
+    if ((unsigned)(c - 'a') < 6u) return c - 'a' + 10;
+    return -1;
+}
+
+static inline bool match(const char** p, const char* end, const char* lit, size_t len) {
+    if ((size_t)(end - *p) < len || memcmp(*p, lit, len) != 0) return false;
+    *p += len;
+    return true;
+}
+
+// Next whitespace-delimited field
+static bool scan_word(const char** p, const char* end, TokenScanView* out) {
+    const char* s = skip_space(*p, end);
+    const char* e = s;
+    while (e < end && !is_space(*e)) e++;
+    if (e == s) return false;
+
+    out->ptr = s;
+    out->len = (size_t)(e - s);
+    *p = e;
+    return true;
+}
+
+bool token_scan_hex32(const char** p, const char* end, uint32_t* out) {
+    const char* s = *p;
+    if (end - s >= 2 && s[0] == '0' && (s[1] | 0x20) == 'x') s += 2;
+
+    uint64_t value = 0;
+    const char* digits = s;
+    int d;
+    while (s < end && (d = hex_value((unsigned char)*s)) >= 0) {
+        value = (value << 4) | (uint64_t)d;
+        if (value > UINT32_MAX) return false;
+        s++;
+    }
+    if (s == digits) return false;
+
+    *out = (uint32_t)value;
+    *p = s;
+    return true;
+}
+
+bool token_scan_dec32(const char** p, const char* end, uint32_t* out) {
+    const char* s = *p;
+    uint64_t value = 0;
+    while (s < end && (unsigned)(*s - '0') < 10u) {
+        value = value * 10 + (uint64_t)(*s - '0');
+        if (value > UINT32_MAX) return false;
+        s++;
+    }
+    if (s == *p) return false;
+
+    *out = (uint32_t)value;
+    *p = s;
+    return true;
+}
+
+// TOKEN: 0x<id> <type> <zone>
+static bool scan_token(const char* p, const char* end, TokenScanToken* tok) {
+    p = skip_space(p, end);
+    if (!token_scan_hex32(&p, end, &tok->id)) return false;
+    if (p < end && !is_space(*p)) return false;
+    if (!scan_word(&p, end, &tok->type)) return false;
+    if (!scan_word(&p, end, &tok->zone)) return false;
+
+    const char* z = tok->zone.ptr;
+    tok->zone_value = 0;
+    token_scan_dec32(&z, z + tok->zone.len, &tok->zone_value);
+    return true;
+}
+
+// RELATION: 0x<src> -> 0x<dst> : <type>
+static bool scan_relation(const char* p, const char* end, TokenScanRelation* rel) {
+    p = skip_space(p, end);
+    if (!token_scan_hex32(&p, end, &rel->src_id)) return false;
+    p = skip_space(p, end);
+    if (!match(&p, end, "->", 2)) return false;
+    p = skip_space(p, end);
+    if (!token_scan_hex32(&p, end, &rel->dst_id)) return false;
+    p = skip_space(p, end);
+    if (!match(&p, end, ":", 1)) return false;
+    return scan_word(&p, end, &rel->type);
+}
+
+size_t token_scan_buffer(const char* data, size_t size, bool final, uint64_t first_line,
+                         const TokenScanCallbacks* callbacks, TokenScanStats* stats) {
+    TokenScanStats local = {0};
+    if (!stats) stats = &local;
+    if (!data) return 0;
+
+    const char* p = data;
+    const char* end = data + size;
+    uint64_t line_no = first_line;
+
+    while (p < end) {
+        const char* nl = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = nl ? nl : end;
+        if (!nl && !final) break;
+        const char* next = nl ? nl + 1 : end;
+
+        const char* s = skip_space(p, line_end);
+        stats->lines++;
+
+        if (s < line_end && *s != '#') {
+            if (match(&s, line_end, "TOKEN:", 6)) {
+                TokenScanToken tok;
+                if (scan_token(s, line_end, &tok)) {
+                    tok.line = line_no;
+                    stats->tokens++;
+                    if (callbacks && callbacks->on_token &&
+                        !callbacks->on_token(&tok, callbacks->user)) {
+                        stats->stopped = true;
+                    }
+                } else {
+                    stats->malformed++;
+                }
+            } else if (match(&s, line_end, "RELATION:", 9)) {
+                TokenScanRelation rel;
+                if (scan_relation(s, line_end, &rel)) {
+                    rel.line = line_no;
+                    stats->relations++;
+                    if (callbacks && callbacks->on_relation &&
+                        !callbacks->on_relation(&rel, callbacks->user)) {
+                        stats->stopped = true;
+                    }
+                } else {
+                    stats->malformed++;
+                }
+            }
+        }
+
+        p = next;
+        line_no++;
+        if (stats->stopped) break;
+    }
+
+    stats->bytes += (uint64_t)(p - data);
+    return (size_t)(p - data);
+}
+
+bool token_scan_open(TokenScanFile* file, const char* path) {
+    if (!file || !path) return false;
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    file->fd = fd;
+    file->size = (size_t)st.st_size;
+    if (file->size == 0) return true;
+
+    void* map = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        file->fd = -1;
+        return false;
+    }
+    madvise(map, file->size, MADV_SEQUENTIAL);
+    file->data = map;
+    return true;
+}
+
+void token_scan_close(TokenScanFile* file) {
+    if (!file) return;
+    if (file->data) munmap((void*)file->data, file->size);
+    if (file->fd >= 0) close(file->fd);
+    file->data = NULL;
+    file->size = 0;
+    file->fd = -1;
+}
+
+long token_scan_file(const char* path, const TokenScanCallbacks* callbacks,
+                     TokenScanStats* stats) {
+    TokenScanFile file;
+    if (!token_scan_open(&file, path)) return -1;
+
+    TokenScanStats local = {0};
+    if (!stats) stats = &local;
+    uint64_t before = stats->tokens;
+
+    token_scan_buffer(file.data, file.size, true, 1, callbacks, stats);
+    token_scan_close(&file);
+    return (long)(stats->tokens - before);
+}
+
+#define FOLLOW_READ_BLOCK (1u << 20)
+
+static void follow_reset(TokenFollower* follower) {
+    follower->offset = 0;
+    follower->next_line = 1;
+    follower->carry = 0;
+    follower->fingerprint = 0;
+    follower->fingerprint_pos = 0;
+    follower->stale = false;
+}
+
+// XXH64 of the first and last TOKEN_FOLLOW_BLOCK bytes before end
+static bool follow_fingerprint(int fd, uint64_t end, uint64_t* out) {
+    char block[TOKEN_FOLLOW_BLOCK];
+    size_t len = end < TOKEN_FOLLOW_BLOCK ? (size_t)end : TOKEN_FOLLOW_BLOCK;
+    if (pread(fd, block, len, 0) != (ssize_t)len) return false;
+    uint64_t hash = pheno_xxh64(block, len, end);
+    if (pread(fd, block, len, (off_t)(end - len)) != (ssize_t)len) return false;
+    *out = pheno_xxh64(block, len, hash);
+    return true;
+}
+
+// True when the range read so far still holds the bytes it was read with
+static bool follow_unchanged(const TokenFollower* follower, int fd) {
+    if (follower->fingerprint_pos == 0) return true;
+    uint64_t hash;
+    return follow_fingerprint(fd, follower->fingerprint_pos, &hash) && hash == follower->fingerprint;
+}
+
+bool token_follow_open(TokenFollower* follower, const char* path) {
+    if (!follower || !path) return false;
+    memset(follower, 0, sizeof(*follower));
+
+    follower->path = strdup(path);
+    if (!follower->path) return false;
+    follow_reset(follower);
+    return true;
+}
+
+void token_follow_close(TokenFollower* follower) {
+    if (!follower) return;
+    free(follower->path);
+    free(follower->buffer);
+    memset(follower, 0, sizeof(*follower));
+}
+
+long token_follow_poll(TokenFollower* follower, const TokenScanCallbacks* callbacks) {
+    if (!follower || !follower->path) return -1;
+
+    int fd = open(follower->path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Truncated, replaced or rewritten in place: start over
+    uint64_t size = (uint64_t)st.st_size;
+    uint64_t read_pos = follower->offset + follower->carry;
+    if ((follower->inode && follower->inode != (uint64_t)st.st_ino) || size < read_pos ||
+        follower->stale || !follow_unchanged(follower, fd)) {
+        follow_reset(follower);
+        follower->resets++;
+        read_pos = 0;
+    }
+    follower->inode = (uint64_t)st.st_ino;
+
+    uint64_t before = follower->stats.tokens;
+    while (read_pos < size && !follower->stats.stopped) {
+        size_t want = size - read_pos < FOLLOW_READ_BLOCK ?
+                      (size_t)(size - read_pos) : FOLLOW_READ_BLOCK;
+        if (follower->carry + want > follower->capacity) {
+            size_t cap = follower->carry + want;
+            char* grown = realloc(follower->buffer, cap);
+            if (!grown) break;
+            follower->buffer = grown;
+            follower->capacity = cap;
+        }
+
+        ssize_t n = pread(fd, follower->buffer + follower->carry, want, (off_t)read_pos);
+        if (n <= 0) break;
+        read_pos += (uint64_t)n;
+
+        // Only complete lines; the remainder is carried to the next read
+        size_t len = follower->carry + (size_t)n;
+        uint64_t lines = follower->stats.lines;
+        size_t consumed = token_scan_buffer(follower->buffer, len, false, follower->next_line,
+                                            callbacks, &follower->stats);
+        follower->next_line += follower->stats.lines - lines;
+        follower->offset += consumed;
+        follower->carry = len - consumed;
+        memmove(follower->buffer, follower->buffer + consumed, follower->carry);
+    }
+    // Without a fingerprint nothing read can be vouched for later, so the
+    // next poll rescans rather than skipping the check
+    if (read_pos != follower->fingerprint_pos) {
+        follower->stale = !follow_fingerprint(fd, read_pos, &follower->fingerprint);
+        follower->fingerprint_pos = follower->stale ? 0 : read_pos;
+    }
+    close(fd);
+
+    // A stop request only applies to the poll that made it
+    follower->stats.stopped = false;
+    return (long)(follower->stats.tokens - before);
+}
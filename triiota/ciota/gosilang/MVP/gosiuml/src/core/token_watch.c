@@ -0,0 +1,425 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "token_watch.h"
+#include "batch_render.h"
+#include "gosiuml.h"
+#include "svg_generator.h"
+#include "pheno_threadpool.h"
+#include "pheno_histogram.h"
+
+#define WATCH_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)
+#define WATCH_PATH_MAX 1200
+
+typedef struct {
+    int wd;
+    char* path;
+    char* only;                    // File name filter, NULL = every suffix file
+} WatchDir;
+
+typedef struct {
+    char* path;
+    char output[WATCH_PATH_MAX];
+    GosiUMLDocumentFollower* doc;
+    SvgFragmentCache* svg;
+    bool dirty;
+    bool rendered;                 // Output written at least once
+    uint64_t first_event_ns;       // Oldest change not yet rendered
+
+    // Result of the last render, read back by the polling thread
+    LayoutMode layout_mode;
+    PhenoThreadPool* layout_pool;  // NULL = serial
+    bool ok;
+    bool skipped;                  // Nothing new since the previous render
+    bool reset;
+    long added;
+    uint64_t parsed_bytes;
+    uint64_t done_ns;
+} WatchFile;
+
+struct TokenWatch {
+    WatchOptions options;
+    char* out_dir;
+    char* suffix;
+    int inotify_fd;
+    int stop_fd;
+    atomic_bool stopped;
+    PhenoThreadPool* pool;
+    bool own_pool;
+
+    WatchDir* dirs;
+    size_t dir_count;
+    size_t dir_capacity;
+    WatchFile** files;
+    size_t file_count;
+    size_t file_capacity;
+
+    WatchStats stats;
+    PhenoHistogram latency;
+};
+
+void watch_defaults(WatchOptions* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->layout = LAYOUT_AUTO;
+    options->coalesce_ms = WATCH_COALESCE_MS;
+    options->max_delay_ms = WATCH_MAX_DELAY_MS;
+}
+
+TokenWatch* watch_create(const WatchOptions* options) {
+    WatchOptions defaults;
+    if (!options) {
+        watch_defaults(&defaults);
+        options = &defaults;
+    }
+    TokenWatch* w = calloc(1, sizeof(TokenWatch));
+    if (!w) return NULL;
+    w->options = *options;
+    if (w->options.coalesce_ms <= 0) w->options.coalesce_ms = WATCH_COALESCE_MS;
+    if (w->options.max_delay_ms <= 0) w->options.max_delay_ms = WATCH_MAX_DELAY_MS;
+    w->suffix = strdup(options->suffix ? options->suffix : ".tok");
+    w->out_dir = options->out_dir ? strdup(options->out_dir) : NULL;
+    w->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    w->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    w->own_pool = options->threads > 1;
+    w->pool = w->own_pool ? pheno_threadpool_create(options->threads) :
+              options->threads == 0 ? pheno_threadpool_default() : NULL;
+    if (!w->suffix || (options->out_dir && !w->out_dir) || w->inotify_fd < 0 || w->stop_fd < 0 ||
+        (options->threads != 1 && !w->pool)) {
+        watch_destroy(w);
+        return NULL;
+    }
+    w->options.out_dir = w->out_dir;
+    w->options.suffix = w->suffix;
+    return w;
+}
+
+static void file_free(WatchFile* f) {
+    if (!f) return;
+    gosiuml_follow_free(f->doc);
+    svg_cache_destroy(f->svg);
+    free(f->path);
+    free(f);
+}
+
+void watch_destroy(TokenWatch* w) {
+    if (!w) return;
+    for (size_t i = 0; i < w->file_count; i++) file_free(w->files[i]);
+    for (size_t i = 0; i < w->dir_count; i++) {
+        free(w->dirs[i].path);
+        free(w->dirs[i].only);
+    }
+    if (w->own_pool) pheno_threadpool_destroy(w->pool);
+    if (w->inotify_fd >= 0) close(w->inotify_fd);
+    if (w->stop_fd >= 0) close(w->stop_fd);
+    free(w->files);
+    free(w->dirs);
+    free(w->out_dir);
+    free(w->suffix);
+    free(w);
+}
+
+static WatchFile* file_find(TokenWatch* w, const char* path, size_t* index) {
+    for (size_t i = 0; i < w->file_count; i++) {
+        if (strcmp(w->files[i]->path, path) == 0) {
+            if (index) *index = i;
+            return w->files[i];
+        }
+    }
+    return NULL;
+}
+
+// Mark path changed, following it from now on if it is new
+static bool file_touch(TokenWatch* w, const char* path, uint64_t now) {
+    WatchFile* f = file_find(w, path, NULL);
+    if (!f) {
+        if (w->file_count == w->file_capacity) {
+            size_t cap = w->file_capacity ? w->file_capacity * 2 : 16;
+            WatchFile** grown = realloc(w->files, cap * sizeof(WatchFile*));
+            if (!grown) return false;
+            w->files = grown;
+            w->file_capacity = cap;
+        }
+        f = calloc(1, sizeof(WatchFile));
+        if (f) {
+            f->path = strdup(path);
+            f->doc = gosiuml_follow_document(path);
+            f->svg = svg_cache_create();
+        }
+        if (!f || !f->path || !f->doc || !f->svg ||
+            !batch_output_path(path, w->out_dir, f->output, sizeof(f->output))) {
+            file_free(f);
+            return false;
+        }
+        w->files[w->file_count++] = f;
+    }
+    if (!f->dirty) {
+        f->dirty = true;
+        f->first_event_ns = now;
+    }
+    return true;
+}
+
+static void file_forget(TokenWatch* w, const char* path) {
+    size_t i;
+    WatchFile* f = file_find(w, path, &i);
+    if (!f) return;
+    w->files[i] = w->files[--w->file_count];
+    file_free(f);
+}
+
+static bool has_suffix(const char* name, const char* suffix) {
+    size_t n = strlen(name), s = strlen(suffix);
+    return n > s && strcmp(name + n - s, suffix) == 0;
+}
+
+static bool dir_wants(const TokenWatch* w, const WatchDir* dir, const char* name) {
+    return dir->only ? strcmp(dir->only, name) == 0 : has_suffix(name, w->suffix);
+}
+
+static bool add_dir(TokenWatch* w, const char* path, const char* only) {
+    int wd = inotify_add_watch(w->inotify_fd, path, WATCH_EVENTS);
+    if (wd < 0) return false;
+    if (w->dir_count == w->dir_capacity) {
+        size_t cap = w->dir_capacity ? w->dir_capacity * 2 : 8;
+        WatchDir* grown = realloc(w->dirs, cap * sizeof(WatchDir));
+        if (!grown) return false;
+        w->dirs = grown;
+        w->dir_capacity = cap;
+    }
+    WatchDir* dir = &w->dirs[w->dir_count];
+    dir->wd = wd;
+    dir->path = strdup(path);
+    dir->only = only ? strdup(only) : NULL;
+    if (!dir->path || (only && !dir->only)) {
+        free(dir->path);
+        free(dir->only);
+        return false;
+    }
+    w->dir_count++;
+    return true;
+}
+
+bool watch_add(TokenWatch* w, const char* path) {
+    struct stat st;
+    if (!w || !path || stat(path, &st) != 0) return false;
+    uint64_t now = pheno_monotonic_ns();
+
+    // Files are watched through their directory so a replacing rename is
+    // seen, and are keyed by the same dir/name path the events produce
+    char dir[WATCH_PATH_MAX], file[WATCH_PATH_MAX];
+    if (!S_ISDIR(st.st_mode)) {
+        const char* slash = strrchr(path, '/');
+        const char* name = slash ? slash + 1 : path;
+        snprintf(dir, sizeof(dir), "%.*s", slash ? (int)(slash - path) : 1, slash ? path : ".");
+        if (dir[0] == '\0') snprintf(dir, sizeof(dir), "/");
+        int n = snprintf(file, sizeof(file), "%s/%s", dir, name);
+        return n > 0 && (size_t)n < sizeof(file) && add_dir(w, dir, name) && file_touch(w, file, now);
+    }
+
+    if (!add_dir(w, path, NULL)) return false;
+    DIR* d = opendir(path);
+    if (!d) return false;
+    bool ok = true;
+    struct dirent* entry;
+    while (ok && (entry = readdir(d))) {
+        if (!has_suffix(entry->d_name, w->suffix)) continue;
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        ok = stat(file, &st) != 0 || !S_ISREG(st.st_mode) || file_touch(w, file, now);
+    }
+    closedir(d);
+    return ok;
+}
+
+// Drain queued events; false on a read error
+static bool read_events(TokenWatch* w) {
+    char buf[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char path[WATCH_PATH_MAX];
+    for (;;) {
+        ssize_t n = read(w->inotify_fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return errno == EAGAIN;
+        if (n == 0) return true;
+
+        uint64_t now = pheno_monotonic_ns();
+        for (char* p = buf; p < buf + n; ) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            w->stats.events++;
+            if (ev->len == 0 || (ev->mask & IN_ISDIR)) continue;
+            for (size_t i = 0; i < w->dir_count; i++) {
+                const WatchDir* dir = &w->dirs[i];
+                if (dir->wd != ev->wd || !dir_wants(w, dir, ev->name)) continue;
+                snprintf(path, sizeof(path), "%s/%s", dir->path, ev->name);
+                if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    file_forget(w, path);
+                } else {
+                    file_touch(w, path, now);
+                }
+                break;
+            }
+        }
+    }
+}
+
+static void render_file(void* arg) {
+    WatchFile* f = arg;
+    uint64_t before = gosiuml_follow_offset(f->doc);
+    f->added = gosiuml_follow_refresh(f->doc, &f->reset);
+    uint64_t after = gosiuml_follow_offset(f->doc);
+    f->parsed_bytes = f->reset ? after : after - before;
+    f->ok = f->added >= 0;
+    f->skipped = f->ok && f->added == 0 && !f->reset && f->rendered;
+    if (f->ok && !f->skipped) {
+        LayoutOptions options;
+        Layout layout;
+        layout_defaults(&options);
+        options.mode = f->layout_mode;
+        options.threads = 1;
+        options.pool = f->layout_pool;
+        const GosiUMLDocument* doc = gosiuml_follow_get(f->doc);
+        f->ok = layout_document(doc, &options, &layout);
+        if (f->ok) {
+            f->ok = svg_render_layout_cached(f->svg, doc->tokens, doc->symbols, &layout, f->output, NULL) == 0;
+            layout_free(&layout);
+        }
+        f->rendered = f->rendered || f->ok;
+    }
+    f->done_ns = pheno_monotonic_ns();
+}
+
+static int render_dirty(TokenWatch* w) {
+    size_t dirty = 0;
+    for (size_t i = 0; i < w->file_count; i++) dirty += w->files[i]->dirty;
+    if (dirty == 0) return 0;
+
+    // Several files: one per worker, each laid out serially. A single file
+    // is laid out on the watch's pool rather than one built per render
+    PhenoTaskGroup group;
+    bool parallel = w->pool && dirty > 1;
+    if (parallel) pheno_taskgroup_init(&group);
+    for (size_t i = 0; i < w->file_count; i++) {
+        WatchFile* f = w->files[i];
+        if (!f->dirty) continue;
+        f->layout_mode = w->options.layout;
+        f->layout_pool = parallel ? NULL : w->pool;
+        if (parallel) {
+            pheno_threadpool_submit(w->pool, &group, render_file, f);
+        } else {
+            render_file(f);
+        }
+    }
+    if (parallel) {
+        pheno_taskgroup_wait(w->pool, &group);
+        pheno_taskgroup_destroy(&group);
+    }
+
+    int rendered = 0;
+    for (size_t i = 0; i < w->file_count; i++) {
+        WatchFile* f = w->files[i];
+        if (!f->dirty) continue;
+        f->dirty = false;
+        w->stats.parsed_bytes += f->parsed_bytes;
+        w->stats.resets += f->reset;
+        if (!f->ok) {
+            w->stats.failed++;
+            if (!w->options.quiet) fprintf(stderr, "[WATCH] Failed: %s\n", f->path);
+            continue;
+        }
+        if (f->skipped) continue;
+
+        uint64_t latency = f->done_ns - f->first_event_ns;
+        pheno_hist_record(&w->latency, latency);
+        if (latency > w->stats.max_ns) w->stats.max_ns = latency;
+        w->stats.renders++;
+        rendered++;
+        if (!w->options.quiet) {
+            const GosiUMLDocument* doc = gosiuml_follow_get(f->doc);
+            printf("[WATCH] %s -> %s: %s%ld, %zu tokens, %zu relations, %.2f ms\n", f->path,
+                   f->output, f->reset ? "reset, " : "+", f->added, doc->token_count,
+                   doc->relation_count, latency / 1e6);
+        }
+    }
+    if (rendered > 0) w->stats.batches++;
+    return rendered;
+}
+
+static int wait_events(TokenWatch* w, int timeout_ms) {
+    struct pollfd fds[2] = { { w->inotify_fd, POLLIN, 0 }, { w->stop_fd, POLLIN, 0 } };
+    int rc;
+    do {
+        rc = poll(fds, 2, timeout_ms);
+    } while (rc < 0 && errno == EINTR && !atomic_load(&w->stopped));
+    if (rc < 0 && errno != EINTR) return -1;
+    return rc > 0 && (fds[0].revents & POLLIN);
+}
+
+int watch_poll(TokenWatch* w, int timeout_ms) {
+    if (!w) return -1;
+    bool pending = false;
+    for (size_t i = 0; i < w->file_count && !pending; i++) pending = w->files[i]->dirty;
+
+    int rc = wait_events(w, pending ? 0 : timeout_ms);
+    if (rc < 0 || atomic_load(&w->stopped)) return rc < 0 ? -1 : 0;
+    if (rc > 0 && !read_events(w)) return -1;
+
+    // Coalesce: keep draining until quiet or the oldest change is due
+    uint64_t oldest = UINT64_MAX;
+    for (size_t i = 0; i < w->file_count; i++) {
+        if (w->files[i]->dirty && w->files[i]->first_event_ns < oldest) {
+            oldest = w->files[i]->first_event_ns;
+        }
+    }
+    if (oldest == UINT64_MAX) return 0;
+    uint64_t deadline = oldest + (uint64_t)w->options.max_delay_ms * 1000000ull;
+    for (;;) {
+        uint64_t now = pheno_monotonic_ns();
+        if (now >= deadline) break;
+        uint64_t left_ms = (deadline - now) / 1000000;
+        int quiet = w->options.coalesce_ms < (int64_t)left_ms ? w->options.coalesce_ms : (int)left_ms;
+        rc = wait_events(w, quiet);
+        if (rc < 0) return -1;
+        if (rc == 0 || atomic_load(&w->stopped)) break;
+        if (!read_events(w)) return -1;
+    }
+    return render_dirty(w);
+}
+
+int watch_run(TokenWatch* w) {
+    if (!w) return -1;
+    while (!atomic_load(&w->stopped)) {
+        if (watch_poll(w, -1) < 0) return -1;
+    }
+    return 0;
+}
+
+void watch_stop(TokenWatch* w) {
+    if (!w) return;
+    atomic_store(&w->stopped, true);
+    uint64_t one = 1;
+    ssize_t n = write(w->stop_fd, &one, sizeof(one));
+    (void)n;
+}
+
+void watch_get_stats(TokenWatch* w, WatchStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!w) return;
+    *stats = w->stats;
+    stats->files = w->file_count;
+    PhenoHistogramSnapshot* snap = malloc(sizeof(PhenoHistogramSnapshot));
+    if (snap) {
+        pheno_hist_snapshot(&w->latency, snap, false);
+        stats->p50_ns = pheno_hist_percentile(snap, 50.0);
+        stats->p99_ns = pheno_hist_percentile(snap, 99.0);
+        free(snap);
+    }
+}